@@ -0,0 +1,99 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Screen.h>
+#include <terminal/ScreenEvents.h>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace terminal;
+
+namespace {
+
+/// @returns the @p _n'th line of kernel log like output.
+string dmesgLine(size_t _n)
+{
+    static auto const messages = array<char const*, 8>{
+        "usb 1-{}: new high-speed USB device number {} using xhci_hcd",
+        "\033[33mwlp3s0: authenticate with 5c:49:79:{:02x}:{:02x}:10\033[m",
+        "EXT4-fs (nvme0n1p{}): mounted filesystem with ordered data mode. Opts: (null). Quota mode: {}.",
+        "audit: type=1400 audit({}.{}:42): apparmor=\"STATUS\" operation=\"profile_load\"",
+        "\033[1;31mperf: interrupt took too long ({} > {}), lowering kernel.perf_event_max_sample_rate\033[m",
+        "pci 0000:00:{:02x}.{}: [8086:a0e8] type 00 class 0x0c8000",
+        "input: Logitech USB Receiver as /devices/pci0000:00/0000:00:14.0/usb1/1-{}/input/input{}",
+        "ACPI: \\_SB_.PCI0.GP{}: PM: Power state change: D3hot -> D0 ({})",
+    };
+
+    auto const timestamp = static_cast<double>(_n) * 0.000731;
+    return fmt::format("[{:12.6f}] ", timestamp)
+         + fmt::format(messages[_n % messages.size()], _n % 7, _n % 251)
+         + "\r\n";
+}
+
+double secondsSince(chrono::steady_clock::time_point _start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - _start).count();
+}
+
+} // namespace
+
+int main(int argc, char const* argv[])
+{
+    size_t const count = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 1'000'000;
+
+    auto events = ScreenEvents{};
+    auto screen = Screen{{120, 40}, events};
+    screen.setMaxHistoryLineCount(nullopt);
+
+    cout << "Pushing " << count << " lines of dmesg-like output through a 120x40 screen.\n";
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+        screen.write(dmesgLine(i));
+    auto seconds = secondsSince(start);
+
+    cout << fmt::format("write:  {:.3f} secs, {:.0f} lines/sec\n", seconds, static_cast<double>(count) / seconds);
+
+    auto const stats = screen.historyStats();
+    auto const compactLineCount = static_cast<double>(max(stats.compactLineCount, size_t{1}));
+    auto const compactBytes = static_cast<double>(max(stats.compactBytes, size_t{1}));
+    cout << fmt::format("history: {} lines, {} compact, {:.1f} MB, {:.1f} bytes/line, {:.1f}x smaller than cells\n",
+                        stats.lineCount,
+                        stats.compactLineCount,
+                        static_cast<double>(stats.compactBytes) / 1e6,
+                        static_cast<double>(stats.compactBytes) / compactLineCount,
+                        static_cast<double>(stats.cellBytes) / compactBytes);
+
+    // Scrolls through the whole history page by page, as a user would, expanding each line on render.
+    size_t renderedCells = 0;
+    start = chrono::steady_clock::now();
+    screen.scrollUp(screen.historyLineCount());
+    do
+        screen.render([&](Coordinate const&, CellView const&) { ++renderedCells; }, screen.scrollOffset());
+    while (screen.scrollDown(40));
+    seconds = secondsSince(start);
+
+    cout << fmt::format("render: {:.3f} secs, {:.0f} lines/sec ({} cells)\n",
+                        seconds,
+                        static_cast<double>(screen.historyLineCount()) / seconds,
+                        renderedCells);
+
+    return EXIT_SUCCESS;
+}
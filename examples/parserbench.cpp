@@ -0,0 +1,155 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/CommandBuilder.h>
+#include <terminal/Parser.h>
+#include <terminal/UTF8Decoder.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace terminal;
+
+namespace {
+
+/// Generates output resembling a build log: mostly plain ASCII lines,
+/// with some colored diagnostics and a little bit of non-ASCII text.
+string makeBuildLog(size_t _size)
+{
+    string_view constexpr lines[] = {
+        "[ 42%] Building CXX object src/terminal/CMakeFiles/terminal.dir/Screen.cpp.o\r\n",
+        "/usr/bin/c++ -DLIBTERMINAL_VERSION_MAJOR=0 -I/home/user/contour/src -O2 -g -Wall -Wextra -std=c++17 -o Screen.cpp.o -c Screen.cpp\r\n",
+        "\033[1m/home/user/contour/src/terminal/Screen.cpp:123:45: \033[35mwarning: \033[0m\033[1munused variable 'x'\033[0m\r\n",
+        "    auto const x = 42; // \xC3\xBC\xC3\xB6\xC3\xA4 \xE2\x86\x92 \xE2\x9C\x93\r\n",
+        "[ 43%] Linking CXX static library libterminal.a\r\n",
+    };
+
+    string output;
+    output.reserve(_size);
+    for (size_t i = 0; output.size() < _size; ++i)
+        output += lines[i % size(lines)];
+    return output;
+}
+
+/// Generates CJK heavy text with some emoji, as seen in chat logs or localized tool output.
+string makeCJKText(size_t _size)
+{
+    string_view constexpr lines[] = {
+        "\xE4\xBB\x8A\xE6\x97\xA5\xE3\x81\xAF\xE8\x89\xAF\xE3\x81\x84\xE5\xA4\xA9\xE6\xB0\x97\xE3\x81\xA7\xE3\x81\x99\xE3\x81\xAD\xE3\x80\x82\r\n",
+        "\xE7\xBB\x88\xE7\xAB\xAF\xE6\xA8\xA1\xE6\x8B\x9F\xE5\x99\xA8\xE6\xAD\xA3\xE5\x9C\xA8\xE8\xA7\xA3\xE6\x9E\x90\xE8\xBE\x93\xE5\x87\xBA \xF0\x9F\x9A\x80\xF0\x9F\x8E\x89\r\n",
+        "\033[32m\xED\x95\x9C\xEA\xB5\xAD\xEC\x96\xB4 \xED\x85\x8D\xEC\x8A\xA4\xED\x8A\xB8\033[0m \xE2\x9C\x93\r\n",
+    };
+
+    string output;
+    output.reserve(_size);
+    for (size_t i = 0; output.size() < _size; ++i)
+        output += lines[i % size(lines)];
+    return output;
+}
+
+template <typename ParserT>
+double measure(string const& _input, CommandBuilder& _builder, ParserT& _parser, size_t _repeat)
+{
+    // Feed the parser in chunks of typical PTY read size.
+    constexpr size_t ChunkSize = 32 * 1024;
+
+    auto const start = chrono::steady_clock::now();
+    for (size_t i = 0; i < _repeat; ++i)
+    {
+        for (size_t offset = 0; offset < _input.size(); offset += ChunkSize)
+        {
+            auto const n = min(ChunkSize, _input.size() - offset);
+            _parser.parseFragment(_input.data() + offset, n);
+            _builder.clear();
+        }
+    }
+    auto const end = chrono::steady_clock::now();
+
+    auto const seconds = chrono::duration<double>(end - start).count();
+    auto const megabytes = static_cast<double>(_input.size() * _repeat) / (1024.0 * 1024.0);
+    return megabytes / seconds;
+}
+
+double measureDecoder(string const& _input, UTF8Decoder::Implementation _implementation, size_t _repeat)
+{
+    auto decoder = UTF8Decoder{_implementation};
+    auto output = vector<char32_t>(_input.size());
+    auto const input = reinterpret_cast<uint8_t const*>(_input.data());
+
+    auto const start = chrono::steady_clock::now();
+    for (size_t i = 0; i < _repeat; ++i)
+        decoder.decode(input, input + _input.size(), output.data());
+    auto const end = chrono::steady_clock::now();
+
+    auto const seconds = chrono::duration<double>(end - start).count();
+    auto const megabytes = static_cast<double>(_input.size() * _repeat) / (1024.0 * 1024.0);
+    return megabytes / seconds;
+}
+
+void benchmark(string_view _title, string const& _input, size_t _repeat)
+{
+    cout << "Parsing " << (_input.size() / (1024 * 1024)) << " MB of " << _title << ", " << _repeat << " times.\n";
+
+    auto builder = CommandBuilder{Logger{}};
+
+    // type-erased handler, one Print action per codepoint
+    auto perByteParser = parser::Parser{ref(builder)};
+    auto const perByte = measure(_input, builder, perByteParser, _repeat);
+    cout << "per-byte path:                   " << perByte << " MB/s\n";
+
+    // type-erased handler, printable text passed in bulk
+    auto bulkParser = parser::Parser{ref(builder),
+                                     [](string const&) {},
+                                     [&](u32string_view _text) { builder.print(_text); }};
+    auto const bulk = measure(_input, builder, bulkParser, _repeat);
+    cout << "bulk text fast path:             " << bulk << " MB/s (" << (bulk / perByte) << "x)\n";
+
+    // statically bound handler, as used by Screen
+    auto inlinedParser = parser::BasicParser<CommandBuilder&>{builder};
+    auto const inlined = measure(_input, builder, inlinedParser, _repeat);
+    cout << "bulk text fast path, inlined:    " << inlined << " MB/s (" << (inlined / perByte) << "x)\n";
+
+    // UTF-8 decoding stage alone
+    auto constexpr implementations = array{
+        pair{UTF8Decoder::Implementation::Scalar, "scalar"},
+        pair{UTF8Decoder::Implementation::SSE41, "SSE4.1"},
+        pair{UTF8Decoder::Implementation::AVX2, "AVX2"},
+    };
+    for (auto const& [implementation, name] : implementations)
+        if (UTF8Decoder::supported(implementation))
+            cout << "UTF-8 decoding, " << name << ":" << string(17 - string_view(name).size(), ' ')
+                 << measureDecoder(_input, implementation, _repeat) << " MB/s\n";
+
+    cout << '\n';
+}
+
+} // namespace
+
+int main(int argc, char const* argv[])
+{
+    size_t const megabytes = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 64;
+    size_t const repeat = 3;
+
+    benchmark("build log output", makeBuildLog(megabytes * 1024 * 1024), repeat);
+    benchmark("CJK text", makeCJKText(megabytes * 1024 * 1024), repeat);
+
+    return EXIT_SUCCESS;
+}
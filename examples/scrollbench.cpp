@@ -0,0 +1,99 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Screen.h>
+#include <terminal/ScreenEvents.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace terminal;
+
+namespace {
+
+/// Runs @p _scroll @p _count times on a 200x60 screen filled with text,
+/// with a scrolling region as set up by vim, tmux or less.
+void run(string const& _title, size_t _count, function<void(Screen&)> const& _setup, function<void(Screen&, size_t)> const& _scroll)
+{
+    auto events = ScreenEvents{};
+    auto screen = Screen{{200, 60}, events};
+
+    for (int row = 1; row <= 60; ++row)
+    {
+        screen.write(MoveCursorTo{row, 1});
+        screen.write(string(200, static_cast<char>('A' + row % 26)));
+    }
+
+    _setup(screen);
+
+    auto const start = chrono::steady_clock::now();
+    for (size_t i = 0; i < _count; ++i)
+        _scroll(screen, i);
+    auto const end = chrono::steady_clock::now();
+
+    auto const seconds = chrono::duration<double>(end - start).count();
+    cout << _title << ": " << seconds << " secs, "
+         << (seconds * 1e9 / static_cast<double>(_count)) << " ns/scroll\n";
+}
+
+} // namespace
+
+int main(int argc, char const* argv[])
+{
+    size_t const count = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 100'000;
+
+    auto const verticalMargin = [](Screen& _screen) {
+        _screen.write(SetTopBottomMargin{2, 59});
+    };
+
+    auto const horizontalMargin = [](Screen& _screen) {
+        _screen.write(SetTopBottomMargin{2, 59});
+        _screen.write(SetMode{Mode::LeftRightMargin, true});
+        _screen.write(SetLeftRightMargin{11, 190});
+    };
+
+    cout << "Scrolling a 200x60 screen " << count << " times.\n";
+
+    run("full screen       ", count, [](Screen& _screen) { _screen.setMaxHistoryLineCount(1000); }, [](Screen& _screen, size_t) {
+        _screen.write(ScrollUp{1});
+    });
+
+    run("region scroll-up  ", count, verticalMargin, [](Screen& _screen, size_t) {
+        _screen.write(ScrollUp{1});
+    });
+
+    run("region scroll-down", count, verticalMargin, [](Screen& _screen, size_t) {
+        _screen.write(ScrollDown{1});
+    });
+
+    run("region IL/DL      ", count, verticalMargin, [](Screen& _screen, size_t i) {
+        _screen.write(MoveCursorTo{10, 1});
+        if (i % 2)
+            _screen.write(InsertLines{1});
+        else
+            _screen.write(DeleteLines{1});
+    });
+
+    run("partial width     ", count, horizontalMargin, [](Screen& _screen, size_t i) {
+        if (i % 2)
+            _screen.write(ScrollUp{1});
+        else
+            _screen.write(ScrollDown{1});
+    });
+
+    return EXIT_SUCCESS;
+}
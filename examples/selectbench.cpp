@@ -0,0 +1,164 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/CommandBuilder.h>
+#include <terminal/Functions.h>
+#include <terminal/Parser.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+using namespace terminal;
+
+namespace {
+
+/// A mix of cursor movement, erase, scroll and SGR sequences, roughly as emitted by
+/// full screen applications such as vim or tmux while redrawing.
+string_view constexpr redrawSequences[] = {
+    "\033[12;1H",
+    "\033[K",
+    "\033[38;5;244m",
+    "\033[0m",
+    "\033[1;34m",
+    "\033[A",
+    "\033[3C",
+    "\033[2B",
+    "\033[D",
+    "\033[?25l",
+    "\033[?25h",
+    "\033[1;24r",
+    "\033[5X",
+    "\033[17G",
+    "\033[8d",
+    "\033[2L",
+    "\033[M",
+    "\033[2J",
+    "\033[H",
+    "\033[m",
+    "\033[22;39m",
+    "\033[48;2;40;44;52m",
+    "\033[S",
+    "\033[4@",
+    "\033[P",
+    "\0337",
+    "\0338",
+    "\033M",
+};
+
+/// The selectors the parser produces for redrawSequences, in the same order.
+FunctionSelector constexpr redrawSelectors[] = {
+    {FunctionCategory::CSI, 0, 2, 0, 'H'},
+    {FunctionCategory::CSI, 0, 0, 0, 'K'},
+    {FunctionCategory::CSI, 0, 3, 0, 'm'},
+    {FunctionCategory::CSI, 0, 1, 0, 'm'},
+    {FunctionCategory::CSI, 0, 2, 0, 'm'},
+    {FunctionCategory::CSI, 0, 0, 0, 'A'},
+    {FunctionCategory::CSI, 0, 1, 0, 'C'},
+    {FunctionCategory::CSI, 0, 1, 0, 'B'},
+    {FunctionCategory::CSI, 0, 0, 0, 'D'},
+    {FunctionCategory::CSI, '?', 1, 0, 'l'},
+    {FunctionCategory::CSI, '?', 1, 0, 'h'},
+    {FunctionCategory::CSI, 0, 2, 0, 'r'},
+    {FunctionCategory::CSI, 0, 1, 0, 'X'},
+    {FunctionCategory::CSI, 0, 1, 0, 'G'},
+    {FunctionCategory::CSI, 0, 1, 0, 'd'},
+    {FunctionCategory::CSI, 0, 1, 0, 'L'},
+    {FunctionCategory::CSI, 0, 0, 0, 'M'},
+    {FunctionCategory::CSI, 0, 1, 0, 'J'},
+    {FunctionCategory::CSI, 0, 0, 0, 'H'},
+    {FunctionCategory::CSI, 0, 0, 0, 'm'},
+    {FunctionCategory::CSI, 0, 2, 0, 'm'},
+    {FunctionCategory::CSI, 0, 5, 0, 'm'},
+    {FunctionCategory::CSI, 0, 0, 0, 'S'},
+    {FunctionCategory::CSI, 0, 1, 0, '@'},
+    {FunctionCategory::CSI, 0, 0, 0, 'P'},
+    {FunctionCategory::ESC, 0, 0, 0, '7'},
+    {FunctionCategory::ESC, 0, 0, 0, '8'},
+    {FunctionCategory::ESC, 0, 0, 0, 'M'},
+};
+
+static_assert(size(redrawSelectors) == size(redrawSequences));
+
+vector<FunctionSelector> makeSelectors(size_t _count)
+{
+    vector<FunctionSelector> selectors;
+    selectors.reserve(_count);
+    for (size_t i = 0; i < _count; ++i)
+        selectors.push_back(redrawSelectors[i % size(redrawSelectors)]);
+    return selectors;
+}
+
+string makeRedrawStream(size_t _sequenceCount)
+{
+    string output;
+    for (size_t i = 0; i < _sequenceCount; ++i)
+    {
+        output += redrawSequences[i % size(redrawSequences)];
+        output += "abc";
+    }
+    return output;
+}
+
+template <typename F>
+double measure(size_t _repeat, F _f)
+{
+    auto const start = chrono::steady_clock::now();
+    for (size_t i = 0; i < _repeat; ++i)
+        _f();
+    auto const end = chrono::steady_clock::now();
+    return chrono::duration<double>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char const* argv[])
+{
+    size_t const sequenceCount = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 1'000'000;
+    size_t const repeat = 10;
+    auto const total = static_cast<double>(sequenceCount * repeat);
+
+    // function lookup only
+    auto const selectors = makeSelectors(sequenceCount);
+    size_t found = 0;
+    auto const selectTime = measure(repeat, [&]() {
+        for (FunctionSelector const& selector : selectors)
+            found += select(selector) != nullptr;
+    });
+
+    cout << "select():   " << found << " of " << selectors.size() * repeat << " selectors matched.\n";
+    cout << "Duration:   " << selectTime << " secs\n";
+    cout << "Latency:    " << (selectTime * 1e9 / total) << " ns/lookup\n\n";
+
+    // full parse into commands
+    auto const input = makeRedrawStream(sequenceCount);
+    auto builder = CommandBuilder{Logger{}};
+    auto parser = parser::BasicParser<CommandBuilder&>{builder};
+    size_t commandCount = 0;
+    auto const parseTime = measure(repeat, [&]() {
+        parser.parseFragment(input.data(), input.size());
+        commandCount += builder.commands().size();
+        builder.clear();
+    });
+
+    cout << "Parsed " << sequenceCount * repeat << " sequences into " << commandCount << " commands.\n";
+    cout << "Duration:   " << parseTime << " secs\n";
+    cout << "Throughput: " << (static_cast<double>(input.size() * repeat) / (1024.0 * 1024.0) / parseTime) << " MB/s\n";
+    cout << "Latency:    " << (parseTime * 1e9 / total) << " ns/sequence\n";
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/CommandBuilder.h>
+#include <terminal/Parser.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+using namespace terminal;
+
+namespace {
+
+/// Generates SGR heavy output, as produced by colored ls, compilers, or htop.
+string makeSGRStream(size_t _sequenceCount)
+{
+    string_view constexpr sequences[] = {
+        "\033[0m",
+        "\033[1;34m",
+        "\033[01;32m",
+        "\033[38;5;208m",
+        "\033[48;2;40;44;52m",
+        "\033[38:2::171:178:191m",
+        "\033[4:3m",
+        "\033[58:2:255:128:65m",
+        "\033[1;4;7;38;5;15;48;5;236m",
+        "\033[22;24;27;39;49m",
+    };
+
+    string output;
+    for (size_t i = 0; i < _sequenceCount; ++i)
+    {
+        output += sequences[i % size(sequences)];
+        output += "ab";
+    }
+    return output;
+}
+
+} // namespace
+
+int main(int argc, char const* argv[])
+{
+    size_t const sequenceCount = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 1'000'000;
+    size_t const repeat = 10;
+
+    auto const input = makeSGRStream(sequenceCount);
+
+    auto builder = CommandBuilder{Logger{}};
+    auto parser = parser::BasicParser<CommandBuilder&>{builder};
+
+    size_t commandCount = 0;
+    auto const start = chrono::steady_clock::now();
+    for (size_t i = 0; i < repeat; ++i)
+    {
+        parser.parseFragment(input.data(), input.size());
+        commandCount += builder.commands().size();
+        builder.clear();
+    }
+    auto const end = chrono::steady_clock::now();
+
+    auto const seconds = chrono::duration<double>(end - start).count();
+    auto const total = static_cast<double>(sequenceCount * repeat);
+
+    cout << "Parsed " << sequenceCount * repeat << " SGR sequences into " << commandCount << " commands.\n";
+    cout << "Duration:   " << seconds << " secs\n";
+    cout << "Throughput: " << (total / seconds / 1e6) << " million sequences/s, "
+         << (static_cast<double>(input.size() * repeat) / (1024.0 * 1024.0) / seconds) << " MB/s\n";
+    cout << "Latency:    " << (seconds * 1e9 / total) << " ns/sequence\n";
+
+    return EXIT_SUCCESS;
+}
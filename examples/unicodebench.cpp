@@ -0,0 +1,99 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/CodepointProperties.h>
+#include <terminal/Screen.h>
+#include <terminal/ScreenEvents.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace terminal;
+
+namespace {
+
+u32string repeat(u32string_view _pattern, size_t _count)
+{
+    auto text = u32string{};
+    text.reserve(_count);
+    while (text.size() < _count)
+        text.append(_pattern.substr(0, _count - text.size()));
+    return text;
+}
+
+/// Runs @p _lookup over all codepoints of @p _text, @p _rounds times.
+void run(string const& _title, u32string const& _text, size_t _rounds, function<int(char32_t, char32_t)> const& _lookup)
+{
+    // Summed up, so the lookups cannot be optimized away.
+    int sum = 0;
+
+    auto const start = chrono::steady_clock::now();
+    for (size_t round = 0; round < _rounds; ++round)
+        for (size_t i = 1; i < _text.size(); ++i)
+            sum += _lookup(_text[i - 1], _text[i]);
+    auto const end = chrono::steady_clock::now();
+
+    auto const seconds = chrono::duration<double>(end - start).count();
+    auto const count = static_cast<double>(_rounds * (_text.size() - 1));
+    cout << _title << ": " << (seconds * 1e9 / count) << " ns/codepoint (" << sum << ")\n";
+}
+
+void write(string const& _title, u32string const& _text, size_t _rounds)
+{
+    auto events = ScreenEvents{};
+    auto screen = Screen{{200, 60}, events};
+
+    auto const start = chrono::steady_clock::now();
+    for (size_t round = 0; round < _rounds; ++round)
+        screen.writeText(_text);
+    auto const end = chrono::steady_clock::now();
+
+    auto const seconds = chrono::duration<double>(end - start).count();
+    auto const count = static_cast<double>(_rounds * _text.size());
+    cout << _title << ": " << (seconds * 1e9 / count) << " ns/codepoint\n";
+}
+
+} // namespace
+
+int main(int argc, char const* argv[])
+{
+    size_t const rounds = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 1000;
+
+    auto const texts = {
+        pair{"ascii", repeat(U"The quick brown fox jumps over the lazy dog. ", 10'000)},
+        pair{"latin1", repeat(U"Größenänderung über Äpfel, Übel und Öl. ", 10'000)},
+        pair{"cjk  ", repeat(U"日本語のテキストと한국어 텍스트와中文文本。", 10'000)},
+        pair{"emoji", repeat(U"😀🚀👍🏽❤️👨‍👩‍👧🎉", 10'000)},
+    };
+
+    cout << "Looking up " << rounds << " times 10000 codepoints.\n";
+
+    for (auto const& [name, text]: texts)
+    {
+        run(string(name) + " unicode::width    ", text, rounds, [](char32_t, char32_t b) { return unicode::width(b); });
+        run(string(name) + " columnWidth       ", text, rounds, [](char32_t, char32_t b) { return columnWidth(b); });
+        run(string(name) + " unicode::nonbreak ", text, rounds, [](char32_t a, char32_t b) {
+            return unicode::grapheme_segmenter::nonbreakable(a, b) ? 1 : 0;
+        });
+        run(string(name) + " nonbreakable      ", text, rounds, [](char32_t a, char32_t b) {
+            return nonbreakable(a, b) ? 1 : 0;
+        });
+        write(string(name) + " Screen::writeText ", text, rounds / 10 + 1);
+    }
+
+    return EXIT_SUCCESS;
+}
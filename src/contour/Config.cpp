@@ -735,6 +735,22 @@ TerminalProfile loadTerminalProfile(YAML::Node const& _node,
                 profile.maxHistoryLineCount = limit.as<size_t>();
         }
 
+        if (auto residentLimit = history["resident_limit"]; residentLimit)
+        {
+            if (residentLimit.as<int>() < 0)
+                profile.maxResidentHistoryLineCount = nullopt;
+            else
+                profile.maxResidentHistoryLineCount = residentLimit.as<size_t>();
+        }
+
+        if (auto memoryLimit = history["memory_limit"]; memoryLimit)
+        {
+            if (memoryLimit.as<long long>() < 0)
+                profile.maxHistoryBytes = nullopt;
+            else
+                profile.maxHistoryBytes = memoryLimit.as<size_t>();
+        }
+
         softLoadValue(history, "auto_scroll_on_update", profile.autoScrollOnUpdate);
         softLoadValue(history, "scroll_multiplier", profile.historyScrollMultiplier);
     }
@@ -784,6 +800,27 @@ void loadConfigFromFile(Config& _config,
     YAML::Node doc = YAML::LoadFile(_fileName.string());
 
     softLoadValue(doc, "word_delimiters", _config.wordDelimiters);
+    softLoadValue(doc, "max_payload_size", _config.maxPayloadSize);
+    softLoadValue(doc, "read_buffer_size", _config.maxReadBufferSize);
+
+    if (auto readLatency = doc["read_latency"]; readLatency)
+        _config.readLatency = chrono::milliseconds{readLatency.as<unsigned>()};
+
+    softLoadValue(doc, "paste_chunk_size", _config.pasteChunkSize);
+
+    if (auto pasteChunkInterval = doc["paste_chunk_interval"]; pasteChunkInterval)
+        _config.pasteChunkInterval = chrono::milliseconds{pasteChunkInterval.as<unsigned>()};
+
+    softLoadValue(doc, "io_threads", _config.ioThreads);
+    softLoadValue(doc, "io_byte_budget", _config.ioByteBudget);
+
+    if (auto memoryLimit = doc["history_memory_limit"]; memoryLimit)
+    {
+        if (memoryLimit.as<long long>() < 0)
+            _config.maxHistoryBytes = nullopt;
+        else
+            _config.maxHistoryBytes = memoryLimit.as<size_t>();
+    }
 
     if (auto profiles = doc["color_schemes"]; profiles)
     {
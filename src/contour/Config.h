@@ -18,7 +18,10 @@
 
 #include <terminal/Color.h>
 #include <terminal/Commands.h>          // CursorDisplay
+#include <terminal/IoReactor.h>
 #include <terminal/Process.h>
+#include <terminal/PtyReader.h>
+#include <terminal/PtyWriter.h>
 #include <terminal/Size.h>
 #include <terminal_view/ShaderConfig.h>
 #include <terminal_view/DecorationRenderer.h> // Decorator
@@ -81,6 +84,8 @@ struct TerminalProfile {
     terminal::Size terminalSize;
 
     std::optional<int> maxHistoryLineCount;
+    std::optional<int> maxResidentHistoryLineCount;
+    std::optional<size_t> maxHistoryBytes;
     int historyScrollMultiplier;
     bool autoScrollOnUpdate;
 
@@ -130,6 +135,30 @@ struct Config {
     // selection
     std::string wordDelimiters;
 
+    // maximum size in bytes of an OSC or DCS payload (such as OSC 52 clipboard data)
+    size_t maxPayloadSize = terminal::Sequence::DefaultMaxPayloadSize;
+
+    // maximum size in bytes the buffer reading the application's output may grow to
+    size_t maxReadBufferSize = terminal::PtyReader::DefaultMaxBufferSize;
+
+    // maximum time the application's output may be held back to be read in one go with what follows
+    std::chrono::milliseconds readLatency = terminal::PtyReader::DefaultLatency;
+
+    // maximum number of bytes of pasted text sent to the application at once
+    size_t pasteChunkSize = terminal::PtyWriter::DefaultPasteChunkSize;
+
+    // minimum time between sending two chunks of pasted text
+    std::chrono::milliseconds pasteChunkInterval = terminal::PtyWriter::DefaultPasteChunkInterval;
+
+    // number of threads reading the output of all terminals together, or 0 for a thread per terminal
+    size_t ioThreads = 0;
+
+    // maximum number of bytes read from one terminal before turning to the next, when reading is shared
+    size_t ioByteBudget = terminal::IoReactor::DefaultByteBudget;
+
+    // maximum size in bytes of the scrollback of all terminals together
+    std::optional<size_t> maxHistoryBytes;
+
     // input mapping
     std::map<QKeySequence, std::vector<actions::Action>> keyMappings;
     std::unordered_map<terminal::MouseEvent, std::vector<actions::Action>> mouseMappings;
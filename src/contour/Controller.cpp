@@ -40,6 +40,9 @@ Controller::Controller(std::string _programPath,
     // TODO: systrayIcon_: add icon
     // TODO: systrayIcon_: add context menu?
 
+    if (config_.ioThreads != 0 && terminal::IoReactor::supported())
+        ioReactor_ = make_unique<terminal::IoReactor>(config_.ioThreads, config_.ioByteBudget);
+
     connect(this, &Controller::started, this, [this]() { newWindow(); });
 
     self_ = this;
@@ -56,7 +59,8 @@ void Controller::newWindow()
     auto mainWindow = new TerminalWindow{
         config_,
         profileName_,
-        programPath_
+        programPath_,
+        ioReactor_.get()
     };
     mainWindow->show();
 
@@ -16,6 +16,8 @@
 #include <contour/Config.h>
 #include <contour/DebuggerService.h>
 
+#include <terminal/IoReactor.h>
+
 #include <QtCore/QThread>
 #include <QtWidgets/QSystemTrayIcon>
 
@@ -54,6 +56,9 @@ class Controller : public QThread {
     contour::config::Config config_;
     std::string profileName_;
 
+    // Reads the output of all terminal windows if configured to be shared, nullptr otherwise.
+    std::unique_ptr<terminal::IoReactor> ioReactor_;
+
     std::list<TerminalWindow*> terminalWindows_;
     std::unique_ptr<DebuggerService> debuggerService_;
 
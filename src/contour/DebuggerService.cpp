@@ -18,6 +18,7 @@
 
 #include <terminal/Commands.h>
 #include <terminal/Debugger.h>
+#include <terminal/HistoryBudget.h>
 
 #include <terminal_view/TerminalView.h>
 
@@ -51,6 +52,7 @@ namespace contour {
     inspect screen buffer        Prints screen including SGRs
     inspect screen text          Prints screen text only
     inspect render cache         Prints render cache
+    inspect memory               Prints memory usage of the scrollback
     inspect glyph metrics TEXT   Prints glyph metrics for given TEXT including fonts used for each glyph
     list windows                 Prints all available windows
     use window N                 Uses given window N for debugging
@@ -206,12 +208,43 @@ void DebuggerService::main()
                 screen.dumpState();
                 break;
             }
+            case 'm': // memory usage of scrollback
+            {
+                auto _l = scoped_lock{terminal};
+                auto const stats = screen.historyStats();
+                auto const residentCount = stats.lineCount - stats.swappedLineCount;
+                auto const ratio = [](size_t _a, size_t _b) { return _b != 0 ? double(_a) / double(_b) : 0.0; };
+                auto const limit = [](std::optional<size_t> _bytes) {
+                    return _bytes.has_value() ? fmt::format("{} bytes", *_bytes) : string("unlimited");
+                };
+                cout << fmt::format("Scrollback memory: {} bytes (limit: {})\n",
+                                    stats.bytes,
+                                    limit(screen.maxHistoryBytes()));
+                cout << fmt::format("Scrollback memory of all terminals: {} bytes in {} scrollbacks (limit: {})\n",
+                                    terminal::HistoryBudget::processUsage(),
+                                    terminal::HistoryBudget::processUserCount(),
+                                    limit(terminal::HistoryBudget::processLimit()));
+                cout << fmt::format("Scrollback lines: {} ({} compact, {} expanded, {} swapped out)\n",
+                                    stats.lineCount,
+                                    stats.compactLineCount,
+                                    residentCount - stats.compactLineCount,
+                                    stats.swappedLineCount);
+                cout << fmt::format("Compact lines: {} bytes, {:.1f} bytes per line, compression ratio {:.1f}\n",
+                                    stats.compactBytes,
+                                    ratio(stats.compactBytes, stats.compactLineCount),
+                                    ratio(stats.cellBytes, stats.compactBytes));
+                cout << fmt::format("Swap file: {} bytes, compression ratio {:.1f}\n",
+                                    stats.swapBytes,
+                                    ratio(stats.swapRawBytes, stats.swapBytes));
+                break;
+            }
             case '?': // help
             case 'h': // help
                 cout << "Available commands:\n"
                         "  (s)tep to next instruction\n"
                         "  (c)ontinue until next event (<LF>?)\n"
                         "  (i)nspect current state\n"
+                        "  (m)emory usage of scrollback\n"
                         "  (h)elp\n"
                         "  (q)uit\n"
                         "\n";
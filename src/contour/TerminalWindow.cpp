@@ -13,6 +13,7 @@
  */
 #include <contour/TerminalWindow.h>
 #include <contour/Actions.h>
+#include <terminal/HistoryBudget.h>
 #include <terminal/Metrics.h>
 
 #include <QtCore/QDebug>
@@ -307,12 +308,16 @@ namespace
     }
 }
 
-TerminalWindow::TerminalWindow(config::Config _config, string _profileName, string _programPath) :
+TerminalWindow::TerminalWindow(config::Config _config,
+                               string _profileName,
+                               string _programPath,
+                               terminal::IoReactor* _ioReactor) :
     now_{ chrono::steady_clock::now() },
     config_{ move(_config) },
     profileName_{ move(_profileName) },
     profile_{ *config_.profile(profileName_) },
     programPath_{ move(_programPath) },
+    ioReactor_{ _ioReactor },
     logger_{
         config_.logFilePath
             ? LoggingSink{config_.loggingMask, config_.logFilePath->string()}
@@ -339,6 +344,7 @@ TerminalWindow::TerminalWindow(config::Config _config, string _profileName, stri
 
     connect(this, SIGNAL(screenChanged(QScreen*)), this, SLOT(onScreenChanged(QScreen*)));
     connect(this, SIGNAL(frameSwapped()), this, SLOT(onFrameSwapped()));
+    connect(this, &TerminalWindow::terminalClosed, this, &TerminalWindow::onTerminalClosed, Qt::QueuedConnection);
 
     if (!loggingSink_.good())
         throw runtime_error{ "Failed to open log file." };
@@ -526,12 +532,24 @@ void TerminalWindow::initializeGL()
         ortho(0.0f, static_cast<float>(width()), 0.0f, static_cast<float>(height())),
         *config::Config::loadShaderConfig(config::ShaderClass::Background),
         *config::Config::loadShaderConfig(config::ShaderClass::Text),
-        ref(logger_)
+        ref(logger_),
+        ioReactor_
     );
 
+    terminalView_->terminal().setMaxResidentHistoryLineCount(profile().maxResidentHistoryLineCount);
+    terminalView_->terminal().setMaxHistoryBytes(profile().maxHistoryBytes);
+    terminal::HistoryBudget::setProcessLimit(config_.maxHistoryBytes);
     terminalView_->terminal().setLogRawOutput((config_.loggingMask & LogMask::RawOutput) != LogMask::None);
     terminalView_->terminal().setLogTraceOutput((config_.loggingMask & LogMask::TraceOutput) != LogMask::None);
     terminalView_->terminal().setTabWidth(profile().tabWidth);
+    terminalView_->terminal().setMaxPayloadSize(config_.maxPayloadSize);
+    terminalView_->terminal().setMaxReadBufferSize(config_.maxReadBufferSize);
+    terminalView_->terminal().setReadLatency(config_.readLatency);
+    terminalView_->terminal().setPasteChunkSize(config_.pasteChunkSize);
+    terminalView_->terminal().setPasteChunkInterval(config_.pasteChunkInterval);
+#if defined(CONTOUR_VT_METRICS)
+    terminalView_->terminal().setCommandRecording(true);
+#endif
 }
 
 void TerminalWindow::resizeEvent(QResizeEvent* _event)
@@ -590,8 +608,9 @@ void TerminalWindow::paintGL()
             for_each(begin(calls), end(calls), [](auto& _call) { _call(); });
         }
 
-        bool const reverseVideo =
-            terminalView_->terminal().screen().isModeEnabled(terminal::Mode::ReverseVideo);
+        // Rendered as a whole from the snapshot, as the screen may be written to meanwhile.
+        auto const& snapshot = terminalView_->terminal().snapshot(now_);
+        bool const reverseVideo = snapshot.reverseVideo();
 
         QVector4D const bg = Renderer::canonicalColor(
             reverseVideo
@@ -608,7 +627,7 @@ void TerminalWindow::paintGL()
         glClear(GL_COLOR_BUFFER_BIT);
 
         //terminal::view::render(terminalView_, now_);
-        STATS_SET(updatesSinceRendering) terminalView_->render(now_, renderingPressure_);
+        STATS_SET(updatesSinceRendering) terminalView_->render(snapshot, now_, renderingPressure_);
     }
     catch (exception const& e)
     {
@@ -673,6 +692,12 @@ bool TerminalWindow::reloadConfigValues(config::Config _newConfig, string const&
             : LoggingSink{_newConfig.loggingMask, &cout};
 
     terminalView_->terminal().setWordDelimiters(_newConfig.wordDelimiters);
+    terminalView_->terminal().setMaxPayloadSize(_newConfig.maxPayloadSize);
+    terminalView_->terminal().setMaxReadBufferSize(_newConfig.maxReadBufferSize);
+    terminalView_->terminal().setReadLatency(_newConfig.readLatency);
+    terminalView_->terminal().setPasteChunkSize(_newConfig.pasteChunkSize);
+    terminalView_->terminal().setPasteChunkInterval(_newConfig.pasteChunkInterval);
+    terminal::HistoryBudget::setProcessLimit(_newConfig.maxHistoryBytes);
 
     terminalView_->terminal().setLogRawOutput((_newConfig.loggingMask & LogMask::RawOutput) != LogMask::None);
     terminalView_->terminal().setLogTraceOutput((_newConfig.loggingMask & LogMask::TraceOutput) != LogMask::None);
@@ -1186,6 +1211,8 @@ void TerminalWindow::setProfile(config::TerminalProfile newProfile)
         terminalView_->setTerminalSize(newScreenSize);
         // TODO: maybe update margin after this call?
     terminalView_->terminal().setMaxHistoryLineCount(newProfile.maxHistoryLineCount);
+    terminalView_->terminal().setMaxResidentHistoryLineCount(newProfile.maxResidentHistoryLineCount);
+    terminalView_->terminal().setMaxHistoryBytes(newProfile.maxHistoryBytes);
 
     terminalView_->setColorProfile(newProfile.colors);
 
@@ -1214,7 +1241,7 @@ string TerminalWindow::extractSelectionText()
     string text;
     string currentLine;
 
-    terminalView_->terminal().screen().renderSelection([&](Coordinate const& _pos, Cell const& _cell) {
+    terminalView_->terminal().screen().renderSelection([&](Coordinate const& _pos, CellView const& _cell) {
         if (_pos.column <= lastColumn)
         {
             text += currentLine;
@@ -1233,7 +1260,6 @@ string TerminalWindow::extractLastMarkRange()
 {
     using terminal::Coordinate;
     using terminal::cursor_pos_t;
-    using terminal::Cell;
 
     auto const _l = std::lock_guard{terminalView_->terminal()};
 
@@ -1431,9 +1457,6 @@ void TerminalWindow::commands(terminal::CommandList const& _commands)
 
     if (profile().autoScrollOnUpdate && terminalView_->terminal().scrollOffset())
         terminalView_->terminal().scrollToBottom();
-
-    if (setScreenDirty())
-        QCoreApplication::postEvent(this, new QEvent(QEvent::UpdateRequest));
 }
 
 void TerminalWindow::resizeWindow(int _width, int _height, bool _inPixels)
@@ -1497,14 +1520,38 @@ void TerminalWindow::resizeWindow(int _width, int _height, bool _inPixels)
     }
 }
 
+void TerminalWindow::screenUpdated()
+{
+    // The screen is marked dirty only once the update can be rendered from the published snapshot,
+    // as a frame painted earlier may not include it, with no other frame being requested then.
+    if (setScreenDirty())
+        QCoreApplication::postEvent(this, new QEvent(QEvent::UpdateRequest));
+}
+
 void TerminalWindow::onClosed()
+{
+    // This is invoked by the thread reading the terminal's output, which might be shared
+    // by other terminals, so the process is reaped by the GUI thread instead.
+    emit terminalClosed();
+}
+
+void TerminalWindow::onTerminalClosed()
 {
     using terminal::Process;
 
     // TODO: silently quit instantly when window/terminal has been spawned already since N seconds.
     // This message should only be printed for "fast" terminal terminations.
 
-    terminal::Process::ExitStatus const ec = terminalView_->process().wait();
+    // The PTY may be hung up before the process has terminated, so this never waits for it,
+    // but checks back later instead.
+    auto const status = terminalView_->process().checkStatus();
+    if (!status)
+    {
+        QTimer::singleShot(chrono::milliseconds(100), this, &TerminalWindow::onTerminalClosed);
+        return;
+    }
+
+    terminal::Process::ExitStatus const ec = *status;
     if (holds_alternative<Process::SignalExit>(ec))
         terminalView_->terminal().writeToScreen(fmt::format("\r\nShell has terminated with signal {} ({}).",
                                                             get<Process::SignalExit>(ec).signum,
@@ -1526,6 +1573,9 @@ void TerminalWindow::dumpState()
 {
     terminalView_->terminal().screen().currentBuffer().dumpState("Dump screen state.");
     terminalView_->renderer().dumpState(std::cout);
+
+    auto const output = terminalView_->terminal().outputStatistics();
+    std::cout << fmt::format("PTY output: {} bytes/s, {} reads/s\n", output.bytesPerSecond, output.readsPerSecond);
 }
 // }}}
 
@@ -47,7 +47,10 @@ class TerminalWindow :
     Q_OBJECT
 
   public:
-    TerminalWindow(config::Config _config, std::string _profileName, std::string _programPath);
+    TerminalWindow(config::Config _config,
+                   std::string _profileName,
+                   std::string _programPath,
+                   terminal::IoReactor* _ioReactor = nullptr);
     ~TerminalWindow() override;
 
     static QSurfaceFormat surfaceFormat();
@@ -78,6 +81,7 @@ class TerminalWindow :
   public Q_SLOTS:
     void onFrameSwapped();
     void onScreenChanged(QScreen* _screen);
+    void onTerminalClosed();
 
   private:
     terminal::view::FontConfig loadFonts(config::TerminalProfile const& _profile);
@@ -119,10 +123,12 @@ class TerminalWindow :
     void onClosed() override;
     void onSelectionComplete() override;
     void resizeWindow(int /*_width*/, int /*_height*/, bool /*_unitInPixels*/) override;
+    void screenUpdated() override;
     void setWindowTitle(std::string_view const& /*_title*/) override;
 
   signals:
     void showNotification(QString const& _title, QString const& _body);
+    void terminalClosed();
 
   private:
     /// Declares the screen-dirtiness-vs-rendering state.
@@ -188,6 +194,7 @@ class TerminalWindow :
     std::string profileName_;
     config::TerminalProfile profile_;
     std::string programPath_;
+    terminal::IoReactor* ioReactor_; // reading the terminal's output if shared, nullptr otherwise
     std::ofstream loggingSink_;
     LoggingSink logger_;
     crispy::text::FontLoader fontLoader_;
@@ -13,7 +13,16 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define CRISPY_BASE64_SSSE3 1
+    #include <immintrin.h>
+#endif
 
 namespace crispy::base64 {
 
@@ -205,4 +214,159 @@ inline std::string decode(const std::string_view& input)
     return output;
 }
 
+namespace detail
+{
+#if defined(CRISPY_BASE64_SSSE3)
+    inline bool ssse3Supported() noexcept
+    {
+        static bool const supported = __builtin_cpu_supports("ssse3");
+        return supported;
+    }
+
+    /// Decodes blocks of 16 characters from @p _input into 12 bytes each at @p _output,
+    /// stopping at the first block containing anything but the base64 alphabet (including padding).
+    ///
+    /// @p _output must provide 4 bytes of extra room beyond the decoded bytes.
+    ///
+    /// @returns the number of characters consumed, which is a multiple of 16.
+    __attribute__((target("ssse3")))
+    inline size_t decodeBlocksSSSE3(char const* _input, size_t _size, char* _output) noexcept
+    {
+        // Character classes by low and high nibble, whose bitwise AND is non-zero for
+        // anything outside of the alphabet, as well as the per-class offsets to the 6-bit values.
+        auto const lutLow = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        auto const lutHigh = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        auto const lutOffset = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                             0, 0, 0, 0, 0, 0, 0, 0);
+        auto const mask2F = _mm_set1_epi8(0x2F);
+        auto const pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+        size_t i = 0;
+        for (; i + 16 <= _size; i += 16)
+        {
+            auto const input = _mm_loadu_si128(reinterpret_cast<__m128i const*>(_input + i));
+            auto const high = _mm_and_si128(_mm_srli_epi32(input, 4), mask2F);
+            auto const low = _mm_and_si128(input, mask2F);
+            auto const invalid = _mm_and_si128(_mm_shuffle_epi8(lutLow, low), _mm_shuffle_epi8(lutHigh, high));
+            if (_mm_movemask_epi8(_mm_cmpgt_epi8(invalid, _mm_setzero_si128())) != 0)
+                break;
+
+            // '/' shares its high nibble with '+', but needs a different offset.
+            auto const offset = _mm_shuffle_epi8(lutOffset, _mm_add_epi8(_mm_cmpeq_epi8(input, mask2F), high));
+            auto const values = _mm_add_epi8(input, offset);
+
+            // Merge the four 6-bit values of each 32-bit lane into 24 bits and pack those.
+            auto const pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+            auto const triples = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(_output), _mm_shuffle_epi8(triples, pack));
+            _output += 12;
+        }
+        return i;
+    }
+#endif
+}
+
+/// Decodes base64 incrementally, as its input arrives in arbitrarily sized pieces.
+///
+/// Input is buffered and decoded block-wise, using SSSE3 if supported by the CPU.
+/// Padding terminates the data, whereas any other character outside of the alphabet
+/// renders the input invalid.
+class Decoder {
+  public:
+    void put(char _ch)
+    {
+        if (pending_ == buffer_.size())
+            flush();
+        buffer_[pending_++] = _ch;
+    }
+
+    void put(std::string_view _input)
+    {
+        for (char const ch : _input)
+            put(ch);
+    }
+
+    /// Decodes any pending input.
+    ///
+    /// @returns whether or not all input was valid base64.
+    bool finish()
+    {
+        flush();
+        // A single character of a final group does not even make up a byte.
+        return valid_ && bitCount_ != 6;
+    }
+
+    std::string const& output() const noexcept { return output_; }
+    std::string& output() noexcept { return output_; }
+
+    void reset()
+    {
+        pending_ = 0;
+        bits_ = 0;
+        bitCount_ = 0;
+        padding_ = false;
+        valid_ = true;
+        output_.clear();
+    }
+
+  private:
+    void flush()
+    {
+        size_t i = 0;
+        while (i < pending_ && valid_)
+        {
+#if defined(CRISPY_BASE64_SSSE3)
+            if (bitCount_ == 0 && !padding_ && detail::ssse3Supported())
+            {
+                auto const offset = output_.size();
+                output_.resize(offset + (pending_ - i) / 16 * 12 + 4);
+                auto const count = detail::decodeBlocksSSSE3(buffer_.data() + i, pending_ - i, output_.data() + offset);
+                output_.resize(offset + count / 16 * 12);
+                i += count;
+            }
+#endif
+            // Decode scalar up to the next block boundary, e.g. across padding or invalid input.
+            for (auto const end = std::min(pending_, i + 16); i < end; ++i)
+                decode(buffer_[i]);
+        }
+        pending_ = 0;
+    }
+
+    void decode(char _ch)
+    {
+        if (_ch == '=')
+        {
+            padding_ = true;
+            return;
+        }
+
+        auto const value = detail::indexmap[static_cast<uint8_t>(_ch)];
+        if (value > 63 || padding_)
+        {
+            valid_ = false;
+            return;
+        }
+
+        bits_ = (bits_ << 6) | value;
+        bitCount_ += 6;
+        if (bitCount_ >= 8)
+        {
+            bitCount_ -= 8;
+            output_.push_back(static_cast<char>(bits_ >> bitCount_));
+            bits_ &= (1u << bitCount_) - 1;
+        }
+    }
+
+  private:
+    std::array<char, 1024> buffer_{};
+    size_t pending_ = 0;
+    unsigned bits_ = 0;
+    unsigned bitCount_ = 0;
+    bool padding_ = false;
+    bool valid_ = true;
+    std::string output_;
+};
+
 } // end namespace xzero
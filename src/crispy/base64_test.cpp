@@ -33,3 +33,56 @@ TEST_CASE("base64.decode", "[base64]")
     CHECK("abcd" == base64::decode("YWJjZA=="));
     CHECK("foo:bar" == base64::decode("Zm9vOmJhcg=="));
 }
+
+namespace
+{
+    std::string decodeIncrementally(std::string_view _input, size_t _chunkSize, bool& _valid)
+    {
+        auto decoder = base64::Decoder{};
+        for (size_t i = 0; i < _input.size(); i += _chunkSize)
+            decoder.put(_input.substr(i, _chunkSize));
+        _valid = decoder.finish();
+        return decoder.output();
+    }
+}
+
+TEST_CASE("base64.Decoder", "[base64]")
+{
+    bool valid = false;
+    CHECK("a" == decodeIncrementally("YQ==", 1, valid));
+    CHECK(valid);
+    CHECK("abcd" == decodeIncrementally("YWJjZA==", 3, valid));
+    CHECK(valid);
+    CHECK("foo:bar" == decodeIncrementally("Zm9vOmJhcg", 5, valid));
+    CHECK(valid);
+
+    decodeIncrementally("YW?j", 4, valid);
+    CHECK_FALSE(valid);
+    decodeIncrementally("YQ==YQ==", 4, valid);
+    CHECK_FALSE(valid);
+    decodeIncrementally("YWJjZ", 5, valid);
+    CHECK_FALSE(valid);
+}
+
+TEST_CASE("base64.Decoder.large", "[base64]")
+{
+    // Large enough to pass the internal buffer a few times, and to be decoded block-wise.
+    std::string text;
+    for (int i = 0; i < 10000; ++i)
+        text.push_back(static_cast<char>(i * 7 + i / 256));
+    auto const encoded = base64::encode(text);
+
+    for (size_t const chunkSize : {size_t{1}, size_t{13}, size_t{1000}, encoded.size()})
+    {
+        bool valid = false;
+        CHECK(text == decodeIncrementally(encoded, chunkSize, valid));
+        CHECK(valid);
+    }
+
+    // Invalid input in the middle of a block is detected.
+    auto invalid = encoded;
+    invalid[5000] = '!';
+    bool valid = true;
+    decodeIncrementally(invalid, 77, valid);
+    CHECK_FALSE(valid);
+}
@@ -0,0 +1,188 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+/// Byte oriented LZ77 compression in the spirit of LZ4.
+///
+/// Fast rather than strong, meant for data with many repetitions, such as terminal cells.
+///
+/// The compressed data is a series of sequences, each made of a token byte holding the literal
+/// length (upper 4 bits) and match length minus 4 (lower 4 bits), optional extra literal length
+/// bytes, the literals, a 16-bit little endian match offset, and optional extra match length bytes.
+/// A length field of 15 is continued by bytes that are added up until one is less than 255.
+/// The last sequence only consists of the token, literal length and literals.
+namespace crispy::lz {
+
+namespace detail
+{
+    constexpr size_t MinMatch = 4;
+    constexpr size_t MaxOffset = 0xFFFF;
+    constexpr unsigned HashBits = 13;
+
+    inline uint32_t read32(uint8_t const* _data) noexcept
+    {
+        uint32_t value;
+        std::memcpy(&value, _data, sizeof(value));
+        return value;
+    }
+
+    constexpr uint32_t hash(uint32_t _value) noexcept
+    {
+        return (_value * 2654435761u) >> (32 - HashBits);
+    }
+
+    inline void writeLength(std::vector<uint8_t>& _output, size_t _length)
+    {
+        for (; _length >= 255; _length -= 255)
+            _output.push_back(255);
+        _output.push_back(static_cast<uint8_t>(_length));
+    }
+
+    inline void writeLiterals(std::vector<uint8_t>& _output, uint8_t _matchNibble, uint8_t const* _literals, size_t _count)
+    {
+        _output.push_back(static_cast<uint8_t>((std::min(_count, size_t{15}) << 4) | _matchNibble));
+        if (_count >= 15)
+            writeLength(_output, _count - 15);
+        _output.insert(_output.end(), _literals, _literals + _count);
+    }
+}
+
+/// Compresses @p _size bytes at @p _data.
+inline std::vector<uint8_t> compress(uint8_t const* _data, size_t _size)
+{
+    using namespace detail;
+
+    std::vector<uint8_t> output;
+    output.reserve(_size / 4 + 16);
+
+    std::vector<uint32_t> table(size_t{1} << HashBits, 0);
+
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + MinMatch <= _size)
+    {
+        auto const value = read32(_data + i);
+        auto& slot = table[hash(value)];
+        size_t const candidate = slot;
+        slot = static_cast<uint32_t>(i);
+
+        if (candidate >= i || i - candidate > MaxOffset || read32(_data + candidate) != value)
+        {
+            ++i;
+            continue;
+        }
+
+        size_t length = MinMatch;
+        while (i + length < _size && _data[candidate + length] == _data[i + length])
+            ++length;
+
+        auto const extra = length - MinMatch;
+        writeLiterals(output, static_cast<uint8_t>(std::min(extra, size_t{15})), _data + anchor, i - anchor);
+
+        auto const offset = i - candidate;
+        output.push_back(static_cast<uint8_t>(offset & 0xFF));
+        output.push_back(static_cast<uint8_t>(offset >> 8));
+        if (extra >= 15)
+            writeLength(output, extra - 15);
+
+        i += length;
+        anchor = i;
+    }
+
+    writeLiterals(output, 0, _data + anchor, _size - anchor);
+    return output;
+}
+
+inline std::vector<uint8_t> compress(std::vector<uint8_t> const& _data)
+{
+    return compress(_data.data(), _data.size());
+}
+
+/// Decompresses @p _size bytes at @p _data, that are known to decompress into @p _originalSize bytes.
+///
+/// @returns the decompressed data or std::nullopt if the input is malformed.
+inline std::optional<std::vector<uint8_t>> decompress(uint8_t const* _data, size_t _size, size_t _originalSize)
+{
+    using namespace detail;
+
+    std::vector<uint8_t> output(_originalSize);
+    uint8_t* out = output.data();
+    uint8_t* const outEnd = out + _originalSize;
+    uint8_t const* in = _data;
+    uint8_t const* const inEnd = _data + _size;
+
+    auto const readLength = [&](size_t _length) -> std::optional<size_t> {
+        if (_length == 15)
+        {
+            uint8_t byte = 255;
+            while (byte == 255)
+            {
+                if (in == inEnd)
+                    return std::nullopt;
+                byte = *in++;
+                _length += byte;
+            }
+        }
+        return _length;
+    };
+
+    while (in != inEnd)
+    {
+        auto const token = *in++;
+
+        auto const literals = readLength(token >> 4);
+        if (!literals || *literals > static_cast<size_t>(inEnd - in) || *literals > static_cast<size_t>(outEnd - out))
+            return std::nullopt;
+        out = std::copy_n(in, *literals, out);
+        in += *literals;
+
+        if (in == inEnd)
+            break;
+
+        if (inEnd - in < 2)
+            return std::nullopt;
+        auto const offset = static_cast<size_t>(in[0] | (in[1] << 8));
+        in += 2;
+
+        auto const extra = readLength(token & 0x0F);
+        if (!extra || offset == 0 || offset > static_cast<size_t>(out - output.data()))
+            return std::nullopt;
+        auto const length = *extra + MinMatch;
+        if (length > static_cast<size_t>(outEnd - out))
+            return std::nullopt;
+
+        // Matches may overlap with their own output, so copy byte by byte.
+        uint8_t const* from = out - offset;
+        for (size_t k = 0; k < length; ++k)
+            *out++ = *from++;
+    }
+
+    if (out != outEnd)
+        return std::nullopt;
+
+    return output;
+}
+
+inline std::optional<std::vector<uint8_t>> decompress(std::vector<uint8_t> const& _data, size_t _originalSize)
+{
+    return decompress(_data.data(), _data.size(), _originalSize);
+}
+
+} // end namespace
@@ -0,0 +1,75 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/lz.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    vector<uint8_t> bytes(string const& _text)
+    {
+        return vector<uint8_t>(_text.begin(), _text.end());
+    }
+
+    vector<uint8_t> roundtrip(vector<uint8_t> const& _data)
+    {
+        auto const compressed = crispy::lz::compress(_data);
+        auto const decompressed = crispy::lz::decompress(compressed, _data.size());
+        REQUIRE(decompressed.has_value());
+        return *decompressed;
+    }
+}
+
+TEST_CASE("lz.roundtrip")
+{
+    CHECK(roundtrip(bytes("")) == bytes(""));
+    CHECK(roundtrip(bytes("abc")) == bytes("abc"));
+    CHECK(roundtrip(bytes("Hello, World! Hello, World! Hello, World!")) == bytes("Hello, World! Hello, World! Hello, World!"));
+
+    auto noise = vector<uint8_t>(100'000);
+    uint32_t seed = 42;
+    for (auto& byte: noise)
+    {
+        seed = seed * 1103515245 + 12345;
+        byte = static_cast<uint8_t>(seed >> 16);
+    }
+    CHECK(roundtrip(noise) == noise);
+}
+
+TEST_CASE("lz.runs")
+{
+    // Long runs are encoded as matches overlapping with their own output.
+    auto const blanks = vector<uint8_t>(100'000, ' ');
+    auto const compressed = crispy::lz::compress(blanks);
+    CHECK(compressed.size() < 500);
+    CHECK(roundtrip(blanks) == blanks);
+}
+
+TEST_CASE("lz.malformed")
+{
+    auto const data = bytes("abcdabcdabcdabcdabcdabcdabcdabcd");
+    auto const compressed = crispy::lz::compress(data);
+
+    CHECK_FALSE(crispy::lz::decompress(compressed, data.size() - 1).has_value());
+    CHECK_FALSE(crispy::lz::decompress(compressed, data.size() + 1).has_value());
+    CHECK_FALSE(crispy::lz::decompress(compressed.data(), 3, data.size()).has_value());
+
+    // A match referring to before the start of the output.
+    auto const invalidOffset = vector<uint8_t>{0x10, 'a', 0x05, 0x00};
+    CHECK_FALSE(crispy::lz::decompress(invalidOffset, 5).has_value());
+}
@@ -0,0 +1,192 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace crispy {
+
+/// Double-ended queue of bounded capacity, stored in a circular buffer.
+///
+/// Removing elements from either end does not destroy them. Their slots are handed out again,
+/// still holding the removed value, by the next recycle_back() or recycle_front(). That way,
+/// resources owned by an element (such as heap memory) are reused rather than released and
+/// reacquired when the ring is used as a sliding window.
+template <typename T>
+class ring {
+  public:
+    template <typename Ring, typename U>
+    class basic_iterator {
+      public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::remove_const_t<U>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = U*;
+        using reference = U&;
+
+        basic_iterator() = default;
+        basic_iterator(Ring* _ring, difference_type _index) noexcept : ring_{_ring}, index_{_index} {}
+
+        // Allows converting an iterator into a const_iterator.
+        template <typename R, typename V, std::enable_if_t<std::is_convertible_v<V*, U*>, int> = 0>
+        basic_iterator(basic_iterator<R, V> const& _other) noexcept : ring_{_other.ring_}, index_{_other.index_} {}
+
+        reference operator*() const noexcept { return (*ring_)[static_cast<std::size_t>(index_)]; }
+        pointer operator->() const noexcept { return &**this; }
+        reference operator[](difference_type _n) const noexcept { return *(*this + _n); }
+
+        basic_iterator& operator++() noexcept { ++index_; return *this; }
+        basic_iterator& operator--() noexcept { --index_; return *this; }
+        basic_iterator operator++(int) noexcept { auto old = *this; ++index_; return old; }
+        basic_iterator operator--(int) noexcept { auto old = *this; --index_; return old; }
+
+        basic_iterator& operator+=(difference_type _n) noexcept { index_ += _n; return *this; }
+        basic_iterator& operator-=(difference_type _n) noexcept { index_ -= _n; return *this; }
+
+        friend basic_iterator operator+(basic_iterator _it, difference_type _n) noexcept { return _it += _n; }
+        friend basic_iterator operator+(difference_type _n, basic_iterator _it) noexcept { return _it += _n; }
+        friend basic_iterator operator-(basic_iterator _it, difference_type _n) noexcept { return _it -= _n; }
+        friend difference_type operator-(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ - b.index_; }
+
+        friend bool operator==(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ == b.index_; }
+        friend bool operator!=(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ != b.index_; }
+        friend bool operator<(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ < b.index_; }
+        friend bool operator>(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ > b.index_; }
+        friend bool operator<=(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ <= b.index_; }
+        friend bool operator>=(basic_iterator const& a, basic_iterator const& b) noexcept { return a.index_ >= b.index_; }
+
+      private:
+        template <typename, typename> friend class basic_iterator;
+
+        Ring* ring_ = nullptr;
+        difference_type index_ = 0;
+    };
+
+    using value_type = T;
+    using reference = T&;
+    using const_reference = T const&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = basic_iterator<ring, T>;
+    using const_iterator = basic_iterator<ring const, T const>;
+
+    ring() = default;
+    explicit ring(size_type _capacity) : storage_(_capacity) {}
+    ring(size_type _count, T const& _value) : storage_(_count, _value), size_{_count} {}
+
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return storage_.size(); }
+    bool empty() const noexcept { return size_ == 0; }
+    bool full() const noexcept { return size_ == storage_.size(); }
+
+    T& operator[](size_type _i) noexcept { return storage_[slot(_i)]; }
+    T const& operator[](size_type _i) const noexcept { return storage_[slot(_i)]; }
+
+    T& at(size_type _i)
+    {
+        if (_i >= size_)
+            throw std::out_of_range("crispy::ring::at");
+        return (*this)[_i];
+    }
+
+    T const& at(size_type _i) const { return const_cast<ring&>(*this).at(_i); }
+
+    T& front() noexcept { return (*this)[0]; }
+    T const& front() const noexcept { return (*this)[0]; }
+    T& back() noexcept { return (*this)[size_ - 1]; }
+    T const& back() const noexcept { return (*this)[size_ - 1]; }
+
+    iterator begin() noexcept { return iterator{this, 0}; }
+    iterator end() noexcept { return iterator{this, static_cast<difference_type>(size_)}; }
+    const_iterator begin() const noexcept { return const_iterator{this, 0}; }
+    const_iterator end() const noexcept { return const_iterator{this, static_cast<difference_type>(size_)}; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    /// Extends the ring by one element at the back and returns it.
+    ///
+    /// The element still holds the value last stored in its slot, or a value-initialized T.
+    /// @pre !full()
+    T& recycle_back() noexcept
+    {
+        assert(!full());
+        ++size_;
+        return back();
+    }
+
+    /// Extends the ring by one element at the front and returns it.
+    ///
+    /// The element still holds the value last stored in its slot, or a value-initialized T.
+    /// @pre !full()
+    T& recycle_front() noexcept
+    {
+        assert(!full());
+        first_ = first_ != 0 ? first_ - 1 : storage_.size() - 1;
+        ++size_;
+        return front();
+    }
+
+    /// Removes @p _n elements from the front, keeping them for recycling.
+    void pop_front(size_type _n = 1) noexcept
+    {
+        assert(_n <= size_);
+        first_ = slot(_n);
+        size_ -= _n;
+    }
+
+    /// Removes @p _n elements from the back, keeping them for recycling.
+    void pop_back(size_type _n = 1) noexcept
+    {
+        assert(_n <= size_);
+        size_ -= _n;
+    }
+
+    /// Changes the capacity to @p _capacity, keeping all elements.
+    ///
+    /// Also moves the elements back to the beginning of the underlying storage, so this is
+    /// linear in the capacity. Slots beyond the new capacity are destroyed.
+    ///
+    /// @pre _capacity >= size()
+    void set_capacity(size_type _capacity)
+    {
+        assert(_capacity >= size_);
+        std::rotate(storage_.begin(), std::next(storage_.begin(), static_cast<difference_type>(first_)), storage_.end());
+        first_ = 0;
+        storage_.resize(_capacity);
+    }
+
+  private:
+    size_type slot(size_type _i) const noexcept
+    {
+        auto const i = first_ + _i;
+        return i < storage_.size() ? i : i - storage_.size();
+    }
+
+    std::vector<T> storage_;
+    size_type first_ = 0;
+    size_type size_ = 0;
+};
+
+template <typename T> auto begin(ring<T>& _ring) noexcept { return _ring.begin(); }
+template <typename T> auto end(ring<T>& _ring) noexcept { return _ring.end(); }
+template <typename T> auto begin(ring<T> const& _ring) noexcept { return _ring.begin(); }
+template <typename T> auto end(ring<T> const& _ring) noexcept { return _ring.end(); }
+
+} // end namespace
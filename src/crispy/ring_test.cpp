@@ -0,0 +1,110 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/ring.h>
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    template <typename T>
+    vector<T> toVector(crispy::ring<T> const& _ring)
+    {
+        return vector<T>(_ring.begin(), _ring.end());
+    }
+}
+
+TEST_CASE("ring.recycle_back")
+{
+    auto r = crispy::ring<int>(3);
+    CHECK(r.empty());
+
+    r.recycle_back() = 1;
+    r.recycle_back() = 2;
+    r.recycle_back() = 3;
+    CHECK(r.full());
+    CHECK(toVector(r) == vector{1, 2, 3});
+
+    r.pop_front();
+    CHECK(r.size() == 2);
+    CHECK(r.front() == 2);
+
+    // The slot of the popped element is handed out again, still holding its value.
+    CHECK(r.recycle_back() == 1);
+    r.back() = 4;
+    CHECK(toVector(r) == vector{2, 3, 4});
+    CHECK(r[0] == 2);
+    CHECK(r.at(2) == 4);
+    CHECK_THROWS_AS(r.at(3), std::out_of_range);
+}
+
+TEST_CASE("ring.recycle_front")
+{
+    auto r = crispy::ring<int>(3, 0);
+    iota(r.begin(), r.end(), 1);
+    CHECK(toVector(r) == vector{1, 2, 3});
+
+    r.pop_back(2);
+    CHECK(toVector(r) == vector{1});
+
+    CHECK(r.recycle_front() == 3);
+    CHECK(r.recycle_front() == 2);
+    CHECK(toVector(r) == vector{2, 3, 1});
+}
+
+TEST_CASE("ring.set_capacity")
+{
+    auto r = crispy::ring<string>(3);
+    r.recycle_back() = "a";
+    r.recycle_back() = "b";
+    r.recycle_back() = "c";
+    r.pop_front();
+    r.recycle_back() = "d";
+    CHECK(toVector(r) == vector<string>{"b", "c", "d"});
+
+    r.set_capacity(5);
+    CHECK(r.capacity() == 5);
+    CHECK(toVector(r) == vector<string>{"b", "c", "d"});
+    r.recycle_back() = "e";
+    CHECK(toVector(r) == vector<string>{"b", "c", "d", "e"});
+
+    r.pop_front(2);
+    r.set_capacity(2);
+    CHECK(toVector(r) == vector<string>{"d", "e"});
+    CHECK(r.full());
+}
+
+TEST_CASE("ring.iterator")
+{
+    auto r = crispy::ring<int>(4);
+    for (int i = 1; i <= 4; ++i)
+        r.recycle_back() = i;
+    r.pop_front(2);
+    r.recycle_back() = 5;
+    r.recycle_back() = 6;
+
+    CHECK(r.end() - r.begin() == 4);
+    CHECK(*next(r.begin(), 2) == 5);
+    CHECK(r.begin()[3] == 6);
+
+    rotate(r.begin(), next(r.begin()), r.end());
+    CHECK(toVector(r) == vector{4, 5, 6, 3});
+
+    crispy::ring<int>::const_iterator i = r.begin();
+    CHECK(*i == 4);
+}
@@ -0,0 +1,139 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace crispy {
+
+/// Bounded queue handing elements from a single producer thread to a single consumer thread.
+///
+/// Elements are filled and consumed in place. Their slots are never destroyed but handed out
+/// to the producer again, still holding the consumed value, so that resources owned by an element
+/// (such as heap memory) are reused rather than released and reacquired.
+///
+/// Pushing and popping are lock-free. Only waiting for a free slot or an element to arrive,
+/// when the queue is full or empty respectively, blocks on a mutex.
+template <typename T>
+class spsc_queue {
+  public:
+    explicit spsc_queue(size_t _capacity) : slots_(_capacity) { assert(_capacity != 0); }
+
+    size_t capacity() const noexcept { return slots_.size(); }
+    size_t size() const noexcept { return tail_.load() - head_.load(); }
+    bool empty() const noexcept { return size() == 0; }
+    bool full() const noexcept { return size() == capacity(); }
+
+    // {{{ producer
+    /// @returns the slot to be filled and pushed next, or nullptr if the queue is full.
+    T* try_back() noexcept
+    {
+        auto const tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == capacity())
+            return nullptr;
+        return &slots_[tail % capacity()];
+    }
+
+    /// @returns the slot to be filled and pushed next, waiting for one to become free.
+    T& wait_back()
+    {
+        if (T* slot = try_back(); slot)
+            return *slot;
+
+        auto lock = std::unique_lock{mutex_};
+        producerWaiting_.store(true);
+        notFull_.wait(lock, [&]() { return !full(); });
+        producerWaiting_.store(false);
+        return *try_back();
+    }
+
+    /// Hands the slot returned by try_back() or wait_back() over to the consumer.
+    void push()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1);
+        notify(consumerWaiting_, notEmpty_);
+    }
+
+    /// Tells the consumer that nothing is pushed anymore, once it has consumed what is left.
+    void close()
+    {
+        closed_.store(true);
+        notify(consumerWaiting_, notEmpty_);
+    }
+    // }}}
+
+    // {{{ consumer
+    /// @returns the element to be consumed next, or nullptr if the queue is empty.
+    T* try_front() noexcept
+    {
+        auto const head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+            return nullptr;
+        return &slots_[head % capacity()];
+    }
+
+    /// @returns the element to be consumed next, waiting for one to arrive,
+    ///          or nullptr if the queue has been closed and everything consumed.
+    T* wait_front()
+    {
+        if (T* element = try_front(); element)
+            return element;
+
+        auto lock = std::unique_lock{mutex_};
+        consumerWaiting_.store(true);
+        notEmpty_.wait(lock, [&]() { return !empty() || closed_.load(); });
+        consumerWaiting_.store(false);
+        return try_front();
+    }
+
+    /// Hands the slot of the element returned by try_front() or wait_front() back to the producer.
+    void pop()
+    {
+        head_.store(head_.load(std::memory_order_relaxed) + 1);
+        notify(producerWaiting_, notFull_);
+    }
+    // }}}
+
+  private:
+    void notify(std::atomic<bool> const& _waiting, std::condition_variable& _condition)
+    {
+        // The waiter raises its flag before checking the queue, and we check the flag after
+        // changing the queue, so that (sequentially consistent) either one sees the other's change.
+        if (!_waiting.load())
+            return;
+
+        // Taking the mutex orders the notification after the waiter has gone to sleep.
+        { auto const _l = std::lock_guard{mutex_}; }
+        _condition.notify_one();
+    }
+
+    std::vector<T> slots_;
+    std::atomic<size_t> head_{0}; // number of elements consumed
+    std::atomic<size_t> tail_{0}; // number of elements pushed
+    std::atomic<bool> closed_{false};
+
+    std::atomic<bool> producerWaiting_{false};
+    std::atomic<bool> consumerWaiting_{false};
+
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
+
+} // end namespace
@@ -0,0 +1,87 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/spsc_queue.h>
+
+#include <catch2/catch.hpp>
+
+#include <thread>
+#include <vector>
+
+using namespace std;
+using crispy::spsc_queue;
+
+TEST_CASE("spsc_queue.basic")
+{
+    auto queue = spsc_queue<int>{2};
+    CHECK(queue.empty());
+    CHECK(queue.try_front() == nullptr);
+
+    *queue.try_back() = 1;
+    queue.push();
+    queue.wait_back() = 2;
+    queue.push();
+    CHECK(queue.full());
+    CHECK(queue.try_back() == nullptr);
+
+    CHECK(*queue.try_front() == 1);
+    queue.pop();
+    CHECK(*queue.wait_front() == 2);
+    queue.pop();
+    CHECK(queue.empty());
+
+    queue.close();
+    CHECK(queue.wait_front() == nullptr);
+}
+
+TEST_CASE("spsc_queue.recycle")
+{
+    // Slots are handed out again with the value consumed, keeping its resources.
+    auto queue = spsc_queue<vector<int>>{1};
+    auto& slot = queue.wait_back();
+    slot.assign(100, 1);
+    queue.push();
+    queue.wait_front();
+    queue.pop();
+
+    auto& recycled = queue.wait_back();
+    CHECK(&recycled == &slot);
+    CHECK(recycled.capacity() >= 100);
+}
+
+TEST_CASE("spsc_queue.threads")
+{
+    auto queue = spsc_queue<size_t>{4};
+    constexpr size_t Count = 100'000;
+
+    auto producer = thread([&]() {
+        for (size_t i = 0; i < Count; ++i)
+        {
+            queue.wait_back() = i;
+            queue.push();
+        }
+        queue.close();
+    });
+
+    size_t expected = 0;
+    while (size_t* value = queue.wait_front())
+    {
+        if (*value != expected)
+            break;
+        ++expected;
+        queue.pop();
+    }
+    producer.join();
+
+    CHECK(expected == Count);
+}
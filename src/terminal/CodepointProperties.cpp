@@ -0,0 +1,50 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/CodepointProperties.h>
+
+#include <algorithm>
+#include <memory>
+
+namespace terminal::detail {
+
+namespace {
+    std::unique_ptr<BmpWidths> buildBmpWidths()
+    {
+        auto table = std::make_unique<BmpWidths>();
+        size_t blockCount = 0;
+
+        for (size_t blockNumber = 0; blockNumber < table->blockIndex.size(); ++blockNumber)
+        {
+            auto& block = table->blocks[blockCount];
+            for (size_t i = 0; i < block.size(); ++i)
+                block[i] = static_cast<uint8_t>(unicode::width(static_cast<char32_t>(blockNumber << 8 | i)));
+
+            auto const blocksEnd = table->blocks.begin() + static_cast<ptrdiff_t>(blockCount);
+            auto const existing = std::find(table->blocks.begin(), blocksEnd, block);
+            table->blockIndex[blockNumber] = static_cast<uint8_t>(existing - table->blocks.begin());
+            if (existing == blocksEnd)
+                ++blockCount;
+        }
+
+        return table;
+    }
+}
+
+BmpWidths const& BmpWidths::get()
+{
+    static auto const table = buildBmpWidths();
+    return *table;
+}
+
+} // end namespace
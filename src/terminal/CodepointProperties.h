@@ -0,0 +1,96 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <unicode/grapheme_segmenter.h>
+#include <unicode/width.h>
+
+#include <array>
+#include <cstdint>
+
+/// Fast paths in front of the libunicode lookups done for every written character.
+///
+/// Printable Latin-1 (which includes US-ASCII) is answered from tables generated at compile time,
+/// the rest of the Basic Multilingual Plane from a two-level table built from libunicode on first use.
+/// Everything else is passed through to libunicode.
+namespace terminal {
+
+namespace detail
+{
+    /// Marks a Latin-1 codepoint, whose properties are left to libunicode.
+    constexpr uint8_t UnknownWidth = 0xFF;
+
+    /// @returns whether @p _codepoint is a printable Latin-1 codepoint other than the soft hyphen,
+    ///          that is, a single column character that never joins a grapheme cluster.
+    constexpr bool isPlainLatin1(char32_t _codepoint) noexcept
+    {
+        return (0x20 <= _codepoint && _codepoint < 0x7F)
+            || (0xA0 <= _codepoint && _codepoint <= 0xFF && _codepoint != 0xAD);
+    }
+
+    constexpr std::array<uint8_t, 0x100> makeLatin1Widths() noexcept
+    {
+        std::array<uint8_t, 0x100> widths{};
+        for (char32_t codepoint = 0; codepoint < widths.size(); ++codepoint)
+            widths[codepoint] = isPlainLatin1(codepoint) ? 1 : UnknownWidth;
+        return widths;
+    }
+
+    constexpr auto Latin1Widths = makeLatin1Widths();
+
+    /// Column widths of the Basic Multilingual Plane, in blocks of 256 codepoints.
+    ///
+    /// Blocks of equal widths share their storage, leaving few enough of them to stay in cache.
+    struct BmpWidths {
+        std::array<uint8_t, 0x100> blockIndex;
+        std::array<std::array<uint8_t, 0x100>, 0x100> blocks;
+
+        int operator()(char32_t _codepoint) const noexcept
+        {
+            return blocks[blockIndex[_codepoint >> 8]][_codepoint & 0xFF];
+        }
+
+        /// @returns the table, building it on first use.
+        static BmpWidths const& get();
+    };
+}
+
+/// @returns the number of columns @p _codepoint occupies, same as unicode::width().
+inline int columnWidth(char32_t _codepoint) noexcept
+{
+    if (_codepoint < 0x100)
+    {
+        if (auto const width = detail::Latin1Widths[_codepoint]; width != detail::UnknownWidth)
+            return width;
+        return unicode::width(_codepoint);
+    }
+
+    if (_codepoint < 0x10000)
+        return detail::BmpWidths::get()(_codepoint);
+
+    return unicode::width(_codepoint);
+}
+
+/// @returns whether there is no grapheme cluster boundary between @p _a and @p _b,
+///          same as unicode::grapheme_segmenter::nonbreakable().
+inline bool nonbreakable(char32_t _a, char32_t _b) noexcept
+{
+    // Printable Latin-1 has no grapheme cluster break property other than "Other" (GB999).
+    if (detail::isPlainLatin1(_a) && detail::isPlainLatin1(_b))
+        return false;
+
+    return unicode::grapheme_segmenter::nonbreakable(_a, _b);
+}
+
+} // end namespace
@@ -0,0 +1,42 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/CodepointProperties.h>
+
+#include <catch2/catch.hpp>
+
+using namespace terminal;
+
+TEST_CASE("CodepointProperties.columnWidth", "[unicode]")
+{
+    static_assert(detail::Latin1Widths['A'] == 1);
+    static_assert(detail::Latin1Widths[0xE4] == 1);
+    static_assert(detail::Latin1Widths['\n'] == detail::UnknownWidth);
+
+    // Checked one by one, as Catch would record over a million assertions otherwise.
+    for (char32_t codepoint = 0; codepoint <= 0x10FFFF; ++codepoint)
+        if (columnWidth(codepoint) != unicode::width(codepoint))
+            FAIL_CHECK("width of U+" << std::hex << static_cast<uint32_t>(codepoint) << " differs");
+}
+
+TEST_CASE("CodepointProperties.nonbreakable", "[unicode]")
+{
+    for (char32_t a = 0; a < 0x100; ++a)
+        for (char32_t b = 0; b < 0x100; ++b)
+            if (nonbreakable(a, b) != unicode::grapheme_segmenter::nonbreakable(a, b))
+                FAIL_CHECK("U+" << std::hex << static_cast<uint32_t>(a) << " U+" << static_cast<uint32_t>(b) << " differ");
+
+    CHECK(nonbreakable(U'e', U'́'));
+    CHECK(nonbreakable(U'ä', U'‍'));
+    CHECK_FALSE(nonbreakable(U'a', U'b'));
+}
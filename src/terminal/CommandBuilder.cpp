@@ -27,6 +27,7 @@
 
 #include <array>
 #include <cstdlib>
+#include <memory>
 #include <numeric>
 #include <optional>
 #include <sstream>
@@ -64,9 +65,9 @@ namespace // {{{ helpers
     }
 
     template <typename T, typename... Args>
-    ApplyResult emitCommand(CommandList& _output, Args&&... args)
+    ApplyResult emitCommand(CommandSink& _output, Args&&... args)
     {
-        _output.emplace_back(T{std::forward<Args>(args)...});
+        _output.emit(T{std::forward<Args>(args)...});
         // TODO: telemetry_.increment(...);
         return ApplyResult::Ok;
     }
@@ -98,7 +99,7 @@ namespace // {{{ helpers
 
 namespace impl // {{{ some command generator helpers
 {
-    ApplyResult setMode(Sequence const& _ctx, size_t _modeIndex, bool _enable, CommandList& _output)
+    ApplyResult setMode(Sequence const& _ctx, size_t _modeIndex, bool _enable, CommandSink& _output)
 	{
 		switch (_ctx.param(_modeIndex))
 		{
@@ -114,7 +115,7 @@ namespace impl // {{{ some command generator helpers
 		}
 	}
 
-	ApplyResult setModeDEC(Sequence const& _ctx, size_t _modeIndex, bool _enable, CommandList& _output)
+	ApplyResult setModeDEC(Sequence const& _ctx, size_t _modeIndex, bool _enable, CommandSink& _output)
 	{
 		switch (_ctx.param(_modeIndex))
 		{
@@ -191,7 +192,7 @@ namespace impl // {{{ some command generator helpers
                         auto const g = _ctx.subparam(i, 2);
                         auto const b = _ctx.subparam(i, 3);
                         if (r <= 255 && g <= 255 && b <= 255)
-                            return pair{i + 1, Color{RGBColor{static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b)} }};
+                            return pair{i, Color{RGBColor{static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b)} }};
                     }
                     break;
                 case 3: // ":3:F:C:M:Y" (TODO)
@@ -199,7 +200,7 @@ namespace impl // {{{ some command generator helpers
                     break;
                 case 5: // ":5:P"
                     if (auto const P = _ctx.subparam(i, 1); P <= 255)
-                        return pair{i + 1, static_cast<IndexedColor>(P)};
+                        return pair{i, static_cast<IndexedColor>(P)};
                     break;
                 default:
                     break; // XXX invalid sub parameter
@@ -216,7 +217,7 @@ namespace impl // {{{ some command generator helpers
 				{
 					++i;
 					auto const value = _ctx.param(i);
-					if (i <= 255)
+					if (value <= 255)
 						return {i, static_cast<IndexedColor>(value)};
 					else
                         {} // TODO: _ctx.logInvalidCSI("Invalid color indexing.");
@@ -250,103 +251,105 @@ namespace impl // {{{ some command generator helpers
 		return {i + 1, Color{}};
 	}
 
-	/// Parses color at given parameter offset @p i and returns new offset to continue processing parameters.
-	template <typename T>
-	size_t parseColor(Sequence const& _ctx, size_t i, CommandList& _output)
+	/// Parses color at given parameter offset @p i into @p _color and returns new offset to continue processing parameters.
+	size_t parseColor(Sequence const& _ctx, size_t i, std::optional<Color>& _color)
     {
         auto const [k, color] = parseColor(_ctx, i);
-        _output.emplace_back(T{color});
+        _color = color;
         return k;
     }
 
-	ApplyResult dispatchSGR(Sequence const& _ctx, CommandList& _output)
+	ApplyResult dispatchSGR(Sequence const& _ctx, CommandSink& _output)
 	{
+        // All parameters are folded into a single command, to be applied at once.
+        auto sgr = ApplyGraphicsRendition{};
         if (_ctx.parameterCount() == 0)
-           return emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Reset);
+            sgr.add(GraphicsRendition::Reset);
 
 		for (size_t i = 0; i < _ctx.parameterCount(); ++i)
 		{
 			switch (_ctx.param(i))
 			{
-				case 0: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Reset); break;
-				case 1: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Bold); break;
-				case 2: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Faint); break;
-				case 3: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Italic); break;
+				case 0: sgr.add(GraphicsRendition::Reset); break;
+				case 1: sgr.add(GraphicsRendition::Bold); break;
+				case 2: sgr.add(GraphicsRendition::Faint); break;
+				case 3: sgr.add(GraphicsRendition::Italic); break;
 				case 4:
                     if (_ctx.subParameterCount(i) == 1)
                     {
                         switch (_ctx.subparam(i, 0))
                         {
-                            case 0: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::NoUnderline); break; // 4:0
-                            case 1: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Underline); break; // 4:1
-                            case 2: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::DoublyUnderlined); break; // 4:2
-                            case 3: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::CurlyUnderlined); break; // 4:3
-                            case 4: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::DottedUnderline); break; // 4:4
-                            case 5: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::DashedUnderline); break; // 4:5
-                            default: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Underline); break;
+                            case 0: sgr.add(GraphicsRendition::NoUnderline); break; // 4:0
+                            case 1: sgr.add(GraphicsRendition::Underline); break; // 4:1
+                            case 2: sgr.add(GraphicsRendition::DoublyUnderlined); break; // 4:2
+                            case 3: sgr.add(GraphicsRendition::CurlyUnderlined); break; // 4:3
+                            case 4: sgr.add(GraphicsRendition::DottedUnderline); break; // 4:4
+                            case 5: sgr.add(GraphicsRendition::DashedUnderline); break; // 4:5
+                            default: sgr.add(GraphicsRendition::Underline); break;
                         }
                     }
                     else
-                        emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Underline);
+                        sgr.add(GraphicsRendition::Underline);
 					break;
-				case 5: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Blinking); break;
-				case 7: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Inverse); break;
-				case 8: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Hidden); break;
-				case 9: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::CrossedOut); break;
-				case 21: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::DoublyUnderlined); break;
-				case 22: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Normal); break;
-				case 23: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::NoItalic); break;
-				case 24: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::NoUnderline); break;
-				case 25: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::NoBlinking); break;
-				case 27: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::NoInverse); break;
-				case 28: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::NoHidden); break;
-				case 29: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::NoCrossedOut); break;
-				case 30: emitCommand<SetForegroundColor>(_output, IndexedColor::Black); break;
-				case 31: emitCommand<SetForegroundColor>(_output, IndexedColor::Red); break;
-				case 32: emitCommand<SetForegroundColor>(_output, IndexedColor::Green); break;
-				case 33: emitCommand<SetForegroundColor>(_output, IndexedColor::Yellow); break;
-				case 34: emitCommand<SetForegroundColor>(_output, IndexedColor::Blue); break;
-				case 35: emitCommand<SetForegroundColor>(_output, IndexedColor::Magenta); break;
-				case 36: emitCommand<SetForegroundColor>(_output, IndexedColor::Cyan); break;
-				case 37: emitCommand<SetForegroundColor>(_output, IndexedColor::White); break;
-				case 38: i = parseColor<SetForegroundColor>(_ctx, i, _output); break;
-				case 39: emitCommand<SetForegroundColor>(_output, DefaultColor{}); break;
-				case 40: emitCommand<SetBackgroundColor>(_output, IndexedColor::Black); break;
-				case 41: emitCommand<SetBackgroundColor>(_output, IndexedColor::Red); break;
-				case 42: emitCommand<SetBackgroundColor>(_output, IndexedColor::Green); break;
-				case 43: emitCommand<SetBackgroundColor>(_output, IndexedColor::Yellow); break;
-				case 44: emitCommand<SetBackgroundColor>(_output, IndexedColor::Blue); break;
-				case 45: emitCommand<SetBackgroundColor>(_output, IndexedColor::Magenta); break;
-				case 46: emitCommand<SetBackgroundColor>(_output, IndexedColor::Cyan); break;
-				case 47: emitCommand<SetBackgroundColor>(_output, IndexedColor::White); break;
-				case 48: i = parseColor<SetBackgroundColor>(_ctx, i, _output); break;
-				case 49: emitCommand<SetBackgroundColor>(_output, DefaultColor{}); break;
-                case 51: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Framed); break;
-                case 53: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::Overline); break;
-                case 54: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::NoFramed); break;
-                case 55: emitCommand<SetGraphicsRendition>(_output, GraphicsRendition::NoOverline); break;
+				case 5: sgr.add(GraphicsRendition::Blinking); break;
+				case 7: sgr.add(GraphicsRendition::Inverse); break;
+				case 8: sgr.add(GraphicsRendition::Hidden); break;
+				case 9: sgr.add(GraphicsRendition::CrossedOut); break;
+				case 21: sgr.add(GraphicsRendition::DoublyUnderlined); break;
+				case 22: sgr.add(GraphicsRendition::Normal); break;
+				case 23: sgr.add(GraphicsRendition::NoItalic); break;
+				case 24: sgr.add(GraphicsRendition::NoUnderline); break;
+				case 25: sgr.add(GraphicsRendition::NoBlinking); break;
+				case 27: sgr.add(GraphicsRendition::NoInverse); break;
+				case 28: sgr.add(GraphicsRendition::NoHidden); break;
+				case 29: sgr.add(GraphicsRendition::NoCrossedOut); break;
+				case 30: sgr.foregroundColor = IndexedColor::Black; break;
+				case 31: sgr.foregroundColor = IndexedColor::Red; break;
+				case 32: sgr.foregroundColor = IndexedColor::Green; break;
+				case 33: sgr.foregroundColor = IndexedColor::Yellow; break;
+				case 34: sgr.foregroundColor = IndexedColor::Blue; break;
+				case 35: sgr.foregroundColor = IndexedColor::Magenta; break;
+				case 36: sgr.foregroundColor = IndexedColor::Cyan; break;
+				case 37: sgr.foregroundColor = IndexedColor::White; break;
+				case 38: i = parseColor(_ctx, i, sgr.foregroundColor); break;
+				case 39: sgr.foregroundColor = DefaultColor{}; break;
+				case 40: sgr.backgroundColor = IndexedColor::Black; break;
+				case 41: sgr.backgroundColor = IndexedColor::Red; break;
+				case 42: sgr.backgroundColor = IndexedColor::Green; break;
+				case 43: sgr.backgroundColor = IndexedColor::Yellow; break;
+				case 44: sgr.backgroundColor = IndexedColor::Blue; break;
+				case 45: sgr.backgroundColor = IndexedColor::Magenta; break;
+				case 46: sgr.backgroundColor = IndexedColor::Cyan; break;
+				case 47: sgr.backgroundColor = IndexedColor::White; break;
+				case 48: i = parseColor(_ctx, i, sgr.backgroundColor); break;
+				case 49: sgr.backgroundColor = DefaultColor{}; break;
+                case 51: sgr.add(GraphicsRendition::Framed); break;
+                case 53: sgr.add(GraphicsRendition::Overline); break;
+                case 54: sgr.add(GraphicsRendition::NoFramed); break;
+                case 55: sgr.add(GraphicsRendition::NoOverline); break;
                 // 58 is reserved, but used for setting underline/decoration colors by some other VTEs (such as mintty, kitty, libvte)
-                case 58: i = parseColor<SetUnderlineColor>(_ctx, i, _output); break;
-				case 90: emitCommand<SetForegroundColor>(_output, BrightColor::Black); break;
-				case 91: emitCommand<SetForegroundColor>(_output, BrightColor::Red); break;
-				case 92: emitCommand<SetForegroundColor>(_output, BrightColor::Green); break;
-				case 93: emitCommand<SetForegroundColor>(_output, BrightColor::Yellow); break;
-				case 94: emitCommand<SetForegroundColor>(_output, BrightColor::Blue); break;
-				case 95: emitCommand<SetForegroundColor>(_output, BrightColor::Magenta); break;
-				case 96: emitCommand<SetForegroundColor>(_output, BrightColor::Cyan); break;
-				case 97: emitCommand<SetForegroundColor>(_output, BrightColor::White); break;
-				case 100: emitCommand<SetBackgroundColor>(_output, BrightColor::Black); break;
-				case 101: emitCommand<SetBackgroundColor>(_output, BrightColor::Red); break;
-				case 102: emitCommand<SetBackgroundColor>(_output, BrightColor::Green); break;
-				case 103: emitCommand<SetBackgroundColor>(_output, BrightColor::Yellow); break;
-				case 104: emitCommand<SetBackgroundColor>(_output, BrightColor::Blue); break;
-				case 105: emitCommand<SetBackgroundColor>(_output, BrightColor::Magenta); break;
-				case 106: emitCommand<SetBackgroundColor>(_output, BrightColor::Cyan); break;
-				case 107: emitCommand<SetBackgroundColor>(_output, BrightColor::White); break;
+                case 58: i = parseColor(_ctx, i, sgr.underlineColor); break;
+                case 59: sgr.underlineColor = DefaultColor{}; break;
+				case 90: sgr.foregroundColor = BrightColor::Black; break;
+				case 91: sgr.foregroundColor = BrightColor::Red; break;
+				case 92: sgr.foregroundColor = BrightColor::Green; break;
+				case 93: sgr.foregroundColor = BrightColor::Yellow; break;
+				case 94: sgr.foregroundColor = BrightColor::Blue; break;
+				case 95: sgr.foregroundColor = BrightColor::Magenta; break;
+				case 96: sgr.foregroundColor = BrightColor::Cyan; break;
+				case 97: sgr.foregroundColor = BrightColor::White; break;
+				case 100: sgr.backgroundColor = BrightColor::Black; break;
+				case 101: sgr.backgroundColor = BrightColor::Red; break;
+				case 102: sgr.backgroundColor = BrightColor::Green; break;
+				case 103: sgr.backgroundColor = BrightColor::Yellow; break;
+				case 104: sgr.backgroundColor = BrightColor::Blue; break;
+				case 105: sgr.backgroundColor = BrightColor::Magenta; break;
+				case 106: sgr.backgroundColor = BrightColor::Cyan; break;
+				case 107: sgr.backgroundColor = BrightColor::White; break;
 				default: break; // TODO: logInvalidCSI("Invalid SGR number: {}", _ctx.param(i));
 			}
 		}
-		return ApplyResult::Ok;
+		return emitCommand<ApplyGraphicsRendition>(_output, std::move(sgr));
 	}
 
 	ApplyResult requestMode(Sequence const& /*_ctx*/, unsigned int _mode)
@@ -423,7 +426,7 @@ namespace impl // {{{ some command generator helpers
 		}
 	}
 
-    ApplyResult CPR(Sequence const& _ctx, CommandList& _output)
+    ApplyResult CPR(Sequence const& _ctx, CommandSink& _output)
     {
         switch (_ctx.param(0))
         {
@@ -433,7 +436,7 @@ namespace impl // {{{ some command generator helpers
         }
     }
 
-    ApplyResult DECRQPSR(Sequence const& _ctx, CommandList& _output)
+    ApplyResult DECRQPSR(Sequence const& _ctx, CommandSink& _output)
     {
         if (_ctx.parameterCount() != 1)
             return ApplyResult::Invalid; // -> error
@@ -447,7 +450,7 @@ namespace impl // {{{ some command generator helpers
             return ApplyResult::Invalid;
     }
 
-    ApplyResult DECSCUSR(Sequence const& _ctx, CommandList& _output)
+    ApplyResult DECSCUSR(Sequence const& _ctx, CommandSink& _output)
     {
         if (_ctx.parameterCount() <= 1)
         {
@@ -467,7 +470,7 @@ namespace impl // {{{ some command generator helpers
             return ApplyResult::Invalid;
     }
 
-    ApplyResult ED(Sequence const& _ctx, CommandList& _output)
+    ApplyResult ED(Sequence const& _ctx, CommandSink& _output)
     {
         if (_ctx.parameterCount() == 0)
             return emitCommand<ClearToEndOfScreen>(_output);
@@ -487,7 +490,7 @@ namespace impl // {{{ some command generator helpers
         }
     }
 
-    ApplyResult EL(Sequence const& _ctx, CommandList& _output)
+    ApplyResult EL(Sequence const& _ctx, CommandSink& _output)
     {
         switch (_ctx.param_or(0, Sequence::Parameter{0}))
         {
@@ -498,7 +501,7 @@ namespace impl // {{{ some command generator helpers
         }
     }
 
-    ApplyResult TBC(Sequence const& _ctx, CommandList& _output)
+    ApplyResult TBC(Sequence const& _ctx, CommandSink& _output)
     {
         if (_ctx.parameterCount() != 1)
             return emitCommand<HorizontalTabClear>(_output, HorizontalTabClear::AllTabs);
@@ -516,7 +519,7 @@ namespace impl // {{{ some command generator helpers
         return crispy::splitKeyValuePairs(s, ':');
     }
 
-    ApplyResult setOrRequestDynamicColor(Sequence const& _ctx, CommandList& _output, DynamicColorName _name)
+    ApplyResult setOrRequestDynamicColor(Sequence const& _ctx, CommandSink& _output, DynamicColorName _name)
     {
         auto const& value = _ctx.intermediateCharacters();
         if (value == "?")
@@ -527,17 +530,18 @@ namespace impl // {{{ some command generator helpers
             return ApplyResult::Invalid;
     }
 
-    ApplyResult clipboard(Sequence const& _ctx, CommandList& _output)
+    ApplyResult clipboard(Sequence const& _ctx, CommandSink& _output)
     {
         // Only setting clipboard contents is supported, not reading.
-        auto const& params = _ctx.intermediateCharacters();
-        if (auto const splits = crispy::split(params, ';'); splits.size() == 2 && splits[0] == "c")
-            return emitCommand<CopyToClipboard>(_output, crispy::base64::decode(splits[1]));
+        // The selection is passed as intermediate characters, and the (already base64-decoded)
+        // data as data string, see CommandBuilder::putOSC().
+        if (_ctx.intermediateCharacters() == "c")
+            return emitCommand<CopyToClipboard>(_output, _ctx.dataString());
         else
             return ApplyResult::Invalid;
     }
 
-    ApplyResult NOTIFY(Sequence const& _ctx, CommandList& _output)
+    ApplyResult NOTIFY(Sequence const& _ctx, CommandSink& _output)
     {
         auto const& value = _ctx.intermediateCharacters();
         if (auto const splits = crispy::split(value, ';'); splits.size() == 3 && splits[0] == "notify")
@@ -546,7 +550,7 @@ namespace impl // {{{ some command generator helpers
             return ApplyResult::Unsupported;
     }
 
-    ApplyResult HYPERLINK(Sequence const& _ctx, CommandList& _output)
+    ApplyResult HYPERLINK(Sequence const& _ctx, CommandSink& _output)
     {
         auto const& value = _ctx.intermediateCharacters();
         // hyperlink_OSC ::= OSC '8' ';' params ';' URI
@@ -572,7 +576,7 @@ namespace impl // {{{ some command generator helpers
             return ApplyResult::Invalid;
     }
 
-    ApplyResult DECRQSS(Sequence const& _ctx, CommandList& _output)
+    ApplyResult DECRQSS(Sequence const& _ctx, CommandSink& _output)
     {
         auto const s = [](std::string const& _dataString) -> optional<RequestStatusString::Value> {
             auto const mappings = std::array<std::pair<std::string_view, RequestStatusString::Value>, 9>{
@@ -600,7 +604,7 @@ namespace impl // {{{ some command generator helpers
         return ApplyResult::Unsupported;
     }
 
-    ApplyResult WINDOWMANIP(Sequence const& _ctx, CommandList& _output)
+    ApplyResult WINDOWMANIP(Sequence const& _ctx, CommandSink& _output)
     {
         if (_ctx.parameterCount() == 3)
         {
@@ -658,21 +662,21 @@ void CommandBuilder::handleAction(ActionClass _actionClass, Action _action, char
 #if 0
             sequence_.clear();
             sequence_.setCategory(FunctionCategory::Text);
-            sequence_.parameters().push_back({_currentChar});
+            sequence_.appendParameter(static_cast<Sequence::Parameter>(_currentChar));
             emitSequence(); // TODO: Not so sure I wanna stick with this! Rethink meh! :-) ^o^
 #else
             emitCommand<AppendChar>(_currentChar);
 #endif
             return;
         case Action::Param:
-            if (sequence_.parameters().empty())
-                sequence_.parameters().push_back({0});
+            if (sequence_.parameterCount() == 0)
+                sequence_.nextParameter();
             if (_currentChar == ';')
-                sequence_.parameters().push_back({0});
+                sequence_.nextParameter();
             else if (_currentChar == ':')
-                sequence_.parameters().back().push_back({0});
+                sequence_.nextSubParameter();
             else
-                sequence_.parameters().back().back() = sequence_.parameters().back().back() * 10 + (_currentChar - U'0');
+                sequence_.appendParameterDigit(static_cast<Sequence::Parameter>(_currentChar - U'0'));
             return;
         case Action::CSI_Dispatch:
 			dispatchCSI(static_cast<char>(_currentChar));
@@ -685,38 +689,28 @@ void CommandBuilder::handleAction(ActionClass _actionClass, Action _action, char
             return;
         case Action::OSC_Start:
             sequence_.setCategory(FunctionCategory::OSC);
+            payloadSize_ = 0;
+            payloadSink_ = PayloadSink::OSCCode;
             break;
         case Action::OSC_Put:
-        {
-            uint8_t u8[4];
-            size_t const count = unicode::to_utf8(_currentChar, u8);
-            for (size_t i = 0; i < count; ++i)
-                sequence_.intermediateCharacters().push_back(u8[i]);
+            putOSC(_currentChar);
             break;
-        }
         case Action::OSC_End:
-        {
-            auto const [code, skipCount] = parseOSC(sequence_.intermediateCharacters());
-            sequence_.parameters().push_back({static_cast<Sequence::Parameter>(code)});
-            sequence_.intermediateCharacters().erase(0, skipCount);
-            emitSequence();
+            finishOSC();
             sequence_.clear();
             break;
-        }
         case Action::Hook: // this is actually state DCS_PassThrough
             sequence_.setCategory(FunctionCategory::DCS);
             sequence_.setFinalChar(static_cast<char>(_currentChar));
+            payloadSize_ = 0;
+            payloadSink_ = PayloadSink::Text;
             break;
         case Action::Put: // DCS_PassThrough: DCS data string
-            {
-                uint8_t u8[4];
-                size_t const count = unicode::to_utf8(_currentChar, u8);
-                for (size_t i = 0; i < count; ++i)
-                    sequence_.dataString().push_back(u8[i]);
-            }
+            putDCS(_currentChar);
             break;
         case Action::Unhook: // DCS_PassThrough: DCS data string complete
-            emitSequence();
+            if (payloadSink_ != PayloadSink::Discard)
+                emitSequence();
             break;
         case Action::Ignore:
         case Action::Undefined:
@@ -724,6 +718,111 @@ void CommandBuilder::handleAction(ActionClass _actionClass, Action _action, char
     }
 }
 
+bool CommandBuilder::acceptPayload(size_t _size)
+{
+    if (payloadSink_ == PayloadSink::Discard)
+        return false;
+
+    payloadSize_ += _size;
+    if (payloadSize_ <= maxPayloadSize_)
+        return true;
+
+    log<InvalidOutputEvent>(
+        fmt::format("{} {}", sequence_.category(), sequence_.parameterCount() ? sequence_.param(0) : 0),
+        fmt::format("Payload exceeds the maximum size of {} bytes.", maxPayloadSize_)
+    );
+    payloadSink_ = PayloadSink::Discard;
+    sequence_.intermediateCharacters().clear();
+    sequence_.intermediateCharacters().shrink_to_fit();
+    sequence_.dataString().clear();
+    sequence_.dataString().shrink_to_fit();
+    clipboardDecoder_.reset();
+    return false;
+}
+
+void CommandBuilder::putOSC(char32_t _char)
+{
+    uint8_t u8[4];
+    size_t const count = unicode::to_utf8(_char, u8);
+    if (!acceptPayload(count))
+        return;
+
+    switch (payloadSink_)
+    {
+        case PayloadSink::OSCCode:
+            sequence_.intermediateCharacters().append(reinterpret_cast<char const*>(u8), count);
+            if (_char < '0' || _char > '9')
+            {
+                // The code is complete, so the rest of the payload can be routed by it.
+                auto const [code, skipCount] = parseOSC(sequence_.intermediateCharacters());
+                sequence_.appendParameter(static_cast<Sequence::Parameter>(code));
+                sequence_.intermediateCharacters().erase(0, skipCount);
+                payloadSink_ = code == 52 ? PayloadSink::ClipboardSelection : PayloadSink::Text;
+            }
+            break;
+        case PayloadSink::ClipboardSelection:
+            if (_char == ';')
+            {
+                clipboardDecoder_.reset();
+                payloadSink_ = PayloadSink::ClipboardData;
+            }
+            else
+                sequence_.intermediateCharacters().append(reinterpret_cast<char const*>(u8), count);
+            break;
+        case PayloadSink::ClipboardData:
+            // Anything but US-ASCII is invalid base64 anyway.
+            clipboardDecoder_.put(std::string_view(reinterpret_cast<char const*>(u8), count));
+            break;
+        case PayloadSink::Text:
+            sequence_.intermediateCharacters().append(reinterpret_cast<char const*>(u8), count);
+            break;
+        case PayloadSink::Discard:
+            break;
+    }
+}
+
+void CommandBuilder::finishOSC()
+{
+    switch (payloadSink_)
+    {
+        case PayloadSink::OSCCode:
+        {
+            auto const [code, skipCount] = parseOSC(sequence_.intermediateCharacters());
+            sequence_.appendParameter(static_cast<Sequence::Parameter>(code));
+            sequence_.intermediateCharacters().erase(0, skipCount);
+            emitSequence();
+            break;
+        }
+        case PayloadSink::ClipboardSelection:
+            // The data part is missing.
+            emitCommand<InvalidCommand>(std::make_shared<Sequence const>(sequence_), InvalidCommand::Reason::Invalid);
+            break;
+        case PayloadSink::ClipboardData:
+            if (clipboardDecoder_.finish())
+            {
+                sequence_.dataString() = move(clipboardDecoder_.output());
+                emitSequence();
+            }
+            else
+                emitCommand<InvalidCommand>(std::make_shared<Sequence const>(sequence_), InvalidCommand::Reason::Invalid);
+            clipboardDecoder_.reset();
+            break;
+        case PayloadSink::Text:
+            emitSequence();
+            break;
+        case PayloadSink::Discard:
+            break;
+    }
+}
+
+void CommandBuilder::putDCS(char32_t _char)
+{
+    uint8_t u8[4];
+    size_t const count = unicode::to_utf8(_char, u8);
+    if (acceptPayload(count))
+        sequence_.dataString().append(reinterpret_cast<char const*>(u8), count);
+}
+
 void CommandBuilder::executeControlFunction(char _c0)
 {
 #if 0
@@ -787,20 +886,20 @@ void CommandBuilder::emitSequence()
 {
     if (FunctionDefinition const* funcSpec = select(sequence_.selector()); funcSpec != nullptr)
     {
-        switch (apply(*funcSpec, sequence_, commands_))
+        switch (apply(*funcSpec, sequence_, sink_))
         {
             case ApplyResult::Unsupported:
-                emitCommand<InvalidCommand>(sequence_, InvalidCommand::Reason::Unsupported);
+                emitCommand<InvalidCommand>(std::make_shared<Sequence const>(sequence_), InvalidCommand::Reason::Unsupported);
                 break;
             case ApplyResult::Invalid:
-                emitCommand<InvalidCommand>(sequence_, InvalidCommand::Reason::Invalid);
+                emitCommand<InvalidCommand>(std::make_shared<Sequence const>(sequence_), InvalidCommand::Reason::Invalid);
                 break;
             case ApplyResult::Ok:
                 break;
         }
     }
     else
-        emitCommand<InvalidCommand>(sequence_, InvalidCommand::Reason::Unknown);
+        emitCommand<InvalidCommand>(std::make_shared<Sequence const>(sequence_), InvalidCommand::Reason::Unknown);
 }
 
 std::optional<RGBColor> CommandBuilder::parseColor(std::string_view const& _value)
@@ -830,7 +929,7 @@ std::optional<RGBColor> CommandBuilder::parseColor(std::string_view const& _valu
 }
 
 /// Applies a FunctionDefinition to a given context, emitting the respective command.
-ApplyResult apply(FunctionDefinition const& _function, Sequence const& _ctx, CommandList& _output)
+ApplyResult apply(FunctionDefinition const& _function, Sequence const& _ctx, CommandSink& _output)
 {
     // This function assumed that the incoming instruction has been already resolved to a given
     // FunctionDefinition
@@ -941,9 +1040,11 @@ ApplyResult apply(FunctionDefinition const& _function, Sequence const& _ctx, Com
         case DUMPSTATE: return emitCommand<DumpState>(_output);
 
         default:
-            return emitCommand<InvalidCommand>(_output, _ctx, InvalidCommand::Reason::Unsupported);
+            return emitCommand<InvalidCommand>(_output, std::make_shared<Sequence const>(_ctx), InvalidCommand::Reason::Unsupported);
     }
 }
 
+template class parser::BasicParser<CommandBuilder&>;
+
 }  // namespace terminal
 
@@ -18,8 +18,12 @@
 #include <terminal/Functions.h>
 #include <terminal/Commands.h>
 
+#include <crispy/base64.h>
+
+#include <cstdint>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace terminal {
@@ -30,12 +34,51 @@ enum class ApplyResult {
     Unsupported,
 };
 
+/// Receives the commands as they are being constructed.
+///
+/// Each command is handed to the executor (if any) right away, and is only collected
+/// into a CommandList if recording is enabled, so that the common path neither copies
+/// the Command variant nor walks the output a second time.
+class CommandSink {
+  public:
+    CommandVisitor* executor() const noexcept { return executor_; }
+    void setExecutor(CommandVisitor* _executor) noexcept { executor_ = _executor; }
+
+    bool recording() const noexcept { return recording_; }
+    void setRecording(bool _enabled) noexcept { recording_ = _enabled; }
+
+    CommandList const& commands() const noexcept { return commands_; }
+    CommandList& commands() noexcept { return commands_; }
+
+    /// Number of commands executed since last reset by the executor.
+    int64_t instructionCounter() const noexcept { return instructionCounter_; }
+    int64_t& instructionCounter() noexcept { return instructionCounter_; }
+
+    template <typename T>
+    void emit(T&& _command)
+    {
+        if (executor_)
+        {
+            executor_->visit(_command);
+            ++instructionCounter_;
+        }
+        if (recording_)
+            commands_.emplace_back(std::forward<T>(_command));
+    }
+
+  private:
+    CommandVisitor* executor_ = nullptr;
+    bool recording_ = true;
+    CommandList commands_{};
+    int64_t instructionCounter_ = 0;
+};
+
 /// Applies a FunctionDefinition to a given context, emitting the respective command.
 ///
 /// A FunctionSelector must have been transformed into a FunctionDefinition already.
 /// So the idea is:
 ///     VT sequence -> FunctionSelector -> FunctionDefinition -> Command.
-ApplyResult apply(FunctionDefinition const& _function, Sequence const& _context, CommandList& _output);
+ApplyResult apply(FunctionDefinition const& _function, Sequence const& _context, CommandSink& _output);
 
 /// Takes parser events as input, assembles them into Sequence objects and then produces
 /// a sequence of Command objects.
@@ -53,16 +96,39 @@ class CommandBuilder {
     /// @param _commandBuilder the next stage in the pipeline to feed the Sequence objects to.
     explicit CommandBuilder(Logger _logger);
 
-    CommandList const& commands() const noexcept { return commands_; }
-    CommandList& commands() noexcept { return commands_; }
+    CommandSink const& sink() const noexcept { return sink_; }
+    CommandSink& sink() noexcept { return sink_; }
+
+    CommandList const& commands() const noexcept { return sink_.commands(); }
+    CommandList& commands() noexcept { return sink_.commands(); }
 
-    void clear() { commands_.clear(); }
+    void clear() { sink_.commands().clear(); }
+
+    /// Maximum size in bytes of an OSC or DCS payload.
+    ///
+    /// A sequence whose payload exceeds this size is dropped as soon as it does,
+    /// without buffering the remainder of it.
+    size_t maxPayloadSize() const noexcept { return maxPayloadSize_; }
+    void setMaxPayloadSize(size_t _value) noexcept { maxPayloadSize_ = _value; }
 
     void operator()(ActionClass _actionClass, Action _action, char32_t _finalChar)
     {
         return handleAction(_actionClass, _action, _finalChar);
     }
 
+    /// Handles a run of printable text, as passed by the parser's text fast path.
+    void print(std::u32string_view _text)
+    {
+        emitCommand<AppendText>(std::u32string(_text));
+    }
+
+    bool acceptsText() const noexcept { return true; }
+
+    void parseError(std::string const& _message)
+    {
+        log<ParserErrorEvent>(_message);
+    }
+
     // helper methods
     //
     std::optional<RGBColor> static parseColor(std::string_view const& _value);
@@ -72,7 +138,10 @@ class CommandBuilder {
     void executeControlFunction(char _c0);
     void dispatchESC(char _finalChar);
     void dispatchCSI(char _finalChar);
-    void dispatchOSC();
+    void putOSC(char32_t _char);
+    void finishOSC();
+    void putDCS(char32_t _char);
+    bool acceptPayload(size_t _size);
     void emitSequence();
 
     template <typename Event, typename... Args>
@@ -85,15 +154,64 @@ class CommandBuilder {
     template <typename T, typename... Args>
     ApplyResult emitCommand(Args&&... args)
     {
-        commands_.emplace_back(T{std::forward<Args>(args)...});
+        sink_.emit(T{std::forward<Args>(args)...});
         // TODO: telemetry_.increment(...);
         return ApplyResult::Ok;
     }
 
+    /// Determines where the payload of the OSC or DCS sequence currently being parsed goes to.
+    enum class PayloadSink {
+        OSCCode,            //!< OSC code incomplete, collected into the intermediate characters
+        Text,               //!< collected into the intermediate characters (OSC) or data string (DCS)
+        ClipboardSelection, //!< OSC 52 selection, collected into the intermediate characters
+        ClipboardData,      //!< OSC 52 base64 data, decoded as it arrives
+        Discard,            //!< payload exceeded the maximum size
+    };
+
   private:
     Sequence sequence_{};
-    CommandList commands_{};
+    CommandSink sink_{};
     Logger const logger_;
+
+    size_t maxPayloadSize_ = Sequence::DefaultMaxPayloadSize;
+    size_t payloadSize_ = 0;
+    PayloadSink payloadSink_ = PayloadSink::Text;
+    crispy::base64::Decoder clipboardDecoder_{};
+};
+
+// The parser is instantiated along with CommandBuilder::handleAction(), so that it can be inlined.
+extern template class parser::BasicParser<CommandBuilder&>;
+
+/// Parses output into commands, without executing them.
+///
+/// Commands do not depend on the state of the screen they are applied to, so parsing may be done
+/// ahead of, and concurrently to, applying them (see Screen::write(CommandList const&)).
+class CommandParser {
+  public:
+    explicit CommandParser(Logger _logger) :
+        builder_{ std::move(_logger) },
+        parser_{ builder_ }
+    {}
+
+    CommandParser(CommandParser const&) = delete;
+    CommandParser& operator=(CommandParser const&) = delete;
+
+    void setMaxPayloadSize(size_t _value) noexcept { builder_.setMaxPayloadSize(_value); }
+
+    /// Parses @p _size bytes at @p _data into @p _commands, replacing what it held before.
+    ///
+    /// Sequences may span several calls. The storage of @p _commands is reused.
+    void parse(char const* _data, size_t _size, CommandList& _commands)
+    {
+        _commands.clear();
+        std::swap(builder_.commands(), _commands);
+        parser_.parseFragment(_data, _size);
+        std::swap(builder_.commands(), _commands);
+    }
+
+  private:
+    CommandBuilder builder_;
+    parser::BasicParser<CommandBuilder&> parser_;
 };
 
 }  // namespace terminal
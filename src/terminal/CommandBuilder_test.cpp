@@ -12,7 +12,9 @@
  * limitations under the License.
  */
 #include <terminal/CommandBuilder.h>
+#include <terminal/OutputGenerator.h>
 #include <terminal/Parser.h>
+#include <crispy/escape.h>
 #include <catch2/catch.hpp>
 #include <fmt/format.h>
 
@@ -101,16 +103,16 @@ TEST_CASE("CommandBuilder.sub_parameters", "[CommandBuilder]")
     SECTION("curly underline") {
         parser.parseFragment("\033[4:3m");
         REQUIRE(1 == output.commands().size());
-        REQUIRE(holds_alternative<SetGraphicsRendition>(output.commands()[0]));
-        REQUIRE(get<SetGraphicsRendition>(output.commands()[0]).rendition == GraphicsRendition::CurlyUnderlined);
+        REQUIRE(holds_alternative<ApplyGraphicsRendition>(output.commands()[0]));
+        REQUIRE(get<ApplyGraphicsRendition>(output.commands()[0]).setStyles.mask() == CharacterStyleMask::CurlyUnderlined);
     }
 
     SECTION("decoration color") {
         parser.parseFragment("\033[58:2:255:128:65m");
         REQUIRE(1 == output.commands().size());
-        REQUIRE(holds_alternative<SetUnderlineColor>(output.commands()[0]));
+        REQUIRE(holds_alternative<ApplyGraphicsRendition>(output.commands()[0]));
 
-        REQUIRE(get<SetUnderlineColor>(output.commands()[0]).color == terminal::RGBColor(255, 128, 65));
+        REQUIRE(get<ApplyGraphicsRendition>(output.commands()[0]).underlineColor == Color{terminal::RGBColor(255, 128, 65)});
     }
 }
 
@@ -163,10 +165,11 @@ TEST_CASE("CommandBuilder.color_fg_indexed", "[CommandBuilder]")
     parser.parseFragment("\033[38;5;235m");
     REQUIRE(1 == output.commands().size());
     INFO(fmt::format("sgr: {}", to_string(output.commands()[0])));
-    REQUIRE(holds_alternative<SetForegroundColor>(output.commands()[0]));
-    auto sgr = get<SetForegroundColor>(output.commands()[0]);
-    REQUIRE(holds_alternative<IndexedColor>(sgr.color));
-    auto indexedColor = get<IndexedColor>(sgr.color);
+    REQUIRE(holds_alternative<ApplyGraphicsRendition>(output.commands()[0]));
+    auto sgr = get<ApplyGraphicsRendition>(output.commands()[0]);
+    REQUIRE(sgr.foregroundColor.has_value());
+    REQUIRE(holds_alternative<IndexedColor>(*sgr.foregroundColor));
+    auto indexedColor = get<IndexedColor>(*sgr.foregroundColor);
     REQUIRE(235 == static_cast<unsigned>(indexedColor));
 }
 
@@ -181,10 +184,11 @@ TEST_CASE("CommandBuilder.color_bg_indexed", "[CommandBuilder]")
     parser.parseFragment("\033[48;5;235m");
     REQUIRE(1 == output.commands().size());
     INFO(fmt::format("sgr: {}", to_string(output.commands()[0])));
-    REQUIRE(holds_alternative<SetBackgroundColor>(output.commands()[0]));
-    auto sgr = get<SetBackgroundColor>(output.commands()[0]);
-    REQUIRE(holds_alternative<IndexedColor>(sgr.color));
-    auto indexedColor = get<IndexedColor>(sgr.color);
+    REQUIRE(holds_alternative<ApplyGraphicsRendition>(output.commands()[0]));
+    auto sgr = get<ApplyGraphicsRendition>(output.commands()[0]);
+    REQUIRE(sgr.backgroundColor.has_value());
+    REQUIRE(holds_alternative<IndexedColor>(*sgr.backgroundColor));
+    auto indexedColor = get<IndexedColor>(*sgr.backgroundColor);
     REQUIRE(235 == static_cast<unsigned>(indexedColor));
 }
 
@@ -212,3 +216,130 @@ TEST_CASE("CommandBuilder.DCS_DECRQSS", "[CommandBuilder]")
     REQUIRE(get<RequestStatusString>(output.commands()[0]).value == RequestStatusString::Value::DECSCL);
 }
 
+
+TEST_CASE("CommandBuilder.parameter_overflow", "[CommandBuilder]")
+{
+    auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
+    auto parser = parser::Parser{ref(output)};
+
+    // Excess parameters are dropped, the remaining ones still apply.
+    parser.parseFragment("\033[1;1;1;1;1;1;1;1;1;1;1;1;1;1;1;31;32;33m");
+    REQUIRE(output.commands().size() == 1);
+    REQUIRE(holds_alternative<ApplyGraphicsRendition>(output.commands()[0]));
+    auto const& sgr = get<ApplyGraphicsRendition>(output.commands()[0]);
+    CHECK(sgr.setStyles.mask() == CharacterStyleMask::Bold);
+    CHECK(sgr.foregroundColor == Color{IndexedColor::Red});
+}
+
+TEST_CASE("CommandBuilder.OSC_52", "[CommandBuilder]")
+{
+    auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
+    auto parser = parser::Parser{ref(output)};
+
+    SECTION("split across fragments") {
+        parser.parseFragment("\033]52;c;Zm9v");
+        parser.parseFragment("OmJh");
+        parser.parseFragment("cg==\033\\");
+        REQUIRE(1 == output.commands().size());
+        REQUIRE(holds_alternative<CopyToClipboard>(output.commands()[0]));
+        CHECK(get<CopyToClipboard>(output.commands()[0]).data == "foo:bar");
+    }
+
+    SECTION("invalid base64") {
+        parser.parseFragment("\033]52;c;Zm9v!\033\\");
+        REQUIRE(1 == output.commands().size());
+        REQUIRE(holds_alternative<InvalidCommand>(output.commands()[0]));
+    }
+
+    SECTION("unsupported selection") {
+        parser.parseFragment("\033]52;p;Zm9v\033\\");
+        REQUIRE(1 == output.commands().size());
+        REQUIRE(holds_alternative<InvalidCommand>(output.commands()[0]));
+    }
+}
+
+TEST_CASE("CommandBuilder.payload_limit", "[CommandBuilder]")
+{
+    auto events = vector<LogEvent>{};
+    auto output = CommandBuilder{[&](LogEvent const& ev) { events.emplace_back(ev); }};
+    auto parser = parser::Parser{ref(output)};
+    output.setMaxPayloadSize(16);
+
+    SECTION("OSC") {
+        parser.parseFragment("\033]2;0123456789");
+        CHECK(events.empty());
+        parser.parseFragment("0123456789\033\\");
+        CHECK(output.commands().empty());
+        REQUIRE(events.size() == 1);
+        CHECK(holds_alternative<InvalidOutputEvent>(events[0]));
+
+        // Sequences following the oversized one are not affected.
+        parser.parseFragment("\033]2;abcd\033\\");
+        REQUIRE(1 == output.commands().size());
+        CHECK(get<ChangeWindowTitle>(output.commands()[0]).title == "abcd");
+    }
+
+    SECTION("OSC 52") {
+        parser.parseFragment("\033]52;c;Zm9vOmJhcg==Zm9vOmJhcg==\033\\");
+        CHECK(output.commands().empty());
+        REQUIRE(events.size() == 1);
+        CHECK(holds_alternative<InvalidOutputEvent>(events[0]));
+    }
+
+    SECTION("DCS") {
+        parser.parseFragment("\033P$q0123456789ABCDEFGH\033\\");
+        CHECK(output.commands().empty());
+        REQUIRE(events.size() == 1);
+        CHECK(holds_alternative<InvalidOutputEvent>(events[0]));
+    }
+}
+
+TEST_CASE("CommandBuilder.SGR_coalesced", "[CommandBuilder]")
+{
+    auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
+    auto parser = parser::Parser{ref(output)};
+
+    parser.parseFragment("\033[0;1;38;2;10;20;30;48;5;17;3;22;4:3m");
+    REQUIRE(1 == output.commands().size());
+    REQUIRE(holds_alternative<ApplyGraphicsRendition>(output.commands()[0]));
+
+    auto const& sgr = get<ApplyGraphicsRendition>(output.commands()[0]);
+    CHECK(sgr.reset);
+    CHECK(sgr.clearStyles.mask() == (CharacterStyleMask::Bold | CharacterStyleMask::Faint));
+    CHECK(sgr.setStyles.mask() == (CharacterStyleMask::Italic | CharacterStyleMask::CurlyUnderlined));
+    CHECK(sgr.foregroundColor == Color{RGBColor{10, 20, 30}});
+    CHECK(sgr.backgroundColor == Color{static_cast<IndexedColor>(17)});
+    CHECK_FALSE(sgr.underlineColor.has_value());
+}
+
+TEST_CASE("CommandBuilder.SGR_roundtrip", "[CommandBuilder]")
+{
+    auto const sequences = {
+        "\033[m",
+        "\033[1;3;4;5;7;8;9m",
+        "\033[22;23;24;25;27;28;29;54;55m",
+        "\033[21;4:3;4:4;4:5;51;53m",
+        "\033[0;1;31;42m",
+        "\033[38;5;200;48;2;1;2;3;58;2;4;5;6m",
+        "\033[1;22;2m",
+        "\033[93;104;39;59m",
+    };
+
+    for (auto const sequence : sequences)
+    {
+        auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
+        auto parser = parser::Parser{ref(output)};
+        parser.parseFragment(sequence);
+        REQUIRE(1 == output.commands().size());
+        auto const first = output.commands()[0];
+
+        auto const generated = OutputGenerator::generate(output.commands());
+        INFO(fmt::format("{} -> {}", crispy::escape(sequence), crispy::escape(generated)));
+        output.clear();
+        parser.parseFragment(generated);
+        REQUIRE(1 == output.commands().size());
+        REQUIRE(holds_alternative<ApplyGraphicsRendition>(output.commands()[0]));
+        CHECK(get<ApplyGraphicsRendition>(output.commands()[0]) == get<ApplyGraphicsRendition>(first));
+        CHECK(to_mnemonic(output.commands()[0], true, true) == to_mnemonic(first, true, true));
+    }
+}
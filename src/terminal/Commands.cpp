@@ -17,6 +17,7 @@
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <sstream>
 #include <vector>
@@ -110,6 +111,82 @@ string to_string(GraphicsRendition s)
     return "?";
 }
 
+string to_string(CharacterStyleMask _mask)
+{
+    constexpr auto names = array{
+        pair{CharacterStyleMask::Bold, "Bold"},
+        pair{CharacterStyleMask::Faint, "Faint"},
+        pair{CharacterStyleMask::Italic, "Italic"},
+        pair{CharacterStyleMask::Underline, "Underline"},
+        pair{CharacterStyleMask::Blinking, "Blinking"},
+        pair{CharacterStyleMask::Inverse, "Inverse"},
+        pair{CharacterStyleMask::Hidden, "Hidden"},
+        pair{CharacterStyleMask::CrossedOut, "CrossedOut"},
+        pair{CharacterStyleMask::DoublyUnderlined, "DoublyUnderlined"},
+        pair{CharacterStyleMask::CurlyUnderlined, "CurlyUnderlined"},
+        pair{CharacterStyleMask::DottedUnderline, "DottedUnderline"},
+        pair{CharacterStyleMask::DashedUnderline, "DashedUnderline"},
+        pair{CharacterStyleMask::Framed, "Framed"},
+        pair{CharacterStyleMask::Encircled, "Encircled"},
+        pair{CharacterStyleMask::Overline, "Overline"},
+    };
+
+    string s;
+    for (auto const& [style, name] : names)
+    {
+        if (_mask & style)
+        {
+            if (!s.empty())
+                s += '|';
+            s += name;
+        }
+    }
+    return s;
+}
+
+void ApplyGraphicsRendition::add(GraphicsRendition _rendition) noexcept
+{
+    auto const enable = [this](CharacterStyleMask _styles) {
+        setStyles |= _styles;
+        clearStyles &= ~_styles;
+    };
+    auto const disable = [this](CharacterStyleMask _styles) {
+        clearStyles |= _styles;
+        setStyles &= ~_styles;
+    };
+
+    switch (_rendition)
+    {
+        case GraphicsRendition::Reset:
+            *this = ApplyGraphicsRendition{};
+            reset = true;
+            break;
+        case GraphicsRendition::Bold: enable(CharacterStyleMask::Bold); break;
+        case GraphicsRendition::Faint: enable(CharacterStyleMask::Faint); break;
+        case GraphicsRendition::Italic: enable(CharacterStyleMask::Italic); break;
+        case GraphicsRendition::Underline: enable(CharacterStyleMask::Underline); break;
+        case GraphicsRendition::Blinking: enable(CharacterStyleMask::Blinking); break;
+        case GraphicsRendition::Inverse: enable(CharacterStyleMask::Inverse); break;
+        case GraphicsRendition::Hidden: enable(CharacterStyleMask::Hidden); break;
+        case GraphicsRendition::CrossedOut: enable(CharacterStyleMask::CrossedOut); break;
+        case GraphicsRendition::DoublyUnderlined: enable(CharacterStyleMask::DoublyUnderlined); break;
+        case GraphicsRendition::CurlyUnderlined: enable(CharacterStyleMask::CurlyUnderlined); break;
+        case GraphicsRendition::DottedUnderline: enable(CharacterStyleMask::DottedUnderline); break;
+        case GraphicsRendition::DashedUnderline: enable(CharacterStyleMask::DashedUnderline); break;
+        case GraphicsRendition::Framed: enable(CharacterStyleMask::Framed); break;
+        case GraphicsRendition::Overline: enable(CharacterStyleMask::Overline); break;
+        case GraphicsRendition::Normal: disable(CharacterStyleMask::Bold | CharacterStyleMask::Faint); break;
+        case GraphicsRendition::NoItalic: disable(CharacterStyleMask::Italic); break;
+        case GraphicsRendition::NoUnderline: disable(CharacterStyleMask::Underline); break;
+        case GraphicsRendition::NoBlinking: disable(CharacterStyleMask::Blinking); break;
+        case GraphicsRendition::NoInverse: disable(CharacterStyleMask::Inverse); break;
+        case GraphicsRendition::NoHidden: disable(CharacterStyleMask::Hidden); break;
+        case GraphicsRendition::NoCrossedOut: disable(CharacterStyleMask::CrossedOut); break;
+        case GraphicsRendition::NoFramed: disable(CharacterStyleMask::Framed); break;
+        case GraphicsRendition::NoOverline: disable(CharacterStyleMask::Overline); break;
+    }
+}
+
 string to_string(Mode m)
 {
     switch (m)
@@ -329,6 +406,23 @@ class MnemonicBuilder {
     void operator()(SetBackgroundColor const& v) { build("SGR", fmt::format("Set background color to {}", to_string(v.color))); }
     void operator()(SetUnderlineColor const& v) {  build("SGR", fmt::format("Set underline color to {}", to_string(v.color))); }
     void operator()(SetGraphicsRendition const& v) { build("SGR", fmt::format("Select style rendition to {}", to_string(v.rendition))); }
+    void operator()(ApplyGraphicsRendition const& v)
+    {
+        vector<string> changes;
+        if (v.reset)
+            changes.emplace_back("reset");
+        if (v.clearStyles)
+            changes.emplace_back(fmt::format("clear {}", to_string(v.clearStyles)));
+        if (v.setStyles)
+            changes.emplace_back(fmt::format("set {}", to_string(v.setStyles)));
+        if (v.foregroundColor)
+            changes.emplace_back(fmt::format("foreground {}", to_string(*v.foregroundColor)));
+        if (v.backgroundColor)
+            changes.emplace_back(fmt::format("background {}", to_string(*v.backgroundColor)));
+        if (v.underlineColor)
+            changes.emplace_back(fmt::format("underline {}", to_string(*v.underlineColor)));
+        build("SGR", fmt::format("Apply graphics rendition: {}", fmt::join(changes, ", ")));
+    }
     void operator()(SetMark const&) { build("SETMARK", "Sets vertical jump-mark in current line"); }
     void operator()(SetMode const& v) {
         if (v.enable)
@@ -391,6 +485,9 @@ class MnemonicBuilder {
     void operator()(AppendChar const& v) {
         pendingText_ += unicode::to_utf8(v.ch);
     }
+    void operator()(AppendText const& v) {
+        pendingText_ += unicode::to_utf8(v.text);
+    }
 
     void operator()(SetDynamicColor const& v) {
         build("SETDYNCOLOR", fmt::format("{} {}", v.name, to_string(v.color)));
@@ -411,7 +508,7 @@ class MnemonicBuilder {
         build("DECTABSR");
     }
     void operator()(InvalidCommand  const& v) {
-        build("INVALID", fmt::format("{} ({})", v.sequence, v.reason));
+        build("INVALID", fmt::format("{} ({})", *v.sequence, v.reason));
     }
 
   private:
@@ -20,6 +20,7 @@
 
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -62,6 +63,69 @@ enum class GraphicsRendition {
 
 std::string to_string(GraphicsRendition s);
 
+class CharacterStyleMask {
+  public:
+	enum Mask : uint16_t {
+		Bold = (1 << 0),
+		Faint = (1 << 1),
+		Italic = (1 << 2),
+		Underline = (1 << 3),
+		Blinking = (1 << 4),
+		Inverse = (1 << 5),
+		Hidden = (1 << 6),
+		CrossedOut = (1 << 7),
+		DoublyUnderlined = (1 << 8),
+        CurlyUnderlined = (1 << 9),
+        DottedUnderline = (1 << 10),
+        DashedUnderline = (1 << 11),
+        Framed = (1 << 12),
+        Encircled = (1 << 13),
+        Overline = (1 << 14),
+	};
+
+	constexpr CharacterStyleMask() : mask_{} {}
+	constexpr CharacterStyleMask(Mask m) : mask_{m} {}
+	constexpr CharacterStyleMask(unsigned m) : mask_{m} {}
+	constexpr CharacterStyleMask(CharacterStyleMask const& _other) noexcept : mask_{_other.mask_} {}
+
+	constexpr CharacterStyleMask& operator=(CharacterStyleMask const& _other) noexcept
+	{
+		mask_ = _other.mask_;
+		return *this;
+	}
+
+	constexpr unsigned mask() const noexcept { return mask_; }
+
+	constexpr operator unsigned () const noexcept { return mask_; }
+
+  private:
+	unsigned mask_;
+};
+
+std::string to_string(CharacterStyleMask _mask);
+
+constexpr bool operator==(CharacterStyleMask const& a, CharacterStyleMask const& b) noexcept
+{
+	return a.mask() == b.mask();
+}
+
+constexpr CharacterStyleMask& operator|=(CharacterStyleMask& a, CharacterStyleMask const& b) noexcept
+{
+    a = a | b;
+	return a;
+}
+
+constexpr CharacterStyleMask& operator&=(CharacterStyleMask& a, CharacterStyleMask const& b) noexcept
+{
+    a = a & b;
+	return a;
+}
+
+constexpr bool operator!(CharacterStyleMask const& a) noexcept
+{
+	return a.mask() == 0;
+}
+
 enum class Mode {
     // {{{ normal modes
     KeyboardAction,
@@ -244,7 +308,8 @@ struct InvalidCommand {
         Unsupported,
         Invalid
     };
-    Sequence sequence;
+    /// The offending sequence, kept out of line as it is rarely needed and large.
+    std::shared_ptr<Sequence const> sequence;
     Reason reason;
 };
 
@@ -571,8 +636,37 @@ struct SetBackgroundColor { Color color; };
 struct SetUnderlineColor { Color color; };
 struct SetGraphicsRendition { GraphicsRendition rendition; };
 
+/// SGR - Select Graphic Rendition, with all parameters of the sequence coalesced into one delta.
+///
+/// Renditions and colors are folded in the order given, so that applying the delta at once
+/// has the same effect as applying each of them one after another.
+struct ApplyGraphicsRendition {
+    bool reset = false;                     //!< Resets all attributes before applying the others.
+    CharacterStyleMask clearStyles{};       //!< Styles to disable.
+    CharacterStyleMask setStyles{};         //!< Styles to enable.
+    std::optional<Color> foregroundColor{};
+    std::optional<Color> backgroundColor{};
+    std::optional<Color> underlineColor{};
+
+    /// Folds the given rendition into this delta.
+    void add(GraphicsRendition _rendition) noexcept;
+};
+
+inline bool operator==(ApplyGraphicsRendition const& a, ApplyGraphicsRendition const& b) noexcept
+{
+    return a.reset == b.reset
+        && a.clearStyles == b.clearStyles
+        && a.setStyles == b.setStyles
+        && a.foregroundColor == b.foregroundColor
+        && a.backgroundColor == b.backgroundColor
+        && a.underlineColor == b.underlineColor;
+}
+
 struct AppendChar { char32_t ch; };
 
+/// Appends a run of printable text, as if each codepoint was passed via AppendChar.
+struct AppendText { std::u32string text; };
+
 struct SetMode { Mode mode; bool enable; };
 
 /// DECRQM - Request Mode
@@ -946,7 +1040,9 @@ struct SetLogFilePathConfig {
 
 using Command = std::variant<
     AppendChar,
+    AppendText,
     ApplicationKeypadMode,
+    ApplyGraphicsRendition,
     BackIndex,
     Backspace,
     Bell,
@@ -1040,7 +1136,9 @@ class CommandVisitor {
     virtual ~CommandVisitor() = default;
 
     virtual void visit(AppendChar const& v) = 0;
+    virtual void visit(AppendText const& v) = 0;
     virtual void visit(ApplicationKeypadMode const& v) = 0;
+    virtual void visit(ApplyGraphicsRendition const& v) = 0;
     virtual void visit(BackIndex const& v) = 0;
     virtual void visit(Backspace const& v) = 0;
     virtual void visit(Bell const& v) = 0;
@@ -1123,7 +1221,9 @@ class CommandVisitor {
 
     // {{{ Secret std::visit() workaround
     void operator()(AppendChar const& v) { visit(v); }
+    void operator()(AppendText const& v) { visit(v); }
     void operator()(ApplicationKeypadMode const& v) { visit(v); }
+    void operator()(ApplyGraphicsRendition const& v) { visit(v); }
     void operator()(BackIndex const& v) { visit(v); }
     void operator()(Backspace const& v) { visit(v); }
     void operator()(Bell const& v) { visit(v); }
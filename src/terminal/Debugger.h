@@ -51,7 +51,9 @@ class Debugger : public CommandVisitor {
 
     // {{{ CommandExecutor overrides
     void visit(AppendChar const& v) override { enqueue(v); };
+    void visit(AppendText const& v) override { enqueue(v); };
     void visit(ApplicationKeypadMode const& v) override { enqueue(v); };
+    void visit(ApplyGraphicsRendition const& v) override { enqueue(v); };
     void visit(BackIndex const& v) override { enqueue(v); };
     void visit(Backspace const& v) override { enqueue(v); };
     void visit(Bell const& v) override { enqueue(v); };
@@ -25,14 +25,13 @@
 
 #include <array>
 #include <algorithm>
-#include <numeric>
 #include <sstream>
 #include <string>
+#include <type_traits>
 
 using crispy::times;
 using crispy::for_each;
 
-using std::accumulate;
 using std::array;
 using std::for_each;
 using std::pair;
@@ -45,27 +44,116 @@ namespace terminal {
 
 using Parameter = Sequence::Parameter;
 
-FunctionDefinition const* select(FunctionSelector const& _selector)
+namespace // {{{ function lookup
 {
-    auto static const& funcs = functions();
+    /// Packs the fields a function is identified by, except its parameter count,
+    /// into a single integer.
+    ///
+    /// OSC functions are identified by their numeric code instead of a final character.
+    constexpr uint64_t functionKey(FunctionCategory _category, char _leader, char _intermediate, uint32_t _finalOrCode) noexcept
+    {
+        return static_cast<uint64_t>(_category) << 48
+             | static_cast<uint64_t>(static_cast<uint8_t>(_leader)) << 40
+             | static_cast<uint64_t>(static_cast<uint8_t>(_intermediate)) << 32
+             | _finalOrCode;
+    }
 
-    //std::cout << fmt::format("select: {}\n", _selector);
+    constexpr uint64_t functionKey(FunctionDefinition const& _function) noexcept
+    {
+        return functionKey(_function.category,
+                           _function.leader,
+                           _function.intermediate,
+                           _function.category == FunctionCategory::OSC
+                               ? static_cast<uint32_t>(_function.maximumParameters)
+                               : static_cast<uint8_t>(_function.finalSymbol));
+    }
 
-    int a = 0;
-    int b = static_cast<int>(funcs.size()) - 1;
-    while (a <= b)
+    constexpr uint64_t functionKey(FunctionSelector const& _selector) noexcept
     {
-        auto const i = (a + b) / 2;
-        auto const& I = funcs[i];
-        auto const rel = compare(_selector, I);
-        //std::cout << fmt::format(" - a:{:>2} b:{:>2} i:{} rel:{} I: {}\n", a, b, i, rel < 0 ? '<' : rel > 0 ? '>' : '=', I);
-        if (rel > 0)
-            a = i + 1;
-        else if (rel < 0)
-            b = i - 1;
-        else
-            return &I;
+        return functionKey(_selector.category,
+                           _selector.leader,
+                           _selector.intermediate,
+                           _selector.category == FunctionCategory::OSC
+                               ? static_cast<uint32_t>(_selector.argc)
+                               : static_cast<uint8_t>(_selector.finalSymbol));
     }
+
+    constexpr auto FunctionCount = std::tuple_size_v<std::decay_t<decltype(functions())>>;
+    static_assert(FunctionCount < 0xFF, "Function indices must fit into FunctionIndex::slots.");
+
+    /// Perfect hash table, mapping a function key to the first function in functions() with that key.
+    ///
+    /// Functions sharing a key only differ in their parameter count, and are adjacent in functions().
+    struct FunctionIndex
+    {
+        static constexpr unsigned Bits = 10;
+
+        /// Multiplier of the hash function, chosen such that no two distinct keys collide.
+        uint64_t multiplier = 0;
+
+        /// Keys of functions(), by index, followed by a sentinel matching no selector.
+        std::array<uint64_t, FunctionCount + 1> keys{};
+
+        /// Index into functions() by hash, or FunctionCount if no function hashes to it.
+        std::array<uint8_t, 1 << Bits> slots{};
+
+        constexpr size_t hash(uint64_t _key) const noexcept
+        {
+            return static_cast<size_t>((_key * multiplier) >> (64 - Bits));
+        }
+    };
+
+    constexpr FunctionIndex makeFunctionIndex()
+    {
+        auto index = FunctionIndex{};
+
+        for (size_t i = 0; i < FunctionCount; ++i)
+            index.keys[i] = functionKey(functions()[i]);
+        index.keys[FunctionCount] = ~uint64_t{0};
+
+        // Try multipliers from a fixed pseudo random sequence until one is collision free.
+        // With 1024 slots this is usually the case within the first hundred.
+        uint64_t candidate = 0x9E3779B97F4A7C15;
+        for (;;)
+        {
+            index.multiplier = candidate | 1;
+            for (auto& slot : index.slots)
+                slot = FunctionCount;
+
+            bool collision = false;
+            for (size_t i = 0; i < FunctionCount && !collision; ++i)
+            {
+                if (i != 0 && index.keys[i] == index.keys[i - 1])
+                    continue;
+
+                auto& slot = index.slots[index.hash(index.keys[i])];
+                if (slot != FunctionCount)
+                    collision = true;
+                else
+                    slot = static_cast<uint8_t>(i);
+            }
+
+            if (!collision)
+                return index;
+
+            candidate = candidate * 6364136223846793005u + 1442695040888963407u;
+        }
+    }
+
+    constexpr auto functionIndex = makeFunctionIndex();
+} // }}}
+
+FunctionDefinition const* select(FunctionSelector const& _selector)
+{
+    auto const key = functionKey(_selector);
+
+    for (size_t i = functionIndex.slots[functionIndex.hash(key)]; functionIndex.keys[i] == key; ++i)
+    {
+        FunctionDefinition const& function = functions()[i];
+        if (function.minimumParameters <= _selector.argc && _selector.argc <= function.maximumParameters)
+            return &function;
+    }
+
     return nullptr;
 }
 
@@ -82,7 +170,7 @@ std::string Sequence::raw() const
         case FunctionCategory::OSC: sstr << "\033]"; break;
     }
 
-    if (parameterCount() > 1 || (parameterCount() == 1 && parameters_[0][0] != 0))
+    if (parameterCount() > 1 || (parameterCount() == 1 && param(0) != 0))
     {
         for (auto i = 0u; i < parameterCount(); ++i)
         {
@@ -90,7 +178,7 @@ std::string Sequence::raw() const
                 sstr << ';';
 
             sstr << param(i);
-            for (auto k = 1u; k < subParameterCount(i); ++k)
+            for (auto k = 0u; k < subParameterCount(i); ++k)
                 sstr << ':' << subparam(i, k);
         }
     }
@@ -115,35 +203,18 @@ string Sequence::text() const
     if (leaderSymbol_)
         sstr << ' ' << leaderSymbol_;
 
-    if (parameterCount() > 1 || (parameterCount() == 1 && parameters_[0][0] != 0))
+    if (parameterCount() > 1 || (parameterCount() == 1 && param(0) != 0))
     {
-        sstr << ' ' << accumulate(
-            begin(parameters_), end(parameters_), string{},
-            [](string const& a, auto const& p) -> string {
-                return !a.empty()
-                    ? fmt::format("{};{}",
-                            a,
-                            accumulate(
-                                begin(p), end(p),
-                                string{},
-                                [](string const& x, Sequence::Parameter y) -> string {
-                                    return !x.empty()
-                                        ? fmt::format("{}:{}", x, y)
-                                        : std::to_string(y);
-                                }
-                            )
-                        )
-                    : accumulate(
-                            begin(p), end(p),
-                            string{},
-                            [](string const& x, Sequence::Parameter y) -> string {
-                                return !x.empty()
-                                    ? fmt::format("{}:{}", x, y)
-                                    : std::to_string(y);
-                            }
-                        );
-            }
-        );
+        sstr << ' ';
+        for (auto i = 0u; i < parameterCount(); ++i)
+        {
+            if (i)
+                sstr << ';';
+
+            sstr << param(i);
+            for (auto k = 0u; k < subParameterCount(i); ++k)
+                sstr << ':' << subparam(i, k);
+        }
     }
 
     if (!intermediateCharacters().empty())
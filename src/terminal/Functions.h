@@ -19,7 +19,10 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <vector>
@@ -137,30 +140,38 @@ constexpr int compare(FunctionSelector const& a, FunctionDefinition const& b) no
 class Sequence {
   public:
     using Parameter = int;
-    using ParameterList = std::vector<std::vector<Parameter>>;
     using Intermediaries = std::string;
     using DataString = std::string;
 
+    /// Maximum number of parameters, further parameters are ignored.
+    size_t constexpr static MaxParameters = 16;
+
+    /// Maximum number of sub-parameters per parameter, further sub-parameters are ignored.
+    size_t constexpr static MaxSubParameters = 8;
+
+    /// Maximum value of a single (sub-)parameter, larger values are saturated to this value.
+    Parameter constexpr static MaxParameterValue = 0xFFFF;
+
+    /// Default maximum size in bytes of an OSC or DCS payload, larger payloads are rejected.
+    size_t constexpr static DefaultMaxPayloadSize = 8 * 1024 * 1024;
+
   private:
     FunctionCategory category_;
     char leaderSymbol_ = 0;
-    ParameterList parameters_;
+
+    // Parameters and their sub-parameters are stored in one flat array, without allocations.
+    // The parameter at index i is stored at values_[offsets_[i]], directly followed by its sub-parameters.
+    std::array<Parameter, MaxParameters * (1 + MaxSubParameters)> values_{};
+    std::array<uint8_t, MaxParameters> offsets_{};
+    uint8_t parameterCount_ = 0;
+    uint8_t valueCount_ = 0;
+    bool discardingParameter_ = false; // current (sub-)parameter exceeded its limits and is ignored
+
     Intermediaries intermediateCharacters_;
     char finalChar_ = 0;
     DataString dataString_;
 
   public:
-    size_t constexpr static MaxParameters = 16;
-    size_t constexpr static MaxSubParameters = 8;
-
-    Sequence()
-    {
-        parameters_.resize(MaxParameters);
-        for (auto& param : parameters_)
-            param.reserve(MaxSubParameters);
-        parameters_.clear();
-    }
-
     // mutators
     //
     void clear()
@@ -168,20 +179,80 @@ class Sequence {
         category_ = FunctionCategory::C0;
         leaderSymbol_ = 0;
         intermediateCharacters_.clear();
-        parameters_.clear();
+        clearParameters();
         finalChar_ = 0;
         dataString_.clear();
     }
 
     void setCategory(FunctionCategory _cat) noexcept { category_ = _cat; }
     void setLeader(char _ch) noexcept { leaderSymbol_ = _ch; }
-    ParameterList& parameters() noexcept { return parameters_; }
     Intermediaries& intermediateCharacters() noexcept { return intermediateCharacters_; }
     void setFinalChar(char _ch) noexcept { finalChar_ = _ch; }
 
     DataString const& dataString() const noexcept { return dataString_; }
     DataString& dataString() noexcept { return dataString_; }
 
+    void clearParameters() noexcept
+    {
+        parameterCount_ = 0;
+        valueCount_ = 0;
+        discardingParameter_ = false;
+    }
+
+    /// Starts a new parameter with the value 0.
+    ///
+    /// If there are already MaxParameters parameters, this and any further parameter is ignored.
+    void nextParameter() noexcept
+    {
+        if (parameterCount_ < MaxParameters)
+        {
+            offsets_[parameterCount_++] = valueCount_;
+            values_[valueCount_++] = 0;
+            discardingParameter_ = false;
+        }
+        else
+            discardingParameter_ = true;
+    }
+
+    /// Starts a new sub-parameter with the value 0 for the current parameter.
+    ///
+    /// If the current parameter already has MaxSubParameters sub-parameters,
+    /// this and any further sub-parameter of the current parameter is ignored.
+    void nextSubParameter() noexcept
+    {
+        if (discardingParameter_)
+            return;
+
+        if (parameterCount_ == 0)
+            nextParameter();
+
+        if (subParameterCount(parameterCount_ - 1) < MaxSubParameters)
+            values_[valueCount_++] = 0;
+        else
+            discardingParameter_ = true;
+    }
+
+    /// Appends a decimal digit to the current (sub-)parameter, saturating at MaxParameterValue.
+    void appendParameterDigit(Parameter _digit) noexcept
+    {
+        if (discardingParameter_)
+            return;
+
+        if (parameterCount_ == 0)
+            nextParameter();
+
+        auto& value = values_[valueCount_ - 1];
+        value = std::min(value * 10 + _digit, MaxParameterValue);
+    }
+
+    /// Appends a new parameter of the given value.
+    void appendParameter(Parameter _value) noexcept
+    {
+        nextParameter();
+        if (!discardingParameter_)
+            values_[valueCount_ - 1] = _value;
+    }
+
     /// @returns this VT-sequence into a human readable string form.
     std::string text() const;
 
@@ -194,7 +265,7 @@ class Sequence {
         switch (category_)
         {
             case FunctionCategory::OSC:
-                return FunctionSelector{category_, 0, parameters_[0][0], 0, 0};
+                return FunctionSelector{category_, 0, param_or(0, 0), 0, 0};
             default:
             {
                 // Only support CSI sequences with 0 or 1 intermediate characters.
@@ -202,7 +273,7 @@ class Sequence {
                     ? static_cast<char>(intermediateCharacters_[0])
                     : char{};
 
-                return FunctionSelector{category_, leaderSymbol_, static_cast<int>(parameters_.size()), intermediate, finalChar_};
+                return FunctionSelector{category_, leaderSymbol_, static_cast<int>(parameterCount_), intermediate, finalChar_};
             }
         }
     }
@@ -213,14 +284,19 @@ class Sequence {
     Intermediaries const& intermediateCharacters() const noexcept { return intermediateCharacters_; }
     char finalChar() const noexcept { return finalChar_; }
 
-    ParameterList const& parameters() const noexcept { return parameters_; }
-    size_t parameterCount() const noexcept { return parameters_.size(); }
-    size_t subParameterCount(size_t _index) const noexcept { return parameters_[_index].size() - 1; }
+    size_t parameterCount() const noexcept { return parameterCount_; }
+
+    size_t subParameterCount(size_t _index) const noexcept
+    {
+        assert(_index < parameterCount_);
+        auto const end = _index + 1 < parameterCount_ ? offsets_[_index + 1] : valueCount_;
+        return static_cast<size_t>(end - offsets_[_index] - 1);
+    }
 
     std::optional<Parameter> param_opt(size_t _index) const noexcept
     {
-        if (_index < parameters_.size() && parameters_[_index][0])
-            return {parameters_[_index][0]};
+        if (_index < parameterCount_ && values_[offsets_[_index]])
+            return {values_[offsets_[_index]]};
         else
             return std::nullopt;
     }
@@ -232,16 +308,15 @@ class Sequence {
 
     int param(size_t _index) const noexcept
     {
-        assert(_index < parameters_.size());
-        assert(0 < parameters_[_index].size());
-        return parameters_[_index][0];
+        assert(_index < parameterCount_);
+        return values_[offsets_[_index]];
     }
 
     int subparam(size_t _index, size_t _subIndex) const noexcept
     {
-        assert(_index < parameters_.size());
-        assert(_subIndex + 1 < parameters_[_index].size());
-        return parameters_[_index][_subIndex + 1];
+        assert(_index < parameterCount_);
+        assert(_subIndex < subParameterCount(_index));
+        return values_[offsets_[_index] + 1 + _subIndex];
     }
 };
 
@@ -432,9 +507,11 @@ constexpr inline auto RCOLORMOUSEBG = detail::OSC(114, "RCOLORMOUSEBG", "Reset m
 constexpr inline auto NOTIFY        = detail::OSC(777, "NOTIFY", "Send Notification.");
 constexpr inline auto DUMPSTATE     = detail::OSC(888, "DUMPSTATE", "Dumps internal state to debug stream.");
 
-inline auto const& functions()
+namespace detail
 {
-    static auto const funcs = []() constexpr { // {{{
+    /// All known functions, sorted by compare(), so that functions only differing
+    /// in their parameter count are adjacent.
+    constexpr inline auto Functions = []() constexpr { // {{{
         auto f = std::array{
             // C0
             EOT,
@@ -544,13 +621,11 @@ inline auto const& functions()
         crispy::sort(f, [](FunctionDefinition const& a, FunctionDefinition const& b) constexpr { return compare(a, b); });
         return f;
     }();  // }}}
+}
 
-#if 0
-    for (auto [a, b] : crispy::indexed(funcs))
-        std::cout << fmt::format("{:>2}: {}\n", a, b);
-#endif
-
-    return funcs;
+constexpr auto const& functions() noexcept
+{
+    return detail::Functions;
 }
 
 /// Selects a FunctionDefinition based on a FunctionSelector.
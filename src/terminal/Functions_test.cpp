@@ -70,3 +70,115 @@ TEST_CASE("Functions.OSC777", "[Functions]")
     REQUIRE(osc);
     CHECK(*osc == NOTIFY);
 }
+
+TEST_CASE("Functions.select_all", "[Functions]")
+{
+    for (FunctionDefinition const& f : functions())
+    {
+        INFO(fmt::format("function: {}", f.mnemonic));
+        auto const argc = f.category == FunctionCategory::OSC ? f.maximumParameters : f.minimumParameters;
+        FunctionDefinition const* found = select({f.category, f.leader, argc, f.intermediate, f.finalSymbol});
+        REQUIRE(found);
+        CHECK(*found == f);
+    }
+}
+
+TEST_CASE("Functions.select_unknown", "[Functions]")
+{
+    CHECK(terminal::selectOSCommand(4711) == nullptr);
+    CHECK(terminal::selectOSCommand(8 + (1 << 16)) == nullptr);
+    CHECK(terminal::selectControl(0, 0, 0, 'y') == nullptr);
+    CHECK(terminal::selectControl('?', 0, 0, 'm') == nullptr);
+    CHECK(terminal::selectControl(0, 1, 0, 's') == nullptr); // SCOSC takes none, DECSLRM takes two.
+    CHECK(terminal::selectEscape('#', '9') == nullptr);
+}
+
+TEST_CASE("Sequence.parameters", "[Functions]")
+{
+    auto seq = Sequence{};
+    seq.clear();
+    CHECK(seq.parameterCount() == 0);
+    CHECK(!seq.param_opt(0).has_value());
+
+    // "1;38:2:10:20:30;;4"
+    seq.nextParameter();
+    seq.appendParameterDigit(1);
+    seq.nextParameter();
+    seq.appendParameterDigit(3);
+    seq.appendParameterDigit(8);
+    for (int const value : {2, 10, 20, 30})
+    {
+        seq.nextSubParameter();
+        for (char const digit : std::to_string(value))
+            seq.appendParameterDigit(digit - '0');
+    }
+    seq.nextParameter();
+    seq.nextParameter();
+    seq.appendParameterDigit(4);
+
+    REQUIRE(seq.parameterCount() == 4);
+    CHECK(seq.param(0) == 1);
+    CHECK(seq.subParameterCount(0) == 0);
+    CHECK(seq.param(1) == 38);
+    REQUIRE(seq.subParameterCount(1) == 4);
+    CHECK(seq.subparam(1, 0) == 2);
+    CHECK(seq.subparam(1, 1) == 10);
+    CHECK(seq.subparam(1, 2) == 20);
+    CHECK(seq.subparam(1, 3) == 30);
+    CHECK(seq.param(2) == 0);
+    CHECK(!seq.param_opt(2).has_value());
+    CHECK(seq.param_or(2, 7) == 7);
+    CHECK(seq.param(3) == 4);
+    CHECK(seq.subParameterCount(3) == 0);
+
+    seq.clearParameters();
+    CHECK(seq.parameterCount() == 0);
+}
+
+TEST_CASE("Sequence.parameter_overflow", "[Functions]")
+{
+    auto seq = Sequence{};
+    seq.clear();
+
+    SECTION("too many parameters") {
+        for (size_t i = 0; i < Sequence::MaxParameters + 4; ++i)
+        {
+            seq.nextParameter();
+            seq.appendParameterDigit(static_cast<Sequence::Parameter>(i % 10));
+            seq.nextSubParameter();
+        }
+        REQUIRE(seq.parameterCount() == Sequence::MaxParameters);
+        for (size_t i = 0; i < Sequence::MaxParameters; ++i)
+        {
+            CHECK(seq.param(i) == static_cast<Sequence::Parameter>(i % 10));
+            CHECK(seq.subParameterCount(i) == 1);
+        }
+    }
+
+    SECTION("too many sub-parameters") {
+        seq.nextParameter();
+        seq.appendParameterDigit(5);
+        for (size_t i = 0; i < Sequence::MaxSubParameters + 3; ++i)
+        {
+            seq.nextSubParameter();
+            seq.appendParameterDigit(static_cast<Sequence::Parameter>(i % 10));
+        }
+        seq.nextParameter();
+        seq.appendParameterDigit(6);
+
+        REQUIRE(seq.parameterCount() == 2);
+        CHECK(seq.param(0) == 5);
+        REQUIRE(seq.subParameterCount(0) == Sequence::MaxSubParameters);
+        for (size_t i = 0; i < Sequence::MaxSubParameters; ++i)
+            CHECK(seq.subparam(0, i) == static_cast<Sequence::Parameter>(i % 10));
+        CHECK(seq.param(1) == 6);
+    }
+
+    SECTION("value saturation") {
+        seq.nextParameter();
+        for (int i = 0; i < 20; ++i)
+            seq.appendParameterDigit(9);
+        REQUIRE(seq.parameterCount() == 1);
+        CHECK(seq.param(0) == Sequence::MaxParameterValue);
+    }
+}
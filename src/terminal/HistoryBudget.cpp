@@ -0,0 +1,116 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/HistoryBudget.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <utility>
+
+using std::memory_order_relaxed;
+using std::nullopt;
+using std::optional;
+
+namespace terminal {
+
+namespace {
+    constexpr size_t Unlimited = std::numeric_limits<size_t>::max();
+
+    std::atomic<size_t> processUsage_{0};
+    std::atomic<size_t> processUserCount_{0};
+    std::atomic<size_t> processLimit_{Unlimited};
+}
+
+HistoryBudget::HistoryBudget(HistoryBudget&& _other) noexcept :
+    usage_{std::exchange(_other.usage_, 0)},
+    limit_{_other.limit_}
+{
+}
+
+HistoryBudget& HistoryBudget::operator=(HistoryBudget&& _other) noexcept
+{
+    if (this == &_other)
+        return *this;
+
+    remove(usage_);
+    usage_ = std::exchange(_other.usage_, 0);
+    limit_ = _other.limit_;
+    return *this;
+}
+
+HistoryBudget::~HistoryBudget()
+{
+    remove(usage_);
+}
+
+void HistoryBudget::add(size_t _bytes) noexcept
+{
+    if (_bytes == 0)
+        return;
+
+    if (usage_ == 0)
+        processUserCount_.fetch_add(1, memory_order_relaxed);
+
+    usage_ += _bytes;
+    processUsage_.fetch_add(_bytes, memory_order_relaxed);
+}
+
+void HistoryBudget::remove(size_t _bytes) noexcept
+{
+    if (_bytes == 0)
+        return;
+
+    usage_ -= _bytes;
+    processUsage_.fetch_sub(_bytes, memory_order_relaxed);
+
+    if (usage_ == 0)
+        processUserCount_.fetch_sub(1, memory_order_relaxed);
+}
+
+bool HistoryBudget::exceeded() const noexcept
+{
+    if (limit_.has_value() && usage_ > *limit_)
+        return true;
+
+    auto const limit = processLimit_.load(memory_order_relaxed);
+    if (limit == Unlimited || processUsage_.load(memory_order_relaxed) <= limit)
+        return false;
+
+    auto const fairShare = limit / std::max(processUserCount_.load(memory_order_relaxed), size_t{1});
+    return usage_ > fairShare;
+}
+
+size_t HistoryBudget::processUsage() noexcept
+{
+    return processUsage_.load(memory_order_relaxed);
+}
+
+size_t HistoryBudget::processUserCount() noexcept
+{
+    return processUserCount_.load(memory_order_relaxed);
+}
+
+optional<size_t> HistoryBudget::processLimit() noexcept
+{
+    if (auto const limit = processLimit_.load(memory_order_relaxed); limit != Unlimited)
+        return limit;
+    return nullopt;
+}
+
+void HistoryBudget::setProcessLimit(optional<size_t> _bytes) noexcept
+{
+    processLimit_.store(_bytes.value_or(Unlimited), memory_order_relaxed);
+}
+
+} // end namespace
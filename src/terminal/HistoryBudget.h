@@ -0,0 +1,64 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <optional>
+
+namespace terminal {
+
+/// Accounts the bytes taken by a screen buffer's scrollback against a limit of its own
+/// and a process-wide limit shared by all screen buffers.
+///
+/// Once the process-wide limit is exceeded, the budgets using more than their fair share
+/// of it (the limit divided by the number of budgets in use) report being exceeded,
+/// so that the largest scrollbacks give back lines first.
+///
+/// The process-wide figures may be read and changed from any thread.
+class HistoryBudget {
+  public:
+    HistoryBudget() = default;
+    HistoryBudget(HistoryBudget&& _other) noexcept;
+    HistoryBudget& operator=(HistoryBudget&& _other) noexcept;
+    HistoryBudget(HistoryBudget const&) = delete;
+    HistoryBudget& operator=(HistoryBudget const&) = delete;
+    ~HistoryBudget();
+
+    void add(size_t _bytes) noexcept;
+    void remove(size_t _bytes) noexcept;
+
+    /// @returns the number of bytes accounted.
+    size_t usage() const noexcept { return usage_; }
+
+    std::optional<size_t> limit() const noexcept { return limit_; }
+    void setLimit(std::optional<size_t> _bytes) noexcept { limit_ = _bytes; }
+
+    /// @returns whether or not lines should be given back, as explained above.
+    bool exceeded() const noexcept;
+
+    /// @returns the number of bytes accounted by all budgets.
+    static size_t processUsage() noexcept;
+
+    /// @returns the number of budgets accounting any bytes.
+    static size_t processUserCount() noexcept;
+
+    static std::optional<size_t> processLimit() noexcept;
+    static void setProcessLimit(std::optional<size_t> _bytes) noexcept;
+
+  private:
+    size_t usage_ = 0;
+    std::optional<size_t> limit_;
+};
+
+} // end namespace
@@ -0,0 +1,109 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Hyperlink.h>
+
+#include <algorithm>
+#include <cassert>
+
+using std::min;
+using std::nullopt;
+using std::optional;
+using std::string;
+using std::vector;
+
+namespace terminal {
+
+HyperlinkStore::HyperlinkStore(size_t _capacity) :
+    capacity_{min(_capacity, MaxCapacity)},
+    links_(1)
+{
+    assert(capacity_ > 0);
+}
+
+optional<HyperlinkStore::Id> HyperlinkStore::find(string const& _userId, URI const& _uri) const
+{
+    if (auto const i = userIds_.find(_userId); i != userIds_.end() && links_[i->second].link->uri == _uri)
+        return i->second;
+    return nullopt;
+}
+
+optional<HyperlinkStore::Id> HyperlinkStore::add(string const& _userId, URI const& _uri)
+{
+    if (full())
+        return nullopt;
+
+    auto id = Id{};
+    if (!freeIds_.empty())
+    {
+        id = freeIds_.back();
+        freeIds_.pop_back();
+    }
+    else
+    {
+        id = static_cast<Id>(links_.size());
+        links_.emplace_back();
+    }
+
+    links_[id].link = std::make_shared<HyperlinkInfo>(HyperlinkInfo{_userId, _uri});
+    touch(id);
+
+    if (!_userId.empty())
+        userIds_[_userId] = id;
+
+    return id;
+}
+
+void HyperlinkStore::clearUserIds()
+{
+    userIds_.clear();
+}
+
+void HyperlinkStore::beginCollection()
+{
+    for (Entry& entry : links_)
+        entry.marked = false;
+}
+
+void HyperlinkStore::evict(Id _id)
+{
+    Entry& entry = links_[_id];
+    if (auto const i = userIds_.find(entry.link->id); i != userIds_.end() && i->second == _id)
+        userIds_.erase(i);
+    entry.link.reset();
+    freeIds_.push_back(_id);
+}
+
+void HyperlinkStore::endCollection()
+{
+    vector<Id> candidates;
+    for (size_t id = 1; id < links_.size(); ++id)
+    {
+        Entry const& entry = links_[id];
+        if (!entry.link || entry.marked)
+            continue;
+        auto const userId = userIds_.find(entry.link->id);
+        if (userId != userIds_.end() && userId->second == id)
+            candidates.push_back(static_cast<Id>(id));
+        else
+            evict(static_cast<Id>(id));
+    }
+
+    sort(begin(candidates), end(candidates), [&](Id a, Id b) { return links_[a].lastUse < links_[b].lastUse; });
+
+    auto const lowWaterMark = capacity_ * 3 / 4;
+    for (auto i = candidates.begin(); i != candidates.end() && size() > lowWaterMark; ++i)
+        evict(*i);
+}
+
+} // end namespace
@@ -13,10 +13,14 @@
  */
 #pragma once
 
-#include <string>
-#include <unordered_map>
+#include <cstdint>
+#include <limits>
 #include <list>
 #include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace terminal {
 
@@ -74,4 +78,69 @@ using HyperlinkRef = std::shared_ptr<HyperlinkInfo>;
 
 bool is_local(HyperlinkInfo const& _hyperlink);
 
+/// Hyperlinks of a single screen buffer, referenced by cells via small integer IDs.
+///
+/// ID 0 denotes "no hyperlink". Links with an explicit id (as in OSC 8 "id=...") can be found
+/// again by that id, so that separately written parts of the same link remain one link.
+///
+/// The number of links is bounded. Once full, links that are no longer referenced by any cell
+/// are evicted, least recently used first. Which links are still referenced is up to the owning
+/// buffer to find out, by marking them in between beginCollection() and endCollection().
+class HyperlinkStore {
+  public:
+    using Id = uint16_t;
+
+    static size_t constexpr MaxCapacity = std::numeric_limits<Id>::max();
+
+    explicit HyperlinkStore(size_t _capacity = MaxCapacity);
+
+    size_t capacity() const noexcept { return capacity_; }
+
+    /// @returns the number of links currently stored.
+    size_t size() const noexcept { return links_.size() - 1 - freeIds_.size(); }
+
+    bool full() const noexcept { return size() >= capacity_; }
+
+    /// @returns the link of given ID, or nullptr if there is none.
+    HyperlinkRef const& at(Id _id) const noexcept { return links_[_id].link; }
+
+    /// Finds a link that was added with the given user id and URI.
+    std::optional<Id> find(std::string const& _userId, URI const& _uri) const;
+
+    /// Marks the link as most recently used.
+    void touch(Id _id) noexcept { links_[_id].lastUse = ++useCounter_; }
+
+    /// Adds a new link, marked as most recently used.
+    ///
+    /// @returns the new link's ID, or std::nullopt if the store is full.
+    std::optional<Id> add(std::string const& _userId, URI const& _uri);
+
+    /// Forgets all user ids, so that subsequently added links never join previously added ones.
+    void clearUserIds();
+
+    void beginCollection();
+    void mark(Id _id) noexcept { links_[_id].marked = true; }
+
+    /// Evicts links not marked since beginCollection().
+    ///
+    /// Links without a user id can never be referred to again, so all unmarked ones are evicted.
+    /// Others are evicted least recently used first, until the store is filled to three quarters.
+    void endCollection();
+
+  private:
+    struct Entry {
+        HyperlinkRef link;
+        uint64_t lastUse = 0;
+        bool marked = false;
+    };
+
+    void evict(Id _id);
+
+    size_t capacity_;
+    uint64_t useCounter_ = 0;
+    std::vector<Entry> links_;
+    std::vector<Id> freeIds_;
+    std::unordered_map<std::string, Id> userIds_;
+};
+
 } // end namespace
@@ -0,0 +1,207 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/IoReactor.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+using std::lock_guard;
+using std::make_shared;
+using std::move;
+using std::runtime_error;
+using std::shared_ptr;
+using std::string;
+
+namespace terminal {
+
+bool IoReactor::supported() noexcept
+{
+#if defined(__linux__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if defined(__linux__)
+namespace {
+    [[noreturn]] void fail(string const& _what)
+    {
+        throw runtime_error{_what + ". " + strerror(errno)};
+    }
+}
+
+IoReactor::IoReactor(size_t _threadCount, size_t _byteBudget) :
+    byteBudget_{ _byteBudget }
+{
+    assert(_threadCount != 0);
+
+    epoll_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_ < 0)
+        fail("Failed to create I/O reactor");
+
+    if (pipe2(stopPipe_, O_CLOEXEC) < 0)
+        fail("Failed to create I/O reactor");
+
+    // Level triggered, so that it wakes up all threads once stopping.
+    auto event = epoll_event{};
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+    if (epoll_ctl(epoll_, EPOLL_CTL_ADD, stopPipe_[0], &event) < 0)
+        fail("Failed to create I/O reactor");
+
+    for (size_t i = 0; i < _threadCount; ++i)
+        threads_.emplace_back([this]() { run(); });
+}
+
+IoReactor::~IoReactor()
+{
+    if (!threads_.empty())
+    {
+        char const stop = 0;
+        [[maybe_unused]] auto const rv = ::write(stopPipe_[1], &stop, 1);
+        for (auto& thread : threads_)
+            thread.join();
+    }
+
+    for (int const fd : {epoll_, stopPipe_[0], stopPipe_[1]})
+        if (fd >= 0)
+            ::close(fd);
+}
+
+IoReactor::SourceId IoReactor::add(PseudoTerminal& _pty, Handler _handler)
+{
+    auto source = make_shared<Source>();
+    source->handle = _pty.readinessHandle();
+    source->handler = move(_handler);
+
+    auto const _l = lock_guard{mutex_};
+    auto const id = nextId_++;
+    sources_[id] = source;
+
+    auto event = epoll_event{};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = id;
+    if (epoll_ctl(epoll_, EPOLL_CTL_ADD, source->handle, &event) < 0)
+    {
+        sources_.erase(id);
+        fail("Failed to add PTY to I/O reactor");
+    }
+
+    return id;
+}
+
+void IoReactor::remove(SourceId _id)
+{
+    auto source = shared_ptr<Source>{};
+    {
+        auto const _l = lock_guard{mutex_};
+        if (auto i = sources_.find(_id); i != sources_.end())
+        {
+            source = move(i->second);
+            sources_.erase(i);
+        }
+    }
+    if (!source)
+        return;
+
+    auto const _l = lock_guard{source->mutex};
+    if (!source->removed)
+    {
+        source->removed = true;
+        epoll_ctl(epoll_, EPOLL_CTL_DEL, source->handle, nullptr);
+    }
+}
+
+void IoReactor::run()
+{
+    for (;;)
+    {
+        // Taking one event at a time, so that the others are left to the other threads.
+        auto event = epoll_event{};
+        int const count = epoll_wait(epoll_, &event, 1, -1);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 || event.data.u64 == 0)
+            break;
+
+        auto const id = event.data.u64;
+        auto source = shared_ptr<Source>{};
+        {
+            auto const _l = lock_guard{mutex_};
+            if (auto i = sources_.find(id); i != sources_.end())
+                source = i->second;
+        }
+        if (!source)
+            continue;
+
+        auto const _l = lock_guard{source->mutex};
+        if (source->removed)
+            continue;
+
+        if (source->handler(byteBudget_))
+        {
+            // Being one-shot, the PTY is not handled by another thread meanwhile. Re-arming queues it up
+            // behind the ones ready already, if there is output left.
+            rearm(*source, id);
+        }
+        else
+        {
+            source->removed = true;
+            epoll_ctl(epoll_, EPOLL_CTL_DEL, source->handle, nullptr);
+
+            auto const _l2 = lock_guard{mutex_};
+            sources_.erase(id);
+        }
+    }
+}
+
+void IoReactor::rearm(Source const& _source, SourceId _id)
+{
+    auto event = epoll_event{};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = _id;
+    epoll_ctl(epoll_, EPOLL_CTL_MOD, _source.handle, &event);
+}
+#else
+IoReactor::IoReactor(size_t, size_t _byteBudget) :
+    byteBudget_{ _byteBudget }
+{
+    throw runtime_error{"I/O reactor is not supported on this platform."};
+}
+
+IoReactor::~IoReactor()
+{
+}
+
+IoReactor::SourceId IoReactor::add(PseudoTerminal&, Handler)
+{
+    return 0;
+}
+
+void IoReactor::remove(SourceId)
+{
+}
+#endif
+
+} // end namespace
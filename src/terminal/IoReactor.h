@@ -0,0 +1,94 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/PseudoTerminal.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace terminal {
+
+/// Event loop reading the output of many PTYs on a small, fixed number of threads,
+/// as an alternative to each Terminal reading its own PTY on a thread of its own.
+///
+/// Whenever a PTY has output to read, or has been closed, its handler is given one turn on
+/// one of the threads, to consume at most a byte budget of output. If there is more left,
+/// the PTY queues up behind the PTYs that became ready meanwhile, so that one PTY flooding
+/// output delays the others by at most one turn each.
+///
+/// This is only supported on Linux.
+class IoReactor {
+  public:
+    static constexpr size_t DefaultByteBudget = 64 * 1024;
+
+    /// Handles a turn of a PTY that has output to read or has been closed.
+    ///
+    /// @param _byteBudget the most bytes of output to consume during this turn.
+    ///
+    /// @returns false if the PTY is done with, to not be handled anymore.
+    using Handler = std::function<bool(size_t _byteBudget)>;
+
+    using SourceId = uint64_t;
+
+    /// @returns whether IoReactor is supported on this platform.
+    static bool supported() noexcept;
+
+    IoReactor(size_t _threadCount, size_t _byteBudget = DefaultByteBudget);
+    ~IoReactor();
+
+    IoReactor(IoReactor const&) = delete;
+    IoReactor& operator=(IoReactor const&) = delete;
+
+    size_t threadCount() const noexcept { return threads_.size(); }
+    size_t byteBudget() const noexcept { return byteBudget_; }
+
+    /// Starts handling turns of @p _pty by @p _handler.
+    ///
+    /// @returns the ID to remove it by.
+    SourceId add(PseudoTerminal& _pty, Handler _handler);
+
+    /// Stops handling turns of the PTY registered as @p _id, waiting for a turn in progress to finish.
+    ///
+    /// Must not be called from within a handler.
+    void remove(SourceId _id);
+
+  private:
+    struct Source {
+        int handle;
+        Handler handler;
+        std::mutex mutex; // held during a turn
+        bool removed = false;
+    };
+
+    void run();
+    void rearm(Source const& _source, SourceId _id);
+
+    size_t const byteBudget_;
+    int epoll_ = -1;
+    int stopPipe_[2] = {-1, -1};
+
+    std::mutex mutex_;
+    SourceId nextId_ = 1; // 0 identifies stopPipe_
+    std::unordered_map<SourceId, std::shared_ptr<Source>> sources_;
+
+    std::vector<std::thread> threads_;
+};
+
+} // end namespace
@@ -0,0 +1,171 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/IoReactor.h>
+#include <terminal/PtyReader.h>
+#include <terminal/test_pty.h>
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <poll.h>
+#endif
+
+using namespace terminal;
+using namespace std;
+
+#if defined(__linux__)
+using terminal::test::writeToSlave;
+
+namespace {
+    /// Waits for what has been written to the slave side to arrive at the master side,
+    /// which happens asynchronously.
+    bool waitReadable(PseudoTerminal const& _pty)
+    {
+        auto fd = pollfd{_pty.readinessHandle(), POLLIN, 0};
+        return poll(&fd, 1, 5000) == 1;
+    }
+
+    struct Turn {
+        char name;
+        size_t size;
+        bool closed;
+    };
+
+    /// Records the turns taken by a number of PTYs.
+    struct Recorder {
+        mutex lock;
+        condition_variable changed;
+        vector<Turn> turns;
+
+        IoReactor::Handler handler(char _name, PtyReader& _reader, string& _output)
+        {
+            return [=, &_reader, &_output](size_t _byteBudget) {
+                auto turn = Turn{_name, 0, false};
+                while (turn.size < _byteBudget)
+                {
+                    auto const chunk = _reader.readAvailable(_byteBudget - turn.size);
+                    if (!chunk)
+                    {
+                        turn.closed = true;
+                        break;
+                    }
+                    if (chunk->empty())
+                        break;
+                    _output += *chunk;
+                    turn.size += chunk->size();
+                }
+
+                auto const _l = lock_guard{lock};
+                turns.push_back(turn);
+                changed.notify_all();
+                return !turn.closed;
+            };
+        }
+
+        template <typename Predicate>
+        bool waitFor(Predicate _predicate)
+        {
+            auto _l = unique_lock{lock};
+            return changed.wait_for(_l, chrono::seconds{5}, [&]() { return _predicate(turns); });
+        }
+    };
+}
+
+TEST_CASE("IoReactor.fairness", "[pty]")
+{
+    auto constexpr ByteBudget = size_t{512};
+    auto reactor = IoReactor{1, ByteBudget};
+    auto flooding = PseudoTerminal{Size{80, 25}};
+    auto interactive = PseudoTerminal{Size{80, 25}};
+    auto floodingReader = PtyReader{flooding};
+    auto interactiveReader = PtyReader{interactive};
+    auto floodingOutput = string{};
+    auto interactiveOutput = string{};
+    auto recorder = Recorder{};
+
+    auto const flood = string(32 * ByteBudget, 'x');
+    auto written = false;
+    auto writer = thread{[&]() { written = writeToSlave(flooding, flood); }};
+
+    // Holds the flooding PTY's first turn until the interactive PTY is ready, too.
+    auto interactiveAdded = promise<void>{};
+    auto const floodingId = reactor.add(flooding, [&, handler = recorder.handler('f', floodingReader, floodingOutput),
+                                                   added = interactiveAdded.get_future().share()](size_t _byteBudget) {
+        added.wait();
+        return handler(_byteBudget);
+    });
+
+    REQUIRE(writeToSlave(interactive, "ls"));
+    REQUIRE(waitReadable(interactive));
+    auto const interactiveId = reactor.add(interactive, recorder.handler('i', interactiveReader, interactiveOutput));
+    interactiveAdded.set_value();
+
+    REQUIRE(recorder.waitFor([&](auto const& _turns) {
+        size_t consumed = 0;
+        for (auto const& turn : _turns)
+            if (turn.name == 'f')
+                consumed += turn.size;
+        return consumed == flood.size();
+    }));
+    writer.join();
+    CHECK(written);
+
+    // Handlers are done with, having consumed all output.
+    reactor.remove(floodingId);
+    reactor.remove(interactiveId);
+
+    CHECK(interactiveOutput == "ls");
+    CHECK(floodingOutput == flood);
+
+    // The interactive PTY is served after at most one turn of the flooding one,
+    // which in turn takes many turns, none exceeding the budget.
+    auto const& turns = recorder.turns;
+    auto const interactiveTurn = find_if(turns.begin(), turns.end(), [](Turn const& t) { return t.name == 'i'; });
+    REQUIRE(interactiveTurn != turns.end());
+    CHECK(distance(turns.begin(), interactiveTurn) <= 1);
+    CHECK(count_if(turns.begin(), turns.end(), [](Turn const& t) { return t.name == 'f'; }) >= 32);
+    for (auto const& turn : turns)
+        CHECK(turn.size <= ByteBudget);
+}
+
+TEST_CASE("IoReactor.close", "[pty]")
+{
+    auto reactor = IoReactor{2};
+    auto pty = PseudoTerminal{Size{80, 25}};
+    auto reader = PtyReader{pty};
+    auto output = string{};
+    auto recorder = Recorder{};
+
+    auto const id = reactor.add(pty, recorder.handler('p', reader, output));
+    pty.close();
+
+    REQUIRE(recorder.waitFor([](auto const& _turns) { return !_turns.empty(); }));
+
+    // Not handled anymore once closed, even though the handle stays ready.
+    this_thread::sleep_for(chrono::milliseconds{10});
+    reactor.remove(id);
+
+    REQUIRE(recorder.turns.size() == 1);
+    CHECK(recorder.turns[0].closed);
+}
+#endif
@@ -42,6 +42,73 @@ void OutputGenerator::operator()(std::vector<Command> const& commands)
         (*this)(command);
 }
 
+namespace
+{
+    /// SGR codes disabling styles, some of which disable more than one.
+    constexpr pair<unsigned, char const*> sgrClearCodes[] = {
+        {CharacterStyleMask::Bold | CharacterStyleMask::Faint, "22"},
+        {CharacterStyleMask::Italic, "23"},
+        {CharacterStyleMask::Underline, "24"},
+        {CharacterStyleMask::Blinking, "25"},
+        {CharacterStyleMask::Inverse, "27"},
+        {CharacterStyleMask::Hidden, "28"},
+        {CharacterStyleMask::CrossedOut, "29"},
+        {CharacterStyleMask::Framed, "54"},
+        {CharacterStyleMask::Overline, "55"},
+    };
+
+    /// SGR codes enabling styles.
+    constexpr pair<unsigned, char const*> sgrSetCodes[] = {
+        {CharacterStyleMask::Bold, "1"},
+        {CharacterStyleMask::Faint, "2"},
+        {CharacterStyleMask::Italic, "3"},
+        {CharacterStyleMask::Underline, "4"},
+        {CharacterStyleMask::Blinking, "5"},
+        {CharacterStyleMask::Inverse, "7"},
+        {CharacterStyleMask::Hidden, "8"},
+        {CharacterStyleMask::CrossedOut, "9"},
+        {CharacterStyleMask::DoublyUnderlined, "21"},
+        {CharacterStyleMask::CurlyUnderlined, "4:3"},
+        {CharacterStyleMask::DottedUnderline, "4:4"},
+        {CharacterStyleMask::DashedUnderline, "4:5"},
+        {CharacterStyleMask::Framed, "51"},
+        {CharacterStyleMask::Overline, "53"},
+    };
+
+    /// Encodes @p _color as SGR parameters.
+    ///
+    /// @param _base       code of the first of the 8 standard colors, or 0 if there is none (underline)
+    /// @param _extended   code introducing an indexed or RGB color
+    /// @param _default    code selecting the default color
+    /// @param _brightBase code of the first of the 8 bright colors, or 0 if there is none (underline)
+    string sgrColor(Color const& _color, unsigned _base, unsigned _extended, unsigned _default, unsigned _brightBase)
+    {
+        if (holds_alternative<IndexedColor>(_color))
+        {
+            auto const index = static_cast<unsigned>(get<IndexedColor>(_color));
+            if (index < 8 && _base != 0)
+                return fmt::format("{}", _base + index);
+            else
+                return fmt::format("{};5;{}", _extended, index);
+        }
+        else if (holds_alternative<BrightColor>(_color))
+        {
+            auto const index = static_cast<unsigned>(get<BrightColor>(_color));
+            if (_brightBase != 0)
+                return fmt::format("{}", _brightBase + index);
+            else
+                return fmt::format("{};5;{}", _extended, 8 + index);
+        }
+        else if (holds_alternative<RGBColor>(_color))
+        {
+            auto const& rgb = get<RGBColor>(_color);
+            return fmt::format("{};2;{};{};{}", _extended, rgb.red, rgb.green, rgb.blue);
+        }
+        else
+            return fmt::format("{}", _default);
+    }
+}
+
 constexpr optional<char> gnumber(CharsetTable table, CharsetId charset)
 {
     array<char, 4> const std = {'(', ')', '*', '+'};
@@ -421,6 +488,44 @@ void OutputGenerator::operator()(Command const& command)
                 currentBackgroundColor_ = DefaultColor{};
             }
         },
+        [&](ApplyGraphicsRendition const& v) {
+            auto params = vector<string>{};
+            auto const add = [&](auto _param) { params.emplace_back(fmt::format("{}", _param)); };
+
+            if (v.reset)
+            {
+                add(0);
+                currentForegroundColor_ = DefaultColor{};
+                currentBackgroundColor_ = DefaultColor{};
+                currentUnderlineColor_ = DefaultColor{};
+            }
+
+            // Clearing first, as some codes clear more than one style (such as 22 for Bold and Faint).
+            for (auto const& [style, code] : sgrClearCodes)
+                if (v.clearStyles & style)
+                    add(code);
+            for (auto const& [style, code] : sgrSetCodes)
+                if (v.setStyles & style)
+                    add(code);
+
+            if (v.foregroundColor)
+            {
+                currentForegroundColor_ = *v.foregroundColor;
+                add(sgrColor(*v.foregroundColor, 30, 38, 39, 90));
+            }
+            if (v.backgroundColor)
+            {
+                currentBackgroundColor_ = *v.backgroundColor;
+                add(sgrColor(*v.backgroundColor, 40, 48, 49, 100));
+            }
+            if (v.underlineColor)
+            {
+                currentUnderlineColor_ = *v.underlineColor;
+                add(sgrColor(*v.underlineColor, 0, 58, 59, 0));
+            }
+
+            write("\033[{}m", fmt::join(params, ";"));
+        },
         [&](DesignateCharset v) {
             if (auto g = gnumber(v.table, v.charset); g.has_value())
                 if (auto f = finalChar(v.charset); f.has_value())
@@ -440,6 +545,7 @@ void OutputGenerator::operator()(Command const& command)
             }
         },
         [&](AppendChar const& v) { write(v.ch); },
+        [&](AppendText const& v) { write(unicode::to_utf8(v.text)); },
         [&](ChangeIconTitle const& v) { write("\033]1;{}\033\\", v.title); },
         [&](ChangeWindowTitle const& v) { write("\033]2;{}\033\\", v.title); },
         [&](SoftTerminalReset) { write("\033[!p"); },
@@ -452,7 +558,7 @@ void OutputGenerator::operator()(Command const& command)
         },
         [&](SaveWindowTitle const&) { write("\033[22;0;0t"); },
         [&](RestoreWindowTitle const&) { write("\033[23;0;0t"); },
-        [&](InvalidCommand const& v) { write(v.sequence.raw()); }
+        [&](InvalidCommand const& v) { write(v.sequence->raw()); }
     }, command);
 }
 
@@ -28,10 +28,85 @@
 
 #include <fmt/format.h>
 
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define LIBTERMINAL_PARSER_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
 namespace terminal::parser {
 
 using namespace std;
 
+namespace {
+    constexpr bool isPrintable(char32_t _ch) noexcept
+    {
+        return (0x20 <= _ch && _ch <= 0x7E) || 0xA0 <= _ch;
+    }
+
+#if defined(__AVX2__) || defined(LIBTERMINAL_PARSER_SSE2)
+    inline unsigned countTrailingZeros(uint32_t _value) noexcept
+    {
+    #if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, _value);
+        return static_cast<unsigned>(index);
+    #else
+        return static_cast<unsigned>(__builtin_ctz(_value));
+    #endif
+    }
+#endif
+}
+
+char32_t const* scanText(char32_t const* _begin, char32_t const* _end) noexcept
+{
+    auto input = _begin;
+
+    // Signed 32-bit comparisons are fine, as decoded codepoints never exceed 0x1FFFFF.
+    // Each codepoint yields 4 bits in the byte mask.
+#if defined(__AVX2__)
+    auto const lower = _mm256_set1_epi32(0x1F);
+    auto const del = _mm256_set1_epi32(0x7F);
+    auto const c1 = _mm256_set1_epi32(0x9F);
+    while (_end - input >= 8)
+    {
+        auto const batch = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input));
+        auto const printable = _mm256_or_si256(
+            _mm256_and_si256(_mm256_cmpgt_epi32(batch, lower), _mm256_cmpgt_epi32(del, batch)),
+            _mm256_cmpgt_epi32(batch, c1));
+        auto const mask = static_cast<uint32_t>(_mm256_movemask_epi8(printable));
+        if (mask != 0xFFFFFFFFu)
+            return input + countTrailingZeros(~mask) / 4;
+        input += 8;
+    }
+#elif defined(LIBTERMINAL_PARSER_SSE2)
+    auto const lower = _mm_set1_epi32(0x1F);
+    auto const del = _mm_set1_epi32(0x7F);
+    auto const c1 = _mm_set1_epi32(0x9F);
+    while (_end - input >= 4)
+    {
+        auto const batch = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input));
+        auto const printable = _mm_or_si128(
+            _mm_and_si128(_mm_cmpgt_epi32(batch, lower), _mm_cmplt_epi32(batch, del)),
+            _mm_cmpgt_epi32(batch, c1));
+        auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(printable));
+        if (mask != 0xFFFFu)
+            return input + countTrailingZeros(~mask) / 4;
+        input += 4;
+    }
+#endif
+
+    while (input != _end && isPrintable(*input))
+        ++input;
+
+    return input;
+}
+
 using Transition = pair<State, State>;
 using Range = ParserTable::Range;
 using RangeSet = std::vector<Range>;
@@ -14,12 +14,12 @@
 #pragma once
 
 #include <terminal/ControlCode.h>
+#include <terminal/UTF8Decoder.h>
 
 #include <crispy/overloaded.h>
 #include <crispy/range.h>
 
-#include <unicode/utf8.h>
-
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <functional>
@@ -27,6 +27,7 @@
 #include <limits>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
@@ -703,6 +704,15 @@ constexpr ParserTable ParserTable::get() // {{{
     return t;
 } // }}}
 
+/// Scans for the longest run of printable text, starting at @p _begin.
+///
+/// The run consists of printable US-ASCII (U+0020..U+007E) and codepoints not below U+00A0.
+/// It ends at the first C0 control (including ESC), DEL, or C1 control,
+/// which are all left to the state machine.
+///
+/// @returns end of the printable run, which is @p _begin if there is none.
+char32_t const* scanText(char32_t const* _begin, char32_t const* _end) noexcept;
+
 /**
  * Terminal Parser.
  *
@@ -711,16 +721,34 @@ constexpr ParserTable ParserTable::get() // {{{
  *
  * The code comments for enum values have been mostly copied into this source for better
  * understanding when working with this parser.
+ *
+ * The Handler type receives the parser events and must provide:
+ *
+ * @code
+ *   void operator()(ActionClass, Action, char32_t); // a parser action (never Ignore nor Undefined)
+ *   bool acceptsText() const;                       // whether or not print() may be used
+ *   void print(std::u32string_view);                // a run of printable text in Ground state
+ *   void parseError(std::string const&);            // malformed input
+ * @endcode
+ *
+ * Input is decoded from UTF-8 ahead of the state machine, in chunks of up to 4096 bytes.
+ * Invalid UTF-8 is therefore reported before any of the actions of the chunk it is found in,
+ * rather than in between the actions for the codepoints around it.
+ *
+ * The Handler may be a reference type, in which case the parser does not own the handler.
  */
-class Parser {
+template <typename Handler>
+class BasicParser {
   public:
-    using ActionHandler = std::function<void(ActionClass, Action, char32_t)>;
-    using ParseError = std::function<void(std::string const&)>;
     using iterator = uint8_t const*;
 
-    Parser(ActionHandler _actionHandler, ParseError _parseError = {}) :
-        actionHandler_{std::move(_actionHandler)},
-        parseError_{ std::move(_parseError) }
+    /// Constructs the handler from @p _args, leaving copying and moving to the parser's own constructors.
+    template <
+        typename... Args,
+        std::enable_if_t<!(sizeof...(Args) == 1 && (std::is_same_v<std::decay_t<Args>, BasicParser> && ...)), int> = 0
+    >
+    explicit BasicParser(Args&&... _args) :
+        handler_{std::forward<Args>(_args)...}
     {
     }
 
@@ -737,41 +765,101 @@ class Parser {
     }
 
   private:
+    void parseCodepoints(char32_t const* _begin, char32_t const* _end);
     void processInput(char32_t _ch);
 
+    void handle(ActionClass _actionClass, Action _action, char32_t _ch)
+    {
+        if (_action != Action::Ignore && _action != Action::Undefined)
+            handler_(_actionClass, _action, _ch);
+    }
+
   private:
     State state_ = State::Ground;
-    unicode::utf8_decoder_state utf8DecoderState_{};
+    UTF8Decoder utf8Decoder_{};
+
+    /// Input is decoded in chunks of this many bytes, as no byte decodes into more than one codepoint.
+    std::array<char32_t, 4096> codepoints_;
+
+    Handler handler_;
+};
+
+/// Parser event handler, dispatching to type-erased callbacks.
+class CallbackHandler {
+  public:
+    using ActionHandler = std::function<void(ActionClass, Action, char32_t)>;
+    using TextHandler = std::function<void(std::u32string_view)>;
+    using ParseError = std::function<void(std::string const&)>;
 
+    /// @param _actionHandler receives every parser action.
+    /// @param _parseError    invoked on malformed input (may be empty).
+    /// @param _textHandler   if given, receives runs of printable text in Ground state in one call,
+    ///                       instead of one Print action per codepoint.
+    CallbackHandler(ActionHandler _actionHandler, ParseError _parseError = {}, TextHandler _textHandler = {}) :
+        actionHandler_{std::move(_actionHandler)},
+        textHandler_{std::move(_textHandler)},
+        parseError_{ std::move(_parseError) }
+    {
+    }
+
+    void operator()(ActionClass _actionClass, Action _action, char32_t _ch) { actionHandler_(_actionClass, _action, _ch); }
+    bool acceptsText() const noexcept { return static_cast<bool>(textHandler_); }
+    void print(std::u32string_view _text) { textHandler_(_text); }
+
+    void parseError(std::string const& _message)
+    {
+        if (parseError_)
+            parseError_(_message);
+    }
+
+  private:
     ActionHandler actionHandler_;
+    TextHandler textHandler_;
     ParseError const parseError_;
 };
 
-inline void Parser::parseFragment(iterator _begin, iterator _end)
+/// Type-erased parser, as used by tools and tests.
+using Parser = BasicParser<CallbackHandler>;
+
+template <typename Handler>
+void BasicParser<Handler>::parseFragment(iterator _begin, iterator _end)
 {
-    static constexpr char32_t ReplacementCharacter {0xFFFD};
+    auto input = _begin;
+    while (input != _end)
+    {
+        auto const chunkEnd = input + std::min(static_cast<size_t>(_end - input), codepoints_.size());
+        auto const [count, invalidCount] = utf8Decoder_.decode(input, chunkEnd, codepoints_.data());
+        input = chunkEnd;
+
+        for (size_t i = 0; i < invalidCount; ++i)
+            handler_.parseError("Invalid UTF-8 byte sequence received.");
 
-    for (auto const current : crispy::range(_begin, _end))
+        parseCodepoints(codepoints_.data(), codepoints_.data() + count);
+    }
+}
+
+template <typename Handler>
+void BasicParser<Handler>::parseCodepoints(char32_t const* _begin, char32_t const* _end)
+{
+    auto input = _begin;
+    while (input != _end)
     {
-        std::visit(
-            overloaded{
-                [&](unicode::Incomplete) {},
-                [&](unicode::Invalid) {
-                    if (parseError_)
-                        parseError_("Invalid UTF-8 byte sequence received.");
-                    processInput(ReplacementCharacter);
-                },
-                [&](unicode::Success const& success) {
-                    // std::cout << fmt::format("VTParser.parse: ch = {:04X}\n", static_cast<unsigned>(success.value));
-                    processInput(success.value);
-                },
-            },
-            unicode::from_utf8(utf8DecoderState_, current)
-        );
+        if (state_ == State::Ground && handler_.acceptsText())
+        {
+            if (auto const textEnd = scanText(input, _end); textEnd != input)
+            {
+                handler_.print(std::u32string_view(input, static_cast<size_t>(textEnd - input)));
+                input = textEnd;
+                if (input == _end)
+                    break;
+            }
+        }
+        processInput(*input++);
     }
 }
 
-inline void Parser::processInput(char32_t _ch)
+template <typename Handler>
+void BasicParser<Handler>::processInput(char32_t _ch)
 {
     auto const s = static_cast<size_t>(state_);
 
@@ -781,16 +869,15 @@ inline void Parser::processInput(char32_t _ch)
 
     if (auto const t = table.transitions[s][ch]; t != State::Undefined)
     {
-        // actionHandler_(_actionClass, _action, currentChar());
-        actionHandler_(ActionClass::Leave, table.exitEvents[s], _ch);
-        actionHandler_(ActionClass::Transition, table.events[s][ch], _ch);
+        handle(ActionClass::Leave, table.exitEvents[s], _ch);
+        handle(ActionClass::Transition, table.events[s][ch], _ch);
         state_ = t;
-        actionHandler_(ActionClass::Enter, table.entryEvents[static_cast<size_t>(t)], _ch);
+        handle(ActionClass::Enter, table.entryEvents[static_cast<size_t>(t)], _ch);
     }
     else if (Action const a = table.events[s][ch]; a != Action::Undefined)
-        actionHandler_(ActionClass::Event, a, _ch);
-    else if (parseError_)
-        parseError_(fmt::format("Parser Error: Unknown action for state/input pair ({}, 0x{:02X})", state_, static_cast<uint32_t>(ch)));
+        handle(ActionClass::Event, a, _ch);
+    else
+        handler_.parseError(fmt::format("Parser Error: Unknown action for state/input pair ({}, 0x{:02X})", state_, static_cast<uint32_t>(ch)));
 }
 
 void dot(std::ostream& _os, ParserTable const& _table);
@@ -14,9 +14,118 @@
 #include <terminal/Parser.h>
 #include <catch2/catch.hpp>
 
+#include <fmt/format.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
 using namespace std;
 using namespace terminal;
 
+namespace {
+    /// Parses @p _fragments and records every action, flattening text runs into Print events.
+    vector<string> parseAndTrace(vector<string_view> const& _fragments, bool _textFastPath)
+    {
+        auto trace = vector<string>{};
+        auto const actionHandler = [&](parser::ActionClass _class, parser::Action _action, char32_t _ch) {
+            if (_action == parser::Action::Print)
+                trace.emplace_back(fmt::format("Print {:04X}", static_cast<uint32_t>(_ch)));
+            else
+                trace.emplace_back(fmt::format("{} {} {:04X}", _class, _action, static_cast<uint32_t>(_ch)));
+        };
+        auto const textHandler = [&](u32string_view _text) {
+            for (char32_t const ch : _text)
+                trace.emplace_back(fmt::format("Print {:04X}", static_cast<uint32_t>(ch)));
+        };
+        auto const parseError = [&](string const& _msg) { trace.emplace_back(_msg); };
+
+        auto p = _textFastPath ? parser::Parser{actionHandler, parseError, textHandler}
+                               : parser::Parser{actionHandler, parseError};
+        for (auto const fragment : _fragments)
+            p.parseFragment(fragment.data(), fragment.size());
+
+        return trace;
+    }
+
+    size_t scanTextLength(u32string_view _text)
+    {
+        return static_cast<size_t>(parser::scanText(_text.data(), _text.data() + _text.size()) - _text.data());
+    }
+}
+
 TEST_CASE("Parser_subparams", "[parser]")
 {
 }
+
+TEST_CASE("Parser.scanText", "[parser]")
+{
+    CHECK(scanTextLength(U"") == 0);
+    CHECK(scanTextLength(U"\033[m") == 0);
+    CHECK(scanTextLength(U"Hello, World!") == 13);
+    CHECK(scanTextLength(U"Hello\r\nWorld") == 5);
+    CHECK(scanTextLength(U"Hello\033[1mWorld") == 5);
+    CHECK(scanTextLength(U"Hello\x7FWorld") == 5); // DEL
+
+    // long runs, crossing SIMD batch boundaries
+    auto const longText = u32string(1000, U'x');
+    CHECK(scanTextLength(longText) == 1000);
+    CHECK(scanTextLength(longText + U"\a" + longText) == 1000);
+    for (size_t i = 0; i < 70; ++i)
+        CHECK(scanTextLength(u32string(i, U'x') + U"\033") == i);
+
+    // non US-ASCII
+    CHECK(scanTextLength(U"A\u00F6Z") == 3);           // AöZ
+    CHECK(scanTextLength(U"\u20AC\U0001F600") == 2);   // €😀
+    CHECK(scanTextLength(U"A\u0085Z") == 1);           // C1 (NEL)
+    CHECK(scanTextLength(U"A\u009FZ") == 1);           // C1 (APC)
+    CHECK(scanTextLength(U"A\u00A0Z") == 3);           // NBSP
+    CHECK(scanTextLength(U"A\uFFFDZ") == 3);           // replacement character
+}
+
+TEST_CASE("Parser.text_fast_path", "[parser]")
+{
+    auto const fragments = vector<string_view>{
+        "Hello, World!\r\n",
+        "\033[1;31mred\033[m plain \xC3\xB6\xE2\x82\xAC\xF0\x9F\x98\x80 text\n",
+        "C1\xC2\x85" "control, invalid \xFF\xC3Z, split \xE2\x82",
+        "\xAC continued\033]2;title \xC3\xB6\007tail\x7F",
+        "\033P$q\"p\033\\done"
+    };
+
+    CHECK(parseAndTrace(fragments, true) == parseAndTrace(fragments, false));
+}
+
+TEST_CASE("Parser.copy", "[parser]")
+{
+    auto trace = vector<string>{};
+    auto p = parser::Parser{[&](parser::ActionClass, parser::Action _action, char32_t _ch) {
+        trace.emplace_back(fmt::format("{} {:04X}", _action, static_cast<uint32_t>(_ch)));
+    }};
+
+    // Copying a non-const parser copies its handler, and the state it is in.
+    p.parseFragment("\033[", 2);
+    auto copy = parser::Parser(p);
+    copy.parseFragment("m", 1);
+
+    REQUIRE(!trace.empty());
+    CHECK(trace.back() == "CSI_Dispatch 006D");
+}
+
+TEST_CASE("Parser.invalid_utf8", "[parser]")
+{
+    auto constexpr InvalidUTF8 = "Invalid UTF-8 byte sequence received.";
+
+    for (bool const textFastPath : {false, true})
+    {
+        // Invalid UTF-8 is reported ahead of the whole chunk it is decoded in, ...
+        CHECK(parseAndTrace({"A\xFF" "B\xFF"}, textFastPath) == vector<string>{
+            InvalidUTF8, InvalidUTF8, "Print 0041", "Print FFFD", "Print 0042", "Print FFFD"
+        });
+
+        // ... but after the actions of the fragments before.
+        CHECK(parseAndTrace({"A", "\xFF" "B"}, textFastPath) == vector<string>{
+            "Print 0041", InvalidUTF8, "Print FFFD", "Print 0042"
+        });
+    }
+}
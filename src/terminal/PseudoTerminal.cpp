@@ -21,6 +21,7 @@
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 #if !defined(_MSC_VER)
 
@@ -36,11 +37,16 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/ioctl.h>
-#include <sys/select.h>
+#include <poll.h>
 #include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#endif
 #endif
 
 using namespace std;
+using std::chrono::milliseconds;
 
 namespace {
     string GetLastErrorAsString()
@@ -70,6 +76,20 @@ namespace {
         return message;
 #endif
     }
+
+#if defined(__unix__) || defined(__APPLE__)
+    void setFlags(int _fd, int _statusFlags, int _descriptorFlags)
+    {
+        if (fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | _statusFlags) < 0
+                || fcntl(_fd, F_SETFD, fcntl(_fd, F_GETFD) | _descriptorFlags) < 0)
+            throw runtime_error{ "Failed to set up PTY. " + GetLastErrorAsString() };
+    }
+
+    bool wouldBlock() noexcept
+    {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+#endif
 } // anonymous namespace
 
 namespace terminal {
@@ -118,6 +138,31 @@ PseudoTerminal::PseudoTerminal(Size const& _windowSize) :
     // TODO: termios term{};
     if (openpty(&master_, &slave_, nullptr, /*&term*/ nullptr, wsa) < 0)
         throw runtime_error{ "Failed to open PTY. " + GetLastErrorAsString() };
+
+    setFlags(master_, O_NONBLOCK, 0);
+
+    if (pipe(wakeupPipe_) < 0)
+        throw runtime_error{ "Failed to set up PTY. " + GetLastErrorAsString() };
+    setFlags(wakeupPipe_[0], O_NONBLOCK, FD_CLOEXEC);
+    setFlags(wakeupPipe_[1], O_NONBLOCK, FD_CLOEXEC);
+
+#if defined(__linux__)
+    for (auto const& [epoll, masterEvents] : {pair{&epoll_, EPOLLIN}, pair{&outputEpoll_, EPOLLOUT}})
+    {
+        *epoll = epoll_create1(EPOLL_CLOEXEC);
+        if (*epoll < 0)
+            throw runtime_error{ "Failed to set up PTY. " + GetLastErrorAsString() };
+
+        for (auto const& [fd, events] : {pair{master_, masterEvents}, pair{wakeupPipe_[0], EPOLLIN}})
+        {
+            auto event = epoll_event{};
+            event.events = static_cast<uint32_t>(events);
+            event.data.fd = fd;
+            if (epoll_ctl(*epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+                throw runtime_error{ "Failed to set up PTY. " + GetLastErrorAsString() };
+        }
+    }
+#endif
 #else
     master_ = INVALID_HANDLE_VALUE;
     input_ = INVALID_HANDLE_VALUE;
@@ -159,6 +204,17 @@ PseudoTerminal::PseudoTerminal(Size const& _windowSize) :
 PseudoTerminal::~PseudoTerminal()
 {
     close();
+
+#if defined(__unix__) || defined(__APPLE__)
+#if defined(__linux__)
+    for (int const fd : {epoll_, outputEpoll_})
+        if (fd >= 0)
+            ::close(fd);
+#endif
+    for (int const fd : wakeupPipe_)
+        if (fd >= 0)
+            ::close(fd);
+#endif
 }
 
 void PseudoTerminal::close()
@@ -166,6 +222,11 @@ void PseudoTerminal::close()
 #if defined(__unix__) || defined(__APPLE__)
     if (master_ >= 0)
     {
+        // The wakeup pipe stays readable from now on, failing any wait to come.
+        closed_ = true;
+        char const wakeup = 0;
+        [[maybe_unused]] auto const rv = ::write(wakeupPipe_[1], &wakeup, 1);
+
         ::close(master_);
         master_ = -1;
     }
@@ -191,46 +252,7 @@ void PseudoTerminal::close()
 auto PseudoTerminal::read(char* buf, size_t size) -> ssize_t
 {
 #if defined(__unix__) || defined(__APPLE__)
-    ssize_t rv = ::read(master_, buf, size);
-    if (rv < 0 || rv >= static_cast<decltype(rv)>(size))
-        return rv;
-#if 1
-    //size_t const cap = size;
-    ssize_t nread = rv;
-    int i = 1;
-    size -= rv;
-    buf += rv;
-
-    auto const oldFlags = fcntl(master_, F_GETFL);
-    fcntl(master_, F_SETFL, oldFlags | O_NONBLOCK);
-
-    fd_set in, out, err;
-    FD_ZERO(&in);
-    FD_ZERO(&out);
-    FD_ZERO(&err);
-    FD_SET(master_, &in);
-
-    while (size > 0)
-    {
-        ++i;
-        timeval tv{0, 0};
-        int const selected = select(master_ + 1, &in, &out, &err, &tv);
-        if (selected <= 0)
-            break;
-        rv = ::read(master_, buf, size);
-        if (rv < 0)
-            break;
-        nread += rv;
-        size -= rv;
-        buf += rv;
-    }
-
-    fcntl(master_, F_SETFL, oldFlags);
-    //printf("pty.read: %zu/%zu bytes (%ld%%, #%d)\n", nread, cap, nread * 100 / cap, i);
-    return nread;
-#else
-    return rv;
-#endif
+    return read(buf, size, -1);
 #else
     DWORD nread{};
     if (ReadFile(input_, buf, static_cast<DWORD>(size), &nread, nullptr))
@@ -240,10 +262,97 @@ auto PseudoTerminal::read(char* buf, size_t size) -> ssize_t
 #endif
 }
 
+auto PseudoTerminal::read(char* buf, size_t size, milliseconds _timeout) -> ssize_t
+{
+#if defined(__unix__) || defined(__APPLE__)
+    return read(buf, size, static_cast<int>(min(_timeout.count(), milliseconds::rep{numeric_limits<int>::max()})));
+#else
+    DWORD available{};
+    if (!PeekNamedPipe(input_, nullptr, 0, nullptr, &available, nullptr))
+        return -1;
+    if (available == 0)
+        return 0;
+    return read(buf, min(size, static_cast<size_t>(available)));
+#endif
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+auto PseudoTerminal::read(char* buf, size_t size, int _timeoutMillis) -> ssize_t
+{
+    for (;;)
+    {
+        ssize_t const rv = ::read(master_, buf, size);
+        if (rv > 0)
+            return rv;
+
+        // End of file is reported by some platforms once the slave side is closed, others fail with EIO.
+        if (rv == 0)
+            return -1;
+
+        if (errno == EINTR)
+            continue;
+
+        if (!wouldBlock() || closed_)
+            return -1;
+
+        if (_timeoutMillis == 0)
+            return 0;
+
+        switch (wait(false, _timeoutMillis))
+        {
+            case WaitResult::Ready:
+                break;
+            case WaitResult::Timeout:
+                return 0;
+            case WaitResult::Closed:
+                return -1;
+        }
+    }
+}
+
+PseudoTerminal::WaitResult PseudoTerminal::wait(bool _output, int _timeoutMillis)
+{
+#if defined(__linux__)
+    epoll_event events[2];
+    int const count = epoll_wait(_output ? outputEpoll_ : epoll_, events, 2, _timeoutMillis);
+    if (count < 0)
+        return errno == EINTR ? WaitResult::Ready : WaitResult::Closed;
+
+    for (int i = 0; i < count; ++i)
+        if (events[i].data.fd == wakeupPipe_[0])
+            return WaitResult::Closed;
+
+    return count != 0 ? WaitResult::Ready : WaitResult::Timeout;
+#else
+    pollfd fds[2] = {
+        { master_, static_cast<short>(_output ? POLLOUT : POLLIN), 0 },
+        { wakeupPipe_[0], POLLIN, 0 }
+    };
+    int const count = poll(fds, 2, _timeoutMillis);
+    if (count < 0)
+        return errno == EINTR ? WaitResult::Ready : WaitResult::Closed;
+
+    if (fds[1].revents)
+        return WaitResult::Closed;
+
+    return count != 0 ? WaitResult::Ready : WaitResult::Timeout;
+#endif
+}
+#endif
+
 auto PseudoTerminal::write(char const* buf, size_t size) -> ssize_t
 {
 #if defined(__unix__) || defined(__APPLE__)
-    return ::write(master_, buf, size);
+    // The master is non-blocking, so wait for the slave side to catch up if it cannot take it all at once.
+    size_t nwritten = 0;
+    while (nwritten < size)
+    {
+        ssize_t const rv = tryWrite(buf + nwritten, size - nwritten);
+        if (rv < 0 || (rv == 0 && !waitWritable()))
+            return nwritten != 0 ? static_cast<ssize_t>(nwritten) : -1;
+        nwritten += static_cast<size_t>(rv);
+    }
+    return static_cast<ssize_t>(nwritten);
 #else
     DWORD nwritten{};
     if (WriteFile(output_, buf, static_cast<DWORD>(size), &nwritten, nullptr))
@@ -253,6 +362,32 @@ auto PseudoTerminal::write(char const* buf, size_t size) -> ssize_t
 #endif
 }
 
+auto PseudoTerminal::tryWrite(char const* buf, size_t size) -> ssize_t
+{
+#if defined(__unix__) || defined(__APPLE__)
+    for (;;)
+    {
+        ssize_t const rv = ::write(master_, buf, size);
+        if (rv >= 0)
+            return rv;
+        if (errno == EINTR)
+            continue;
+        return wouldBlock() && !closed_ ? 0 : -1;
+    }
+#else
+    return write(buf, size);
+#endif
+}
+
+bool PseudoTerminal::waitWritable()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    return wait(true, -1) != WaitResult::Closed;
+#else
+    return true;
+#endif
+}
+
 Size PseudoTerminal::screenSize() const noexcept
 {
     return size_;
@@ -15,6 +15,8 @@
 
 #include <terminal/Size.h>
 
+#include <atomic>
+#include <chrono>
 #include <map>
 #include <optional>
 #include <string>
@@ -55,10 +57,12 @@ public:
 
 	/// Releases this PTY early.
 	///
+	/// Readers and writers currently waiting on the PTY are woken up and fail.
 	/// This is automatically invoked when the destructor is called.
 	void close();
 
-	/// Reads from the terminal whatever has been written to from the other side of the terminal.
+	/// Reads from the terminal whatever has been written to from the other side of the terminal,
+	/// waiting for something to arrive.
 	///
 	/// @param buf    Target buffer to store the received data to.
 	/// @param size	  Capacity of parameter @p buf. At most @p size bytes will be stored into it.
@@ -66,6 +70,15 @@ public:
 	/// @returns number of bytes stored in @p buf or -1 on error.
 	auto read(char* buf, size_t size) -> ssize_t;
 
+	/// Reads from the terminal whatever has been written to from the other side of the terminal,
+	/// waiting at most @p _timeout for something to arrive.
+	///
+	/// On Windows, this does not wait but only reads what is available already.
+	///
+	/// @returns number of bytes stored in @p buf, 0 if nothing arrived in time,
+	///          or -1 on error or once the PTY has been closed.
+	auto read(char* buf, size_t size, std::chrono::milliseconds _timeout) -> ssize_t;
+
 	/// Writes to the PTY device, so the other end can read from it.
 	///
 	/// @param buf    Buffer of data to be written.
@@ -74,6 +87,18 @@ public:
 	/// @returns Number of bytes written or -1 on error.
 	auto write(char const* buf, size_t size) -> ssize_t;
 
+	/// Writes as much to the PTY device as the other end takes right away, without waiting.
+	///
+	/// On Windows, this waits for everything to be written.
+	///
+	/// @returns Number of bytes written, which may be 0, or -1 on error or once the PTY has been closed.
+	auto tryWrite(char const* buf, size_t size) -> ssize_t;
+
+	/// Waits for the other end to take more input, after tryWrite() could not write everything.
+	///
+	/// @returns false once the PTY has been closed.
+	bool waitWritable();
+
     /// @returns current underlying window size in characters width and height.
     Size screenSize() const noexcept;
 
@@ -88,12 +113,38 @@ public:
 	int slave() const noexcept { return slave_; }
 #endif
 
+#if defined(__linux__)
+	/// @returns a handle that becomes readable whenever there is output to read or the PTY has been closed,
+	///          for event loops to wait on.
+	int readinessHandle() const noexcept { return epoll_; }
+#endif
+
 private:
+#if defined(__unix__) || defined(__APPLE__)
+	enum class WaitResult { Ready, Timeout, Closed };
+
+	/// Waits for the master to become readable (or writable, with @p _output set),
+	/// at most @p _timeoutMillis, or forever if negative.
+	WaitResult wait(bool _output, int _timeoutMillis);
+
+	auto read(char* buf, size_t size, int _timeoutMillis) -> ssize_t;
+#endif
+
 	PtyHandle master_;
     Size size_;
 
 #if defined(__unix__) || defined(__APPLE__)
 	PtyHandle slave_;
+
+	// The master is non-blocking. Waiting for it is done on epoll_ and outputEpoll_ (where available)
+	// for reading and writing respectively, along with the read end of wakeupPipe_,
+	// which close() writes to, to wake up waiters.
+	int wakeupPipe_[2] = {-1, -1};
+	std::atomic<bool> closed_{false};
+#if defined(__linux__)
+	int epoll_ = -1;
+	int outputEpoll_ = -1;
+#endif
 #else
 	IOHandle input_;
 	IOHandle output_;
@@ -0,0 +1,139 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PtyReader.h>
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+using std::nullopt;
+using std::optional;
+using std::string_view;
+using std::chrono::ceil;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+namespace terminal {
+
+optional<string_view> PtyReader::read()
+{
+    // A maximum lowered since the buffer grew takes effect right away, the buffer follows suit.
+    auto const capacity = min(buffer_.size(), maxBufferSize_.load());
+    auto const n = pty_.read(buffer_.data(), capacity);
+    if (n < 0)
+        return nullopt;
+
+    // Only wait for more to arrive under sustained output, but take what is there already in any case.
+    auto deadline = optional<steady_clock::time_point>{};
+    if (capacity > MinBufferSize)
+        deadline = steady_clock::now() + latency();
+
+    return chunk(fill(static_cast<size_t>(n), capacity, deadline));
+}
+
+optional<string_view> PtyReader::readAvailable(size_t _limit)
+{
+    auto const capacity = min({_limit, buffer_.size(), maxBufferSize_.load()});
+    auto const n = pty_.read(buffer_.data(), capacity, milliseconds{0});
+    if (n < 0)
+        return nullopt;
+    if (n == 0)
+        return string_view{};
+
+    return chunk(fill(static_cast<size_t>(n), capacity, nullopt));
+}
+
+size_t PtyReader::fill(size_t _size, size_t _capacity, optional<steady_clock::time_point> _deadline)
+{
+    // Closing is only reported with the next call, after handing over what has been read.
+    ++intervalReads_;
+    while (_size < _capacity)
+    {
+        auto timeout = milliseconds{0};
+        if (_deadline)
+        {
+            auto const now = steady_clock::now();
+            if (now >= *_deadline)
+                break;
+            timeout = ceil<milliseconds>(*_deadline - now);
+        }
+
+        auto const rv = pty_.read(buffer_.data() + _size, _capacity - _size, timeout);
+        if (rv <= 0)
+            break;
+
+        _size += static_cast<size_t>(rv);
+        ++intervalReads_;
+    }
+    return _size;
+}
+
+string_view PtyReader::chunk(size_t _size)
+{
+    account(_size);
+    adaptBufferSize(_size);
+    return string_view{buffer_.data(), _size};
+}
+
+void PtyReader::adaptBufferSize(size_t _chunkSize)
+{
+    auto const maxSize = maxBufferSize_.load();
+    auto const currentSize = buffer_.size();
+
+    auto newSize = currentSize;
+    if (_chunkSize == currentSize)
+        newSize = currentSize * 2;
+    else if (_chunkSize < currentSize / 4)
+        newSize = currentSize / 2;
+    newSize = min(max(newSize, MinBufferSize), maxSize);
+
+    // Shrinking keeps the chunk just read, even if the maximum has been lowered below its size meanwhile.
+    newSize = max(newSize, _chunkSize);
+    if (newSize != currentSize)
+        buffer_.resize(newSize);
+}
+
+void PtyReader::account(size_t _bytes)
+{
+    intervalBytes_ += _bytes;
+
+    auto const now = steady_clock::now();
+    auto const elapsed = now - intervalStart_;
+    if (elapsed < seconds{1})
+        return;
+
+    auto const perSecond = [&](uint64_t _count) {
+        return static_cast<uint64_t>(static_cast<double>(_count) / std::chrono::duration<double>(elapsed).count());
+    };
+    bytesPerSecond_ = perSecond(intervalBytes_);
+    readsPerSecond_ = perSecond(intervalReads_);
+    publishedAt_ = now.time_since_epoch().count();
+
+    intervalStart_ = now;
+    intervalBytes_ = 0;
+    intervalReads_ = 0;
+}
+
+PtyReader::Statistics PtyReader::statistics() const noexcept
+{
+    // Nothing is published while no output arrives, leaving the last figures stale.
+    auto const publishedAt = steady_clock::time_point{steady_clock::duration{publishedAt_.load()}};
+    if (steady_clock::now() - publishedAt > seconds{2})
+        return Statistics{};
+
+    return Statistics{bytesPerSecond_.load(), readsPerSecond_.load()};
+}
+
+} // end namespace
@@ -0,0 +1,96 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/PseudoTerminal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace terminal {
+
+/// Reads the output of a PseudoTerminal in chunks sized to its current throughput.
+///
+/// Whenever a chunk fills the read buffer, the buffer grows, up to a configurable maximum,
+/// and shrinks again once the chunks become small. While the buffer is grown, that is,
+/// under sustained output, reads are coalesced into one chunk until either the buffer is full
+/// or a latency deadline has passed, handing the parser fewer but larger chunks.
+/// Otherwise, such as for echoed keystrokes, output is handed over as soon as it arrives.
+class PtyReader {
+  public:
+    static constexpr size_t MinBufferSize = 4 * 1024;
+    static constexpr size_t DefaultMaxBufferSize = 1024 * 1024;
+    static constexpr std::chrono::milliseconds DefaultLatency{2};
+
+    struct Statistics {
+        uint64_t bytesPerSecond = 0;
+        uint64_t readsPerSecond = 0;
+    };
+
+    explicit PtyReader(PseudoTerminal& _pty) : pty_{_pty} {}
+
+    /// Sets the size the read buffer may grow to, and thus the most bytes coalesced into one chunk.
+    void setMaxBufferSize(size_t _value) noexcept { maxBufferSize_ = std::max(_value, MinBufferSize); }
+    size_t maxBufferSize() const noexcept { return maxBufferSize_; }
+
+    /// Sets how long output may be held back, at most, to be coalesced with what follows.
+    void setLatency(std::chrono::milliseconds _value) noexcept { latency_ = _value.count(); }
+    std::chrono::milliseconds latency() const noexcept { return std::chrono::milliseconds{latency_.load()}; }
+
+    /// Waits for output to arrive and reads it.
+    ///
+    /// @returns the chunk read, valid until the next call, or std::nullopt once the PTY is closed.
+    std::optional<std::string_view> read();
+
+    /// Reads the output available already, without waiting for any to arrive.
+    ///
+    /// @param _limit the most bytes to read.
+    ///
+    /// @returns the chunk read, valid until the next call, which is empty if there is nothing to read,
+    ///          or std::nullopt once the PTY is closed.
+    std::optional<std::string_view> readAvailable(size_t _limit);
+
+    /// @returns the current size of the read buffer.
+    size_t bufferSize() const noexcept { return buffer_.size(); }
+
+    /// Thread-safe query of the throughput of the last full second,
+    /// counting a read for each time output has been found available.
+    Statistics statistics() const noexcept;
+
+  private:
+    size_t fill(size_t _size, size_t _capacity, std::optional<std::chrono::steady_clock::time_point> _deadline);
+    std::string_view chunk(size_t _size);
+    void adaptBufferSize(size_t _chunkSize);
+    void account(size_t _bytes);
+
+    PseudoTerminal& pty_;
+    std::atomic<size_t> maxBufferSize_{DefaultMaxBufferSize};
+    std::atomic<std::chrono::milliseconds::rep> latency_{DefaultLatency.count()};
+    std::vector<char> buffer_ = std::vector<char>(MinBufferSize);
+
+    // Throughput of the current second, published once it has passed.
+    std::chrono::steady_clock::time_point intervalStart_ = std::chrono::steady_clock::now();
+    uint64_t intervalBytes_ = 0;
+    uint64_t intervalReads_ = 0;
+    std::atomic<std::chrono::steady_clock::rep> publishedAt_{intervalStart_.time_since_epoch().count()};
+    std::atomic<uint64_t> bytesPerSecond_{0};
+    std::atomic<uint64_t> readsPerSecond_{0};
+};
+
+} // end namespace
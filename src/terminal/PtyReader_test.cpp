@@ -0,0 +1,118 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PtyReader.h>
+#include <terminal/test_pty.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <thread>
+
+using namespace terminal;
+using namespace std;
+
+#if defined(__unix__) || defined(__APPLE__)
+using terminal::test::writeToSlave;
+
+TEST_CASE("PtyReader.read", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    auto reader = PtyReader{pty};
+
+    REQUIRE(writeToSlave(pty, "Hello"));
+    auto const chunk = reader.read();
+    REQUIRE(chunk.has_value());
+    CHECK(*chunk == "Hello");
+    CHECK(reader.bufferSize() == PtyReader::MinBufferSize);
+}
+
+TEST_CASE("PtyReader.close", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    auto reader = PtyReader{pty};
+
+    // Closing wakes up the reader waiting for output.
+    auto closer = thread{[&]() {
+        this_thread::sleep_for(chrono::milliseconds{10});
+        pty.close();
+    }};
+    CHECK_FALSE(reader.read().has_value());
+    closer.join();
+}
+
+TEST_CASE("PtyReader.adaptBufferSize", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    auto reader = PtyReader{pty};
+    reader.setMaxBufferSize(4 * PtyReader::MinBufferSize);
+
+    auto const text = string(64 * PtyReader::MinBufferSize, 'x');
+    auto written = false;
+    auto writer = thread{[&]() { written = writeToSlave(pty, text); }};
+
+    size_t total = 0;
+    size_t maxBufferSize = 0;
+    while (total < text.size())
+    {
+        auto const chunk = reader.read();
+        REQUIRE(chunk.has_value());
+        CHECK(chunk->find_first_not_of('x') == string_view::npos);
+        total += chunk->size();
+        maxBufferSize = max(maxBufferSize, reader.bufferSize());
+    }
+    writer.join();
+
+    CHECK(written);
+    CHECK(total == text.size());
+    CHECK(maxBufferSize > PtyReader::MinBufferSize);
+    CHECK(maxBufferSize <= reader.maxBufferSize());
+}
+
+TEST_CASE("PtyReader.lowerMaxBufferSize", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    auto reader = PtyReader{pty};
+    reader.setMaxBufferSize(4 * PtyReader::MinBufferSize);
+
+    auto const text = string(64 * PtyReader::MinBufferSize, 'x');
+    auto written = false;
+    auto writer = thread{[&]() { written = writeToSlave(pty, text); }};
+
+    size_t total = 0;
+    auto lowered = false;
+    while (total < text.size())
+    {
+        // The chunk read with the lowered maximum is kept intact as the buffer shrinks.
+        auto const chunk = reader.read();
+        REQUIRE(chunk.has_value());
+        CHECK(chunk->find_first_not_of('x') == string_view::npos);
+        total += chunk->size();
+        if (lowered)
+        {
+            CHECK(chunk->size() <= PtyReader::MinBufferSize);
+            CHECK(reader.bufferSize() == PtyReader::MinBufferSize);
+        }
+        else if (reader.bufferSize() > PtyReader::MinBufferSize)
+        {
+            reader.setMaxBufferSize(PtyReader::MinBufferSize);
+            lowered = true;
+        }
+    }
+    writer.join();
+
+    CHECK(written);
+    CHECK(lowered);
+    CHECK(total == text.size());
+}
+#endif
@@ -0,0 +1,164 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PtyWriter.h>
+
+using std::lock_guard;
+using std::string;
+using std::string_view;
+using std::thread;
+using std::unique_lock;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace terminal {
+
+PtyWriter::~PtyWriter()
+{
+    {
+        auto const _l = lock_guard{mutex_};
+        stopping_ = true;
+    }
+    queued_.notify_one();
+
+    if (writer_.joinable())
+        writer_.join();
+}
+
+void PtyWriter::write(string_view _data)
+{
+    auto const _l = lock_guard{mutex_};
+    if (failed_)
+        return;
+
+    input_.append(_data);
+    schedule(flush());
+}
+
+void PtyWriter::paste(string_view _chunk)
+{
+    auto const _l = lock_guard{mutex_};
+    if (failed_)
+        return;
+
+    pasteChunks_.emplace_back(_chunk);
+    schedule(flush());
+}
+
+size_t PtyWriter::pendingBytes() const
+{
+    auto const _l = lock_guard{mutex_};
+    auto bytes = input_.size() - inputOffset_;
+    for (auto const& chunk : pasteChunks_)
+        bytes += chunk.size();
+    return bytes - pasteOffset_;
+}
+
+PtyWriter::FlushResult PtyWriter::flush()
+{
+    for (;;)
+    {
+        // A paste chunk that has been started is finished first, to not write anything within its brackets.
+        string* buffer = nullptr;
+        size_t* offset = nullptr;
+        if (pasteOffset_ == 0 && inputOffset_ < input_.size())
+        {
+            buffer = &input_;
+            offset = &inputOffset_;
+        }
+        else if (!pasteChunks_.empty())
+        {
+            if (pasteOffset_ == 0 && steady_clock::now() < nextPasteChunk_)
+                return FlushResult::Paced;
+            buffer = &pasteChunks_.front();
+            offset = &pasteOffset_;
+        }
+        else
+            return FlushResult::Done;
+
+        auto const rv = pty_.tryWrite(buffer->data() + *offset, buffer->size() - *offset);
+        if (rv == 0)
+            return FlushResult::Blocked;
+
+        if (rv < 0)
+        {
+            drop();
+            return FlushResult::Done;
+        }
+
+        *offset += static_cast<size_t>(rv);
+        if (*offset != buffer->size())
+            continue;
+
+        if (buffer == &input_)
+        {
+            input_.clear();
+            inputOffset_ = 0;
+        }
+        else
+        {
+            pasteChunks_.pop_front();
+            pasteOffset_ = 0;
+            nextPasteChunk_ = steady_clock::now() + milliseconds{pasteChunkInterval_.load()};
+        }
+    }
+}
+
+void PtyWriter::drop()
+{
+    failed_ = true;
+    input_.clear();
+    inputOffset_ = 0;
+    pasteChunks_.clear();
+    pasteOffset_ = 0;
+}
+
+void PtyWriter::schedule(FlushResult _result)
+{
+    if (_result == FlushResult::Done)
+        return;
+
+    if (!writer_.joinable())
+        writer_ = thread{[this]() { writerThread(); }};
+    else
+        queued_.notify_one();
+}
+
+void PtyWriter::writerThread()
+{
+    auto lock = unique_lock{mutex_};
+    while (!stopping_)
+    {
+        switch (flush())
+        {
+            case FlushResult::Done:
+                queued_.wait(lock);
+                break;
+            case FlushResult::Paced:
+                queued_.wait_until(lock, nextPasteChunk_);
+                break;
+            case FlushResult::Blocked:
+            {
+                // Input queued meanwhile is tried to be written right away, too, so there is no need to wake up.
+                lock.unlock();
+                bool const writable = pty_.waitWritable();
+                lock.lock();
+                if (!writable)
+                    drop();
+                break;
+            }
+        }
+    }
+}
+
+} // end namespace
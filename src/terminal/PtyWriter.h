@@ -0,0 +1,92 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/PseudoTerminal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace terminal {
+
+/// Writes input to a PseudoTerminal without ever waiting for the application to read it.
+///
+/// Input is written right away as far as the PTY takes it. What is left is queued and written
+/// by a thread of its own, started the first time it is needed, whenever the PTY takes more.
+///
+/// Pasted input is queued in chunks, which are written at most one per configurable interval.
+/// Any other input, such as keystrokes, takes priority and goes in between chunks,
+/// so that it is neither held up by a long paste, nor taken as part of a bracketed paste chunk.
+class PtyWriter {
+  public:
+    static constexpr size_t DefaultPasteChunkSize = 4 * 1024;
+    static constexpr std::chrono::milliseconds DefaultPasteChunkInterval{0};
+
+    explicit PtyWriter(PseudoTerminal& _pty) : pty_{_pty} {}
+
+    /// Stops writing, dropping what is left.
+    ///
+    /// If the application is not reading, the PTY must have been closed before.
+    ~PtyWriter();
+
+    /// Sets the most bytes of text to paste in one chunk.
+    void setPasteChunkSize(size_t _value) noexcept { pasteChunkSize_ = std::max(_value, size_t{1}); }
+    size_t pasteChunkSize() const noexcept { return pasteChunkSize_; }
+
+    /// Sets the least time between writing the start of two consecutive paste chunks.
+    void setPasteChunkInterval(std::chrono::milliseconds _value) noexcept { pasteChunkInterval_ = _value.count(); }
+    std::chrono::milliseconds pasteChunkInterval() const noexcept { return std::chrono::milliseconds{pasteChunkInterval_.load()}; }
+
+    /// Writes @p _data ahead of all paste chunks not started yet.
+    void write(std::string_view _data);
+
+    /// Writes @p _chunk after all paste chunks queued before.
+    void paste(std::string_view _chunk);
+
+    /// @returns the number of bytes not written yet.
+    size_t pendingBytes() const;
+
+  private:
+    enum class FlushResult { Done, Blocked, Paced };
+
+    FlushResult flush();
+    void schedule(FlushResult _result);
+    void drop();
+    void writerThread();
+
+    PseudoTerminal& pty_;
+    std::atomic<size_t> pasteChunkSize_{DefaultPasteChunkSize};
+    std::atomic<std::chrono::milliseconds::rep> pasteChunkInterval_{DefaultPasteChunkInterval.count()};
+
+    mutable std::mutex mutex_;
+    std::condition_variable queued_;
+    std::string input_;                   // input to be written ahead of paste chunks not started yet
+    size_t inputOffset_ = 0;              // bytes of input_ written already
+    std::deque<std::string> pasteChunks_;
+    size_t pasteOffset_ = 0;              // bytes of the front paste chunk written already
+    std::chrono::steady_clock::time_point nextPasteChunk_{};
+    bool failed_ = false;                 // PTY closed, dropping all input
+    bool stopping_ = false;
+
+    std::thread writer_;
+};
+
+} // end namespace
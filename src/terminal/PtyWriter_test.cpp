@@ -0,0 +1,125 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PtyWriter.h>
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+using namespace terminal;
+using namespace std;
+
+#if defined(__unix__) || defined(__APPLE__)
+namespace {
+    /// Lets the slave side receive input verbatim, without echoing it back.
+    void makeRaw(PseudoTerminal& _pty)
+    {
+        auto tio = termios{};
+        REQUIRE(tcgetattr(_pty.slave(), &tio) == 0);
+        cfmakeraw(&tio);
+        REQUIRE(tcsetattr(_pty.slave(), TCSANOW, &tio) == 0);
+    }
+
+    string readFromSlave(PseudoTerminal& _pty, size_t _size)
+    {
+        auto text = string(_size, '\0');
+        size_t offset = 0;
+        while (offset < _size)
+        {
+            auto const rv = ::read(_pty.slave(), text.data() + offset, _size - offset);
+            REQUIRE(rv > 0);
+            offset += static_cast<size_t>(rv);
+        }
+        return text;
+    }
+
+    string bracketed(string const& _text)
+    {
+        return "\033[200~" + _text + "\033[201~";
+    }
+}
+
+TEST_CASE("PtyWriter.write", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    makeRaw(pty);
+    auto writer = PtyWriter{pty};
+
+    writer.write("abc");
+    CHECK(writer.pendingBytes() == 0);
+    CHECK(readFromSlave(pty, 3) == "abc");
+}
+
+TEST_CASE("PtyWriter.priority", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    makeRaw(pty);
+    auto writer = PtyWriter{pty};
+
+    // Pasting more than the PTY takes, while the application is not reading, does not wait.
+    auto const chunk = bracketed(string(1024, 'x'));
+    auto constexpr ChunkCount = size_t{256};
+    for (size_t i = 0; i < ChunkCount; ++i)
+        writer.paste(chunk);
+    REQUIRE(writer.pendingBytes() != 0);
+
+    // A keystroke goes ahead of the paste chunks not started yet.
+    writer.write("K");
+
+    auto const input = readFromSlave(pty, ChunkCount * chunk.size() + 1);
+    auto const keystroke = input.find('K');
+    REQUIRE(keystroke != string::npos);
+    CHECK(keystroke < input.size() / 2);
+    CHECK(keystroke % chunk.size() == 0);
+
+    auto expected = string{};
+    for (size_t i = 0; i < ChunkCount; ++i)
+        expected += chunk;
+    CHECK(input.substr(0, keystroke) + input.substr(keystroke + 1) == expected);
+    CHECK(writer.pendingBytes() == 0);
+}
+
+TEST_CASE("PtyWriter.pasteChunkInterval", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    makeRaw(pty);
+    auto writer = PtyWriter{pty};
+    writer.setPasteChunkInterval(chrono::milliseconds{20});
+
+    auto const start = chrono::steady_clock::now();
+    for (auto const text : {"a", "b", "c"})
+        writer.paste(bracketed(text));
+    CHECK(writer.pendingBytes() == 2 * bracketed("a").size());
+
+    CHECK(readFromSlave(pty, 3 * bracketed("a").size()) == bracketed("a") + bracketed("b") + bracketed("c"));
+    CHECK(chrono::steady_clock::now() - start >= chrono::milliseconds{40});
+}
+
+TEST_CASE("PtyWriter.close", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    auto writer = PtyWriter{pty};
+
+    pty.close();
+    writer.write("abc");
+    writer.paste(bracketed("def"));
+    CHECK(writer.pendingBytes() == 0);
+}
+#endif
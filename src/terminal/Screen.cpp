@@ -55,10 +55,7 @@ Screen::Screen(Size const& _size,
     logRaw_{ _logRaw },
     logTrace_{ _logTrace },
     commandBuilder_{ _logger },
-    parser_{
-        ref(commandBuilder_),
-        [this](string const& _msg) { logger_(ParserErrorEvent{_msg}); }
-    },
+    parser_{ commandBuilder_ },
     modes_{},
     primaryBuffer_{ ScreenBuffer::Type::Main, _size, modes_, _maxHistoryLineCount },
     alternateBuffer_{ ScreenBuffer::Type::Alternate, _size, modes_, nullopt },
@@ -67,9 +64,10 @@ Screen::Screen(Size const& _size,
     maxHistoryLineCount_{ _maxHistoryLineCount },
     directExecutor_{ *this, _logger },
     synchronizedExecutor_{ *this, _logger },
-    debugExecutor_{},
-    commandExecutor_ { &directExecutor_ }
+    debugExecutor_{}
 {
+    commandBuilder_.sink().setExecutor(&directExecutor_);
+    updateCommandRecording();
     setMode(Mode::AutoWrap, true);
 }
 
@@ -78,6 +76,16 @@ Debugger* Screen::debugger() noexcept
     return static_cast<Debugger*>(debugExecutor_.get());
 }
 
+void Screen::setMaxResidentHistoryLineCount(std::optional<size_t> _count)
+{
+    primaryBuffer_.setMaxResidentHistoryLineCount(_count);
+}
+
+void Screen::setMaxHistoryBytes(std::optional<size_t> _bytes)
+{
+    primaryBuffer_.setMaxHistoryBytes(_bytes);
+}
+
 void Screen::setMaxHistoryLineCount(std::optional<size_t> _maxHistoryLineCount)
 {
     maxHistoryLineCount_ = _maxHistoryLineCount;
@@ -90,10 +98,22 @@ void Screen::setMaxHistoryLineCount(std::optional<size_t> _maxHistoryLineCount)
 
 void Screen::resize(Size const& _newSize)
 {
+    // Reflowing moves text to other lines, which the selection cannot follow.
+    if (_newSize.width != size_.width && selector_)
+        selector_.reset();
+
+    auto const oldHistoryLineCount = buffer_->historyLineCount();
+
     // TODO: only resize current screen buffer, and then make sure we resize the other upon actual switch
     primaryBuffer_.resize(_newSize);
     alternateBuffer_.resize(_newSize);
     size_ = _newSize;
+
+    // Lines moved into (or out of) the history, or reflowed, are below the viewport,
+    // so it keeps showing the same lines by moving along.
+    if (scrollOffset_ != 0)
+        scrollOffset_ = max(0, min(scrollOffset_ + buffer_->historyLineCount() - oldHistoryLineCount,
+                                   buffer_->historyLineCount()));
 }
 
 void Screen::write(Command const& _command)
@@ -103,12 +123,15 @@ void Screen::write(Command const& _command)
     if (debugging())
         visit(directExecutor_, _command);
     else
-        visit(*commandExecutor_, _command);
+        visit(*commandBuilder_.sink().executor(), _command);
 
     buffer_->verifyState();
-    instructionCounter_++;
+    commandBuilder_.sink().instructionCounter()++;
 
-    eventListener_.commands({_command});
+    if (commandBuilder_.sink().recording())
+        eventListener_.commands({_command});
+    else
+        eventListener_.commands({});
 }
 
 void Screen::write(char const * _data, size_t _size)
@@ -118,37 +141,66 @@ void Screen::write(char const * _data, size_t _size)
         logger_(RawOutputEvent{ escape(_data, _data + _size) });
 #endif
 
+    // Commands are executed as they are being parsed, and only collected
+    // if someone is interested in them.
     commandBuilder_.commands().clear();
     parser_.parseFragment(_data, _size);
 
     buffer_->verifyState();
 
-    // #if defined(LIBTERMINAL_LOG_TRACE)
-    // if (logTrace_ && logger_)
-    // {
-    //     auto const traces = to_mnemonic(commandBuilder_.commands(), true, true);
-    //     for (auto const& trace : traces)
-    //         logger_(TraceOutputEvent{trace});
-    // }
-    // #endif
-
-    for_each(
-        commandBuilder_.commands(),
-        [&](Command const& _command) {
-            buffer_->verifyState();
 #if defined(LIBTERMINAL_LOG_TRACE)
-            auto const trace = to_mnemonic(_command, true, true);
-            logger_(TraceOutputEvent{trace});
+    if (logTrace_ && logger_)
+        for (Command const& command : commandBuilder_.commands())
+            logger_(TraceOutputEvent{to_mnemonic(command, true, true)});
 #endif
-            visit(*commandExecutor_, _command);
-            instructionCounter_++;
-            buffer_->verifyState();
-        }
-    );
 
     eventListener_.commands(commandBuilder_.commands());
 }
 
+void Screen::write(CommandList const& _commands)
+{
+    auto& sink = commandBuilder_.sink();
+    for (Command const& command : _commands)
+    {
+        visit(*sink.executor(), command);
+        sink.instructionCounter()++;
+    }
+
+    buffer_->verifyState();
+
+#if defined(LIBTERMINAL_LOG_TRACE)
+    if (logTrace_ && logger_)
+        for (Command const& command : _commands)
+            logger_(TraceOutputEvent{to_mnemonic(command, true, true)});
+#endif
+
+    if (sink.recording())
+        eventListener_.commands(_commands);
+    else
+        eventListener_.commands({});
+}
+
+void Screen::setCommandRecording(bool _enabled)
+{
+    commandRecording_ = _enabled;
+    updateCommandRecording();
+}
+
+void Screen::setLogTrace(bool _enabled)
+{
+    logTrace_ = _enabled;
+    updateCommandRecording();
+}
+
+void Screen::updateCommandRecording()
+{
+#if defined(LIBTERMINAL_LOG_TRACE)
+    commandBuilder_.sink().setRecording(commandRecording_ || logTrace_);
+#else
+    commandBuilder_.sink().setRecording(commandRecording_);
+#endif
+}
+
 void Screen::write(std::u32string_view const& _text)
 {
     for (char32_t codepoint : _text)
@@ -161,19 +213,29 @@ void Screen::write(std::u32string_view const& _text)
 
 void Screen::writeText(char32_t _char)
 {
-    buffer_->appendChar(_char, instructionCounter_ == 1);
-    instructionCounter_ = 0;
+    auto& instructionCounter = commandBuilder_.sink().instructionCounter();
+    buffer_->appendChar(_char, instructionCounter == 1);
+    instructionCounter = 0;
 }
 
-string Screen::renderHistoryTextLine(cursor_pos_t _lineNumberIntoHistory) const
+void Screen::writeText(u32string_view _text)
 {
+    // Only the first codepoint may be non-consecutive to the previously written text,
+    // all the others directly follow each other.
+    auto& instructionCounter = commandBuilder_.sink().instructionCounter();
+    buffer_->writeText(_text, instructionCounter == 1);
+    instructionCounter = 0;
+}
+
+string Screen::renderHistoryTextLine(cursor_pos_t _lineNumberIntoHistory)
+{
+    reflowHistory(static_cast<size_t>(_lineNumberIntoHistory));
     assert(1 <= _lineNumberIntoHistory && _lineNumberIntoHistory <= buffer_->historyLineCount());
     string line;
     line.reserve(size_.width);
-    auto const lineIter = next(buffer_->savedLines.rbegin(), _lineNumberIntoHistory - 1);
-    for (Cell const& cell : *lineIter)
+    for (Cell const& cell : buffer_->lineAt(1 - _lineNumberIntoHistory))
         if (cell.codepointCount())
-            line += cell.toUtf8();
+            line += buffer_->view(cell).toUtf8();
         else
             line += " "; // fill character
 
@@ -194,6 +256,14 @@ vector<Selector::Range> Screen::selection() const
         return {};
 }
 
+void Screen::reflowHistory(size_t _count)
+{
+    buffer_->reflowHistory(_count);
+
+    // Lines beyond the history's limit may have been dropped after growing by reflowing.
+    scrollOffset_ = min(scrollOffset_, buffer_->historyLineCount());
+}
+
 // {{{ viewport management
 bool Screen::isLineVisible(cursor_pos_t _row) const noexcept
 {
@@ -205,9 +275,14 @@ bool Screen::scrollUp(int _numLines)
     if (isAlternateScreen()) // TODO: make configurable
         return false;
 
+    // Scrollback lines are reflowed to the current width as they come into view.
+    reflowHistory(static_cast<size_t>(scrollOffset_ + _numLines + size_.height));
+
     if (auto const newOffset = min(scrollOffset_ + _numLines, historyLineCount()); newOffset != scrollOffset_)
     {
         scrollOffset_ = newOffset;
+        buffer_->trimHistory();
+        buffer_->markAllDamaged();
         return true;
     }
     else
@@ -222,6 +297,8 @@ bool Screen::scrollDown(int _numLines)
     if (auto const newOffset = scrollOffset_ >= _numLines ? scrollOffset_ - _numLines : 0; newOffset != scrollOffset_)
     {
         scrollOffset_ = newOffset;
+        buffer_->trimHistory();
+        buffer_->markAllDamaged();
         return true;
     }
     else
@@ -233,6 +310,7 @@ bool Screen::scrollMarkUp()
     if (auto const newScrollOffset = buffer_->findMarkerBackward(-scrollOffset_); newScrollOffset.has_value())
     {
         scrollOffset_ = 1 - newScrollOffset.value();
+        buffer_->markAllDamaged();
         return true;
     }
 
@@ -244,6 +322,7 @@ bool Screen::scrollMarkDown()
     if (auto const newScrollOffset = buffer_->findMarkerForward(1 - scrollOffset_); newScrollOffset.has_value())
     {
         scrollOffset_ = *newScrollOffset < 0 ? 1 - newScrollOffset.value() : 0;
+        buffer_->markAllDamaged();
         return true;
     }
 
@@ -255,6 +334,7 @@ bool Screen::scrollToTop()
     if (auto top = historyLineCount(); top != scrollOffset_)
     {
         scrollOffset_ = top;
+        buffer_->markAllDamaged();
         return true;
     }
     else
@@ -266,6 +346,7 @@ bool Screen::scrollToBottom()
     if (scrollOffset_ != 0)
     {
         scrollOffset_ = 0;
+        buffer_->markAllDamaged();
         return true;
     }
     else
@@ -333,6 +414,8 @@ void Screen::setBuffer(ScreenBuffer::Type _type)
 {
     if (bufferType() != _type)
     {
+        auto const damageGeneration = buffer_->damageGeneration();
+
         switch (_type)
         {
             case ScreenBuffer::Type::Main:
@@ -345,12 +428,18 @@ void Screen::setBuffer(ScreenBuffer::Type _type)
                 else
                     eventListener_.setMouseWheelMode(InputGenerator::MouseWheelMode::NormalCursorKeys);
                 buffer_ = &alternateBuffer_;
+                // Link IDs of a previous full screen application must not carry over.
+                buffer_->pool.hyperlinks().clearUserIds();
                 break;
         }
 
         if (selector_)
             selector_.reset();
 
+        // Damage generations carry over, so that changes are told apart regardless of the buffer.
+        buffer_->setDamageGeneration(damageGeneration);
+        buffer_->markAllDamaged();
+
         eventListener_.bufferChanged(_type);
     }
 }
@@ -454,16 +543,18 @@ void Screen::sendTerminalId()
 void Screen::clearToEndOfScreen()
 {
     if (isAlternateScreen() && buffer_->cursor.position.row == 1 && buffer_->cursor.position.column == 1)
-        buffer_->hyperlinks.clear();
+        buffer_->pool.hyperlinks().clearUserIds();
 
     clearToEndOfLine();
+    buffer_->markDamaged(buffer_->cursor.position.row, size_.height);
 
     for_each(
         LIBTERMINAL_EXECUTION_COMMA(par)
-        next(buffer_->currentLine),
+        buffer_->lineIteratorAt(buffer_->cursor.position.row + 1),
         end(buffer_->lines),
         [&](ScreenBuffer::Line& line) {
-            fill(begin(line), end(line), Cell{{}, buffer_->cursor.graphicsRendition});
+            fill(begin(line), end(line), Cell{{}, buffer_->cursorAttributesId()});
+            line.wrapped = false;
         }
     );
 }
@@ -471,13 +562,15 @@ void Screen::clearToEndOfScreen()
 void Screen::clearToBeginOfScreen()
 {
     clearToBeginOfLine();
+    buffer_->markDamaged(1, buffer_->cursor.position.row);
 
     for_each(
         LIBTERMINAL_EXECUTION_COMMA(par)
-        begin(buffer_->lines),
-        buffer_->currentLine,
+        buffer_->lineIteratorAt(1),
+        buffer_->lineIteratorAt(buffer_->cursor.position.row),
         [&](ScreenBuffer::Line& line) {
-            fill(begin(line), end(line), Cell{{}, buffer_->cursor.graphicsRendition});
+            fill(begin(line), end(line), Cell{{}, buffer_->cursorAttributesId()});
+            line.wrapped = false;
         }
     );
 }
@@ -495,7 +588,10 @@ void Screen::clearScrollbackBuffer()
     if (selector_)
         selector_.reset();
 
-    buffer_->savedLines.clear();
+    buffer_->clearHistory();
+
+    if (scrollOffset_ != 0)
+        buffer_->markAllDamaged();
 }
 
 void Screen::eraseCharacters(int _n)
@@ -504,34 +600,39 @@ void Screen::eraseCharacters(int _n)
     // It's not clear from the spec how to perform erase when inside margin and number of chars to be erased would go outside margins.
     // TODO: See what xterm does ;-)
     size_t const n = min(buffer_->size_.width - realCursorPosition().column + 1, _n == 0 ? 1 : _n);
-    fill_n(buffer_->currentColumn, n, Cell{{}, buffer_->cursor.graphicsRendition});
+    fill_n(buffer_->currentColumn, n, Cell{{}, buffer_->cursorAttributesId()});
+    buffer_->markDamaged(buffer_->cursor.position.row);
 }
 
 void Screen::clearToEndOfLine()
 {
     fill(
         buffer_->currentColumn,
-        end(*buffer_->currentLine),
-        Cell{{}, buffer_->cursor.graphicsRendition}
+        end(buffer_->currentLine()),
+        Cell{{}, buffer_->cursorAttributesId()}
     );
+    buffer_->markDamaged(buffer_->cursor.position.row);
 }
 
 void Screen::clearToBeginOfLine()
 {
     fill(
-        begin(*buffer_->currentLine),
+        begin(buffer_->currentLine()),
         next(buffer_->currentColumn),
-        Cell{{}, buffer_->cursor.graphicsRendition}
+        Cell{{}, buffer_->cursorAttributesId()}
     );
+    buffer_->markDamaged(buffer_->cursor.position.row);
 }
 
 void Screen::clearLine()
 {
     fill(
-        begin(*buffer_->currentLine),
-        end(*buffer_->currentLine),
-        Cell{{}, buffer_->cursor.graphicsRendition}
+        begin(buffer_->currentLine()),
+        end(buffer_->currentLine()),
+        Cell{{}, buffer_->cursorAttributesId()}
     );
+    buffer_->currentLine().wrapped = false;
+    buffer_->markDamaged(buffer_->cursor.position.row);
 }
 
 void Screen::moveCursorToNextLine(int _n)
@@ -618,21 +719,12 @@ void Screen::horizontalTabSet()
 
 void Screen::hyperlink(string const& _id, string const& _uri)
 {
+    // Each buffer has its own hyperlink store, so that links created by full screen applications
+    // in the alternate screen do not compete with (or resolve to) the ones in the primary screen.
     if (_uri.empty())
-        buffer_->currentHyperlink = nullptr;
-    else if (_id.empty())
-        buffer_->currentHyperlink = make_shared<HyperlinkInfo>(HyperlinkInfo{_id, _uri});
-    else if (auto i = buffer_->hyperlinks.find(_id); i != buffer_->hyperlinks.end())
-        buffer_->currentHyperlink = i->second;
+        buffer_->currentHyperlink = 0;
     else
-    {
-        buffer_->currentHyperlink = make_shared<HyperlinkInfo>(HyperlinkInfo{_id, _uri});
-        buffer_->hyperlinks[_id] = buffer_->currentHyperlink;
-    }
-    // TODO:
-    // Care about eviction.
-    // Move hyperlink store into ScreenBuffer, so it gets reset upon every switch into
-    // alternate screen (not for main screen!)
+        buffer_->currentHyperlink = buffer_->acquireHyperlink(_id, _uri);
 }
 
 void Screen::moveCursorUp(int _n)
@@ -645,7 +737,6 @@ void Screen::moveCursorUp(int _n)
     );
 
     buffer_->cursor.position.row -= n;
-    buffer_->currentLine = prev(buffer_->currentLine, n);
     buffer_->setCurrentColumn(cursorPosition().column);
     buffer_->verifyState();
 }
@@ -665,7 +756,6 @@ void Screen::moveCursorDown(int _n)
     //         : min(v.n, buffer_->margin_.vertical.to - cursorPosition().row);
 
     buffer_->cursor.position.row += n;
-    buffer_->currentLine = next(buffer_->currentLine, n);
     buffer_->setCurrentColumn(cursorPosition().column);
 }
 
@@ -856,90 +946,31 @@ void Screen::setCursorStyle(CursorDisplay _display, CursorShape _shape)
 
 void Screen::setGraphicsRendition(GraphicsRendition _rendition)
 {
-    // TODO: optimize this as there are only 3 cases
-    // 1.) reset
-    // 2.) set some bits |=
-    // 3.) clear some bits &= ~
-    switch (_rendition)
-    {
-        case GraphicsRendition::Reset:
-            buffer_->cursor.graphicsRendition = {};
-            break;
-        case GraphicsRendition::Bold:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::Bold;
-            break;
-        case GraphicsRendition::Faint:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::Faint;
-            break;
-        case GraphicsRendition::Italic:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::Italic;
-            break;
-        case GraphicsRendition::Underline:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::Underline;
-            break;
-        case GraphicsRendition::Blinking:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::Blinking;
-            break;
-        case GraphicsRendition::Inverse:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::Inverse;
-            break;
-        case GraphicsRendition::Hidden:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::Hidden;
-            break;
-        case GraphicsRendition::CrossedOut:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::CrossedOut;
-            break;
-        case GraphicsRendition::DoublyUnderlined:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::DoublyUnderlined;
-            break;
-        case GraphicsRendition::CurlyUnderlined:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::CurlyUnderlined;
-            break;
-        case GraphicsRendition::DottedUnderline:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::DottedUnderline;
-            break;
-        case GraphicsRendition::DashedUnderline:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::DashedUnderline;
-            break;
-        case GraphicsRendition::Framed:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::Framed;
-            break;
-        case GraphicsRendition::Overline:
-            buffer_->cursor.graphicsRendition.styles |= CharacterStyleMask::Overline;
-            break;
-        case GraphicsRendition::Normal:
-            buffer_->cursor.graphicsRendition.styles &= ~(CharacterStyleMask::Bold | CharacterStyleMask::Faint);
-            break;
-        case GraphicsRendition::NoItalic:
-            buffer_->cursor.graphicsRendition.styles &= ~CharacterStyleMask::Italic;
-            break;
-        case GraphicsRendition::NoUnderline:
-            buffer_->cursor.graphicsRendition.styles &= ~CharacterStyleMask::Underline;
-            break;
-        case GraphicsRendition::NoBlinking:
-            buffer_->cursor.graphicsRendition.styles &= ~CharacterStyleMask::Blinking;
-            break;
-        case GraphicsRendition::NoInverse:
-            buffer_->cursor.graphicsRendition.styles &= ~CharacterStyleMask::Inverse;
-            break;
-        case GraphicsRendition::NoHidden:
-            buffer_->cursor.graphicsRendition.styles &= ~CharacterStyleMask::Hidden;
-            break;
-        case GraphicsRendition::NoCrossedOut:
-            buffer_->cursor.graphicsRendition.styles &= ~CharacterStyleMask::CrossedOut;
-            break;
-        case GraphicsRendition::NoFramed:
-            buffer_->cursor.graphicsRendition.styles &= ~CharacterStyleMask::Framed;
-            break;
-        case GraphicsRendition::NoOverline:
-            buffer_->cursor.graphicsRendition.styles &= ~CharacterStyleMask::Overline;
-            break;
-    }
+    auto sgr = ApplyGraphicsRendition{};
+    sgr.add(_rendition);
+    applyGraphicsRendition(sgr);
+}
+
+void Screen::applyGraphicsRendition(ApplyGraphicsRendition const& _sgr)
+{
+    auto& attributes = buffer_->cursor.graphicsRendition;
+
+    if (_sgr.reset)
+        attributes = {};
+
+    attributes.styles = (attributes.styles & ~_sgr.clearStyles) | _sgr.setStyles;
+
+    if (_sgr.foregroundColor)
+        attributes.foregroundColor = *_sgr.foregroundColor;
+    if (_sgr.backgroundColor)
+        attributes.backgroundColor = *_sgr.backgroundColor;
+    if (_sgr.underlineColor)
+        attributes.underlineColor = *_sgr.underlineColor;
 }
 
 void Screen::setMark()
 {
-    buffer_->currentLine->marked = true;
+    buffer_->currentLine().marked = true;
 }
 
 void Screen::setDebugging(bool _enabled)
@@ -950,11 +981,11 @@ void Screen::setDebugging(bool _enabled)
     if (_enabled)
     {
         debugExecutor_ = make_unique<Debugger>(*this);
-        commandExecutor_ = debugExecutor_.get();
+        commandBuilder_.sink().setExecutor(debugExecutor_.get());
     }
     else
     {
-        commandExecutor_ = &directExecutor_;
+        commandBuilder_.sink().setExecutor(&directExecutor_);
         debugger()->flush();
         debugExecutor_.reset();
     }
@@ -992,10 +1023,10 @@ void Screen::setMode(Mode _mode, bool _enable)
             if (!debugging())
             {
                 if (_enable)
-                    commandExecutor_ = &synchronizedExecutor_;
+                    commandBuilder_.sink().setExecutor(&synchronizedExecutor_);
                 else
                 {
-                    commandExecutor_ = &directExecutor_;
+                    commandBuilder_.sink().setExecutor(&directExecutor_);
                     synchronizedExecutor_.flush();
                 }
             }
@@ -1041,6 +1072,10 @@ void Screen::setMode(Mode _mode, bool _enable)
             break;
     }
 
+    // Reverse video changes the colors of all cells.
+    if (_mode == Mode::ReverseVideo && _enable != isModeEnabled(_mode))
+        buffer_->markAllDamaged();
+
     modes_.set(_mode, _enable);
     buffer_->setMode(_mode, _enable);
 }
@@ -1110,16 +1145,17 @@ void Screen::screenAlignmentPattern()
     moveCursorTo({1, 1});
 
     // fills the complete screen area with a test pattern
+    buffer_->markAllDamaged();
     for_each(
         LIBTERMINAL_EXECUTION_COMMA(par)
-        begin(buffer_->lines),
+        buffer_->lineIteratorAt(1),
         end(buffer_->lines),
         [&](ScreenBuffer::Line& line) {
             fill(
                 LIBTERMINAL_EXECUTION_COMMA(par)
                 begin(line),
                 end(line),
-                Cell{'E', buffer_->cursor.graphicsRendition}
+                Cell{'E', buffer_->cursorAttributesId()}
             );
         }
     );
@@ -1267,11 +1303,13 @@ void Screen::requestTabStops()
 void Screen::resetDynamicColor(DynamicColorName _name)
 {
     eventListener_.resetDynamicColor(_name);
+    buffer_->markAllDamaged();
 }
 
 void Screen::setDynamicColor(DynamicColorName _name, RGBColor const& _color)
 {
     eventListener_.setDynamicColor(_name, _color);
+    buffer_->markAllDamaged();
 }
 
 void Screen::dumpState()
@@ -1282,7 +1320,9 @@ void Screen::dumpState()
 
 // {{{ DirectExecutor
 void DirectExecutor::visit(AppendChar const& v) { screen_.writeText(v.ch); }
+void DirectExecutor::visit(AppendText const& v) { screen_.writeText(v.text); }
 void DirectExecutor::visit(ApplicationKeypadMode const& v) { screen_.applicationKeypadMode(v.enable); }
+void DirectExecutor::visit(ApplyGraphicsRendition const& v) { screen_.applyGraphicsRendition(v); }
 void DirectExecutor::visit(BackIndex const&) { screen_.backIndex(); }
 void DirectExecutor::visit(Backspace const&) { screen_.backspace(); }
 void DirectExecutor::visit(Bell const&) { screen_.eventListener().bell(); }
@@ -1361,7 +1401,7 @@ void DirectExecutor::visit(SetTopBottomMargin const& v) { screen_.setTopBottomMa
 void DirectExecutor::visit(SetUnderlineColor const& v) { screen_.setUnderlineColor(v.color); }
 void DirectExecutor::visit(SingleShiftSelect const& v) { screen_.singleShiftSelect(v.table); }
 void DirectExecutor::visit(SoftTerminalReset const&) { screen_.resetSoft(); }
-void DirectExecutor::visit(InvalidCommand const& v) { if (logger_) logger_(InvalidOutputEvent{v.sequence.text(), "Unknown command"}); }
+void DirectExecutor::visit(InvalidCommand const& v) { if (logger_) logger_(InvalidOutputEvent{v.sequence->text(), "Unknown command"}); }
 // }}}
 
 // {{{ SynchronizedExecutor
@@ -66,7 +66,9 @@ class DirectExecutor : public CommandVisitor {
     {}
 
     void visit(AppendChar const& v) override;
+    void visit(AppendText const& v) override;
     void visit(ApplicationKeypadMode const& v) override;
+    void visit(ApplyGraphicsRendition const& v) override;
     void visit(BackIndex const& v) override;
     void visit(Backspace const& v) override;
     void visit(Bell const& v) override;
@@ -168,6 +170,8 @@ class SynchronizedExecutor : public DirectExecutor {
     }
 
     void visit(AppendChar const& v) override { enqueue(v); }
+    void visit(AppendText const& v) override { enqueue(v); }
+    void visit(ApplyGraphicsRendition const& v) override { enqueue(v); }
     void visit(BackIndex const& v) override { enqueue(v); }
     void visit(Backspace const& v) override { enqueue(v); }
     void visit(ClearLine const& v) override { enqueue(v); }
@@ -256,11 +260,17 @@ class Screen {
            bool _logTrace = false,
            std::optional<size_t> _maxHistoryLineCount = std::nullopt);
 
-    void setLogTrace(bool _enabled) { logTrace_ = _enabled; }
+    void setLogTrace(bool _enabled);
     bool logTrace() const noexcept { return logTrace_; }
     void setLogRaw(bool _enabled) { logRaw_ = _enabled; }
     bool logRaw() const noexcept { return logRaw_; }
 
+    /// Enables or disables collecting the commands of each write() into the list passed
+    /// to ScreenEvents::commands(). Commands are executed directly otherwise,
+    /// and the list passed is empty.
+    void setCommandRecording(bool _enabled);
+    bool commandRecording() const noexcept { return commandRecording_; }
+
     constexpr Size cellPixelSize() const noexcept { return cellPixelSize_; }
 
     constexpr void setCellPixelSize(Size _cellPixelSize)
@@ -274,13 +284,27 @@ class Screen {
     }
 
     void setMaxHistoryLineCount(std::optional<size_t> _maxHistoryLineCount);
+
+    /// Sets the number of scrollback lines to keep in memory before swapping out older ones,
+    /// or std::nullopt to keep all of them in memory.
+    void setMaxResidentHistoryLineCount(std::optional<size_t> _count);
+
+    /// Sets the number of bytes the scrollback may take in memory, or std::nullopt for no limit.
+    void setMaxHistoryBytes(std::optional<size_t> _bytes);
+    std::optional<size_t> maxHistoryBytes() const noexcept { return primaryBuffer_.maxHistoryBytes(); }
     int historyLineCount() const noexcept { return buffer_->historyLineCount(); }
 
+    /// @returns memory statistics of the primary screen's scrollback.
+    ScreenBuffer::HistoryStats historyStats() const { return primaryBuffer_.historyStats(); }
+
     /// Writes given data into the screen.
     void write(char const* _data, size_t _size);
 
     void write(Command const& _command);
 
+    /// Applies the commands @p _commands, as parsed by a CommandParser.
+    void write(CommandList const& _commands);
+
     /// Writes given data into the screen.
     void write(std::string_view const& _text) { write(_text.data(), _text.size()); }
 
@@ -288,9 +312,14 @@ class Screen {
 
     void writeText(char32_t _char);
 
+    /// Writes a run of printable text, as produced by the parser's text fast path.
+    void writeText(std::u32string_view _text);
+
     /// Renders the full screen by passing every grid cell to the callback.
+    ///
+    /// Scrollback lines coming into view are reflowed first, see reflowHistory().
     template <typename RendererT>
-    void render(RendererT _renderer, int _scrollOffset = 0) const;
+    void render(RendererT _renderer, int _scrollOffset = 0);
 
     /// Renders a single text line.
     std::string renderTextLine(cursor_pos_t _row) const { return buffer_->renderTextLine(_row); }
@@ -371,6 +400,7 @@ class Screen {
     void setUnderlineColor(Color const& _color);
     void setCursorStyle(CursorDisplay _display, CursorShape _shape);
     void setGraphicsRendition(GraphicsRendition _rendition);
+    void applyGraphicsRendition(ApplyGraphicsRendition const& _sgr);
     void requestMode(Mode _mode);
     void setTopBottomMargin(std::optional<int> _top, std::optional<int> _bottom);
     void setLeftRightMargin(std::optional<int> _left, std::optional<int> _right);
@@ -410,6 +440,16 @@ class Screen {
     bool scrollMarkDown();
     //}}}
 
+    /// {{{ damage tracking API
+    /// Rows are the screen lines as rendered, so scrolling the viewport damages all of them.
+    /// The cursor and the selection are not tracked, as they are rendered on top of the lines.
+    uint64_t damageGeneration() const noexcept { return buffer_->damageGeneration(); }
+    uint64_t advanceDamageGeneration() noexcept { return buffer_->advanceDamageGeneration(); }
+    bool isLineDamaged(cursor_pos_t _row, uint64_t _generation) const noexcept { return buffer_->isLineDamaged(_row, _generation); }
+    std::vector<cursor_pos_t> damagedLines(uint64_t _generation) const { return buffer_->damagedLines(_generation); }
+    void markHyperlinkDamaged(Cell::HyperlinkId _id) { buffer_->markHyperlinkDamaged(_id); }
+    //}}}
+
     bool isCursorInsideMargins() const noexcept { return buffer_->isCursorInsideMargins(); }
 
     Coordinate realCursorPosition() const noexcept { return buffer_->realCursorPosition(); }
@@ -423,34 +463,17 @@ class Screen {
             && 1 <= _coord.column && _coord.column <= size_.width;
     }
 
-    Cell const& currentCell() const noexcept
-    {
-        return *buffer_->currentColumn;
-    }
-
-    Cell& currentCell() noexcept
+    CellView currentCell() const noexcept
     {
-        return *buffer_->currentColumn;
-    }
-
-    Cell& currentCell(Cell value)
-    {
-        *buffer_->currentColumn = std::move(value);
-        return *buffer_->currentColumn;
+        return buffer_->view(*buffer_->currentColumn);
     }
 
     void moveCursorTo(Coordinate to);
 
-    /// Gets a reference to the cell relative to screen origin (top left, 1:1).
-    Cell& at(Coordinate const& _coord) noexcept
-    {
-        return buffer_->at(_coord);
-    }
-
-    /// Gets a reference to the cell relative to screen origin (top left, 1:1).
-    Cell const& at(Coordinate const& _coord) const noexcept
+    /// Gets a view of the cell relative to screen origin (top left, 1:1).
+    CellView at(Coordinate const& _coord) const noexcept
     {
-        return const_cast<Screen&>(*this).at(_coord);
+        return buffer_->view(buffer_->at(_coord));
     }
 
     bool isPrimaryScreen() const noexcept { return buffer_ == &primaryBuffer_; }
@@ -468,7 +491,6 @@ class Screen {
     bool horizontalMarginsEnabled() const noexcept { return isModeEnabled(Mode::LeftRightMargin); }
 
     Margin const& margin() const noexcept { return buffer_->margin_; }
-    ScreenBuffer::Lines const& scrollbackLines() const noexcept { return buffer_->savedLines; }
 
     void setTabWidth(int _value)
     {
@@ -477,6 +499,9 @@ class Screen {
         alternateBuffer_.tabWidth = _value;
     }
 
+    /// Sets the maximum size in bytes of an OSC or DCS payload, see CommandBuilder::setMaxPayloadSize().
+    void setMaxPayloadSize(size_t _value) noexcept { commandBuilder_.setMaxPayloadSize(_value); }
+
     /**
      * Returns the n'th saved line into the history scrollback buffer.
      *
@@ -484,7 +509,13 @@ class Screen {
      *
      * @returns the textual representation of the n'th line into the history.
      */
-    std::string renderHistoryTextLine(cursor_pos_t _lineNumberIntoHistory) const;
+    std::string renderHistoryTextLine(cursor_pos_t _lineNumberIntoHistory);
+
+    /// Reflows the scrollback lines left to be reflowed since a resize, down to @p _count lines into the history.
+    ///
+    /// Lines are reflowed from the most recent on, keeping their distance to the screen, and so is the
+    /// scroll offset, unless the history is shrunk below it.
+    void reflowHistory(size_t _count);
 
     std::string const& windowTitle() const noexcept { return windowTitle_; }
 
@@ -539,6 +570,7 @@ class Screen {
 
   private:
     void setBuffer(ScreenBuffer::Type _type);
+    void updateCommandRecording();
 
     // interactive replies
     void reply(std::string const& message)
@@ -560,13 +592,13 @@ class Screen {
     Logger const logger_;
     bool logRaw_ = false;
     bool logTrace_ = false;
+    bool commandRecording_ = false;
     bool focused_ = true;
 
     Size cellPixelSize_; ///< contains the pixel size of a single cell, or area(cellPixelSize_) == 0 if unknown.
 
     CommandBuilder commandBuilder_;
-    parser::Parser parser_;
-    int64_t instructionCounter_ = 0;
+    parser::BasicParser<CommandBuilder&> parser_;
 
     VTType terminalId_ = VTType::VT525;
 
@@ -584,7 +616,6 @@ class Screen {
     DirectExecutor directExecutor_;
     SynchronizedExecutor synchronizedExecutor_;
     std::unique_ptr<CommandVisitor> debugExecutor_;
-    CommandVisitor* commandExecutor_ = nullptr;
 
     int scrollOffset_ = 0;
 
@@ -593,7 +624,7 @@ class Screen {
 
 // {{{ template functions
 template <typename RendererT>
-void Screen::render(RendererT _render, int _scrollOffset) const
+void Screen::render(RendererT _render, int _scrollOffset)
 {
     if (!_scrollOffset)
     {
@@ -608,29 +639,34 @@ void Screen::render(RendererT _render, int _scrollOffset) const
     }
     else
     {
+        reflowHistory(static_cast<size_t>(_scrollOffset));
         _scrollOffset = std::min(_scrollOffset, buffer_->historyLineCount());
         auto const historyLineCount = std::min(size_.height, static_cast<int>(_scrollOffset));
         auto const mainLineCount = size_.height - historyLineCount;
 
         cursor_pos_t rowNumber = 1;
 
-        // render first part from history
-        for (auto line = prev(end(buffer_->savedLines), _scrollOffset); rowNumber <= historyLineCount; ++line, ++rowNumber)
+        // render first part from history, with lines narrower than the screen padded by blank cells
+        auto const blank = Cell{};
+        for (; rowNumber <= historyLineCount; ++rowNumber)
         {
-            if (static_cast<int>(line->size()) < size_.width)
-                line->resize(size_.width);
-
-            auto column = begin(*line);
-            for (cursor_pos_t colNumber = 1; colNumber <= size_.width; ++colNumber, ++column)
-                _render({rowNumber, colNumber}, *column);
+            auto const& line = buffer_->lineAt(rowNumber - _scrollOffset);
+            auto const columnCount = std::min(static_cast<int>(line.size()), size_.width);
+
+            auto column = begin(line);
+            cursor_pos_t colNumber = 1;
+            for (; colNumber <= columnCount; ++colNumber, ++column)
+                _render({rowNumber, colNumber}, buffer_->view(*column));
+            for (; colNumber <= size_.width; ++colNumber)
+                _render({rowNumber, colNumber}, buffer_->view(blank));
         }
 
         // render second part from main screen buffer
-        for (auto line = begin(buffer_->lines); line != next(begin(buffer_->lines), mainLineCount); ++line, ++rowNumber)
+        for (auto line = buffer_->lineIteratorAt(1); line != buffer_->lineIteratorAt(1 + mainLineCount); ++line, ++rowNumber)
         {
             auto column = begin(*line);
             for (cursor_pos_t colNumber = 1; colNumber <= size_.width; ++colNumber, ++column)
-                _render({rowNumber, colNumber}, *column);
+                _render({rowNumber, colNumber}, buffer_->view(*column));
         }
     }
 }
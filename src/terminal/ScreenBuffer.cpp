@@ -13,6 +13,7 @@
  */
 #include <terminal/ScreenBuffer.h>
 #include <terminal/OutputGenerator.h>
+#include <terminal/UTF8Decoder.h>
 
 #include <unicode/grapheme_segmenter.h>
 #include <unicode/utf8.h>
@@ -22,9 +23,12 @@
 #include <crispy/utils.h>
 
 #include <algorithm>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
 #include <iostream>
 #include <optional>
+#include <type_traits>
 
 #if defined(LIBTERMINAL_EXECUTION_PAR)
 #include <execution>
@@ -40,15 +44,469 @@ using std::max;
 using std::next;
 using std::nullopt;
 using std::optional;
+using std::prev;
+using std::rotate;
 using std::string;
+using std::string_view;
+using std::u32string_view;
 
+using std::for_each;
 using crispy::for_each;
 
 namespace terminal {
 
-std::string Cell::toUtf8() const
+namespace {
+    /// Copies the cells within the given columns from one line to another.
+    ///
+    /// Used for scrolling within horizontal margins, where whole lines cannot be rotated.
+    void copyColumns(ScreenBuffer::Line const& _source, ScreenBuffer::Line& _target, Margin::Range const& _columns) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<Cell>);
+        std::memmove(&_target[static_cast<size_t>(_columns.from - 1)],
+                     &_source[static_cast<size_t>(_columns.from - 1)],
+                     static_cast<size_t>(_columns.length()) * sizeof(Cell));
+    }
+
+    void fillColumns(ScreenBuffer::Line& _line, Margin::Range const& _columns, Cell const& _cell) noexcept
+    {
+        std::fill_n(next(begin(_line), _columns.from - 1), _columns.length(), _cell);
+    }
+
+    /// Appends @p _value as variable-length integer, 7 bits per byte, least significant first.
+    void writeVarint(string& _output, uint64_t _value)
+    {
+        for (; _value >= 0x80; _value >>= 7)
+            _output.push_back(static_cast<char>((_value & 0x7F) | 0x80));
+        _output.push_back(static_cast<char>(_value));
+    }
+
+    uint64_t readVarint(char const*& _input) noexcept
+    {
+        uint64_t value = 0;
+        for (unsigned shift = 0; ; shift += 7)
+        {
+            auto const byte = static_cast<uint8_t>(*_input++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+    }
+
+    /// Reads a variable-length integer from untrusted input.
+    optional<uint64_t> readVarint(char const*& _input, char const* _end) noexcept
+    {
+        uint64_t value = 0;
+        for (unsigned shift = 0; _input != _end && shift < 64; shift += 7)
+        {
+            auto const byte = static_cast<uint8_t>(*_input++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        return nullopt;
+    }
+}
+
+std::string CellView::toUtf8() const
+{
+    auto const text = codepoints();
+    return unicode::to_utf8(text.data(), text.size());
+}
+
+// {{{ CellPool
+CellPool::CellPool() :
+    attributes_{GraphicsAttributes{}},
+    clusters_{Cluster{}}
+{
+    attributeIds_[GraphicsAttributes{}] = 0;
+}
+
+optional<Cell::AttributesId> CellPool::findAttributes(GraphicsAttributes const& _attributes) const
+{
+    if (auto const i = attributeIds_.find(_attributes); i != attributeIds_.end())
+        return i->second;
+    return nullopt;
+}
+
+Cell::AttributesId CellPool::addAttributes(GraphicsAttributes const& _attributes)
+{
+    auto id = Cell::AttributesId{};
+    if (!freeAttributes_.empty())
+    {
+        id = freeAttributes_.back();
+        freeAttributes_.pop_back();
+        attributes_[id] = _attributes;
+    }
+    else
+    {
+        id = static_cast<Cell::AttributesId>(attributes_.size());
+        attributes_.emplace_back(_attributes);
+    }
+    attributeIds_[_attributes] = id;
+    return id;
+}
+
+Cell::ClusterId CellPool::allocateCluster()
+{
+    if (!freeClusters_.empty())
+    {
+        auto const id = freeClusters_.back();
+        freeClusters_.pop_back();
+        return id;
+    }
+
+    clusters_.emplace_back();
+    return static_cast<Cell::ClusterId>(clusters_.size() - 1);
+}
+
+void CellPool::beginCollection()
+{
+    attributesMarks_.assign(attributes_.size(), false);
+    hyperlinks_.beginCollection();
+    clustersMarks_.assign(clusters_.size(), false);
+}
+
+void CellPool::endCollection()
+{
+    auto const liveCount = attributesCount() + clusterCount() + hyperlinks_.size();
+
+    // Free lists are rebuilt from scratch, as already free entries are unmarked, too.
+    freeAttributes_.clear();
+    for (Cell::AttributesId id = 1; id < attributes_.size(); ++id)
+    {
+        if (attributesMarks_[id])
+            continue;
+        if (auto const i = attributeIds_.find(attributes_[id]); i != attributeIds_.end() && i->second == id)
+            attributeIds_.erase(i);
+        freeAttributes_.push_back(id);
+    }
+
+    hyperlinks_.endCollection();
+
+    freeClusters_.clear();
+    for (Cell::ClusterId id = 1; id < clusters_.size(); ++id)
+        if (!clustersMarks_[id])
+            freeClusters_.push_back(id);
+
+    if (attributesCount() + clusterCount() + hyperlinks_.size() < liveCount)
+        ++generation_;
+
+    // Hand out low IDs first, keeping the tables dense.
+    std::reverse(freeAttributes_.begin(), freeAttributes_.end());
+    std::reverse(freeClusters_.begin(), freeClusters_.end());
+
+    attributesThreshold_ = max(MinCollectThreshold, 2 * attributesCount());
+    clustersThreshold_ = max(MinCollectThreshold, 2 * clusterCount());
+
+    attributesMarks_ = {};
+    clustersMarks_ = {};
+}
+// }}}
+
+// {{{ CompactLine
+namespace {
+    constexpr bool isBlank(Cell const& _cell) noexcept
+    {
+        return _cell.empty() && _cell.attributesId() == 0 && _cell.hyperlinkId() == 0 && _cell.width() == 1;
+    }
+
+    /// @returns the width a cell gets from its first codepoint alone.
+    int naturalWidth(Cell const& _cell) noexcept
+    {
+        return _cell.empty() ? 1 : max(columnWidth(_cell.codepoint()), 1);
+    }
+
+    /// Run-length encodes IDs into (length, ID) pairs.
+    struct SpanWriter {
+        string data;
+        size_t count = 0;
+        uint64_t id = 0;
+        size_t length = 0;
+
+        void add(uint64_t _id)
+        {
+            if (length != 0 && _id != id)
+                flush();
+            id = _id;
+            ++length;
+        }
+
+        void flush()
+        {
+            if (length == 0)
+                return;
+            writeVarint(data, length);
+            writeVarint(data, id);
+            ++count;
+            length = 0;
+        }
+    };
+}
+
+// The encoding is made of variable-length integers and the text:
+//   cell count, number of non-blank cells (N), text size, text,
+//   attribute span count, (length, ID) per span, covering N cells,
+//   hyperlink span count, (length, ID) per span, covering N cells or none if there are no hyperlinks,
+//   exception count, (column, codepoint count, width) per exceptional cell.
+CompactLine CompactLine::encode(Cell const* _cells, size_t _count, CellPool const& _pool)
+{
+    auto length = _count;
+    while (length != 0 && isBlank(_cells[length - 1]))
+        --length;
+
+    auto text = string{};
+    text.reserve(length);
+    auto attributes = SpanWriter{};
+    auto hyperlinks = SpanWriter{};
+    auto exceptions = SpanWriter{};
+    bool hasHyperlinks = false;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        Cell const& cell = _cells[i];
+
+        if (cell.empty())
+            text.push_back('\0');
+        else
+            for (char32_t const codepoint : CellView{cell, _pool}.codepoints())
+            {
+                uint8_t bytes[4];
+                text.append(reinterpret_cast<char const*>(bytes), unicode::to_utf8(codepoint, bytes));
+            }
+
+        if (cell.codepointCount() > 1 || cell.width() != naturalWidth(cell))
+        {
+            writeVarint(exceptions.data, i);
+            writeVarint(exceptions.data, static_cast<uint64_t>(cell.codepointCount()));
+            writeVarint(exceptions.data, static_cast<uint64_t>(cell.width()));
+            ++exceptions.count;
+        }
+
+        attributes.add(cell.attributesId());
+        hyperlinks.add(cell.hyperlinkId());
+        hasHyperlinks = hasHyperlinks || cell.hyperlinkId() != 0;
+    }
+    attributes.flush();
+    hyperlinks.flush();
+
+    auto data = string{};
+    data.reserve(16 + text.size() + attributes.data.size() + exceptions.data.size());
+    writeVarint(data, _count);
+    writeVarint(data, length);
+    writeVarint(data, text.size());
+    data += text;
+    writeVarint(data, attributes.count);
+    data += attributes.data;
+    if (hasHyperlinks)
+    {
+        writeVarint(data, hyperlinks.count);
+        data += hyperlinks.data;
+    }
+    else
+        writeVarint(data, 0);
+    writeVarint(data, exceptions.count);
+    data += exceptions.data;
+
+    data.shrink_to_fit();
+    return CompactLine{std::move(data)};
+}
+
+void CompactLine::decode(std::vector<Cell>& _cells, CellPool& _pool) const
+{
+    char const* input = data_.data();
+    auto const count = static_cast<size_t>(readVarint(input));
+    auto const length = static_cast<size_t>(readVarint(input));
+    auto const textSize = static_cast<size_t>(readVarint(input));
+    auto const* const text = reinterpret_cast<uint8_t const*>(input);
+    input += textSize;
+
+    auto codepoints = std::vector<char32_t>(textSize);
+    UTF8Decoder{}.decode(text, text + textSize, codepoints.data());
+
+    _cells.assign(count, Cell{});
+
+    size_t column = 0;
+    for (auto spans = readVarint(input); spans != 0; --spans)
+    {
+        auto const spanLength = readVarint(input);
+        auto const id = static_cast<Cell::AttributesId>(readVarint(input));
+        for (uint64_t i = 0; i < spanLength; ++i)
+            _cells[column++].setAttributesId(id);
+    }
+
+    column = 0;
+    for (auto spans = readVarint(input); spans != 0; --spans)
+    {
+        auto const spanLength = readVarint(input);
+        auto const id = static_cast<Cell::HyperlinkId>(readVarint(input));
+        for (uint64_t i = 0; i < spanLength; ++i)
+            _cells[column++].setHyperlinkId(id);
+    }
+
+    auto exceptionCount = readVarint(input);
+    auto nextException = exceptionCount != 0 ? readVarint(input) : uint64_t{length};
+
+    char32_t const* codepoint = codepoints.data();
+    for (size_t i = 0; i < length; ++i)
+    {
+        Cell& cell = _cells[i];
+        if (i != nextException)
+        {
+            cell.setCharacter(*codepoint++);
+            continue;
+        }
+
+        auto const codepointCount = static_cast<int>(readVarint(input));
+        auto const width = static_cast<int>(readVarint(input));
+
+        cell.setCharacter(*codepoint);
+        if (codepointCount > 1)
+        {
+            auto const cluster = _pool.allocateCluster();
+            std::copy_n(codepoint, codepointCount, _pool.cluster(cluster).begin());
+            cell.setCluster(cluster, codepointCount);
+        }
+        codepoint += max(codepointCount, 1);
+        cell.setWidth(width);
+
+        nextException = --exceptionCount != 0 ? readVarint(input) : uint64_t{length};
+    }
+}
+
+size_t CompactLine::cellCount() const noexcept
+{
+    char const* input = data_.data();
+    return static_cast<size_t>(readVarint(input));
+}
+
+void CompactLine::forEachId(std::function<void(Cell::AttributesId)> const& _attributes,
+                            std::function<void(Cell::HyperlinkId)> const& _hyperlink) const
+{
+    char const* input = data_.data();
+    readVarint(input);
+    readVarint(input);
+    input += readVarint(input);
+
+    for (auto spans = readVarint(input); spans != 0; --spans)
+    {
+        readVarint(input);
+        _attributes(static_cast<Cell::AttributesId>(readVarint(input)));
+    }
+
+    for (auto spans = readVarint(input); spans != 0; --spans)
+    {
+        readVarint(input);
+        _hyperlink(static_cast<Cell::HyperlinkId>(readVarint(input)));
+    }
+}
+// }}}
+
+Cell::AttributesId ScreenBuffer::intern(GraphicsAttributes const& _attributes)
+{
+    if (auto const id = pool.findAttributes(_attributes); id.has_value())
+        return *id;
+
+    if (pool.shouldCollect())
+        collectGarbage();
+
+    return pool.addAttributes(_attributes);
+}
+
+Cell::HyperlinkId ScreenBuffer::acquireHyperlink(std::string const& _userId, URI const& _uri)
+{
+    auto& store = pool.hyperlinks();
+
+    if (!_userId.empty())
+    {
+        if (auto const id = store.find(_userId, _uri); id.has_value())
+        {
+            store.touch(*id);
+            return *id;
+        }
+    }
+
+    if (store.full())
+        collectGarbage();
+
+    return store.add(_userId, _uri).value_or(0);
+}
+
+Cell::AttributesId ScreenBuffer::cursorAttributesId()
+{
+    if (cursor.graphicsRendition != cachedAttributes_)
+    {
+        cachedAttributesId_ = intern(cursor.graphicsRendition);
+        cachedAttributes_ = cursor.graphicsRendition;
+    }
+    return cachedAttributesId_;
+}
+
+int ScreenBuffer::appendCharacter(Cell& _cell, char32_t _codepoint)
+{
+    auto const count = _cell.codepointCount();
+    if (count >= static_cast<int>(Cell::MaxCodepoints))
+        return 0;
+
+    if (pool.shouldCollect())
+        collectGarbage();
+
+    // Clusters may be shared by copies of this cell, so always write into a fresh one.
+    auto const id = pool.allocateCluster();
+    auto& cluster = pool.cluster(id);
+    auto const current = view(_cell).codepoints();
+    std::copy(current.begin(), current.end(), cluster.begin());
+    cluster[count] = _codepoint;
+    _cell.setCluster(id, count + 1);
+
+    constexpr bool AllowWidthChange = false; // TODO: make configurable
+
+    auto const width = [&]() {
+        switch (_codepoint)
+        {
+            case 0xFE0E:
+                return 1;
+            case 0xFE0F:
+                return 2;
+            default:
+                return columnWidth(_codepoint);
+        }
+    }();
+
+    if (width != _cell.width() && AllowWidthChange)
+    {
+        int const diff = width - _cell.width();
+        _cell.setWidth(width);
+        return diff;
+    }
+
+    return 0;
+}
+
+void ScreenBuffer::collectGarbage()
 {
-    return unicode::to_utf8(codepoints_.data(), codepointCount_);
+    pool.beginCollection();
+
+    auto const markAttributes = [&](Cell::AttributesId _id) { pool.markAttributes(_id); };
+    auto const markHyperlink = [&](Cell::HyperlinkId _id) { pool.markHyperlink(_id); };
+
+    for (Line const& line : lines)
+    {
+        for (Cell const& cell : line.buffer)
+            pool.mark(cell);
+        if (!line.compact.empty())
+            line.compact.forEachId(markAttributes, markHyperlink);
+    }
+
+    for (auto const& [_, page] : swappedPages_)
+    {
+        for_each(begin(page.attributes), end(page.attributes), markAttributes);
+        for_each(begin(page.hyperlinks), end(page.hyperlinks), markHyperlink);
+    }
+
+    pool.markAttributes(cachedAttributesId_);
+    pool.markHyperlink(currentHyperlink);
+
+    pool.endCollection();
 }
 
 std::optional<int> ScreenBuffer::findMarkerBackward(int _currentCursorLine) const
@@ -65,8 +523,7 @@ std::optional<int> ScreenBuffer::findMarkerBackward(int _currentCursorLine) cons
         int row = _currentCursorLine - 1;
         while (row > 0)
         {
-            auto const currentLine = next(begin(lines), row - 1);
-            if (currentLine->marked)
+            if (isLineMarked(row))
                 return {row};
 
             --row;
@@ -77,7 +534,7 @@ std::optional<int> ScreenBuffer::findMarkerBackward(int _currentCursorLine) cons
     auto const scrollOffset = _currentCursorLine <= 0 ? -_currentCursorLine + 1 : 0;
 
     for (int i = scrollOffset; i < historyLineCount(); ++i)
-        if (Line const& line = savedLines.at(historyLineCount() - i - 1); line.marked)
+        if (isLineMarked(-i))
             return -i;
 
     return nullopt;
@@ -86,11 +543,11 @@ std::optional<int> ScreenBuffer::findMarkerBackward(int _currentCursorLine) cons
 std::optional<int> ScreenBuffer::findMarkerForward(int _currentCursorLine) const
 {
     for (int i = _currentCursorLine + 1; i <= 0; ++i)
-        if (int const ri = historyLineCount() + i - 1; savedLines.at(ri).marked)
+        if (isLineMarked(i))
             return {i};
 
     for (int i = max(_currentCursorLine + 1, 1); i <= size_.height; ++i)
-        if (Line const& line = lines.at(i - 1); line.marked)
+        if (isLineMarked(i))
             return {i};
 
     return nullopt;
@@ -100,57 +557,64 @@ void ScreenBuffer::resize(Size const& _newSize)
 {
     if (_newSize.height > size_.height)
     {
-        // Grow line count by splicing available lines from history back into buffer, if available,
-        // or create new ones until size_.height == _newSize.height.
+        // Grow line count by moving the screen's top edge up into the history, if available,
+        // or appending new lines at the bottom until size_.height == _newSize.height.
         auto const extendCount = _newSize.height - size_.height;
-        auto const rowsToTakeFromSavedLines = min(extendCount, static_cast<int>(std::size(savedLines)));
+        reflowHistory(static_cast<size_t>(extendCount));
+        auto const rowsToTakeFromSavedLines = min(extendCount, historyLineCount());
 
-        for_each(
-            crispy::times(rowsToTakeFromSavedLines),
-            [&](auto) {
-                savedLines.back().resize(_newSize.width);
-                lines.emplace_front(std::move(savedLines.back()));
-                savedLines.pop_back();
-            }
-        );
+        for (cursor_pos_t row = 1 - rowsToTakeFromSavedLines; row <= 0; ++row)
+        {
+            auto& line = lineAt(row);
+            historyBudget_.remove(lineBytes(line));
+            line.resize(size_.width);
+        }
 
         cursor.position.row += rowsToTakeFromSavedLines;
 
-        auto const fillLineCount = extendCount - rowsToTakeFromSavedLines;
-        generate_n(
-            back_inserter(lines),
-            fillLineCount,
-            [=]() { return Line{static_cast<size_t>(_newSize.width), Cell{}}; });
+        auto const fillLineCount = static_cast<size_t>(extendCount - rowsToTakeFromSavedLines);
+        if (lines.capacity() < lines.size() + fillLineCount)
+            lines.set_capacity(lines.size() + fillLineCount);
+        for (size_t i = 0; i < fillLineCount; ++i)
+            lines.recycle_back().reset(static_cast<size_t>(size_.width), Cell{});
+
+        size_.height = _newSize.height;
     }
     else if (_newSize.height < size_.height)
     {
         // Shrink existing line count to _newSize.height
-        // by splicing the number of lines to be shrinked by into savedLines bottom.
+        // by moving the screen's top edge down, turning the top lines into history.
+        auto const n = size_.height - _newSize.height;
         if (cursor.position.row == size_.height)
         {
-            auto const n = size_.height - _newSize.height;
-            for_each(
-                crispy::times(n),
-                [&](auto) {
-                    lines.front().resize(_newSize.width);
-                    savedLines.emplace_back(std::move(lines.front()));
-                    lines.pop_front();
-                }
-            );
+            size_.height = _newSize.height;
+
+            // The lines moved into the history are accounted before clamping it,
+            // which might drop them right away again.
+            auto const historyCount = static_cast<size_t>(historyLineCount());
+            for (auto i = historyCount - min(static_cast<size_t>(n), historyCount); i < historyCount; ++i)
+            {
+                historyBudget_.add(lineBytes(lines[i]));
+                compactLine(lines[i]);
+            }
             clampSavedLines();
+            enforceHistoryBudget();
         }
         else
+        {
             // Hard-cut below cursor by the number of lines to shrink.
-            lines.resize(_newSize.height);
-
-        assert(lines.size() == static_cast<size_t>(_newSize.height));
+            lines.pop_back(static_cast<size_t>(n));
+            size_.height = _newSize.height;
+        }
     }
 
-    if (_newSize.width > size_.width)
+    if (_newSize.width != size_.width && type_ == Type::Main)
+        reflow(_newSize.width);
+    else if (_newSize.width > size_.width)
     {
         // Grow existing columns to _newSize.width.
         std::for_each(
-            begin(lines),
+            lineIteratorAt(1),
             end(lines),
             [=](auto& line) { line.resize(_newSize.width); }
         );
@@ -164,12 +628,12 @@ void ScreenBuffer::resize(Size const& _newSize)
         // Nothing should be done, I think, as we preserve prior (now exceeding) content.
         if (cursor.position.column == size_.width)
             wrapPending = true;
-
-        // truncating tabs
-        while (!tabs.empty() && tabs.back() > _newSize.width)
-            tabs.pop_back();
     }
 
+    // truncating tabs
+    while (!tabs.empty() && tabs.back() > _newSize.width)
+        tabs.pop_back();
+
     // Reset margin to their default.
     margin_ = Margin{
 		Margin::Range{1, _newSize.height},
@@ -180,11 +644,14 @@ void ScreenBuffer::resize(Size const& _newSize)
     size_ = _newSize;
 
     lastCursorPosition = clampCoordinate(lastCursorPosition);
-    auto lastLine = next(begin(lines), lastCursorPosition.row - 1);
-    lastColumn = columnIteratorAt(begin(*lastLine), lastCursorPosition.column);
+    lastColumn = columnIteratorAt(begin(lineAt(lastCursorPosition.row)), lastCursorPosition.column);
 
     cursor.position = clampCoordinate(cursor.position);
     updateCursorIterators();
+
+    lineDamage_.assign(static_cast<size_t>(size_.height), damageGeneration_);
+
+    checkHistoryAccounting();
 }
 
 void ScreenBuffer::setMode(Mode _mode, bool _enable)
@@ -232,10 +699,7 @@ Cell& ScreenBuffer::at(Coordinate const& _pos) noexcept
     assert(crispy::ascending(1 - historyLineCount(), _pos.row, size_.height));
     assert(crispy::ascending(1, _pos.column, size_.width));
 
-    if (_pos.row > 0)
-        return (*next(begin(lines), _pos.row - 1))[_pos.column - 1];
-    else
-        return (*next(rbegin(savedLines), -_pos.row))[_pos.column - 1];
+    return lineAt(_pos.row)[_pos.column - 1];
 }
 
 void ScreenBuffer::linefeed(cursor_pos_t _newColumn)
@@ -255,7 +719,6 @@ void ScreenBuffer::linefeed(cursor_pos_t _newColumn)
         // moveCursorTo({cursorPosition().row + 1, margin_.horizontal.from});
         cursor.position.row++;
         cursor.position.column = _newColumn;
-        currentLine++;
         updateColumnIterator();
     }
     verifyState();
@@ -266,8 +729,14 @@ void ScreenBuffer::appendChar(char32_t _ch, bool _consecutive)
     verifyState();
 
     if (wrapPending && cursor.autoWrap)
+    {
         linefeed(margin_.horizontal.from);
 
+        // Only text wrapping over full lines joins them into a logical line that can be reflowed.
+        if (margin_.horizontal == Margin::Range{1, size_.width})
+            lineIteratorAt(cursor.position.row)->wrapped = true;
+    }
+
     auto const ch =
         _ch < 127 ? cursor.charsets.map(static_cast<char>(_ch))
                   : _ch == 0x7F ? ' ' : _ch;
@@ -275,19 +744,109 @@ void ScreenBuffer::appendChar(char32_t _ch, bool _consecutive)
     bool const insertToPrev =
         _consecutive
         && !lastColumn->empty()
-        && unicode::grapheme_segmenter::nonbreakable(lastColumn->codepoint(lastColumn->codepointCount() - 1), ch);
+        && nonbreakable(view(*lastColumn).codepoint(lastColumn->codepointCount() - 1), ch);
 
     if (!insertToPrev)
         writeCharToCurrentAndAdvance(ch);
     else
     {
-        auto const extendedWidth = lastColumn->appendCharacter(ch);
+        markDamaged(lastCursorPosition.row);
+        auto const extendedWidth = appendCharacter(*lastColumn, ch);
 
         if (extendedWidth > 0)
             clearAndAdvance(extendedWidth);
     }
 }
 
+namespace {
+    template <typename Char>
+    constexpr bool isAsciiPrintable(Char _ch) noexcept
+    {
+        return 0x20 <= _ch && _ch < 0x7F;
+    }
+}
+
+void ScreenBuffer::writeText(u32string_view _text, bool _consecutive)
+{
+    writeTextRun(_text.data(), _text.size(), _consecutive);
+}
+
+void ScreenBuffer::writeText(string_view _text, bool _consecutive)
+{
+    writeTextRun(_text.data(), _text.size(), _consecutive);
+}
+
+template <typename Char>
+void ScreenBuffer::writeTextRun(Char const* _text, size_t _size, bool _consecutive)
+{
+    size_t i = 0;
+    while (i < _size)
+    {
+        // A US-ASCII character following another one always starts a new grapheme cluster
+        // of a single column, whereas the first one may still extend the previous cluster.
+        if (i != 0 && isAsciiPrintable(_text[i - 1]) && isAsciiPrintable(_text[i]))
+            i += writeAsciiText(_text + i, _size - i);
+        else
+        {
+            appendChar(static_cast<char32_t>(_text[i]), i != 0 || _consecutive);
+            ++i;
+        }
+    }
+}
+
+template <typename Char>
+size_t ScreenBuffer::writeAsciiText(Char const* _text, size_t _size)
+{
+    if (wrapPending && cursor.autoWrap)
+    {
+        linefeed(margin_.horizontal.from);
+
+        if (margin_.horizontal == Margin::Range{1, size_.width})
+            lineIteratorAt(cursor.position.row)->wrapped = true;
+    }
+
+    bool const cursorInsideMargin = isModeEnabled(Mode::LeftRightMargin) && isCursorInsideMargins();
+    auto const rightColumn = cursorInsideMargin ? margin_.horizontal.to : size_.width;
+    auto const cellsAvailable = static_cast<size_t>(rightColumn - cursor.position.column + 1);
+
+    auto const attributes = cursorAttributesId();
+    auto const hyperlink = currentHyperlink;
+
+    size_t count = 0;
+    auto cell = currentColumn;
+    for (auto const end = min(_size, cellsAvailable); count < end && isAsciiPrintable(_text[count]); ++count)
+    {
+        // Character sets only map US-ASCII onto single column characters.
+        cell->setCharacter(cursor.charsets.map(static_cast<char>(_text[count])));
+        cell->setAttributesId(attributes);
+        cell->setHyperlinkId(hyperlink);
+        ++cell;
+    }
+    assert(count > 0);
+
+    markDamaged(cursor.position.row);
+
+    lastColumn = prev(cell);
+    lastCursorPosition = {cursor.position.row, cursor.position.column + static_cast<int>(count) - 1};
+
+    if (count < cellsAvailable)
+    {
+        cursor.position.column += static_cast<int>(count);
+        currentColumn = cell;
+    }
+    else
+    {
+        // The last character went into the right most column.
+        cursor.position.column = rightColumn;
+        currentColumn = lastColumn;
+        if (cursor.autoWrap)
+            wrapPending = true;
+    }
+
+    verifyState();
+    return count;
+}
+
 void ScreenBuffer::clearAndAdvance(int _offset)
 {
     if (_offset == 0)
@@ -299,9 +858,12 @@ void ScreenBuffer::clearAndAdvance(int _offset)
     if (n == _offset)
     {
         assert(n > 0);
+        markDamaged(cursor.position.row);
         cursor.position.column += n;
+        auto const attributes = cursorAttributesId();
+        auto const hyperlink = currentHyperlink;
         for (auto i = 0; i < n; ++i)
-            (currentColumn++)->reset(cursor.graphicsRendition, currentHyperlink);
+            (currentColumn++)->reset(attributes, hyperlink);
     }
     else if (cursor.autoWrap)
     {
@@ -311,10 +873,15 @@ void ScreenBuffer::clearAndAdvance(int _offset)
 
 void ScreenBuffer::writeCharToCurrentAndAdvance(char32_t _character)
 {
+    auto const attributes = cursorAttributesId();
+    auto const hyperlink = currentHyperlink;
+
+    markDamaged(cursor.position.row);
+
     Cell& cell = *currentColumn;
     cell.setCharacter(_character);
-    cell.attributes() = cursor.graphicsRendition;
-    cell.setHyperlink(currentHyperlink);
+    cell.setAttributesId(attributes);
+    cell.setHyperlinkId(hyperlink);
 
     lastColumn = currentColumn;
     lastCursorPosition = cursor.position;
@@ -331,7 +898,7 @@ void ScreenBuffer::writeCharToCurrentAndAdvance(char32_t _character)
         cursor.position.column += n;
         currentColumn++;
         for (int i = 1; i < n; ++i)
-            (currentColumn++)->reset(cursor.graphicsRendition, currentHyperlink);
+            (currentColumn++)->reset(attributes, hyperlink);
         verifyState();
     }
     else if (cursor.autoWrap)
@@ -350,87 +917,48 @@ void ScreenBuffer::scrollUp(cursor_pos_t v_n)
 
 void ScreenBuffer::scrollUp(cursor_pos_t v_n, Margin const& margin)
 {
+    auto const blankCell = Cell{{}, cursorAttributesId()};
+    auto const marginHeight = margin.vertical.length();
+    auto const n = min(v_n, marginHeight);
+
+    markDamaged(margin.vertical.from, margin.vertical.to);
+
     if (margin.horizontal != Margin::Range{1, size_.width})
     {
         // a full "inside" scroll-up
-        auto const marginHeight = margin.vertical.length();
-        auto const n = min(v_n, marginHeight);
-
-        if (n < marginHeight)
-        {
-            auto targetLine = next(begin(lines), margin.vertical.from - 1);     // target line
-            auto sourceLine = next(begin(lines), margin.vertical.from - 1 + n); // source line
-            auto const bottomLine = next(begin(lines), margin.vertical.to);     // bottom margin's end-line iterator
-
-            for (; sourceLine != bottomLine; ++sourceLine, ++targetLine)
-            {
-                copy_n(
-                    next(begin(*sourceLine), margin.horizontal.from - 1),
-                    margin.horizontal.length(),
-                    next(begin(*targetLine), margin.horizontal.from - 1)
-                );
-            }
-        }
+        for (cursor_pos_t row = margin.vertical.from; row + n <= margin.vertical.to; ++row)
+            copyColumns(lineAt(row + n), lineAt(row), margin.horizontal);
 
         // clear bottom n lines in margin.
-        auto const topLine = next(begin(lines), margin.vertical.to - n);
-        auto const bottomLine = next(begin(lines), margin.vertical.to);     // bottom margin's end-line iterator
-        for_each(
-            topLine,
-            bottomLine,
-            [&](ScreenBuffer::Line& line) {
-                fill_n(
-                    next(begin(line), margin.horizontal.from - 1),
-                    margin.horizontal.length(),
-                    Cell{{}, cursor.graphicsRendition}
-                );
-            }
-        );
+        for (cursor_pos_t row = margin.vertical.to - n + 1; row <= margin.vertical.to; ++row)
+            fillColumns(lineAt(row), margin.horizontal, blankCell);
     }
     else if (margin.vertical == Margin::Range{1, size_.height})
     {
         // full-screen scroll-up
-        auto const n = min(v_n, size_.height);
-
-        if (n > 0)
+        for (int i = 0; i < n; ++i)
+            appendLine(blankCell);
+    }
+    else
+    {
+        // scroll up only inside vertical margin with full horizontal extend,
+        // by rotating the top n lines down to the bottom of the margin, to be reused as blank lines.
+        if (n < marginHeight)
         {
-            for_each(
-                crispy::times(n),
-                [&](auto) {
-                    savedLines.emplace_back(std::move(lines.front()));
-                    lines.pop_front();
-                }
+            rotate(
+                lineIteratorAt(margin.vertical.from),
+                lineIteratorAt(margin.vertical.from + n),
+                lineIteratorAt(margin.vertical.to + 1)
             );
-
-            clampSavedLines();
-
-            generate_n(
-                back_inserter(lines),
-                n,
-                [this]() { return Line{static_cast<size_t>(size_.width), Cell{{}, cursor.graphicsRendition}}; }
-            );
-        }
-    }
-    else
-    {
-        // scroll up only inside vertical margin with full horizontal extend
-        auto const marginHeight = margin.vertical.length();
-        auto const n = min(v_n, marginHeight);
-        if (n < marginHeight)
-        {
-            rotate(
-                next(begin(lines), margin.vertical.from - 1),
-                next(begin(lines), margin.vertical.from - 1 + n),
-                next(begin(lines), margin.vertical.to)
-            );
-        }
+        }
 
         for_each(
             LIBTERMINAL_EXECUTION_COMMA(par)
-            next(begin(lines), margin.vertical.to - n),
-            next(begin(lines), margin.vertical.to),
+            lineIteratorAt(margin.vertical.to - n + 1),
+            lineIteratorAt(margin.vertical.to + 1),
             [&](Line& line) {
-                fill(begin(line), end(line), Cell{{}, cursor.graphicsRendition});
+                fill(begin(line), end(line), blankCell);
+                line.wrapped = false;
             }
         );
     }
@@ -445,101 +973,42 @@ void ScreenBuffer::scrollDown(cursor_pos_t v_n)
 
 void ScreenBuffer::scrollDown(cursor_pos_t v_n, Margin const& _margin)
 {
+    auto const blankCell = Cell{{}, cursorAttributesId()};
     auto const marginHeight = _margin.vertical.length();
     auto const n = min(v_n, marginHeight);
 
+    markDamaged(_margin.vertical.from, _margin.vertical.to);
+
     if (_margin.horizontal != Margin::Range{1, size_.width})
     {
         // full "inside" scroll-down
-        if (n < marginHeight)
-        {
-            auto sourceLine = next(begin(lines), _margin.vertical.to - n - 1);
-            auto targetLine = next(begin(lines), _margin.vertical.to - 1);
-            auto const sourceEndLine = next(begin(lines), _margin.vertical.from - 1);
-
-            while (sourceLine != sourceEndLine)
-            {
-                copy_n(
-                    next(begin(*sourceLine), _margin.horizontal.from - 1),
-                    _margin.horizontal.length(),
-                    next(begin(*targetLine), _margin.horizontal.from - 1)
-                );
-                --targetLine;
-                --sourceLine;
-            }
+        for (cursor_pos_t row = _margin.vertical.to; row - n >= _margin.vertical.from; --row)
+            copyColumns(lineAt(row - n), lineAt(row), _margin.horizontal);
 
-            copy_n(
-                next(begin(*sourceLine), _margin.horizontal.from - 1),
-                _margin.horizontal.length(),
-                next(begin(*targetLine), _margin.horizontal.from - 1)
-            );
-
-            for_each(
-                next(begin(lines), _margin.vertical.from - 1),
-                next(begin(lines), _margin.vertical.from - 1 + n),
-                [_margin, this](Line& line) {
-                    fill_n(
-                        next(begin(line), _margin.horizontal.from - 1),
-                        _margin.horizontal.length(),
-                        Cell{{}, cursor.graphicsRendition}
-                    );
-                }
-            );
-        }
-        else
-        {
-            // clear everything in margin
-            for_each(
-                next(begin(lines), _margin.vertical.from - 1),
-                next(begin(lines), _margin.vertical.to),
-                [_margin, this](Line& line) {
-                    fill_n(
-                        next(begin(line), _margin.horizontal.from - 1),
-                        _margin.horizontal.length(),
-                        Cell{{}, cursor.graphicsRendition}
-                    );
-                }
-            );
-        }
-    }
-    else if (_margin.vertical == Margin::Range{1, size_.height})
-    {
-        rotate(
-            begin(lines),
-            next(begin(lines), marginHeight - n),
-            end(lines)
-        );
-
-        for_each(
-            begin(lines),
-            next(begin(lines), n),
-            [this](Line& line) {
-                fill(
-                    begin(line),
-                    end(line),
-                    Cell{{}, cursor.graphicsRendition}
-                );
-            }
-        );
+        // clear top n lines in margin.
+        for (cursor_pos_t row = _margin.vertical.from; row < _margin.vertical.from + n; ++row)
+            fillColumns(lineAt(row), _margin.horizontal, blankCell);
     }
     else
     {
-        // scroll down only inside vertical margin with full horizontal extend
-        rotate(
-            next(begin(lines), _margin.vertical.from - 1),
-            next(begin(lines), _margin.vertical.to - n),
-            next(begin(lines), _margin.vertical.to)
-        );
+        // scroll down inside vertical margin (or full screen) with full horizontal extend,
+        // by rotating the bottom n lines up to the top of the margin, to be reused as blank lines.
+        if (n < marginHeight)
+        {
+            rotate(
+                lineIteratorAt(_margin.vertical.from),
+                lineIteratorAt(_margin.vertical.to - n + 1),
+                lineIteratorAt(_margin.vertical.to + 1)
+            );
+        }
 
         for_each(
-            next(begin(lines), _margin.vertical.from - 1),
-            next(begin(lines), _margin.vertical.from - 1 + n),
-            [this](Line& line) {
-                fill(
-                    begin(line),
-                    end(line),
-                    Cell{{}, cursor.graphicsRendition}
-                );
+            LIBTERMINAL_EXECUTION_COMMA(par)
+            lineIteratorAt(_margin.vertical.from),
+            lineIteratorAt(_margin.vertical.from + n),
+            [&](Line& line) {
+                fill(begin(line), end(line), blankCell);
+                line.wrapped = false;
             }
         );
     }
@@ -549,7 +1018,9 @@ void ScreenBuffer::scrollDown(cursor_pos_t v_n, Margin const& _margin)
 
 void ScreenBuffer::deleteChars(cursor_pos_t _lineNo, cursor_pos_t _n)
 {
-    auto line = next(begin(lines), _lineNo - 1);
+    markDamaged(_lineNo);
+
+    auto line = lineIteratorAt(_lineNo);
     auto column = next(begin(*line), realCursorPosition().column - 1);
     auto rightMargin = next(begin(*line), margin_.horizontal.to);
     auto const n = min(_n, static_cast<cursor_pos_t>(distance(column, rightMargin)));
@@ -563,16 +1034,18 @@ void ScreenBuffer::deleteChars(cursor_pos_t _lineNo, cursor_pos_t _n)
     fill(
         prev(rightMargin, n),
         rightMargin,
-        Cell{L' ', cursor.graphicsRendition}
+        Cell{L' ', cursorAttributesId()}
     );
 }
 
 /// Inserts @p _n characters at given line @p _lineNo.
 void ScreenBuffer::insertChars(cursor_pos_t _lineNo, cursor_pos_t _n)
 {
+    markDamaged(_lineNo);
+
     auto const n = min(_n, margin_.horizontal.to - cursorPosition().column + 1);
 
-    auto line = next(begin(lines), _lineNo - 1);
+    auto line = lineIteratorAt(_lineNo);
     auto column0 = next(begin(*line), realCursorPosition().column - 1);
     auto column1 = next(begin(*line), margin_.horizontal.to - n);
     auto column2 = next(begin(*line), margin_.horizontal.to);
@@ -583,13 +1056,13 @@ void ScreenBuffer::insertChars(cursor_pos_t _lineNo, cursor_pos_t _n)
         column2
     );
 
-    if (line == currentLine)
+    if (_lineNo == cursor.position.row)
         updateColumnIterator();
 
     fill_n(
         columnIteratorAt(begin(*line), cursor.position.column),
         n,
-        Cell{L' ', cursor.graphicsRendition}
+        Cell{L' ', cursorAttributesId()}
     );
 }
 
@@ -618,13 +1091,664 @@ bool ScreenBuffer::incrementCursorColumn(cursor_pos_t _n)
     return n == _n;
 }
 
+size_t ScreenBuffer::maxLineCount() const noexcept
+{
+    auto constexpr Unlimited = std::numeric_limits<size_t>::max();
+    auto const height = static_cast<size_t>(size_.height);
+
+    if (!maxHistoryLineCount_.has_value() || *maxHistoryLineCount_ > Unlimited - height)
+        return Unlimited;
+
+    return *maxHistoryLineCount_ + height;
+}
+
+void ScreenBuffer::appendLine(Cell const& _fill)
+{
+    if (lines.size() >= maxLineCount())
+        popFrontLines(1);
+    else if (lines.full())
+        lines.set_capacity(min(max(2 * lines.capacity(), size_t{64}), maxLineCount()));
+
+    auto& line = lines.recycle_back();
+
+    // The line that just scrolled off the screen goes into the scrollback in compact form,
+    // handing its cell storage over to the new line.
+    if (historyLineCount() > 0)
+    {
+        auto& scrolledOff = lines[static_cast<size_t>(historyLineCount() - 1)];
+        scrolledOff.compact = CompactLine::encode(scrolledOff.buffer.data(), scrolledOff.buffer.size(), pool);
+        line.buffer.swap(scrolledOff.buffer);
+        LineBuffer{}.swap(scrolledOff.buffer);
+        historyBudget_.add(lineBytes(scrolledOff));
+    }
+
+    line.reset(static_cast<size_t>(size_.width), _fill);
+
+    if (expandedLines_.size() > 4 * static_cast<size_t>(size_.height))
+        compactExpandedLines(2 * static_cast<size_t>(size_.height));
+
+    // Swapping out in whole pages once a page worth of lines exceeds the limit.
+    if (maxResidentHistoryLineCount_.has_value()
+            && static_cast<size_t>(historyLineCount()) - swappedLineCount_ >= *maxResidentHistoryLineCount_ + PageLineCount)
+        swapOutColdPages();
+
+    if (historyBudget_.exceeded())
+        enforceHistoryBudget();
+}
+
 void ScreenBuffer::clampSavedLines()
 {
-    if (maxHistoryLineCount_.has_value())
-        while (savedLines.size() > maxHistoryLineCount_.value())
-            savedLines.pop_front();
+    auto const maxLines = maxLineCount();
+
+    if (lines.size() > maxLines)
+        popFrontLines(lines.size() - maxLines);
+
+    // Also release recycled storage beyond the (possibly lowered) limit.
+    if (lines.capacity() > maxLines)
+        lines.set_capacity(maxLines);
+}
+
+// {{{ scrollback paging
+namespace {
+    template <typename T>
+    void sortUnique(std::vector<T>& _values)
+    {
+        sort(begin(_values), end(_values));
+        _values.erase(unique(begin(_values), end(_values)), end(_values));
+    }
+
+    template <typename T>
+    void addId(std::vector<T>& _ids, T _id)
+    {
+        if (_id != 0 && (_ids.empty() || _ids.back() != _id))
+            _ids.push_back(_id);
+    }
+}
+
+void ScreenBuffer::clearHistory()
+{
+    popFrontLines(static_cast<size_t>(historyLineCount()));
+    checkHistoryAccounting();
 }
 
+void ScreenBuffer::popFrontLines(size_t _n)
+{
+    auto const oldFirstPage = lineNumberOffset_ / PageLineCount;
+
+    // With no history, the top screen line is dropped instead, which is not accounted.
+    auto const historyCount = static_cast<size_t>(max(historyLineCount(), 0));
+
+    for (size_t i = 0; i < _n; ++i)
+    {
+        if (i < historyCount)
+            historyBudget_.remove(lineBytes(lines[i]));
+        if (lines[i].swapped)
+            --swappedLineCount_;
+        lines[i].swapped = false;
+        lines[i].compact.clear();
+    }
+
+    lines.pop_front(_n);
+    lineNumberOffset_ += _n;
+
+    auto const firstPage = lineNumberOffset_ / PageLineCount;
+    if (firstPage == oldFirstPage)
+        return;
+
+    for (auto i = swappedPages_.begin(); i != swappedPages_.end(); )
+    {
+        if (i->first < firstPage)
+        {
+            swapFile_.release(i->second.extent);
+            i = swappedPages_.erase(i);
+        }
+        else
+            ++i;
+    }
+
+    for (auto i = pageAccess_.begin(); i != pageAccess_.end(); )
+        i = i->first < firstPage ? pageAccess_.erase(i) : next(i);
+}
+
+void ScreenBuffer::setMaxResidentHistoryLineCount(optional<size_t> _count)
+{
+    maxResidentHistoryLineCount_ = _count;
+
+    if (_count.has_value())
+        swapOutColdPages();
+    else
+        while (!swappedPages_.empty())
+            swapIn(swappedPages_.begin()->first);
+}
+
+ScreenBuffer::Line& ScreenBuffer::accessHistoryLine(cursor_pos_t _row)
+{
+    reflowHistory(static_cast<size_t>(1 - _row));
+
+    auto const index = static_cast<size_t>(max(historyLineCount() + _row - 1, 0));
+    auto const page = pageOf(index);
+    auto& line = lines[index];
+    bool const swappedIn = line.swapped;
+
+    if (swappedIn)
+        swapIn(page);
+
+    if (!line.compact.empty())
+    {
+        historyBudget_.remove(lineBytes(line));
+        line.compact.decode(line.buffer, pool);
+        line.compact.clear();
+        historyBudget_.add(lineBytes(line));
+        expandedLines_.push_back(lineNumberOffset_ + index);
+    }
+
+    if (!maxResidentHistoryLineCount_.has_value() || (page == lastAccessedPage_ && !swappedIn))
+        return line;
+
+    lastAccessedPage_ = page;
+    pageAccess_[page] = ++accessCounter_;
+    return line;
+}
+
+void ScreenBuffer::compactLine(Line& _line)
+{
+    historyBudget_.remove(lineBytes(_line));
+    _line.compact = CompactLine::encode(_line.buffer.data(), _line.buffer.size(), pool);
+    LineBuffer{}.swap(_line.buffer);
+    historyBudget_.add(lineBytes(_line));
+}
+
+void ScreenBuffer::compactExpandedLines(size_t _keep)
+{
+    auto const historyEnd = lineNumberOffset_ + static_cast<uint64_t>(historyLineCount());
+
+    for (; expandedLines_.size() > _keep; expandedLines_.pop_front())
+    {
+        // The line may have left the scrollback, or may have been compacted or swapped out since.
+        auto const number = expandedLines_.front();
+        if (number < lineNumberOffset_ || number >= historyEnd)
+            continue;
+
+        auto& line = lines[static_cast<size_t>(number - lineNumberOffset_)];
+        if (line.compact.empty() && !line.swapped)
+            compactLine(line);
+    }
+}
+
+void ScreenBuffer::trimHistory()
+{
+    compactExpandedLines(2 * static_cast<size_t>(size_.height));
+    swapOutColdPages();
+    checkHistoryAccounting();
+}
+
+void ScreenBuffer::setMaxHistoryBytes(optional<size_t> _bytes)
+{
+    historyBudget_.setLimit(_bytes);
+    enforceHistoryBudget();
+    checkHistoryAccounting();
+}
+
+void ScreenBuffer::enforceHistoryBudget()
+{
+    if (!historyBudget_.exceeded())
+        return;
+
+    // Compact form is the cheapest to keep in memory, and the swap file is cheaper still.
+    // Beyond two pages worth of resident lines, at least one of them is complete and can be swapped out.
+    compactExpandedLines(0);
+    if (static_cast<size_t>(historyLineCount()) - swappedLineCount_ >= 2 * PageLineCount)
+        swapOutColdPages();
+
+    while (historyLineCount() > 0 && historyBudget_.exceeded())
+        popFrontLines(1);
+}
+
+// {{{ damage tracking
+void ScreenBuffer::markHyperlinkDamaged(Cell::HyperlinkId _id)
+{
+    if (_id == 0)
+        return;
+
+    for (cursor_pos_t row = 1; row <= size_.height; ++row)
+    {
+        auto const& line = *lineIteratorAt(row);
+        if (std::any_of(begin(line), end(line), [=](Cell const& _cell) { return _cell.hyperlinkId() == _id; }))
+            markDamaged(row);
+    }
+}
+
+std::vector<cursor_pos_t> ScreenBuffer::damagedLines(uint64_t _generation) const
+{
+    auto rows = std::vector<cursor_pos_t>{};
+    for (cursor_pos_t row = 1; row <= size_.height; ++row)
+        if (isLineDamaged(row, _generation))
+            rows.push_back(row);
+    return rows;
+}
+// }}}
+
+ScreenBuffer::HistoryStats ScreenBuffer::historyStats() const
+{
+    auto stats = HistoryStats{};
+    stats.lineCount = static_cast<size_t>(historyLineCount());
+    stats.bytes = historyBudget_.usage();
+    stats.swappedLineCount = swappedLineCount_;
+    stats.swapBytes = swapFile_.size();
+    stats.swapRawBytes = swapFile_.rawSize();
+
+    for (size_t i = 0; i < stats.lineCount; ++i)
+    {
+        if (auto const& compact = lines[i].compact; !compact.empty())
+        {
+            ++stats.compactLineCount;
+            stats.compactBytes += compact.size();
+            stats.cellBytes += compact.cellCount() * sizeof(Cell);
+        }
+    }
+
+    return stats;
+}
+
+void ScreenBuffer::swapOutColdPages()
+{
+    if (!maxResidentHistoryLineCount_.has_value())
+        return;
+
+    auto const historyEnd = lineNumberOffset_ + static_cast<uint64_t>(historyLineCount());
+    auto residentCount = static_cast<size_t>(historyLineCount()) - swappedLineCount_;
+    auto const exceeded = [&]() {
+        return residentCount > *maxResidentHistoryLineCount_ || historyBudget_.exceeded();
+    };
+    if (!exceeded())
+        return;
+
+    // Candidates are the resident pages entirely within the scrollback, and before any lines
+    // still to be reflowed. Never accessed pages go first, oldest first, followed by all others
+    // in least recently used order.
+    auto const candidatesEnd = reflowPending() ? reflowBoundary_ : historyEnd;
+    auto candidates = std::vector<pair<uint64_t, uint64_t>>{};
+    for (auto page = lineNumberOffset_ / PageLineCount; (page + 1) * PageLineCount <= candidatesEnd; ++page)
+    {
+        if (swappedPages_.count(page))
+            continue;
+        auto const access = pageAccess_.find(page);
+        candidates.emplace_back(access != pageAccess_.end() ? access->second : 0, page);
+    }
+    sort(begin(candidates), end(candidates));
+
+    auto const swappedBefore = swappedLineCount_;
+    for (auto const& candidate : candidates)
+    {
+        if (!exceeded())
+            break;
+
+        auto const page = candidate.second;
+        auto const first = static_cast<size_t>(max(page * PageLineCount, lineNumberOffset_) - lineNumberOffset_);
+        auto const last = static_cast<size_t>((page + 1) * PageLineCount - lineNumberOffset_);
+        if (!swapOut(page, first, last))
+            break;
+
+        residentCount -= last - first;
+    }
+
+    if (swappedLineCount_ != swappedBefore)
+        checkHistoryAccounting();
+}
+
+bool ScreenBuffer::swapOut(uint64_t _page, size_t _first, size_t _last)
+{
+    auto const lineCount = _last - _first;
+
+    // The page is stored as its lines in compact form, each prefixed by its size.
+    auto page = SwappedPage{};
+    auto data = string{};
+    for (auto i = _first; i < _last; ++i)
+    {
+        auto& line = lines[i];
+        if (line.compact.empty())
+            compactLine(line);
+
+        writeVarint(data, line.compact.size());
+        data += line.compact.data();
+
+        line.compact.forEachId(
+            [&](Cell::AttributesId _id) { addId(page.attributes, _id); },
+            [&](Cell::HyperlinkId _id) { addId(page.hyperlinks, _id); }
+        );
+    }
+
+    auto const extent = swapFile_.store(reinterpret_cast<uint8_t const*>(data.data()), data.size());
+    if (!extent.has_value())
+        return false;
+
+    page.extent = *extent;
+    page.firstLine = lineNumberOffset_ + _first;
+    page.lineCount = lineCount;
+    sortUnique(page.attributes);
+    sortUnique(page.hyperlinks);
+
+    for (auto i = _first; i < _last; ++i)
+    {
+        historyBudget_.remove(lines[i].compact.size());
+        lines[i].compact.clear();
+        lines[i].swapped = true;
+    }
+
+    swappedLineCount_ += lineCount;
+    swappedPages_.emplace(_page, std::move(page));
+    return true;
+}
+
+void ScreenBuffer::swapIn(uint64_t _page)
+{
+    auto const i = swappedPages_.find(_page);
+    assert(i != swappedPages_.end());
+    auto const& page = i->second;
+
+    // Lines may have been removed from the front since the page was swapped out.
+    auto const skip = static_cast<size_t>(max(lineNumberOffset_, page.firstLine) - page.firstLine);
+    auto const first = static_cast<size_t>(page.firstLine + skip - lineNumberOffset_);
+
+    auto const restore = [&](std::vector<uint8_t> const& _data) -> bool {
+        auto const* input = reinterpret_cast<char const*>(_data.data());
+        auto const* const end = input + _data.size();
+
+        for (size_t k = 0; k < page.lineCount; ++k)
+        {
+            auto const size = readVarint(input, end);
+            if (!size.has_value() || *size > static_cast<uint64_t>(end - input))
+                return false;
+
+            if (k >= skip)
+            {
+                auto& line = lines[first + k - skip];
+                line.compact = CompactLine{string(input, static_cast<size_t>(*size))};
+                line.swapped = false;
+                historyBudget_.add(line.compact.size());
+            }
+            input += *size;
+        }
+        return input == end;
+    };
+
+    if (auto const data = swapFile_.load(page.extent); !data.has_value() || !restore(*data))
+    {
+        // The swap file let us down. Bringing back blank lines is the best we can do.
+        for (size_t k = skip; k < page.lineCount; ++k)
+        {
+            auto& line = lines[first + k - skip];
+            historyBudget_.remove(lineBytes(line));
+            line.compact.clear();
+            line.buffer.assign(static_cast<size_t>(size_.width), Cell{});
+            line.swapped = false;
+            historyBudget_.add(lineBytes(line));
+        }
+    }
+
+    swappedLineCount_ -= page.lineCount - skip;
+    swapFile_.release(page.extent);
+    swappedPages_.erase(i);
+
+    checkHistoryAccounting();
+}
+// }}}
+
+// {{{ reflow
+size_t ScreenBuffer::logicalLineStart(size_t _index) const noexcept
+{
+    while (_index > 0 && lines[_index].wrapped)
+        --_index;
+    return _index;
+}
+
+void ScreenBuffer::swapInLines(size_t _first, size_t _last)
+{
+    for (auto i = _first; i < _last; ++i)
+        if (lines[i].swapped)
+            swapIn(pageOf(i));
+}
+
+std::vector<ScreenBuffer::Line> ScreenBuffer::reflowLines(size_t _first, size_t _last, size_t _width, LinePosition* _cursor)
+{
+    auto result = std::vector<Line>{};
+    auto scratch = LineBuffer{};
+
+    // The logical line being collected.
+    auto cells = LineBuffer{};
+    bool wrapped = false;
+    bool marked = false;
+    optional<size_t> cursorOffset;
+    bool const hasCursor = _cursor != nullptr;
+    auto const cursor = hasCursor ? *_cursor : LinePosition{};
+
+    auto const breakLogicalLine = [&]() {
+        // Trailing blanks are not kept, unless the cursor is in there.
+        auto length = cells.size();
+        while (length != 0 && isBlank(cells[length - 1]))
+            --length;
+        if (cursorOffset.has_value())
+            length = max(length, *cursorOffset);
+        cells.resize(length);
+
+        auto const firstLine = result.size();
+        size_t i = 0;
+        do
+        {
+            auto& line = result.emplace_back();
+            line.wrapped = result.size() - 1 == firstLine ? wrapped : true;
+            line.buffer.reserve(_width);
+
+            auto const lineStart = i;
+            while (i < length)
+            {
+                // Wide characters are never broken apart from their trailing cells.
+                auto const unit = min(static_cast<size_t>(max(cells[i].width(), 1)), length - i);
+                if (line.buffer.size() + unit > _width)
+                {
+                    if (!line.buffer.empty())
+                        break;
+                    line.buffer.insert(end(line.buffer), next(begin(cells), i), next(begin(cells), i + _width));
+                    i += unit;
+                    break;
+                }
+                line.buffer.insert(end(line.buffer), next(begin(cells), i), next(begin(cells), i + unit));
+                i += unit;
+            }
+
+            if (cursorOffset.has_value() && *cursorOffset >= lineStart && (*cursorOffset < i || i == length))
+            {
+                _cursor->line = result.size() - 1;
+                _cursor->column = min(*cursorOffset - lineStart, _width);
+                cursorOffset.reset();
+            }
+
+            line.buffer.resize(_width, Cell{});
+        }
+        while (i < length);
+
+        result[firstLine].marked = marked;
+        cells.clear();
+    };
+
+    for (auto i = _first; i < _last; ++i)
+    {
+        auto const& line = lines[i];
+        if (i != _first && !line.wrapped)
+            breakLogicalLine();
+        if (i == _first || !line.wrapped)
+        {
+            wrapped = line.wrapped;
+            marked = false;
+        }
+
+        auto const* part = &line.buffer;
+        if (!line.compact.empty())
+        {
+            line.compact.decode(scratch, pool);
+            part = &scratch;
+        }
+
+        // A wide character not fitting at the end of the line left blank padding there.
+        if (!part->empty() && part->front().width() > 1)
+        {
+            auto padding = size_t{0};
+            while (padding < cells.size() && isBlank(cells[cells.size() - 1 - padding]))
+                ++padding;
+            if (padding < cells.size())
+            {
+                auto const& preceding = cells[cells.size() - 1 - padding];
+                padding -= min(padding, static_cast<size_t>(max(preceding.width(), 1) - 1));
+            }
+            if (padding < static_cast<size_t>(part->front().width()))
+                cells.resize(cells.size() - padding);
+        }
+
+        if (hasCursor && cursor.line == i - _first)
+            cursorOffset = cells.size() + cursor.column;
+
+        marked = marked || line.marked;
+        cells.insert(end(cells), begin(*part), end(*part));
+
+        // A wide character written into the last column lost its trailing cells.
+        for (auto k = cells.size() - min(cells.size(), size_t{4}); k < cells.size(); ++k)
+            if (k + static_cast<size_t>(max(cells[k].width(), 1)) > cells.size())
+                cells.resize(k + static_cast<size_t>(cells[k].width()), Cell{});
+    }
+
+    if (_first < _last)
+        breakLogicalLine();
+
+    return result;
+}
+
+void ScreenBuffer::replaceLines(size_t _first, size_t _last, std::vector<Line>&& _lines)
+{
+    auto const oldCount = _last - _first;
+    auto const newCount = _lines.size();
+
+    if (newCount > oldCount)
+    {
+        // Makes room by taking slots from the front, and rotating them into place.
+        auto const n = newCount - oldCount;
+        if (lines.capacity() < lines.size() + n)
+            lines.set_capacity(lines.size() + n);
+        for (size_t i = 0; i < n; ++i)
+            lines.recycle_front();
+        rotate(begin(lines), next(begin(lines), n), next(begin(lines), _first + n));
+    }
+    else if (newCount < oldCount)
+    {
+        // Rotates the superfluous lines to the front, to be dropped from there.
+        auto const n = oldCount - newCount;
+        rotate(begin(lines), next(begin(lines), _first), next(begin(lines), _first + n));
+        for (size_t i = 0; i < n; ++i)
+            lines[i].compact.clear();
+        lines.pop_front(n);
+    }
+
+    std::move(begin(_lines), end(_lines), next(begin(lines), _first));
+}
+
+void ScreenBuffer::reflow(int _width)
+{
+    auto const width = static_cast<size_t>(_width);
+    auto const height = static_cast<size_t>(size_.height);
+    auto const historyCount = static_cast<size_t>(historyLineCount());
+    auto const cursorIndex = historyCount + static_cast<size_t>(cursor.position.row - 1);
+
+    auto const isBlankLine = [](Line const& _line) {
+        return !_line.wrapped && !_line.marked && std::all_of(begin(_line), end(_line), isBlank);
+    };
+
+    // Takes in as many scrollback lines as it needs to fill the screen again,
+    // with at least the logical line wrapping into the screen.
+    auto first = logicalLineStart(historyCount);
+    auto cursorPosition = LinePosition{};
+    auto result = std::vector<Line>{};
+    for (;;)
+    {
+        swapInLines(first, historyCount);
+
+        // With a wrap pending, the cursor is right past the last column.
+        cursorPosition = LinePosition{cursorIndex - first, static_cast<size_t>(cursor.position.column - (wrapPending ? 0 : 1))};
+        result = reflowLines(first, lines.size(), width, &cursorPosition);
+
+        // Blank lines below the cursor give way, rather than pushing lines into the scrollback.
+        while (result.size() > height && cursorPosition.line + 1 < result.size() && isBlankLine(result.back()))
+            result.pop_back();
+
+        if (result.size() >= height || first == 0)
+            break;
+
+        first = logicalLineStart(first - 1);
+    }
+
+    while (result.size() < height)
+        result.emplace_back(width, Cell{});
+
+    auto const newHistoryCount = first + result.size() - height;
+
+    for (auto i = first; i < historyCount; ++i)
+        historyBudget_.remove(lineBytes(lines[i]));
+
+    replaceLines(first, lines.size(), std::move(result));
+
+    for (auto i = first; i < newHistoryCount; ++i)
+    {
+        historyBudget_.add(lineBytes(lines[i]));
+        compactLine(lines[i]);
+    }
+
+    size_.width = _width;
+
+    // With more than a screen full of lines below it, the cursor is kept on the top line.
+    cursor.position.row = max(static_cast<cursor_pos_t>(cursorPosition.line + first) - static_cast<cursor_pos_t>(newHistoryCount), 0) + 1;
+    wrapPending = cursorPosition.column == width;
+    cursor.position.column = static_cast<cursor_pos_t>(min(cursorPosition.column + 1, width));
+
+    // Older scrollback lines are reflowed lazily, as they are accessed.
+    reflowBoundary_ = lineNumberOffset_ + first;
+
+    clampSavedLines();
+    enforceHistoryBudget();
+}
+
+void ScreenBuffer::reflowHistory(size_t _count)
+{
+    while (reflowPending() && static_cast<size_t>(historyLineCount()) < _count + (reflowBoundary_ - lineNumberOffset_))
+        reflowHistoryChunk();
+}
+
+void ScreenBuffer::reflowHistoryChunk()
+{
+    auto const last = static_cast<size_t>(reflowBoundary_ - lineNumberOffset_);
+    auto const first = logicalLineStart(last - min(last, PageLineCount));
+
+    swapInLines(first, last);
+    for (auto i = first; i < last; ++i)
+        historyBudget_.remove(lineBytes(lines[i]));
+
+    auto reflown = reflowLines(first, last, static_cast<size_t>(size_.width), nullptr);
+    auto const count = reflown.size();
+    replaceLines(first, last, std::move(reflown));
+
+    for (auto i = first; i < first + count; ++i)
+    {
+        historyBudget_.add(lineBytes(lines[i]));
+        compactLine(lines[i]);
+    }
+
+    reflowBoundary_ = lineNumberOffset_ + first;
+
+    clampSavedLines();
+    if (historyBudget_.exceeded())
+        enforceHistoryBudget();
+
+    checkHistoryAccounting();
+}
+// }}}
+
 void ScreenBuffer::clearAllTabs()
 {
     tabs.clear();
@@ -649,6 +1773,22 @@ void ScreenBuffer::setTabUnderCursor()
     sort(begin(tabs), end(tabs));
 }
 
+void ScreenBuffer::checkHistoryAccounting() const
+{
+#if !defined(NDEBUG)
+    size_t historyBytes = 0;
+    for (size_t i = 0; i < static_cast<size_t>(max(historyLineCount(), 0)); ++i)
+        historyBytes += lineBytes(lines[i]);
+    if (historyBytes != historyBudget_.usage())
+        fail(fmt::format("History takes {} bytes but {} are accounted.", historyBytes, historyBudget_.usage()));
+
+    if (reflowPending())
+        for (auto const& [page, _] : swappedPages_)
+            if ((page + 1) * PageLineCount > reflowBoundary_)
+                fail(fmt::format("Page {} is swapped out while lines in it are still to be reflowed.", page));
+#endif
+}
+
 void ScreenBuffer::verifyState() const
 {
 #if !defined(NDEBUG)
@@ -663,8 +1803,14 @@ void ScreenBuffer::verifyState() const
         ));
     }
 
-    if (static_cast<size_t>(size_.height) != lines.size())
-        fail(fmt::format("Line count mismatch. Actual line count {} but should be {}.", lines.size(), size_.height));
+    if (historyLineCount() < 0)
+        fail(fmt::format("Line count mismatch. Actual line count {} but should be at least {}.", lines.size(), size_.height));
+
+    if (lines.size() > maxLineCount())
+        fail(fmt::format("Line count {} exceeds maximum of {}.", lines.size(), maxLineCount()));
+
+    if (swappedLineCount_ > static_cast<size_t>(historyLineCount()))
+        fail(fmt::format("Swapped line count {} exceeds history line count {}.", swappedLineCount_, historyLineCount()));
 
     // verify cursor positions
     [[maybe_unused]] auto const clampedCursorPos = clampToScreen(cursor.position);
@@ -673,12 +1819,9 @@ void ScreenBuffer::verifyState() const
     // FIXME: the above triggers on tmux vertical screen split (cursor.column off-by-one)
 
     // verify iterators
-    [[maybe_unused]] auto const line = next(begin(lines), cursor.position.row - 1);
     [[maybe_unused]] auto const col = columnIteratorAt(cursor.position.column);
 
-    if (line != currentLine)
-        fail(fmt::format("Calculated current line does not match."));
-    else if (col != currentColumn)
+    if (col != currentColumn)
         fail(fmt::format("Calculated current column does not match."));
 
     if (wrapPending && cursor.position.column != size_.width && cursor.position.column != margin_.horizontal.to)
@@ -730,7 +1873,7 @@ string ScreenBuffer::renderTextLine(cursor_pos_t row) const
     string line;
     line.reserve(size_.width);
     for (cursor_pos_t col = 1; col <= size_.width; ++col)
-        if (auto const& cell = at({row, col}); cell.codepointCount())
+        if (auto const cell = view(at({row, col})); cell.codepointCount())
             line += cell.toUtf8();
         else
             line += " "; // fill character
@@ -761,7 +1904,7 @@ std::string ScreenBuffer::screenshot() const
     {
         for (cursor_pos_t const col : crispy::times(1, size_.width))
         {
-            Cell const& cell = at({row, col});
+            auto const cell = view(at({row, col}));
 
             //TODO: some kind of: generator(SetGraphicsRendition{ cell.attributes().styles });
             if (cell.attributes().styles & CharacterStyleMask::Bold)
@@ -14,19 +14,23 @@
 #pragma once
 
 #include <terminal/Charset.h>
+#include <terminal/CodepointProperties.h>
 #include <terminal/Color.h>
 #include <terminal/Commands.h>              // Coordinate, cursor_pos_t, Mode
 #include <terminal/Hyperlink.h>
 #include <terminal/Logger.h>
 #include <terminal/Size.h>
+#include <terminal/HistoryBudget.h>
+#include <terminal/SwapFile.h>
 
-#include <unicode/width.h>
-
+#include <crispy/ring.h>
 #include <crispy/times.h>
 
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <optional>
@@ -35,6 +39,7 @@
 #include <stack>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 using std::pair;
@@ -64,69 +69,6 @@ class Modes {
     std::set<Mode> enabled_;
 };
 
-class CharacterStyleMask {
-  public:
-	enum Mask : uint16_t {
-		Bold = (1 << 0),
-		Faint = (1 << 1),
-		Italic = (1 << 2),
-		Underline = (1 << 3),
-		Blinking = (1 << 4),
-		Inverse = (1 << 5),
-		Hidden = (1 << 6),
-		CrossedOut = (1 << 7),
-		DoublyUnderlined = (1 << 8),
-        CurlyUnderlined = (1 << 9),
-        DottedUnderline = (1 << 10),
-        DashedUnderline = (1 << 11),
-        Framed = (1 << 12),
-        Encircled = (1 << 13),
-        Overline = (1 << 14),
-	};
-
-	constexpr CharacterStyleMask() : mask_{} {}
-	constexpr CharacterStyleMask(Mask m) : mask_{m} {}
-	constexpr CharacterStyleMask(unsigned m) : mask_{m} {}
-	constexpr CharacterStyleMask(CharacterStyleMask const& _other) noexcept : mask_{_other.mask_} {}
-
-	constexpr CharacterStyleMask& operator=(CharacterStyleMask const& _other) noexcept
-	{
-		mask_ = _other.mask_;
-		return *this;
-	}
-
-	constexpr unsigned mask() const noexcept { return mask_; }
-
-	constexpr operator unsigned () const noexcept { return mask_; }
-
-  private:
-	unsigned mask_;
-};
-
-std::string to_string(CharacterStyleMask _mask);
-
-constexpr bool operator==(CharacterStyleMask const& a, CharacterStyleMask const& b) noexcept
-{
-	return a.mask() == b.mask();
-}
-
-constexpr CharacterStyleMask& operator|=(CharacterStyleMask& a, CharacterStyleMask const& b) noexcept
-{
-    a = a | b;
-	return a;
-}
-
-constexpr CharacterStyleMask& operator&=(CharacterStyleMask& a, CharacterStyleMask const& b) noexcept
-{
-    a = a & b;
-	return a;
-}
-
-constexpr bool operator!(CharacterStyleMask const& a) noexcept
-{
-	return a.mask() == 0;
-}
-
 struct Margin {
 	struct Range {
 		int from;
@@ -187,6 +129,43 @@ struct GraphicsAttributes {
     }
 };
 
+constexpr bool operator==(GraphicsAttributes const& a, GraphicsAttributes const& b) noexcept
+{
+    return a.backgroundColor == b.backgroundColor
+        && a.foregroundColor == b.foregroundColor
+        && a.styles == b.styles
+        && a.underlineColor == b.underlineColor;
+}
+
+constexpr bool operator!=(GraphicsAttributes const& a, GraphicsAttributes const& b) noexcept
+{
+    return !(a == b);
+}
+
+struct GraphicsAttributesHash {
+    static constexpr size_t hash(Color const& _color) noexcept
+    {
+        return std::visit([](auto const& _value) -> size_t {
+            using T = std::decay_t<decltype(_value)>;
+            if constexpr (std::is_same_v<T, RGBColor>)
+                return (size_t(_value.red) << 16) | (size_t(_value.green) << 8) | _value.blue;
+            else if constexpr (std::is_same_v<T, IndexedColor> || std::is_same_v<T, BrightColor>)
+                return static_cast<size_t>(_value);
+            else
+                return 0;
+        }, _color) * 8 + _color.index();
+    }
+
+    size_t operator()(GraphicsAttributes const& _attributes) const noexcept
+    {
+        size_t h = hash(_attributes.foregroundColor);
+        h = h * 31 + hash(_attributes.backgroundColor);
+        h = h * 31 + hash(_attributes.underlineColor);
+        h = h * 31 + _attributes.styles.mask();
+        return h;
+    }
+};
+
 /// Terminal cursor data structure.
 ///
 /// NB: Take care what to store here, as DECSC/DECRC will save/restore this struct.
@@ -204,69 +183,65 @@ struct Cursor
 };
 
 /// Grid cell with character and graphics rendition information.
+///
+/// A cell is kept at 16 bytes, as a screen with a large scrollback holds millions of them.
+/// Only the first codepoint is stored inline. Graphics attributes, hyperlinks and grapheme
+/// clusters of more than one codepoint are referenced by ID into the owning buffer's CellPool.
+/// Use CellView to access a cell together with its pooled data.
 class Cell {
   public:
     static size_t constexpr MaxCodepoints = 9;
 
-    Cell(char32_t _ch, GraphicsAttributes _attrib) noexcept :
-        codepoints_{},
-        attributes_{std::move(_attrib)},
-        width_{1},
-        codepointCount_{0}
+    using AttributesId = uint32_t;
+    using HyperlinkId = uint16_t;
+    using ClusterId = uint32_t;
+
+    Cell(char32_t _ch, AttributesId _attributes, HyperlinkId _hyperlink = 0) noexcept :
+        attributes_{_attributes},
+        hyperlink_{_hyperlink}
     {
         setCharacter(_ch);
     }
 
-    constexpr Cell() noexcept :
-        codepoints_{},
-        attributes_{},
-        width_{1},
-        codepointCount_{0}
-    {}
+    constexpr Cell() noexcept = default;
 
     void reset() noexcept
     {
-        attributes_ = {};
-        codepointCount_ = 0;
-        width_ = 1;
-        hyperlink_ = nullptr;
+        *this = Cell{};
     }
 
-    void reset(GraphicsAttributes _attribs, HyperlinkRef const& _hyperlink) noexcept
+    void reset(AttributesId _attributes, HyperlinkId _hyperlink) noexcept
     {
-        attributes_ = std::move(_attribs);
-        codepointCount_ = 0;
-        width_ = 1;
+        codepoint_ = 0;
+        cluster_ = 0;
+        attributes_ = _attributes;
         hyperlink_ = _hyperlink;
+        width_ = 1;
+        codepointCount_ = 0;
     }
 
-    Cell(Cell const&) noexcept = default;
-    Cell(Cell&&) noexcept = default;
-    Cell& operator=(Cell const&) noexcept = default;
-    Cell& operator=(Cell&&) noexcept = default;
-
-    constexpr std::u32string_view codepoints() const noexcept
-    {
-        return std::u32string_view{codepoints_.data(), codepointCount_};
-    }
-
-    constexpr char32_t codepoint(size_t i) const noexcept { return codepoints_[i]; }
+    /// @returns the first codepoint of this cell, or 0 if empty.
+    constexpr char32_t codepoint() const noexcept { return codepoint_; }
     constexpr int codepointCount() const noexcept { return codepointCount_; }
 
     constexpr bool empty() const noexcept { return codepointCount_ == 0; }
 
     constexpr int width() const noexcept { return width_; }
 
-    constexpr GraphicsAttributes const& attributes() const noexcept { return attributes_; }
-    constexpr GraphicsAttributes& attributes() noexcept { return attributes_; }
+    constexpr AttributesId attributesId() const noexcept { return attributes_; }
+    constexpr HyperlinkId hyperlinkId() const noexcept { return hyperlink_; }
+
+    /// @returns the grapheme cluster this cell refers to, or 0 if it holds at most one codepoint.
+    constexpr ClusterId clusterId() const noexcept { return cluster_; }
 
     void setCharacter(char32_t _codepoint) noexcept
     {
-        codepoints_[0] = _codepoint;
+        codepoint_ = _codepoint;
+        cluster_ = 0;
         if (_codepoint)
         {
             codepointCount_ = 1;
-            width_ = std::max(unicode::width(_codepoint), 1);
+            width_ = static_cast<uint8_t>(std::max(columnWidth(_codepoint), 1));
         }
         else
         {
@@ -277,59 +252,201 @@ class Cell {
 
     void setWidth(int _width) noexcept
     {
-        width_ = _width;
+        width_ = static_cast<uint8_t>(_width);
     }
 
-    int appendCharacter(char32_t _codepoint) noexcept
+    void setAttributesId(AttributesId _id) noexcept { attributes_ = _id; }
+    void setHyperlinkId(HyperlinkId _id) noexcept { hyperlink_ = _id; }
+
+    /// Makes this cell refer to the grapheme cluster @p _id holding @p _count codepoints.
+    void setCluster(ClusterId _id, int _count) noexcept
     {
-        if (codepointCount_ < MaxCodepoints)
-        {
-            codepoints_[codepointCount_] = _codepoint;
-            codepointCount_++;
+        cluster_ = _id;
+        codepointCount_ = static_cast<uint8_t>(_count);
+    }
 
-            constexpr bool AllowWidthChange = false; // TODO: make configurable
+  private:
+    friend class CellView;
 
-            auto const width = [&]() {
-                switch (_codepoint)
-                {
-                    case 0xFE0E:
-                        return 1;
-                    case 0xFE0F:
-                        return 2;
-                    default:
-                        return unicode::width(_codepoint);
-                }
-            }();
+    /// First (and usually only) Unicode codepoint to be displayed.
+    char32_t codepoint_ = 0;
 
-            if (width != width_ && AllowWidthChange)
-            {
-                int const diff = width - width_;
-                width_ = width;
-                return diff;
-            }
-        }
-        return 0;
+    /// Grapheme cluster in the CellPool holding all codepoints, if there is more than one.
+    ClusterId cluster_ = 0;
+
+    /// Graphics renditions, such as foreground/background color or other grpahics attributes.
+    AttributesId attributes_ = 0;
+
+    HyperlinkId hyperlink_ = 0;
+
+    /// number of cells this cell spans. Usually this is 1, but it may be also 0 or >= 2.
+    uint8_t width_ = 1;
+
+    /// Number of combined codepoints stored in this cell.
+    uint8_t codepointCount_ = 0;
+};
+
+static_assert(sizeof(Cell) == 16);
+
+/// Side tables of a ScreenBuffer, holding what does not fit into a Cell: interned graphics
+/// attributes, hyperlinks, and grapheme clusters of more than one codepoint.
+///
+/// ID 0 always refers to the default attributes, no hyperlink, and no cluster respectively.
+///
+/// Cells are copied around freely (scrolling, erasing, inserting), so entries are not reference
+/// counted. Instead, the owning ScreenBuffer reclaims unused entries by marking all cells still
+/// referencing them (see ScreenBuffer::collectGarbage()), once shouldCollect() says so.
+/// Hyperlinks are kept in a bounded HyperlinkStore, which evicts unreferenced links in LRU order.
+/// Grapheme clusters are never modified once written, so that copies of a cell may share them.
+class CellPool {
+  public:
+    using Cluster = std::array<char32_t, Cell::MaxCodepoints>;
+
+    /// Number of entries per table at which the first collection is triggered.
+    static size_t constexpr MinCollectThreshold = 4096;
+
+    CellPool();
+
+    GraphicsAttributes const& attributes(Cell::AttributesId _id) const noexcept { return attributes_[_id]; }
+    HyperlinkRef const& hyperlink(Cell::HyperlinkId _id) const noexcept { return hyperlinks_.at(_id); }
+    Cluster const& cluster(Cell::ClusterId _id) const noexcept { return clusters_[_id]; }
+    Cluster& cluster(Cell::ClusterId _id) noexcept { return clusters_[_id]; }
+
+    HyperlinkStore& hyperlinks() noexcept { return hyperlinks_; }
+    HyperlinkStore const& hyperlinks() const noexcept { return hyperlinks_; }
+
+    std::optional<Cell::AttributesId> findAttributes(GraphicsAttributes const& _attributes) const;
+    Cell::AttributesId addAttributes(GraphicsAttributes const& _attributes);
+
+    Cell::ClusterId allocateCluster();
+
+    /// @returns the number of live entries in the attributes and cluster table.
+    size_t attributesCount() const noexcept { return attributes_.size() - freeAttributes_.size(); }
+    size_t clusterCount() const noexcept { return clusters_.size() - freeClusters_.size(); }
+
+    /// Tests whether any table has grown enough to make a collection worthwhile.
+    ///
+    /// The hyperlink store is bounded instead, and collected once it runs full.
+    bool shouldCollect() const noexcept
+    {
+        return attributesCount() >= attributesThreshold_
+            || clusterCount() >= clustersThreshold_;
+    }
+
+    void beginCollection();
+
+    void mark(Cell const& _cell) noexcept
+    {
+        attributesMarks_[_cell.attributesId()] = true;
+        hyperlinks_.mark(_cell.hyperlinkId());
+        clustersMarks_[_cell.clusterId()] = true;
     }
 
+    void markAttributes(Cell::AttributesId _id) noexcept { attributesMarks_[_id] = true; }
+    void markHyperlink(Cell::HyperlinkId _id) noexcept { hyperlinks_.mark(_id); }
+
+    /// Frees all entries that have not been marked since beginCollection().
+    void endCollection();
+
+    /// Incremented by every collection that freed entries, as their IDs may be handed out again.
+    ///
+    /// Consumers caching data per ID (such as resolved colors) must drop it when this changes.
+    uint64_t generation() const noexcept { return generation_; }
+
+  private:
+    uint64_t generation_ = 0;
+
+    std::vector<GraphicsAttributes> attributes_;
+    std::unordered_map<GraphicsAttributes, Cell::AttributesId, GraphicsAttributesHash> attributeIds_;
+    std::vector<Cell::AttributesId> freeAttributes_;
+    std::vector<bool> attributesMarks_;
+    size_t attributesThreshold_ = MinCollectThreshold;
+
+    HyperlinkStore hyperlinks_;
+
+    std::vector<Cluster> clusters_;
+    std::vector<Cell::ClusterId> freeClusters_;
+    std::vector<bool> clustersMarks_;
+    size_t clustersThreshold_ = MinCollectThreshold;
+};
+
+/// Read-only view of a Cell with its pooled data resolved.
+///
+/// This is what renderers and other consumers outside the ScreenBuffer get to see.
+class CellView {
+  public:
+    CellView(Cell const& _cell, CellPool const& _pool) noexcept : cell_{&_cell}, pool_{&_pool} {}
+
+    std::u32string_view codepoints() const noexcept
+    {
+        if (cell_->cluster_)
+            return std::u32string_view{pool_->cluster(cell_->cluster_).data(), cell_->codepointCount_};
+        else
+            return std::u32string_view{&cell_->codepoint_, cell_->codepointCount_};
+    }
+
+    /// @returns the @p i-th codepoint of this cell, or 0 if out of bounds.
+    char32_t codepoint(size_t i) const noexcept
+    {
+        if (i >= cell_->codepointCount_)
+            return 0;
+        return cell_->cluster_ ? pool_->cluster(cell_->cluster_)[i] : cell_->codepoint_;
+    }
+
+    int codepointCount() const noexcept { return cell_->codepointCount(); }
+    bool empty() const noexcept { return cell_->empty(); }
+    int width() const noexcept { return cell_->width(); }
+
+    Cell::AttributesId attributesId() const noexcept { return cell_->attributesId(); }
+    GraphicsAttributes const& attributes() const noexcept { return pool_->attributes(cell_->attributesId()); }
+    HyperlinkRef const& hyperlink() const noexcept { return pool_->hyperlink(cell_->hyperlinkId()); }
+
     std::string toUtf8() const;
 
-    HyperlinkRef hyperlink() const noexcept { return hyperlink_; }
-    void setHyperlink(HyperlinkRef const& _hyperlink) { hyperlink_ = _hyperlink; }
+    Cell const& cell() const noexcept { return *cell_; }
+    CellPool const& pool() const noexcept { return *pool_; }
 
   private:
-    /// Unicode codepoint to be displayed.
-    std::array<char32_t, MaxCodepoints> codepoints_;
+    Cell const* cell_;
+    CellPool const* pool_;
+};
 
-    /// Graphics renditions, such as foreground/background color or other grpahics attributes.
-    GraphicsAttributes attributes_;
+/// Immutable, compact encoding of a line of cells, as used for lines scrolled off into the history.
+///
+/// Instead of 16 bytes per cell, this holds the UTF-8 text of the cells (an empty cell being
+/// encoded as U+0000), run-length encoded spans of attribute IDs and hyperlink IDs, and the few
+/// cells whose codepoint count or width is not what their text implies. Trailing blank cells are
+/// dropped. Grapheme clusters are stored as text, so the encoding does not refer to the pool's.
+class CompactLine {
+  public:
+    CompactLine() = default;
+    explicit CompactLine(std::string _data) noexcept : data_{std::move(_data)} {}
 
-    /// number of cells this cell spans. Usually this is 1, but it may be also 0 or >= 2.
-    uint8_t width_;
+    static CompactLine encode(Cell const* _cells, size_t _count, CellPool const& _pool);
 
-    /// Number of combined codepoints stored in this cell.
-    uint8_t codepointCount_;
+    /// Replaces @p _cells with the decoded cells, allocating their grapheme clusters in @p _pool.
+    void decode(std::vector<Cell>& _cells, CellPool& _pool) const;
+
+    /// @returns whether or not this holds no line at all.
+    bool empty() const noexcept { return data_.empty(); }
+
+    /// Releases the encoded line.
+    void clear() noexcept { std::string{}.swap(data_); }
+
+    /// @returns the number of bytes the encoded line takes.
+    size_t size() const noexcept { return data_.size(); }
+
+    /// @returns the number of cells of the line, including dropped trailing blank cells.
+    size_t cellCount() const noexcept;
+
+    /// Invokes the given functions with each attributes ID and hyperlink ID referenced by the line.
+    void forEachId(std::function<void(Cell::AttributesId)> const& _attributes,
+                   std::function<void(Cell::HyperlinkId)> const& _hyperlink) const;
+
+    std::string const& data() const noexcept { return data_; }
 
-    HyperlinkRef hyperlink_ = nullptr;
+  private:
+    std::string data_;
 };
 
 /**
@@ -347,6 +464,17 @@ struct ScreenBuffer {
         LineBuffer buffer;
         bool marked = false;
 
+        /// Scrollback lines are kept in compact form, leaving the buffer empty until accessed.
+        CompactLine compact;
+
+        /// Whether the line is swapped out, leaving both buffer and compact form empty (see swapOutColdPages()).
+        bool swapped = false;
+
+        /// Whether the line continues the previous line, as text was wrapped over into it.
+        ///
+        /// Lines continuing each other make up a logical line, which is reflowed on resize.
+        bool wrapped = false;
+
         using iterator = LineBuffer::iterator;
         using const_iterator = LineBuffer::const_iterator;
         using reverse_iterator = LineBuffer::reverse_iterator;
@@ -366,6 +494,16 @@ struct ScreenBuffer {
         auto size() const noexcept { return buffer.size(); }
         void resize(size_type _size) { buffer.resize(_size); }
 
+        /// Fills this line with @p _width copies of @p _cell, reusing the allocated storage.
+        void reset(size_type _width, Cell const& _cell)
+        {
+            buffer.assign(_width, _cell);
+            compact.clear();
+            marked = false;
+            swapped = false;
+            wrapped = false;
+        }
+
         iterator begin() { return buffer.begin(); }
         iterator end() { return buffer.end(); }
         reverse_iterator rbegin() { return buffer.rbegin(); }
@@ -375,10 +513,15 @@ struct ScreenBuffer {
     };
     using ColumnIterator = Line::iterator;
 
-	using Lines = std::deque<Line>;
+    /// Scrollback lines followed by the screen lines, oldest first.
+    ///
+    /// Lines scrolled off the top of the screen stay in place and become scrollback simply by
+    /// the screen's window moving down. Once the history is full, the oldest scrollback line's
+    /// storage is recycled for the new bottom line.
+    using Lines = crispy::ring<Line>;
     using LineIterator = Lines::iterator;
 
-    using Renderer = std::function<void(Coordinate const&, Cell const&)>;
+    using Renderer = std::function<void(Coordinate const&, CellView const&)>;
 
 	ScreenBuffer(Type _type, Size const& _size, Modes& _modes, std::optional<size_t> _maxHistoryLineCount)
 		: type_{ _type },
@@ -391,19 +534,66 @@ struct ScreenBuffer {
 		  },
 		  lines{ static_cast<size_t>(_size.height), Line{static_cast<size_t>(_size.width), Cell{}} }
 	{
+        lineDamage_.assign(static_cast<size_t>(_size.height), 0);
 		verifyState();
 	}
 
     void reset()
     {
+        auto const maxResidentHistoryLineCount = maxResidentHistoryLineCount_;
+        auto const maxHistoryBytes = historyBudget_.limit();
+        auto const damageGeneration = damageGeneration_;
         *this = ScreenBuffer(type_, size_, modes_.get(), maxHistoryLineCount_);
+        maxResidentHistoryLineCount_ = maxResidentHistoryLineCount;
+        historyBudget_.setLimit(maxHistoryBytes);
+        damageGeneration_ = damageGeneration;
+        markAllDamaged();
     }
 
     int historyLineCount() const noexcept
     {
-        return static_cast<int>(savedLines.size());
+        return static_cast<int>(lines.size()) - size_.height;
     }
 
+    /// Removes all lines from the scrollback.
+    void clearHistory();
+
+    /// @returns the line at given row, with rows 1 to N being the screen lines
+    ///          and rows 0 to -M being the scrollback lines, most recent first.
+    ///
+    /// Scrollback lines are reflowed, expanded from their compact form, and swapped back in if needed.
+    Line& lineAt(cursor_pos_t _row)
+    {
+        if (_row <= 0)
+            return accessHistoryLine(_row);
+        return lines[static_cast<size_t>(historyLineCount() + _row - 1)];
+    }
+
+    Line const& lineAt(cursor_pos_t _row) const
+    {
+        return const_cast<ScreenBuffer*>(this)->lineAt(_row);
+    }
+
+    /// @returns an iterator to the line at given row, as in lineAt().
+    ///
+    /// Unlike lineAt(), this does not expand scrollback lines, so only use it for screen lines.
+    LineIterator lineIteratorAt(cursor_pos_t _row) noexcept
+    {
+        return std::next(begin(lines), historyLineCount() + _row - 1);
+    }
+
+    /// Tests whether the line at given row is marked, without swapping it in.
+    ///
+    /// Scrollback lines not reflowed yet are tested as they are.
+    bool isLineMarked(cursor_pos_t _row) const noexcept
+    {
+        return lines[static_cast<size_t>(historyLineCount() + _row - 1)].marked;
+    }
+
+    /// @returns the line the cursor is in.
+    Line& currentLine() noexcept { return lineAt(cursor.position.row); }
+    Line const& currentLine() const noexcept { return lineAt(cursor.position.row); }
+
     /// Finds the previous marker right next to the given line position.
     ///
     /// @paramn _currentCursorLine the line number of the current cursor (1..N) for screen area, or
@@ -414,6 +604,118 @@ struct ScreenBuffer {
 
     std::optional<int> findMarkerForward(int _currentCursorLine) const;
 
+    /// Number of consecutive scrollback lines that are swapped out and in together.
+    static size_t constexpr PageLineCount = 1024;
+
+    /// Sets the number of scrollback lines to keep in memory, or std::nullopt for all of them.
+    ///
+    /// Beyond that, the least recently used pages of scrollback are compressed and written to
+    /// a swap file, to be swapped back in by lineAt() once accessed again.
+    void setMaxResidentHistoryLineCount(std::optional<size_t> _count);
+
+    std::optional<size_t> maxResidentHistoryLineCount() const noexcept { return maxResidentHistoryLineCount_; }
+
+    /// @returns the number of scrollback lines that are currently swapped out.
+    size_t swappedLineCount() const noexcept { return swappedLineCount_; }
+
+    SwapFile const& swapFile() const noexcept { return swapFile_; }
+
+    /// Swaps out the least recently used scrollback pages, until the rest fits into the limit
+    /// set by setMaxResidentHistoryLineCount().
+    ///
+    /// This invalidates references to scrollback lines.
+    void swapOutColdPages();
+
+    /// Reflows the scrollback lines left at a previous width by resize(), until at least
+    /// the @p _count most recent ones are at the current width.
+    ///
+    /// This changes the number of scrollback lines, and invalidates references to them.
+    void reflowHistory(size_t _count);
+
+    /// Compacts the scrollback lines expanded by lineAt() again, except for the most recently
+    /// expanded ones, and swaps out cold pages.
+    ///
+    /// This invalidates references to scrollback lines.
+    void trimHistory();
+
+    /// Sets the number of bytes the scrollback may take in memory, or std::nullopt for no limit.
+    ///
+    /// Once exceeded, or once this buffer's share of HistoryBudget::processLimit() is exceeded,
+    /// cold pages are swapped out if paging is enabled (see setMaxResidentHistoryLineCount()),
+    /// and the oldest lines are dropped otherwise.
+    void setMaxHistoryBytes(std::optional<size_t> _bytes);
+
+    std::optional<size_t> maxHistoryBytes() const noexcept { return historyBudget_.limit(); }
+
+    /// @returns the number of bytes the scrollback takes in memory, as accounted against the limit.
+    size_t historyBytes() const noexcept { return historyBudget_.usage(); }
+
+    /// Verifies in debug builds that historyBytes() adds up over all scrollback lines,
+    /// and that no page with lines still to be reflowed is swapped out.
+    ///
+    /// This walks the whole scrollback, so it is only run after bulk changes to it.
+    void checkHistoryAccounting() const;
+
+    /// @returns the number of bytes a scrollback line takes in memory.
+    static size_t lineBytes(Line const& _line) noexcept
+    {
+        return sizeof(Line) + _line.compact.size() + _line.buffer.capacity() * sizeof(Cell);
+    }
+
+    struct HistoryStats {
+        size_t lineCount;           //!< number of scrollback lines
+        size_t bytes;               //!< bytes taken by the scrollback lines in memory, in any form
+        size_t compactLineCount;    //!< number of scrollback lines in compact form
+        size_t compactBytes;        //!< bytes taken by the compact lines
+        size_t cellBytes;           //!< bytes the compact lines would take as cells
+        size_t swappedLineCount;    //!< number of scrollback lines swapped out
+        size_t swapBytes;           //!< bytes taken by the swapped out lines in the swap file
+        size_t swapRawBytes;        //!< bytes the swapped out lines take in compact form
+    };
+
+    /// @returns memory statistics of the scrollback, which is linear in the number of lines.
+    HistoryStats historyStats() const;
+
+    // {{{ damage tracking
+    /// Records that the screen line at given row changed in the current damage generation.
+    void markDamaged(cursor_pos_t _row) noexcept
+    {
+        lineDamage_[static_cast<size_t>(_row - 1)] = damageGeneration_;
+    }
+
+    /// Records that the screen lines from @p _from to @p _to (inclusive) changed.
+    void markDamaged(cursor_pos_t _from, cursor_pos_t _to) noexcept
+    {
+        std::fill(std::next(begin(lineDamage_), _from - 1), std::next(begin(lineDamage_), _to), damageGeneration_);
+    }
+
+    void markAllDamaged() noexcept { markDamaged(1, size_.height); }
+
+    /// Records that the screen lines showing the hyperlink @p _id changed, such as its hover state.
+    void markHyperlinkDamaged(Cell::HyperlinkId _id);
+
+    /// @returns the generation, that changes are currently recorded in.
+    uint64_t damageGeneration() const noexcept { return damageGeneration_; }
+
+    /// Starts a new damage generation, telling subsequent changes apart from the ones so far.
+    ///
+    /// @returns the new generation, to be passed to damagedLines() for the changes from now on.
+    uint64_t advanceDamageGeneration() noexcept { return ++damageGeneration_; }
+
+    /// Continues the damage generations of another buffer, such as when switching buffers.
+    void setDamageGeneration(uint64_t _generation) noexcept { damageGeneration_ = _generation; }
+
+    /// Tests whether the screen line at given row changed since the start of damage generation @p _generation.
+    bool isLineDamaged(cursor_pos_t _row, uint64_t _generation) const noexcept
+    {
+        return lineDamage_[static_cast<size_t>(_row - 1)] >= _generation;
+    }
+
+    /// @returns the rows of the screen lines changed since the start of damage generation @p _generation,
+    ///          in ascending order.
+    std::vector<cursor_pos_t> damagedLines(uint64_t _generation) const;
+    // }}}
+
     Type type_;
 	Size size_;
     std::reference_wrapper<Modes> modes_;
@@ -421,22 +723,55 @@ struct ScreenBuffer {
 	Margin margin_;
 	Cursor cursor{};
 	Lines lines;
-	Lines savedLines{};
 	bool wrapPending{false};
 	int tabWidth{8};
     std::vector<cursor_pos_t> tabs;
 
-	LineIterator currentLine{std::begin(lines)};
-	ColumnIterator currentColumn{currentLine->begin()};
+	ColumnIterator currentColumn{lines.front().begin()};
 
     ColumnIterator lastColumn{currentColumn};
     Coordinate lastCursorPosition{};
 
-    HyperlinkRef currentHyperlink = {};
-    // TODO: use a deque<> instead, always push_back, lookup reverse, evict in front.
-    std::unordered_map<std::string, HyperlinkRef> hyperlinks;
+    /// Hyperlink to be applied to newly written characters, or 0 if none.
+    Cell::HyperlinkId currentHyperlink = 0;
+
+    /// Attributes, hyperlinks and grapheme clusters referenced by the cells of this buffer.
+    CellPool pool{};
+
+    /// @returns the pool ID of the given graphics attributes, adding them if not present yet.
+    Cell::AttributesId intern(GraphicsAttributes const& _attributes);
+
+    /// @returns the ID of the hyperlink with given user id and URI, adding it if not present yet.
+    ///
+    /// If the hyperlink store is full and nothing can be evicted, 0 (no hyperlink) is returned.
+    Cell::HyperlinkId acquireHyperlink(std::string const& _userId, URI const& _uri);
+
+    /// @returns the pool ID of the cursor's current graphics rendition.
+    Cell::AttributesId cursorAttributesId();
+
+    /// Appends @p _codepoint to the grapheme cluster of @p _cell.
+    ///
+    /// @returns the number of columns the cell's width has grown by.
+    int appendCharacter(Cell& _cell, char32_t _codepoint);
+
+    /// Reclaims all pool entries not referenced by any cell in the screen or scrollback.
+    void collectGarbage();
+
+    CellView view(Cell const& _cell) const noexcept { return CellView{_cell, pool}; }
 
 	void appendChar(char32_t _codepoint, bool _consecutive);
+
+    /// Writes the run of printable codepoints @p _text, as if each was passed to appendChar().
+    ///
+    /// Consecutive US-ASCII characters are written in bulk, as many as fit into the current line
+    /// at once, whereas everything else is passed on to appendChar() one by one.
+    ///
+    /// @param _consecutive whether the first codepoint directly follows the previously written one.
+    void writeText(std::u32string_view _text, bool _consecutive);
+
+    /// Writes the run of printable US-ASCII characters @p _text.
+    void writeText(std::string_view _text, bool _consecutive);
+
 	void writeCharToCurrentAndAdvance(char32_t _codepoint);
     void clearAndAdvance(int _offset);
 
@@ -446,6 +781,15 @@ struct ScreenBuffer {
 	void resize(Size const& _winSize);
 	Size const& size() const noexcept { return size_; }
 
+    /// Appends a line filled with @p _fill below the screen, turning the top line into scrollback.
+    ///
+    /// This is the full screen scroll-up by one line. Once the history is full, the oldest
+    /// scrollback line is evicted and its storage recycled for the new line.
+    void appendLine(Cell const& _fill);
+
+    /// @returns the maximum number of lines held in screen and scrollback together.
+    size_t maxLineCount() const noexcept;
+
 	void scrollUp(cursor_pos_t n);
 	void scrollUp(cursor_pos_t n, Margin const& margin);
 	void scrollDown(cursor_pos_t n);
@@ -472,7 +816,7 @@ struct ScreenBuffer {
     /// @returns an iterator to the real column number @p _n.
     ColumnIterator columnIteratorAt(cursor_pos_t _n)
     {
-        return columnIteratorAt(std::begin(*currentLine), _n);
+        return columnIteratorAt(std::begin(currentLine()), _n);
     }
 
     /// @returns an iterator to the real column number @p _n.
@@ -495,7 +839,6 @@ struct ScreenBuffer {
 
     void updateCursorIterators()
     {
-        currentLine = next(begin(lines), cursor.position.row - 1);
         updateColumnIterator();
     }
 
@@ -588,6 +931,116 @@ struct ScreenBuffer {
                                          || margin_.horizontal.contains(cursor.position.column);
         return insideVerticalMargin && insideHorizontalMargin;
     }
+
+    // Most recently interned cursor attributes, saving a hash lookup per written character.
+    GraphicsAttributes cachedAttributes_{};
+    Cell::AttributesId cachedAttributesId_ = 0;
+
+  private:
+    template <typename Char> void writeTextRun(Char const* _text, size_t _size, bool _consecutive);
+
+    /// Writes the leading US-ASCII characters of @p _text that fit into the current line.
+    ///
+    /// @returns the number of characters written, at least one.
+    template <typename Char> size_t writeAsciiText(Char const* _text, size_t _size);
+
+    /// A page of scrollback lines in the swap file, with the pool entries its cells refer to,
+    /// as these must survive garbage collection.
+    struct SwappedPage {
+        SwapFile::Extent extent;
+        uint64_t firstLine;         //!< absolute number of the first line swapped out
+        size_t lineCount;
+        std::vector<Cell::AttributesId> attributes;
+        std::vector<Cell::HyperlinkId> hyperlinks;
+    };
+
+    /// @returns the page of the line at given index into lines.
+    uint64_t pageOf(size_t _index) const noexcept { return (lineNumberOffset_ + _index) / PageLineCount; }
+
+    /// Records an access to the scrollback line at given row, reflowing, expanding
+    /// and swapping in as needed.
+    ///
+    /// @returns the line at given row, or the oldest line if reflowing left fewer lines than that.
+    Line& accessHistoryLine(cursor_pos_t _row);
+
+    void compactLine(Line& _line);
+
+    /// Compacts all but the @p _keep most recently expanded scrollback lines.
+    void compactExpandedLines(size_t _keep);
+
+    bool swapOut(uint64_t _page, size_t _first, size_t _last);
+    void swapIn(uint64_t _page);
+
+    /// Removes @p _n lines from the front of lines, releasing pages that are gone with them.
+    void popFrontLines(size_t _n);
+
+    /// Swaps out or drops scrollback lines until the history budget is no longer exceeded.
+    void enforceHistoryBudget();
+
+    // {{{ reflow
+    /// Position of a cell within a range of lines, with a column right past the end of a line
+    /// standing for a pending wrap.
+    struct LinePosition {
+        size_t line;
+        size_t column;
+    };
+
+    bool reflowPending() const noexcept { return reflowBoundary_ > lineNumberOffset_; }
+
+    /// @returns the index of the first line of the logical line containing the line at @p _index.
+    size_t logicalLineStart(size_t _index) const noexcept;
+
+    /// Swaps in all lines within [_first, _last).
+    void swapInLines(size_t _first, size_t _last);
+
+    /// @returns the logical lines within [_first, _last) broken into lines of @p _width cells,
+    ///          mapping @p _cursor from the given lines to the returned ones if not null.
+    std::vector<Line> reflowLines(size_t _first, size_t _last, size_t _width, LinePosition* _cursor);
+
+    /// Replaces the lines within [_first, _last) with @p _lines.
+    ///
+    /// The lines before _first stay at their absolute line numbers, keeping their pages intact,
+    /// whereas the lines from _last on move along with the change in line count.
+    void replaceLines(size_t _first, size_t _last, std::vector<Line>&& _lines);
+
+    /// Reflows the screen and the scrollback lines wrapping into it to @p _width,
+    /// leaving older scrollback lines to be reflowed lazily.
+    void reflow(int _width);
+
+    /// Reflows a page worth of the most recent scrollback lines not reflowed yet.
+    void reflowHistoryChunk();
+    // }}}
+
+    /// Absolute number of lines[0], counting all lines ever removed from the front.
+    ///
+    /// Pages are cut by absolute line number, so their boundaries do not move as lines are added or removed.
+    uint64_t lineNumberOffset_ = 0;
+
+    /// Absolute numbers of the scrollback lines expanded by lineAt(), in order of expansion.
+    std::deque<uint64_t> expandedLines_;
+
+    std::optional<size_t> maxResidentHistoryLineCount_;
+    size_t swappedLineCount_ = 0;
+    std::unordered_map<uint64_t, SwappedPage> swappedPages_;
+    SwapFile swapFile_;
+
+    /// Last access of each page, as a value of accessCounter_, for swapping out least recently used pages first.
+    std::unordered_map<uint64_t, uint64_t> pageAccess_;
+    uint64_t accessCounter_ = 0;
+    std::optional<uint64_t> lastAccessedPage_;
+
+    /// Accounts lineBytes() of every scrollback line.
+    HistoryBudget historyBudget_;
+
+    /// Damage generation each screen line was last changed in, by row.
+    std::vector<uint64_t> lineDamage_;
+    uint64_t damageGeneration_ = 0;
+
+    /// Absolute line number of the oldest line reflowed to the current width.
+    ///
+    /// Older lines are at the width they were written at, and reflowed on access. Meanwhile,
+    /// only pages below this line may be swapped out, as reflowing moves all lines above it.
+    uint64_t reflowBoundary_ = 0;
 };
 
 inline auto begin(ScreenBuffer::Line& _line) { return _line.begin(); }
@@ -597,32 +1050,34 @@ inline auto end(ScreenBuffer::Line const& _line) { return _line.cend(); }
 inline ScreenBuffer::Line::const_iterator cbegin(ScreenBuffer::Line const& _line) { return _line.cbegin(); }
 inline ScreenBuffer::Line::const_iterator cend(ScreenBuffer::Line const& _line) { return _line.cend(); }
 
-constexpr bool operator==(GraphicsAttributes const& a, GraphicsAttributes const& b) noexcept
+/// Tests two cells of the same buffer for equal text and graphics attributes.
+///
+/// Attributes are compared by ID. Clusters are compared by ID as well, so that two cells holding
+/// equal multi-codepoint clusters in distinct pool entries compare unequal.
+constexpr bool operator==(Cell const& a, Cell const& b) noexcept
 {
-    return a.backgroundColor == b.backgroundColor
-        && a.foregroundColor == b.foregroundColor
-        && a.styles == b.styles
-        && a.underlineColor == b.underlineColor;
+    return a.codepoint() == b.codepoint()
+        && a.codepointCount() == b.codepointCount()
+        && a.clusterId() == b.clusterId()
+        && a.attributesId() == b.attributesId();
 }
 
-constexpr bool operator!=(GraphicsAttributes const& a, GraphicsAttributes const& b) noexcept
+constexpr bool operator!=(Cell const& a, Cell const& b) noexcept
 {
     return !(a == b);
 }
 
-constexpr bool operator==(Cell const& a, Cell const& b) noexcept
+inline bool operator==(CellView const& a, CellView const& b) noexcept
 {
-    if (a.codepointCount() != b.codepointCount())
-        return false;
-
-    if (!(a.attributes() == b.attributes()))
-        return false;
-
-    for (auto const i : crispy::times(a.codepointCount()))
-        if (a.codepoint(i) != b.codepoint(i))
-            return false;
+    if (&a.pool() == &b.pool())
+        return a.attributesId() == b.attributesId() && a.codepoints() == b.codepoints();
+    else
+        return a.attributes() == b.attributes() && a.codepoints() == b.codepoints();
+}
 
-    return true;
+inline bool operator!=(CellView const& a, CellView const& b) noexcept
+{
+    return !(a == b);
 }
 
 }  // namespace terminal
@@ -651,11 +1106,11 @@ namespace fmt {
     };
 
     template <>
-    struct formatter<terminal::Cell> {
+    struct formatter<terminal::CellView> {
         template <typename ParseContext>
         constexpr auto parse(ParseContext& ctx) { return ctx.begin(); }
         template <typename FormatContext>
-        auto format(terminal::Cell const& cell, FormatContext& ctx)
+        auto format(terminal::CellView const& cell, FormatContext& ctx)
         {
             std::string codepoints;
             for (auto const i : crispy::times(cell.codepointCount()))
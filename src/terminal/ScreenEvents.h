@@ -17,6 +17,8 @@ class ScreenEvents {
     virtual std::optional<RGBColor> requestDynamicColor(DynamicColorName /*_name*/) { return std::nullopt; }
     virtual void bell() {}
     virtual void bufferChanged(ScreenBuffer::Type) {}
+    /// Invoked after each write to the screen. @p _commands is only populated
+    /// if command recording has been enabled on the Screen.
     virtual void commands(CommandList const& /*_commands*/) {}
     virtual void copyToClipboard(std::string_view const& /*_data*/) {}
     virtual void dumpState() {}
@@ -0,0 +1,149 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/ScreenSnapshot.h>
+
+#include <algorithm>
+
+using std::min;
+
+namespace terminal {
+
+namespace {
+    /// Looks up @p _id in @p _ids, growing it as needed.
+    template <typename Id>
+    Id& slot(std::vector<Id>& _ids, size_t _id)
+    {
+        if (_id >= _ids.size())
+            _ids.resize(_id + 1, Id{0});
+        return _ids[_id];
+    }
+}
+
+void ScreenSnapshot::update(Screen& _screen, Cell::HyperlinkId _hoveredHyperlink)
+{
+    // Scrollback lines coming into view are reflowed beforehand, which might adjust the scroll offset.
+    if (_screen.scrollOffset() != 0)
+        _screen.reflowHistory(static_cast<size_t>(_screen.scrollOffset()));
+
+    auto& buffer = _screen.currentBuffer();
+
+    // Scrolled off lines are not tracked by damage, so a scrolled viewport is copied in full.
+    bool const full = &buffer != source_
+                   || buffer.pool.generation() != sourcePoolGeneration_
+                   || _screen.size() != size_
+                   || _screen.scrollOffset() != 0
+                   || scrollOffset_ != 0;
+    if (full)
+        reset(buffer);
+
+    size_ = _screen.size();
+    cursor_ = _screen.cursor();
+    scrollOffset_ = _screen.scrollOffset();
+    bufferType_ = _screen.bufferType();
+    reverseVideo_ = _screen.isModeEnabled(Mode::ReverseVideo);
+    focused_ = _screen.focused();
+    selection_ = _screen.selection();
+    historyLineCount_ = _screen.historyLineCount();
+
+    auto const scrollOffset = min(scrollOffset_, historyLineCount_);
+    for (cursor_pos_t row = 1; row <= size_.height; ++row)
+        if (full || buffer.isLineDamaged(row, generation_))
+            copyLine(buffer.lineAt(row - scrollOffset), row, buffer.pool);
+
+    generation_ = buffer.advanceDamageGeneration();
+
+    setHoveredHyperlink(_hoveredHyperlink < hyperlinkIds_.size() ? hyperlinkIds_[_hoveredHyperlink] : 0);
+}
+
+void ScreenSnapshot::reset(ScreenBuffer const& _buffer)
+{
+    source_ = &_buffer;
+    sourcePoolGeneration_ = _buffer.pool.generation();
+
+    pool_ = CellPool{};
+    attributeIds_.clear();
+    hyperlinkIds_.clear();
+    clusterIds_.clear();
+    hoveredHyperlink_ = 0;
+
+    cells_.assign(static_cast<size_t>(_buffer.size().width * _buffer.size().height), Cell{});
+}
+
+void ScreenSnapshot::copyLine(ScreenBuffer::Line const& _line, cursor_pos_t _row, CellPool const& _pool)
+{
+    auto const target = cells_.begin() + (_row - 1) * size_.width;
+
+    // Scrollback lines narrower than the screen are padded by blank cells.
+    auto const columnCount = min(static_cast<int>(_line.size()), size_.width);
+    std::fill(std::copy_n(_line.cbegin(), columnCount, target), target + size_.width, Cell{});
+
+    for (auto cell = target; cell != target + columnCount; ++cell)
+    {
+        if (cell->attributesId())
+            cell->setAttributesId(mapAttributes(cell->attributesId(), _pool));
+        if (cell->hyperlinkId())
+            cell->setHyperlinkId(mapHyperlink(cell->hyperlinkId(), _pool));
+        if (cell->clusterId())
+            cell->setCluster(mapCluster(cell->clusterId(), _pool), cell->codepointCount());
+    }
+}
+
+Cell::AttributesId ScreenSnapshot::mapAttributes(Cell::AttributesId _id, CellPool const& _pool)
+{
+    auto& id = slot(attributeIds_, _id);
+    if (!id)
+    {
+        auto const& attributes = _pool.attributes(_id);
+        id = pool_.findAttributes(attributes).value_or(0);
+        if (!id)
+            id = pool_.addAttributes(attributes);
+    }
+    return id;
+}
+
+Cell::HyperlinkId ScreenSnapshot::mapHyperlink(Cell::HyperlinkId _id, CellPool const& _pool)
+{
+    auto& id = slot(hyperlinkIds_, _id);
+    if (!id)
+        if (auto const& link = _pool.hyperlink(_id); link)
+            id = pool_.hyperlinks().add(link->id, link->uri).value_or(0);
+    return id;
+}
+
+Cell::ClusterId ScreenSnapshot::mapCluster(Cell::ClusterId _id, CellPool const& _pool)
+{
+    // Clusters are never modified once written, so they can be shared by ID, too.
+    auto& id = slot(clusterIds_, _id);
+    if (!id)
+    {
+        id = pool_.allocateCluster();
+        pool_.cluster(id) = _pool.cluster(_id);
+    }
+    return id;
+}
+
+void ScreenSnapshot::setHoveredHyperlink(Cell::HyperlinkId _id)
+{
+    if (_id == hoveredHyperlink_)
+        return;
+
+    if (auto const& link = pool_.hyperlink(hoveredHyperlink_); link)
+        link->state = HyperlinkState::Inactive;
+    if (auto const& link = pool_.hyperlink(_id); link)
+        link->state = HyperlinkState::Hover;
+
+    hoveredHyperlink_ = _id;
+}
+
+} // end namespace
@@ -0,0 +1,131 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Screen.h>
+#include <terminal/ScreenBuffer.h>
+#include <terminal/Selector.h>
+#include <terminal/Size.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace terminal {
+
+/// Copy of what a Screen displays, that can be rendered without access to the Screen.
+///
+/// A snapshot holds the visible cells along with a CellPool of its own, holding only the
+/// pooled data referenced by these cells, so that the screen may change while it is being rendered.
+/// Updating a snapshot copies only the lines damaged since its last update.
+class ScreenSnapshot {
+  public:
+    /// Brings this snapshot up to date with what @p _screen currently displays.
+    ///
+    /// @param _hoveredHyperlink the screen's hyperlink to be shown as hovered, or 0 for none.
+    void update(Screen& _screen, Cell::HyperlinkId _hoveredHyperlink);
+
+    /// Sets the cursor style, which is kept by the terminal rather than by the screen.
+    void setCursorStyle(CursorDisplay _display, CursorShape _shape) noexcept
+    {
+        cursorDisplay_ = _display;
+        cursorShape_ = _shape;
+    }
+
+    /// Sets whether a blinking cursor is in its visible phase, which advances with time rather than with the screen.
+    void setCursorBlinkPhase(bool _visible) noexcept { cursorBlinkPhase_ = _visible; }
+
+    /// @returns the damage generation of the screen this snapshot has last been updated to,
+    ///          which is increasing with every update.
+    uint64_t generation() const noexcept { return generation_; }
+
+    Size const& size() const noexcept { return size_; }
+    Cursor const& cursor() const noexcept { return cursor_; }
+    CursorDisplay cursorDisplay() const noexcept { return cursorDisplay_; }
+    CursorShape cursorShape() const noexcept { return cursorShape_; }
+
+    /// Tests whether the cursor is to be displayed, taking its blink phase into account.
+    bool cursorVisible() const noexcept
+    {
+        return cursor_.visible && (cursorDisplay_ != CursorDisplay::Blink || cursorBlinkPhase_);
+    }
+
+    int scrollOffset() const noexcept { return scrollOffset_; }
+    int historyLineCount() const noexcept { return historyLineCount_; }
+    ScreenBuffer::Type bufferType() const noexcept { return bufferType_; }
+    bool reverseVideo() const noexcept { return reverseVideo_; }
+    bool focused() const noexcept { return focused_; }
+    std::vector<Selector::Range> const& selection() const noexcept { return selection_; }
+
+    /// Tests whether the screen row @p _row is visible at the snapshot's scroll offset.
+    bool isLineVisible(cursor_pos_t _row) const noexcept
+    {
+        return 1 - scrollOffset_ <= _row && _row <= size_.height - scrollOffset_;
+    }
+
+    /// @returns the cell at the visible position @p _pos.
+    CellView at(Coordinate const& _pos) const noexcept
+    {
+        return CellView{cells_[static_cast<size_t>((_pos.row - 1) * size_.width + _pos.column - 1)], pool_};
+    }
+
+    /// Passes all visible cells to @p _render, row by row.
+    template <typename RendererT>
+    void render(RendererT _render) const
+    {
+        auto cell = cells_.begin();
+        for (cursor_pos_t row = 1; row <= size_.height; ++row)
+            for (cursor_pos_t column = 1; column <= size_.width; ++column, ++cell)
+                _render({row, column}, CellView{*cell, pool_});
+    }
+
+  private:
+    void reset(ScreenBuffer const& _buffer);
+    void copyLine(ScreenBuffer::Line const& _line, cursor_pos_t _row, CellPool const& _pool);
+    Cell::AttributesId mapAttributes(Cell::AttributesId _id, CellPool const& _pool);
+    Cell::HyperlinkId mapHyperlink(Cell::HyperlinkId _id, CellPool const& _pool);
+    Cell::ClusterId mapCluster(Cell::ClusterId _id, CellPool const& _pool);
+    void setHoveredHyperlink(Cell::HyperlinkId _id);
+
+    uint64_t generation_ = 0;
+
+    Size size_{};
+    Cursor cursor_{};
+    CursorDisplay cursorDisplay_ = CursorDisplay::Steady;
+    CursorShape cursorShape_ = CursorShape::Block;
+    bool cursorBlinkPhase_ = true;
+    int scrollOffset_ = 0;
+    int historyLineCount_ = 0;
+    ScreenBuffer::Type bufferType_ = ScreenBuffer::Type::Main;
+    bool reverseVideo_ = false;
+    bool focused_ = true;
+    std::vector<Selector::Range> selection_;
+
+    /// Visible cells, row by row, referring into pool_.
+    std::vector<Cell> cells_;
+    CellPool pool_;
+
+    // The screen buffer and pool generation the pooled data has been copied from, as the IDs
+    // mapped below become meaningless once the buffer is switched or its pool reuses IDs.
+    ScreenBuffer const* source_ = nullptr;
+    uint64_t sourcePoolGeneration_ = 0;
+
+    // IDs of the source buffer's pool mapped to IDs of pool_, 0 if not copied yet.
+    std::vector<Cell::AttributesId> attributeIds_;
+    std::vector<Cell::HyperlinkId> hyperlinkIds_;
+    std::vector<Cell::ClusterId> clusterIds_;
+
+    Cell::HyperlinkId hoveredHyperlink_ = 0;
+};
+
+} // end namespace
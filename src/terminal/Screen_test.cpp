@@ -12,6 +12,7 @@
  * limitations under the License.
  */
 #include <terminal/Screen.h>
+#include <terminal/ScreenSnapshot.h>
 #include <catch2/catch.hpp>
 #include <string_view>
 
@@ -281,6 +282,115 @@ TEST_CASE("AppendChar.emoji_1", "[screen]")
     CHECK(c3.width() == 1);
 }
 
+TEST_CASE("CellPool.attributesId", "[screen]")
+{
+    auto screen = MockScreen{{4, 1}};
+    screen.write("\033[31mAB\033[32mC\033[31mB");
+
+    CHECK(screen.at({1, 1}).attributesId() == screen.at({1, 2}).attributesId());
+    CHECK(screen.at({1, 1}).attributesId() != screen.at({1, 3}).attributesId());
+    CHECK(screen.at({1, 1}).attributesId() == screen.at({1, 4}).attributesId());
+
+    CHECK(screen.at({1, 2}) == screen.at({1, 4}));
+    CHECK(screen.at({1, 2}).cell() == screen.at({1, 4}).cell());
+    CHECK(screen.at({1, 1}) != screen.at({1, 2}));
+    CHECK(screen.at({1, 2}) != screen.at({1, 3}));
+}
+
+TEST_CASE("CellPool.collectGarbage", "[screen]")
+{
+    auto screen = MockScreen{{3, 1}};
+    auto const& pool = screen.currentBuffer().pool;
+
+    SECTION("attributes") {
+        for (unsigned i = 0; i < 3 * CellPool::MinCollectThreshold; ++i)
+            screen.write(fmt::format("\033[H\033[38;2;{};{};{}mX", (i >> 16) & 0xFF, (i >> 8) & 0xFF, i & 0xFF));
+
+        CHECK(pool.attributesCount() <= 2 * CellPool::MinCollectThreshold);
+        CHECK(pool.generation() > 0);
+        auto const last = 3 * CellPool::MinCollectThreshold - 1;
+        CHECK(screen.at({1, 1}).attributes().foregroundColor
+              == Color{RGBColor{static_cast<uint8_t>(last >> 16), static_cast<uint8_t>(last >> 8), static_cast<uint8_t>(last)}});
+        CHECK(screen.at({1, 2}).attributes() == GraphicsAttributes{});
+    }
+
+    SECTION("clusters") {
+        screen.write(U"\033[2Ge\u0302");
+        for (unsigned i = 0; i < 3 * CellPool::MinCollectThreshold; ++i)
+            screen.write(U"\033[He\u0301");
+
+        CHECK(pool.clusterCount() <= 2 * CellPool::MinCollectThreshold);
+        CHECK(screen.at({1, 1}).codepoints() == U"e\u0301");
+        CHECK(screen.at({1, 2}).codepoints() == U"e\u0302");
+    }
+}
+
+TEST_CASE("HyperlinkStore", "[screen]")
+{
+    auto store = HyperlinkStore{4};
+
+    auto const a = store.add("a", "http://a/").value();
+    auto const b = store.add("b", "http://b/").value();
+    auto const c = store.add("c", "http://c/").value();
+    auto const d = store.add("d", "http://d/").value();
+    CHECK(store.full());
+    CHECK_FALSE(store.add("e", "http://e/").has_value());
+
+    CHECK(store.find("a", "http://a/") == a);
+    CHECK_FALSE(store.find("a", "http://other/").has_value());
+    CHECK(store.at(c)->uri == "http://c/");
+
+    SECTION("least recently used first") {
+        store.touch(a);
+        store.beginCollection();
+        store.mark(b);
+        store.endCollection();
+
+        CHECK(store.size() == 3);
+        CHECK(store.at(a) != nullptr);
+        CHECK(store.at(b) != nullptr);
+        CHECK(store.at(c) == nullptr);
+        CHECK(store.at(d) != nullptr);
+        CHECK_FALSE(store.find("c", "http://c/").has_value());
+        CHECK(store.add("e", "http://e/").has_value());
+    }
+
+    SECTION("unreachable") {
+        store.clearUserIds();
+        store.beginCollection();
+        store.mark(b);
+        store.endCollection();
+
+        CHECK(store.size() == 1);
+        CHECK(store.at(b) != nullptr);
+        CHECK_FALSE(store.find("b", "http://b/").has_value());
+    }
+}
+
+TEST_CASE("CellPool.hyperlinks", "[screen]")
+{
+    auto screen = MockScreen{{4, 1}};
+    screen.write("\033]8;id=x;http://x/\033\\A\033]8;;\033\\B\033]8;id=x;http://x/\033\\C\033]8;;\033\\");
+
+    auto const id = screen.at({1, 1}).cell().hyperlinkId();
+    CHECK(id != 0);
+    CHECK(screen.at({1, 2}).cell().hyperlinkId() == 0);
+    CHECK(screen.at({1, 3}).cell().hyperlinkId() == id);
+    CHECK(screen.at({1, 1}).hyperlink()->uri == "http://x/");
+    CHECK(screen.currentBuffer().pool.hyperlinks().size() == 1);
+
+    // The alternate screen has a store of its own.
+    screen.write(SetMode{Mode::UseAlternateScreen, true});
+    screen.write("\033]8;id=x;http://x/\033\\A\033]8;;\033\\");
+    CHECK(screen.isAlternateScreen());
+    CHECK(screen.currentBuffer().pool.hyperlinks().size() == 1);
+    CHECK(screen.at({1, 1}).hyperlink()->uri == "http://x/");
+
+    screen.write(SetMode{Mode::UseAlternateScreen, false});
+    CHECK(screen.at({1, 1}).hyperlink()->uri == "http://x/");
+    CHECK(screen.currentBuffer().pool.hyperlinks().size() == 1);
+}
+
 TEST_CASE("AppendChar_WideChar", "[screen]")
 {
     auto screen = MockScreen{{3, 2}};
@@ -337,6 +447,77 @@ TEST_CASE("AppendChar_AutoWrap_LF", "[screen]")
     REQUIRE(screen.cursorPosition() == Coordinate{2, 2});
 }
 
+TEST_CASE("AppendText", "[screen]")
+{
+    // Writing a run of text in bulk must be indistinguishable from writing it character by character.
+    auto const check = [](Size _size, function<void(Screen&)> const& _setup, u32string_view _text) {
+        auto bulk = MockScreen{_size};
+        auto single = MockScreen{_size};
+        _setup(bulk);
+        _setup(single);
+
+        bulk.currentBuffer().writeText(_text, false);
+        for (size_t i = 0; i < _text.size(); ++i)
+            single.currentBuffer().appendChar(_text[i], i != 0);
+
+        // Also compares the pending wrap.
+        bulk.currentBuffer().appendChar(U'#', false);
+        single.currentBuffer().appendChar(U'#', false);
+
+        CHECK(bulk.renderText() == single.renderText());
+        CHECK(bulk.cursorPosition() == single.cursorPosition());
+        for (int row = 1; row <= _size.height; ++row)
+            CHECK(bulk.currentBuffer().lineAt(row).wrapped == single.currentBuffer().lineAt(row).wrapped);
+        for (int row = 1; row <= _size.height; ++row)
+            for (int column = 1; column <= _size.width; ++column)
+                CHECK(bulk.at({row, column}).width() == single.at({row, column}).width());
+    };
+
+    auto const none = [](Screen&) {};
+
+    SECTION("US-ASCII") {
+        check({8, 3}, none, U"Hello");
+        check({8, 3}, none, U"12345678");
+        check({8, 3}, none, U"Hello, World! What a day it is.");
+    }
+
+    SECTION("no auto-wrap") {
+        auto const noAutoWrap = [](Screen& _screen) { _screen.write(SetMode{Mode::AutoWrap, false}); };
+        check({8, 3}, noAutoWrap, U"12345678");
+        check({8, 3}, noAutoWrap, U"Hello, World!");
+    }
+
+    SECTION("mixed") {
+        check({8, 3}, none, U"ab\u00E4cd\u00F6ef\u00FC");
+        check({8, 3}, none, U"e\u0301e\u0301abc");
+        check({8, 3}, none, U"1234567\U0001F600ab");
+        check({8, 3}, none, U"abc\U0001F600\U0001F600de");
+    }
+
+    SECTION("character set") {
+        auto const special = [](Screen& _screen) { _screen.write(DesignateCharset{CharsetTable::G0, CharsetId::Special}); };
+        check({8, 3}, special, U"lqqqqqqqqk");
+    }
+
+    SECTION("margins") {
+        auto const margins = [](Screen& _screen) {
+            _screen.write(SetMode{Mode::LeftRightMargin, true});
+            _screen.write(SetLeftRightMargin{3, 6});
+            _screen.write(MoveCursorTo{1, 3});
+        };
+        check({8, 3}, margins, U"Hello, World!");
+    }
+}
+
+TEST_CASE("AppendText.ascii", "[screen]")
+{
+    auto screen = MockScreen{{5, 2}};
+    screen.currentBuffer().writeText("Hello World"sv, false);
+    CHECK(" Worl\nd    \n" == screen.renderText());
+    CHECK(screen.cursorPosition() == Coordinate{2, 2});
+    CHECK(screen.currentBuffer().lineAt(2).wrapped);
+}
+
 TEST_CASE("Backspace", "[screen]")
 {
     auto screen = MockScreen{{3, 2}};
@@ -747,7 +928,7 @@ TEST_CASE("ClearScrollbackBuffer", "[screen]")
     screen.write("12345\r\n67890\r\nABCDE\r\nFGHIJ\r\nKLMNO\r\nPQRST\033[H");
     REQUIRE("67890\nABCDE\nFGHIJ\nKLMNO\nPQRST\n" == screen.renderText());
     REQUIRE(screen.cursorPosition() == Coordinate{1, 1});
-    REQUIRE(1 == screen.scrollbackLines().size());
+    REQUIRE(1 == screen.historyLineCount());
     REQUIRE("12345" == screen.renderHistoryTextLine(1));
 }
 
@@ -815,6 +996,238 @@ TEST_CASE("ScrollUp", "[screen]")
     }
 }
 
+TEST_CASE("ScrollUp.recyclesHistory", "[screen]")
+{
+    auto screen = MockScreen{{3, 2}};
+    screen.setMaxHistoryLineCount(2);
+    auto const& buffer = screen.currentBuffer();
+
+    screen.write("AAA\r\nBBB\r\nCCC\r\nDDD");
+    REQUIRE(screen.historyLineCount() == 2);
+    REQUIRE("CCC\nDDD\n" == screen.renderText());
+
+    // The top line goes into the history in compact form, handing its storage to the new bottom line.
+    auto const* const topLine = buffer.lineAt(1).buffer.data();
+    screen.write("\r\nEEE");
+
+    CHECK(screen.historyLineCount() == 2);
+    CHECK(buffer.lines.capacity() == 4);
+    CHECK(buffer.lineAt(2).buffer.data() == topLine);
+    CHECK("BBB" == screen.renderHistoryTextLine(2));
+    CHECK("CCC" == screen.renderHistoryTextLine(1));
+    CHECK("DDD\nEEE\n" == screen.renderText());
+
+    SECTION("lowering the limit") {
+        screen.setMaxHistoryLineCount(1);
+        CHECK(screen.historyLineCount() == 1);
+        CHECK(buffer.lines.capacity() == 3);
+        CHECK("CCC" == screen.renderHistoryTextLine(1));
+    }
+
+    SECTION("resize") {
+        screen.resize({3, 4});
+        CHECK(screen.historyLineCount() == 0);
+        CHECK("BBB\nCCC\nDDD\nEEE\n" == screen.renderText());
+    }
+}
+
+TEST_CASE("ScrollUp.compactsHistory", "[screen]")
+{
+    auto screen = MockScreen{{10, 2}};
+    auto const& buffer = screen.currentBuffer();
+
+    screen.write(U"\033[31mRed\033[m \033]8;;https://example.com\033\\link\033]8;;\033\\");
+    screen.write(U"\r\n\u4E2De\u0301");
+    screen.write("\r\n\033[44m   \033[m");
+    screen.write("\r\nfoo\r\nbar");
+    REQUIRE(screen.historyLineCount() == 3);
+
+    // Scrollback lines are compact until accessed.
+    for (size_t i = 0; i < 3; ++i)
+    {
+        CHECK(buffer.lines[i].buffer.empty());
+        CHECK(!buffer.lines[i].compact.empty());
+        CHECK(buffer.lines[i].compact.cellCount() == 10);
+    }
+
+    auto const stats = buffer.historyStats();
+    CHECK(stats.lineCount == 3);
+    CHECK(stats.compactLineCount == 3);
+    CHECK(stats.cellBytes == 3 * 10 * sizeof(Cell));
+    CHECK(stats.compactBytes * 4 < stats.cellBytes);
+
+    CHECK("Red link  " == screen.renderHistoryTextLine(3));
+    CHECK(buffer.lines[0].compact.empty());
+    CHECK(buffer.lines[0].buffer.size() == 10);
+    CHECK(screen.at({-2, 1}).attributes().foregroundColor == Color{IndexedColor::Red});
+    CHECK(screen.at({-2, 4}).attributes().foregroundColor == screen.at({-2, 9}).attributes().foregroundColor);
+    CHECK(screen.at({-2, 4}).cell().hyperlinkId() == 0);
+    CHECK(screen.at({-2, 5}).cell().hyperlinkId() != 0);
+    CHECK(screen.at({-2, 5}).hyperlink()->uri == "https://example.com");
+    CHECK(screen.at({-2, 8}).cell().hyperlinkId() == screen.at({-2, 5}).cell().hyperlinkId());
+    CHECK(screen.at({-2, 9}).cell().hyperlinkId() == 0);
+
+    CHECK(screen.at({-1, 1}).codepoints() == U"\u4E2D");
+    CHECK(screen.at({-1, 1}).width() == 2);
+    CHECK(screen.at({-1, 3}).codepoints() == U"e\u0301");
+    CHECK(screen.at({-1, 3}).width() == 1);
+    CHECK(screen.at({-1, 4}).empty());
+
+    CHECK(screen.at({0, 3}).attributes().backgroundColor == Color{IndexedColor::Blue});
+    CHECK(screen.at({0, 4}).attributes().backgroundColor != Color{IndexedColor::Blue});
+
+    CHECK(buffer.historyStats().compactLineCount == 0);
+
+    SECTION("trimming") {
+        for (int i = 0; i < 6; ++i)
+            screen.write("\r\nbaz");
+        REQUIRE(screen.historyLineCount() == 9);
+        CHECK(buffer.historyStats().compactLineCount == 6);
+
+        for (int i = 1; i <= 9; ++i)
+            screen.renderHistoryTextLine(i);
+        CHECK(buffer.historyStats().compactLineCount == 0);
+
+        // All but the most recently expanded lines are compacted again.
+        screen.scrollUp(1);
+        CHECK(buffer.historyStats().compactLineCount == 9 - 4);
+        CHECK("Red link  " == screen.renderHistoryTextLine(9));
+        buffer.checkHistoryAccounting();
+    }
+}
+
+TEST_CASE("ScrollUp.historyMemoryLimit", "[screen]")
+{
+    auto screen = MockScreen{{10, 2}};
+    auto const& buffer = screen.currentBuffer();
+
+    for (int i = 1; i <= 100; ++i)
+        screen.write(fmt::format("L{:05}\r\n", i));
+    REQUIRE(screen.historyLineCount() == 99);
+
+    auto const lineBytes = ScreenBuffer::lineBytes(buffer.lines[0]);
+    CHECK(lineBytes > sizeof(ScreenBuffer::Line));
+    CHECK(lineBytes < sizeof(ScreenBuffer::Line) + 10 * sizeof(Cell));
+    CHECK(buffer.historyBytes() == 99 * lineBytes);
+    CHECK(screen.historyStats().bytes == buffer.historyBytes());
+    buffer.checkHistoryAccounting();
+
+    // Expanded lines are accounted with their cells.
+    screen.renderHistoryTextLine(1);
+    CHECK(buffer.historyBytes() == 98 * lineBytes + ScreenBuffer::lineBytes(buffer.lines[98]));
+    CHECK(buffer.historyBytes() > 99 * lineBytes);
+    buffer.checkHistoryAccounting();
+
+    SECTION("per screen") {
+        screen.setMaxHistoryBytes(20 * lineBytes);
+        CHECK(screen.historyLineCount() == 20);
+        CHECK(buffer.historyBytes() == 20 * lineBytes);
+        CHECK("L00080    " == screen.renderHistoryTextLine(20));
+
+        for (int i = 101; i <= 200; ++i)
+            screen.write(fmt::format("L{:05}\r\n", i));
+        CHECK(screen.historyLineCount() == 20);
+        CHECK("L00180    " == screen.renderHistoryTextLine(20));
+        CHECK("L00199    " == screen.renderHistoryTextLine(1));
+        buffer.checkHistoryAccounting();
+
+        screen.setMaxHistoryBytes(nullopt);
+        screen.write("\r\n");
+        CHECK(screen.historyLineCount() == 21);
+    }
+
+    SECTION("process-wide") {
+        auto other = MockScreen{{10, 2}};
+        auto const processUsage = HistoryBudget::processUsage();
+        HistoryBudget::setProcessLimit(processUsage + 20 * lineBytes);
+
+        // The other screen gets to use its share.
+        for (int i = 1; i <= 100; ++i)
+            other.write(fmt::format("L{:05}\r\n", i));
+        auto const share = *HistoryBudget::processLimit() / HistoryBudget::processUserCount();
+        CHECK(other.currentBuffer().historyBytes() <= share);
+        CHECK(other.currentBuffer().historyBytes() + lineBytes > share);
+
+        // This screen holds more than its share, giving back its oldest lines as it grows.
+        CHECK(screen.historyLineCount() == 99);
+        screen.write("L00101\r\n");
+        CHECK(buffer.historyBytes() <= share);
+        CHECK("L00100    " == screen.renderHistoryTextLine(1));
+        buffer.checkHistoryAccounting();
+        other.currentBuffer().checkHistoryAccounting();
+
+        HistoryBudget::setProcessLimit(nullopt);
+        CHECK(HistoryBudget::processUsage() == buffer.historyBytes() + other.currentBuffer().historyBytes());
+    }
+}
+
+TEST_CASE("ScrollUp.swapsOutColdPages", "[screen]")
+{
+    auto screen = MockScreen{{6, 2}};
+    screen.setMaxResidentHistoryLineCount(0);
+    auto const& buffer = screen.currentBuffer();
+
+    // Line N is written as "L{N}", and ends up in history line 2998 - N.
+    screen.write(U"\033[31mRéd\033[m");
+    for (int i = 1; i < 3000; ++i)
+    {
+        screen.write(fmt::format("\r\nL{:05}", i));
+        if (i == 5)
+            screen.write(SetMark{});
+    }
+    REQUIRE(screen.historyLineCount() == 2998);
+
+    // The first two pages are complete and swapped out, the third one is still being filled.
+    CHECK(buffer.swappedLineCount() == 2 * ScreenBuffer::PageLineCount);
+    CHECK(buffer.swapFile().size() > 0);
+    CHECK(buffer.swapFile().size() * 16 < 2 * ScreenBuffer::PageLineCount * 6 * sizeof(Cell));
+
+    // Markers are found without swapping in.
+    CHECK(buffer.findMarkerBackward(0) == optional{5 - 2997});
+    CHECK(buffer.swappedLineCount() == 2 * ScreenBuffer::PageLineCount);
+
+    // Pool entries referenced from swapped out cells survive garbage collection.
+    for (unsigned i = 0; i < 3 * CellPool::MinCollectThreshold; ++i)
+        screen.write(fmt::format("\033[H\033[38;2;{};{};{}mX", (i >> 16) & 0xFF, (i >> 8) & 0xFF, i & 0xFF));
+    for (unsigned i = 0; i < 3 * CellPool::MinCollectThreshold; ++i)
+        screen.write(U"\033[Hê");
+
+    // Accessing a line swaps in its page.
+    CHECK("L01500" == screen.renderHistoryTextLine(2998 - 1500));
+    CHECK(buffer.swappedLineCount() == ScreenBuffer::PageLineCount);
+
+    CHECK(screen.at({-2997, 1}).codepoints() == U"R");
+    CHECK(screen.at({-2997, 1}).attributes().foregroundColor == Color{IndexedColor::Red});
+    CHECK(screen.at({-2997, 2}).codepoints() == U"é");
+    CHECK(screen.at({-2997, 3}).attributes().foregroundColor == Color{IndexedColor::Red});
+    CHECK(buffer.swappedLineCount() == 0);
+    CHECK(buffer.swapFile().size() == 0);
+    buffer.checkHistoryAccounting();
+
+    SECTION("scrolling the viewport") {
+        screen.scrollUp(1);
+        CHECK(buffer.swappedLineCount() == 2 * ScreenBuffer::PageLineCount);
+        CHECK("L00005" == screen.renderHistoryTextLine(2998 - 5));
+    }
+
+    SECTION("evicting from history") {
+        screen.setMaxHistoryLineCount(1500);
+        CHECK(screen.historyLineCount() == 1500);
+        screen.scrollUp(1);
+        CHECK(buffer.swappedLineCount() == 2048 - 1498);
+        CHECK("L01498" == screen.renderHistoryTextLine(1500));
+        CHECK(buffer.swappedLineCount() == 0);
+        CHECK(buffer.swapFile().size() == 0);
+    }
+
+    SECTION("disabling") {
+        screen.scrollUp(1);
+        screen.setMaxResidentHistoryLineCount(nullopt);
+        CHECK(buffer.swappedLineCount() == 0);
+        CHECK("L00005" == screen.renderHistoryTextLine(2998 - 5));
+    }
+}
+
 TEST_CASE("ScrollDown", "[screen]")
 {
     auto screen = MockScreen{{5, 5}};
@@ -1710,7 +2123,7 @@ TEST_CASE("render into history", "[screen]")
 
     string renderedText;
     renderedText.resize(2 * 6);
-    auto const renderer = [&](Coordinate const& pos, Cell const& cell) {
+    auto const renderer = [&](Coordinate const& pos, CellView const& cell) {
         renderedText[(pos.row - 1) * 6 + (pos.column - 1)] = static_cast<char>(cell.codepoint(0));
         if (pos.column == 5)
             renderedText[(pos.row - 1) * 6 + (pos.column)] = '\n';
@@ -2231,6 +2644,242 @@ TEST_CASE("DECTABSR", "[screen]")
     }
 }
 
+TEST_CASE("Screen.damage", "[screen]")
+{
+    using Rows = vector<cursor_pos_t>;
+
+    auto screen = MockScreen{{5, 5}};
+    screen.write("1\r\n2\r\n3\r\n4\r\n5");
+
+    // All lines are damaged at first.
+    REQUIRE(screen.damagedLines(0) == Rows{1, 2, 3, 4, 5});
+
+    /// @returns the rows damaged by writing @p _text.
+    auto const damageOf = [&](string_view _text) {
+        auto const generation = screen.advanceDamageGeneration();
+        screen.write(_text);
+        return screen.damagedLines(generation);
+    };
+
+    SECTION("cursor movement and rendition") {
+        CHECK(damageOf("\033[2;2H\033[1;31m\033[3A\033[5C") == Rows{});
+        CHECK(damageOf("\033[2;1H\n\r") == Rows{});
+    }
+
+    SECTION("text") {
+        CHECK(damageOf("\033[3;2Hab") == Rows{3});
+        CHECK(damageOf("\033[1mX") == Rows{3});
+        CHECK(damageOf("\033[2;4Habcd") == Rows{2, 3});
+        CHECK(damageOf("\033[4;1He") == Rows{4});
+        CHECK(damageOf("\xCC\x81") == Rows{4});
+        CHECK(damageOf("\033[1;1H\033]8;;https://example.com\033\\link\033]8;;\033\\") == Rows{1});
+    }
+
+    SECTION("erasing") {
+        CHECK(damageOf("\033[2;3H\033[K") == Rows{2});
+        CHECK(damageOf("\033[1K") == Rows{2});
+        CHECK(damageOf("\033[2K") == Rows{2});
+        CHECK(damageOf("\033[2X") == Rows{2});
+        CHECK(damageOf("\033[3;1H\033[J") == Rows{3, 4, 5});
+        CHECK(damageOf("\033[1J") == Rows{1, 2, 3});
+        CHECK(damageOf("\033[2J") == Rows{1, 2, 3, 4, 5});
+    }
+
+    SECTION("lines") {
+        CHECK(damageOf("\033[2;1H\033[L") == Rows{2, 3, 4, 5});
+        CHECK(damageOf("\033[4;1H\033[M") == Rows{4, 5});
+        CHECK(damageOf("\033[2;4r\033[3;1H\033[L") == Rows{3, 4});
+        CHECK(damageOf("\033[S") == Rows{2, 3, 4});
+        CHECK(damageOf("\033[T") == Rows{2, 3, 4});
+        CHECK(damageOf("\033[4;1H\n") == Rows{2, 3, 4});
+        CHECK(damageOf("\033[2;1H\033M") == Rows{2, 3, 4});
+        CHECK(damageOf("\033[r\033[5;1H\n") == Rows{1, 2, 3, 4, 5});
+    }
+
+    SECTION("characters") {
+        CHECK(damageOf("\033[2;1H\033[2@") == Rows{2});
+        CHECK(damageOf("\033[3;1H\033[P") == Rows{3});
+        CHECK(damageOf("\033[2'}") == Rows{1, 2, 3, 4, 5});
+        CHECK(damageOf("\033[2'~") == Rows{1, 2, 3, 4, 5});
+    }
+
+    SECTION("whole screen") {
+        CHECK(damageOf("\033#8") == Rows{1, 2, 3, 4, 5});
+        CHECK(damageOf("\033[?5h") == Rows{1, 2, 3, 4, 5});
+        CHECK(damageOf("\033[?5h") == Rows{});
+        CHECK(damageOf("\033[?5l") == Rows{1, 2, 3, 4, 5});
+
+        auto const generation = screen.advanceDamageGeneration();
+        screen.resize({6, 5});
+        CHECK(screen.damagedLines(generation) == Rows{1, 2, 3, 4, 5});
+    }
+
+    SECTION("alternate screen") {
+        CHECK(damageOf("\033[?1049h") == Rows{1, 2, 3, 4, 5});
+        CHECK(damageOf("\033[2;1HX") == Rows{2});
+        CHECK(damageOf("\033[?1049l") == Rows{1, 2, 3, 4, 5});
+        CHECK(damageOf("\033[3;1HX") == Rows{3});
+    }
+
+    SECTION("viewport") {
+        screen.write("\r\n6\r\n7");
+        REQUIRE(screen.historyLineCount() == 2);
+
+        auto generation = screen.advanceDamageGeneration();
+        screen.scrollUp(1);
+        CHECK(screen.damagedLines(generation) == Rows{1, 2, 3, 4, 5});
+
+        generation = screen.advanceDamageGeneration();
+        screen.scrollUp(5);
+        screen.scrollUp(5);
+        screen.scrollToTop();
+        CHECK(screen.damagedLines(generation) == Rows{1, 2, 3, 4, 5});
+
+        generation = screen.advanceDamageGeneration();
+        screen.scrollToBottom();
+        CHECK(screen.damagedLines(generation) == Rows{1, 2, 3, 4, 5});
+    }
+
+    SECTION("hyperlink hover") {
+        screen.write("\033[3;1H\033]8;;https://example.com\033\\link\033]8;;\033\\");
+        auto const hyperlink = screen.at({3, 1}).cell().hyperlinkId();
+        REQUIRE(hyperlink != 0);
+
+        auto const generation = screen.advanceDamageGeneration();
+        screen.markHyperlinkDamaged(hyperlink);
+        CHECK(screen.damagedLines(generation) == Rows{3});
+    }
+
+    SECTION("several consumers") {
+        auto const first = screen.advanceDamageGeneration();
+        screen.write("\033[1;1HX");
+        auto const second = screen.advanceDamageGeneration();
+        screen.write("\033[2;1HX");
+
+        CHECK(screen.damagedLines(first) == Rows{1, 2});
+        CHECK(screen.damagedLines(second) == Rows{2});
+        CHECK(screen.isLineDamaged(1, first));
+        CHECK(!screen.isLineDamaged(1, second));
+    }
+}
+
+TEST_CASE("Screen.snapshot", "[screen]")
+{
+    auto screen = MockScreen{{5, 3}};
+    screen.setMaxHistoryLineCount(10);
+    auto snapshot = ScreenSnapshot{};
+
+    /// Renders the text of the screen's visible lines, or of the snapshot.
+    auto const textOf = [](auto const& _render) {
+        auto text = u32string{};
+        _render([&](Coordinate const& _pos, CellView const& _cell) {
+            if (_pos.column == 1 && !text.empty())
+                text += U'\n';
+            text += _cell.empty() ? u32string_view{U" "} : _cell.codepoints();
+        });
+        return text;
+    };
+    auto const screenText = [&]() {
+        return textOf([&](auto _render) { screen.render(_render, screen.scrollOffset()); });
+    };
+    auto const snapshotText = [&]() {
+        return textOf([&](auto _render) { snapshot.render(_render); });
+    };
+
+    screen.write("ABC\r\n\033[31mDEF\033[m\r\ne\u0301");
+    snapshot.update(screen, 0);
+    CHECK(snapshotText() == screenText());
+    CHECK(snapshot.size() == Size{5, 3});
+    CHECK(snapshot.cursor().position == Coordinate{3, 2});
+    CHECK(snapshot.at({2, 1}).attributes().foregroundColor == IndexedColor::Red);
+    CHECK(snapshot.at({3, 1}).codepoints() == U"e\u0301");
+
+    SECTION("unchanged until updated") {
+        auto const before = snapshotText();
+        screen.write("\033[1;1HXYZ");
+        CHECK(snapshotText() == before);
+        snapshot.update(screen, 0);
+        CHECK(snapshotText() == screenText());
+    }
+
+    SECTION("only damaged lines") {
+        // Lines changed behind the damage tracking's back are left alone.
+        screen.currentBuffer().lineAt(1).buffer[0].setCharacter(U'x');
+        screen.write("\033[2;1HX");
+        snapshot.update(screen, 0);
+        CHECK(snapshot.at({1, 1}).codepoints() == U"A");
+        CHECK(snapshot.at({2, 1}).codepoints() == U"X");
+    }
+
+    SECTION("scrolled viewport") {
+        screen.write("\r\n4\r\n5\r\n6");
+        screen.scrollUp(2);
+        snapshot.update(screen, 0);
+        CHECK(snapshot.scrollOffset() == 2);
+        CHECK(snapshot.historyLineCount() == 3);
+        CHECK(snapshotText() == screenText());
+
+        screen.scrollToBottom();
+        snapshot.update(screen, 0);
+        CHECK(snapshotText() == screenText());
+    }
+
+    SECTION("resize") {
+        screen.resize({4, 2});
+        snapshot.update(screen, 0);
+        CHECK(snapshot.size() == Size{4, 2});
+        CHECK(snapshotText() == screenText());
+    }
+
+    SECTION("alternate screen") {
+        screen.write(SetMode{Mode::UseAlternateScreen, true});
+        screen.write("\033[34malt");
+        snapshot.update(screen, 0);
+        CHECK(snapshot.bufferType() == ScreenBuffer::Type::Alternate);
+        CHECK(snapshotText() == screenText());
+        CHECK(snapshot.at({1, 1}).attributes().foregroundColor == IndexedColor::Blue);
+
+        screen.write(SetMode{Mode::UseAlternateScreen, false});
+        snapshot.update(screen, 0);
+        CHECK(snapshotText() == screenText());
+        CHECK(snapshot.at({2, 1}).attributes().foregroundColor == IndexedColor::Red);
+    }
+
+    SECTION("cursor style") {
+        CHECK(snapshot.cursorVisible());
+        snapshot.setCursorStyle(CursorDisplay::Blink, CursorShape::Bar);
+        snapshot.setCursorBlinkPhase(false);
+        CHECK(snapshot.cursorShape() == CursorShape::Bar);
+        CHECK(!snapshot.cursorVisible());
+
+        // The cursor style is left alone by updates, as it is kept by the terminal.
+        snapshot.setCursorBlinkPhase(true);
+        screen.write("\033[?25l");
+        snapshot.update(screen, 0);
+        CHECK(snapshot.cursorDisplay() == CursorDisplay::Blink);
+        CHECK(!snapshot.cursorVisible());
+    }
+
+    SECTION("hyperlinks") {
+        screen.write("\033[1;1H\033]8;;http://x/\033\\link\033]8;;\033\\");
+        auto const hyperlink = screen.at({1, 1}).cell().hyperlinkId();
+        snapshot.update(screen, 0);
+        REQUIRE(snapshot.at({1, 1}).hyperlink());
+        CHECK(snapshot.at({1, 1}).hyperlink()->uri == "http://x/");
+        CHECK(snapshot.at({1, 1}).hyperlink()->state == HyperlinkState::Inactive);
+        CHECK(!snapshot.at({1, 5}).hyperlink());
+
+        // Hovering is shown by the snapshot only, leaving the screen's link alone.
+        screen.markHyperlinkDamaged(hyperlink);
+        snapshot.update(screen, hyperlink);
+        CHECK(snapshot.at({1, 4}).hyperlink()->state == HyperlinkState::Hover);
+        CHECK(screen.at({1, 1}).hyperlink()->state == HyperlinkState::Inactive);
+
+        snapshot.update(screen, 0);
+        CHECK(snapshot.at({1, 4}).hyperlink()->state == HyperlinkState::Inactive);
+    }
+}
+
 TEST_CASE("resize", "[screen]")
 {
     auto screen = MockScreen{{2, 2}};
@@ -2260,6 +2909,18 @@ TEST_CASE("resize", "[screen]")
         REQUIRE(screen.cursorPosition() == Coordinate{1, 2});
     }
 
+    SECTION("shrink lines without history") {
+        // The lines pushed off the screen are dropped again, without ever being unaccounted.
+        auto const processUsage = HistoryBudget::processUsage();
+        screen.setMaxHistoryLineCount(0);
+        screen.resize({2, 1});
+        REQUIRE("CD\n" == screen.renderText());
+        REQUIRE(screen.historyLineCount() == 0);
+        CHECK(screen.currentBuffer().historyBytes() == 0);
+        CHECK(HistoryBudget::processUsage() == processUsage);
+        screen.currentBuffer().checkHistoryAccounting();
+    }
+
     SECTION("grow columns") {
         screen.resize({3, 2});
         REQUIRE("AB \nCD \n" == screen.renderText());
@@ -2267,8 +2928,11 @@ TEST_CASE("resize", "[screen]")
     }
 
     SECTION("shrink columns") {
+        // Lines are reflowed, pushing the lines at the top into the history.
         screen.resize({1, 2});
-        REQUIRE("A\nC\n" == screen.renderText());
+        REQUIRE("C\nD\n" == screen.renderText());
+        REQUIRE("B" == screen.renderHistoryTextLine(1));
+        REQUIRE("A" == screen.renderHistoryTextLine(2));
         REQUIRE(screen.cursorPosition() == Coordinate{2, 1});
     }
 
@@ -2285,15 +2949,18 @@ TEST_CASE("resize", "[screen]")
         REQUIRE("ABX\nCDY\n" == screen.renderText());
         REQUIRE(screen.cursorPosition() == Coordinate{1, 3});
 
-        // 3.) shrink
+        // 3.) shrink, with the cursor kept on the top line as its line is pushed into the history
         screen.resize({2, 2});
-        REQUIRE("AB\nCD\n" == screen.renderText());
+        REQUIRE("CD\nY \n" == screen.renderText());
+        REQUIRE("X " == screen.renderHistoryTextLine(1));
+        REQUIRE("AB" == screen.renderHistoryTextLine(2));
         REQUIRE(screen.cursorPosition() == Coordinate{1, 2});
 
         // 4.) regrow (and see if pre-filled data were retained)
         screen.resize({3, 2});
         REQUIRE("ABX\nCDY\n" == screen.renderText());
-        REQUIRE(screen.cursorPosition() == Coordinate{1, 3});
+        REQUIRE(screen.historyLineCount() == 0);
+        REQUIRE(screen.cursorPosition() == Coordinate{2, 2});
     }
 
     SECTION("grow rows, grow columns") {
@@ -2305,7 +2972,9 @@ TEST_CASE("resize", "[screen]")
 
     SECTION("grow rows, shrink columns") {
         screen.resize({1, 3});
-        REQUIRE("A\nC\n \n" == screen.renderText());
+        REQUIRE("B\nC\nD\n" == screen.renderText());
+        REQUIRE("A" == screen.renderHistoryTextLine(1));
+        REQUIRE(screen.cursorPosition() == Coordinate{3, 1});
     }
 
     SECTION("shrink rows, grow columns") {
@@ -2315,12 +2984,246 @@ TEST_CASE("resize", "[screen]")
 
     SECTION("shrink rows, shrink columns") {
         screen.resize({1, 1});
-        REQUIRE("C\n" == screen.renderText());
+        REQUIRE("D\n" == screen.renderText());
+        REQUIRE("C" == screen.renderHistoryTextLine(1));
+        REQUIRE("B" == screen.renderHistoryTextLine(2));
+        REQUIRE("A" == screen.renderHistoryTextLine(3));
     }
 
     // TODO: what do we want to do when re resize to {0, y}, {x, 0}, {0, 0}?
 }
 
+TEST_CASE("resize.reflow", "[screen]")
+{
+    auto screen = MockScreen{{4, 3}};
+    auto const& buffer = screen.currentBuffer();
+
+    screen.write("ABCDEFG\r\nxy");
+    REQUIRE("ABCD\nEFG \nxy  \n" == screen.renderText());
+    CHECK(!buffer.lineAt(1).wrapped);
+    CHECK(buffer.lineAt(2).wrapped);
+    CHECK(!buffer.lineAt(3).wrapped);
+
+    SECTION("narrow and widen") {
+        screen.resize({3, 3});
+        CHECK("DEF\nG  \nxy \n" == screen.renderText());
+        CHECK("ABC" == screen.renderHistoryTextLine(1));
+        CHECK(screen.cursorPosition() == Coordinate{3, 3});
+
+        screen.resize({8, 3});
+        CHECK("ABCDEFG \nxy      \n        \n" == screen.renderText());
+        CHECK(screen.historyLineCount() == 0);
+        CHECK(screen.cursorPosition() == Coordinate{2, 3});
+
+        screen.write("z");
+        CHECK("xyz     " == screen.renderTextLine(2));
+    }
+
+    SECTION("widening pulls lines from the history") {
+        screen.write("\r\n12345678");
+        REQUIRE("xy  \n1234\n5678\n" == screen.renderText());
+        REQUIRE(screen.historyLineCount() == 2);
+
+        screen.resize({8, 3});
+        CHECK("ABCDEFG \nxy      \n12345678\n" == screen.renderText());
+        CHECK(screen.historyLineCount() == 0);
+        CHECK(screen.cursorPosition() == Coordinate{3, 8});
+    }
+
+    SECTION("cursor") {
+        screen.write("\r\nabcd");
+        REQUIRE(screen.cursorPosition() == Coordinate{3, 4});
+
+        screen.resize({6, 3});
+        CHECK("G     \nxy    \nabcd  \n" == screen.renderText());
+        CHECK("ABCDEF" == screen.renderHistoryTextLine(1));
+        CHECK(screen.cursorPosition() == Coordinate{3, 5});
+
+        screen.write("e");
+        CHECK("abcde " == screen.renderTextLine(3));
+    }
+
+    SECTION("wide characters") {
+        // The last wide character is cut off at the right edge.
+        screen.write(U"\r\na中文字");
+        REQUIRE(screen.at({2, 2}).codepoints() == U"中");
+        REQUIRE(screen.at({2, 4}).codepoints() == U"文");
+        REQUIRE(screen.at({3, 1}).codepoints() == U"字");
+
+        // A wide character is not split across lines.
+        screen.resize({3, 3});
+        CHECK(screen.at({1, 2}).codepoints() == U"中");
+        CHECK(screen.at({2, 1}).codepoints() == U"文");
+        CHECK(screen.at({2, 3}).empty());
+        CHECK(screen.at({3, 1}).codepoints() == U"字");
+        CHECK(screen.cursorPosition() == Coordinate{3, 3});
+
+        // Nor is the padding taken for text when joining the lines again.
+        screen.resize({7, 3});
+        CHECK(screen.at({3, 2}).codepoints() == U"中");
+        CHECK(screen.at({3, 4}).codepoints() == U"文");
+        CHECK(screen.at({3, 6}).codepoints() == U"字");
+        CHECK(screen.cursorPosition() == Coordinate{3, 7});
+    }
+
+    SECTION("marks") {
+        screen.write(SetMark{});
+        screen.write("123");
+        screen.resize({2, 3});
+        CHECK("xy\n12\n3 \n" == screen.renderText());
+        CHECK(buffer.isLineMarked(1));
+        CHECK(!buffer.isLineMarked(2));
+    }
+
+    SECTION("margins") {
+        // Text wrapping within horizontal margins does not make up a logical line.
+        screen.write("\r\n");
+        screen.write(SetMode{Mode::LeftRightMargin, true});
+        screen.write(SetLeftRightMargin{1, 2});
+        screen.write("1234");
+        CHECK(!buffer.lineAt(3).wrapped);
+    }
+}
+
+TEST_CASE("resize.reflowsHistoryLazily", "[screen]")
+{
+    auto constexpr PageLineCount = static_cast<int>(ScreenBuffer::PageLineCount);
+    auto screen = MockScreen{{4, 2}};
+    auto const& buffer = screen.currentBuffer();
+
+    // Every number takes two lines.
+    for (int i = 0; i < 3 * PageLineCount; ++i)
+        screen.write(fmt::format("\r\n{:07}", i));
+    REQUIRE(screen.historyLineCount() == 6 * PageLineCount - 1);
+
+    SECTION("widening") {
+        screen.resize({8, 2});
+        CHECK("0003070 \n0003071 \n" == screen.renderText());
+
+        // Only the scrollback lines wrapping into the screen are reflowed right away,
+        // others as they are accessed, a page worth at a time.
+        CHECK(screen.historyLineCount() == 6 * PageLineCount - 3);
+        CHECK("0003069 " == screen.renderHistoryTextLine(1));
+        CHECK(screen.historyLineCount() == 6 * PageLineCount - 3 - PageLineCount / 2);
+
+        CHECK("0000000 " == screen.renderHistoryTextLine(3 * PageLineCount - 2));
+        CHECK(screen.historyLineCount() == 3 * PageLineCount - 1);
+        CHECK("0003069 " == screen.renderHistoryTextLine(1));
+    }
+
+    SECTION("narrowing") {
+        screen.resize({2, 2});
+        CHECK("07\n1 \n" == screen.renderText());
+        CHECK("03" == screen.renderHistoryTextLine(1));
+        CHECK("00" == screen.renderHistoryTextLine(2));
+        CHECK("0 " == screen.renderHistoryTextLine(3));
+        CHECK("00" == screen.renderHistoryTextLine(12 * PageLineCount - 2));
+        CHECK(screen.historyLineCount() == 12 * PageLineCount - 1);
+    }
+
+    SECTION("swapped out") {
+        screen.setMaxResidentHistoryLineCount(0);
+        REQUIRE(buffer.swappedLineCount() == 5 * ScreenBuffer::PageLineCount);
+
+        // Pages with lines still to be reflowed are not swapped out.
+        screen.resize({8, 2});
+        screen.setMaxResidentHistoryLineCount(0);
+        CHECK(buffer.swappedLineCount() == 5 * ScreenBuffer::PageLineCount);
+
+        CHECK("0002070 " == screen.renderHistoryTextLine(1000));
+        CHECK("0000000 " == screen.renderHistoryTextLine(3 * PageLineCount - 2));
+        CHECK(screen.historyLineCount() == 3 * PageLineCount - 1);
+    }
+
+    SECTION("scrolling") {
+        screen.resize({8, 2});
+        screen.scrollUp(10);
+        CHECK(screen.scrollOffset() == 10);
+        CHECK(screen.historyLineCount() == 6 * PageLineCount - 3 - PageLineCount / 2);
+    }
+
+    SECTION("scrolled") {
+        // The viewport shows both halves of 0003069, and moves along as lines below it are reflowed.
+        screen.scrollUp(4);
+        REQUIRE("0003" == screen.renderHistoryTextLine(4));
+        REQUIRE("069 " == screen.renderHistoryTextLine(3));
+
+        screen.resize({8, 2});
+        CHECK(screen.scrollOffset() == 2);
+        CHECK("0003069 " == screen.renderHistoryTextLine(1));
+        CHECK(screen.scrollOffset() == 2);
+    }
+}
+
+TEST_CASE("Screen.commandRecording", "[screen]")
+{
+    struct RecordingEvents : public MockScreenEvents {
+        void commands(CommandList const& _commands) override
+        {
+            ++invocations;
+            received = _commands.size();
+        }
+        int invocations = 0;
+        size_t received = 0;
+    };
+
+    auto events = RecordingEvents{};
+    auto screen = Screen{{5, 2}, events};
+
+    // Commands are only executed by default.
+    screen.write("AB\033[1mC");
+    CHECK(events.invocations == 1);
+    CHECK(events.received == 0);
+    CHECK("ABC  \n     \n" == screen.renderText());
+
+    screen.setCommandRecording(true);
+    screen.write("\r\nDE");
+    CHECK(events.invocations == 2);
+    CHECK(events.received == 3);
+    CHECK("ABC  \nDE   \n" == screen.renderText());
+
+    screen.setCommandRecording(false);
+    screen.write("F");
+    CHECK(events.invocations == 3);
+    CHECK(events.received == 0);
+    CHECK("ABC  \nDEF  \n" == screen.renderText());
+}
+
+TEST_CASE("Screen.writeCommandList", "[screen]")
+{
+    // Output parsed ahead in batches, with sequences and grapheme clusters split across batches,
+    // ends up the same as when written directly.
+    auto const output = string_view{
+        "Hello\033[1;31mWorld\033[m e\xCC\x81\r\n"
+        "\033]8;;http://x/\033\\link\033]8;;\033\\ \033[2;3HX\033[4;1H\xE2\x94\x80\xE2\x94\x80"
+    };
+
+    auto direct = MockScreen{{10, 4}};
+    direct.write(output);
+
+    for (size_t const batchSize : {size_t{1}, size_t{3}, size_t{7}, output.size()})
+    {
+        auto events = ScreenEvents{};
+        auto screen = Screen{{10, 4}, events};
+        auto parser = CommandParser{{}};
+        auto commands = CommandList{};
+
+        for (size_t i = 0; i < output.size(); i += batchSize)
+        {
+            parser.parse(output.data() + i, min(batchSize, output.size() - i), commands);
+            screen.write(commands);
+        }
+
+        INFO(fmt::format("batch size: {}", batchSize));
+        CHECK(screen.renderText() == direct.renderText());
+        CHECK(screen.cursorPosition() == direct.cursorPosition());
+        CHECK(screen.at({1, 6}).attributes().foregroundColor == IndexedColor::Red);
+        CHECK(screen.at({2, 2}).codepoints() == U"e\u0301");
+        REQUIRE(screen.at({3, 1}).hyperlink());
+        CHECK(screen.at({3, 1}).hyperlink()->uri == "http://x/");
+    }
+}
+
 // TODO: SetForegroundColor
 // TODO: SetBackgroundColor
 // TODO: SetGraphicsRendition
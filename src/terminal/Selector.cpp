@@ -57,14 +57,14 @@ Selector::Selector(Mode _mode,
                    Coordinate const& _from) :
     Selector{
         _mode,
-        [screen = std::ref(_screen)](Coordinate const& _pos) -> Cell const* {
+        [screen = std::ref(_screen)](Coordinate const& _pos) -> std::optional<CellView> {
             assert(_pos.row >= 0 && "must be absolute coordinate");
             auto const& buffer = screen.get();
             auto const row = _pos.row - buffer.historyLineCount(); // translate to coordinate relative to the screen's home position
             if (row <= buffer.size().height)
-                return &buffer.at({row, _pos.column});
+                return buffer.at({row, _pos.column});
             else
-                return nullptr;
+                return std::nullopt;
         },
         _wordDelimiters,
         _screen.size().height + static_cast<cursor_pos_t>(_screen.historyLineCount()),
@@ -77,7 +77,7 @@ Selector::Selector(Mode _mode,
 Coordinate Selector::stretchedColumn(Coordinate _coord) const noexcept
 {
     Coordinate stretched = _coord;
-    if (Cell const* cell = at(_coord); cell && cell->width() > 1)
+    if (auto const cell = at(_coord); cell && cell->width() > 1)
     {
         // wide character
         stretched.column += cell->width() - 1;
@@ -86,7 +86,7 @@ Coordinate Selector::stretchedColumn(Coordinate _coord) const noexcept
 
     while (stretched.column < columnCount_)
     {
-        if (Cell const* cell = at(stretched); cell)
+        if (auto const cell = at(stretched); cell)
         {
             if (cell->empty())
                 stretched.column++;
@@ -138,7 +138,7 @@ bool Selector::extend(Coordinate const& _coord)
 void Selector::extendSelectionBackward()
 {
     auto const isWordDelimiterAt = [this](Coordinate const& _coord) -> bool {
-        Cell const* cell = at(_coord);
+        auto const cell = at(_coord);
         return !cell || cell->empty() || wordDelimiters_.find(cell->codepoint(0)) != wordDelimiters_.npos;
     };
 
@@ -172,7 +172,7 @@ void Selector::extendSelectionBackward()
 void Selector::extendSelectionForward()
 {
     auto const isWordDelimiterAt = [this](Coordinate const& _coord) -> bool {
-        Cell const* cell = at(_coord);
+        auto const cell = at(_coord);
         return !cell || cell->empty() || wordDelimiters_.find(cell->codepoint(0)) != wordDelimiters_.npos;
     };
 
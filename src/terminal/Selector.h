@@ -20,6 +20,7 @@
 #include <fmt/format.h>
 
 #include <functional>
+#include <optional>
 #include <vector>
 #include <utility>
 
@@ -72,7 +73,7 @@ class Selector {
 
     using Renderer = ScreenBuffer::Renderer;
     enum class Mode { Linear, LinearWordWise, FullLine, Rectangular };
-	using GetCellAt = std::function<Cell const*(Coordinate const&)>;
+	using GetCellAt = std::function<std::optional<CellView>(Coordinate const&)>;
 
     Selector(Mode _mode,
 			 GetCellAt _at,
@@ -138,7 +139,7 @@ class Selector {
     {
         for (auto const& range : selection())
             for (auto const col : crispy::times(range.fromColumn, range.length()))
-                if (Cell const* cell = at({range.line, col}); cell != nullptr)
+                if (auto const cell = at({range.line, col}); cell.has_value())
                 {
                     auto const pos = Coordinate{range.line, col};
                     _render(pos, *cell);
@@ -164,7 +165,7 @@ class Selector {
 		}
 	}
 
-	Cell const* at(Coordinate const& _pos) const { return getCellAt_(_pos); }
+	std::optional<CellView> at(Coordinate const& _pos) const { return getCellAt_(_pos); }
 
 	void extendSelectionBackward();
 	void extendSelectionForward();
@@ -32,7 +32,7 @@ namespace
     struct TextSelection {
         string text;
 
-        void operator()(Coordinate const& _pos, Cell const& _cell)
+        void operator()(Coordinate const& _pos, CellView const& _cell)
         {
             text += _pos.column < lastColumn_ ? "\n" : "";
             text += _cell.toUtf8();
@@ -0,0 +1,258 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/SwapFile.h>
+
+#include <crispy/lz.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using std::nullopt;
+using std::optional;
+using std::string;
+using std::vector;
+
+namespace terminal {
+
+SwapFile::SwapFile(SwapFile&& _other) noexcept
+{
+    *this = std::move(_other);
+}
+
+SwapFile& SwapFile::operator=(SwapFile&& _other) noexcept
+{
+    if (this == &_other)
+        return *this;
+
+    close();
+
+    size_ = std::exchange(_other.size_, 0);
+    rawSize_ = std::exchange(_other.rawSize_, 0);
+#if defined(__unix__) || defined(__APPLE__)
+    fd_ = std::exchange(_other.fd_, -1);
+    fileSize_ = std::exchange(_other.fileSize_, 0);
+    freeRegions_ = std::move(_other.freeRegions_);
+    _other.freeRegions_.clear();
+#else
+    nextOffset_ = std::exchange(_other.nextOffset_, 0);
+    blobs_ = std::move(_other.blobs_);
+    _other.blobs_.clear();
+#endif
+
+    return *this;
+}
+
+SwapFile::~SwapFile()
+{
+    close();
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+namespace {
+    uint64_t pageSize()
+    {
+        static auto const value = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        return value;
+    }
+
+    uint64_t roundUpToPage(uint64_t _n)
+    {
+        auto const page = pageSize();
+        return (_n + page - 1) / page * page;
+    }
+
+    bool writeAll(int _fd, uint8_t const* _data, size_t _size, uint64_t _offset)
+    {
+        while (_size != 0)
+        {
+            auto const n = pwrite(_fd, _data, _size, static_cast<off_t>(_offset));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            _data += n;
+            _size -= static_cast<size_t>(n);
+            _offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+}
+
+void SwapFile::close() noexcept
+{
+    if (fd_ != -1)
+        ::close(fd_);
+
+    fd_ = -1;
+    fileSize_ = 0;
+    freeRegions_.clear();
+    size_ = 0;
+    rawSize_ = 0;
+}
+
+bool SwapFile::open()
+{
+    if (fd_ != -1)
+        return true;
+
+    char const* tempDir = getenv("TMPDIR");
+    auto path = string(tempDir && *tempDir ? tempDir : "/tmp") + "/contour-swap-XXXXXX";
+
+    // The descriptor must not leak into child processes, not even when forked concurrently.
+    fd_ = mkostemp(path.data(), O_CLOEXEC);
+    if (fd_ == -1)
+        return false;
+
+    // The file is only reachable through our descriptor.
+    unlink(path.c_str());
+
+    return true;
+}
+
+optional<uint64_t> SwapFile::allocate(uint64_t _length)
+{
+    for (auto i = freeRegions_.begin(); i != freeRegions_.end(); ++i)
+    {
+        auto const [offset, length] = *i;
+        if (length < _length)
+            continue;
+
+        freeRegions_.erase(i);
+        if (length > _length)
+            freeRegions_.emplace(offset + _length, length - _length);
+        return offset;
+    }
+
+    auto const offset = fileSize_;
+    if (ftruncate(fd_, static_cast<off_t>(offset + _length)) != 0)
+        return nullopt;
+
+    fileSize_ += _length;
+    return offset;
+}
+
+optional<SwapFile::Extent> SwapFile::store(uint8_t const* _data, size_t _size)
+{
+    if (!open())
+        return nullopt;
+
+    auto const compressed = crispy::lz::compress(_data, _size);
+
+    auto const offset = allocate(roundUpToPage(compressed.size()));
+    if (!offset.has_value())
+        return nullopt;
+
+    auto const extent = Extent{*offset, compressed.size(), _size};
+    size_ += extent.size;
+    rawSize_ += extent.rawSize;
+
+    if (!writeAll(fd_, compressed.data(), compressed.size(), *offset))
+    {
+        release(extent);
+        return nullopt;
+    }
+
+    return extent;
+}
+
+optional<vector<uint8_t>> SwapFile::load(Extent const& _extent) const
+{
+    if (fd_ == -1)
+        return nullopt;
+
+    void* region = mmap(nullptr, _extent.size, PROT_READ, MAP_SHARED, fd_, static_cast<off_t>(_extent.offset));
+    if (region == MAP_FAILED)
+        return nullopt;
+
+    auto result = crispy::lz::decompress(static_cast<uint8_t const*>(region), _extent.size, _extent.rawSize);
+
+    munmap(region, _extent.size);
+    return result;
+}
+
+void SwapFile::release(Extent const& _extent)
+{
+    size_ -= _extent.size;
+    rawSize_ -= _extent.rawSize;
+
+    auto offset = _extent.offset;
+    auto length = roundUpToPage(_extent.size);
+
+    // Merge with adjacent free regions.
+    auto next = freeRegions_.lower_bound(offset);
+    if (next != freeRegions_.end() && offset + length == next->first)
+    {
+        length += next->second;
+        next = freeRegions_.erase(next);
+    }
+    if (next != freeRegions_.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            length += prev->second;
+            freeRegions_.erase(prev);
+        }
+    }
+
+    // Give the space back to the file system if it is at the end of the file.
+    if (offset + length == fileSize_ && ftruncate(fd_, static_cast<off_t>(offset)) == 0)
+        fileSize_ = offset;
+    else
+        freeRegions_.emplace(offset, length);
+}
+#else
+void SwapFile::close() noexcept
+{
+    blobs_.clear();
+    size_ = 0;
+    rawSize_ = 0;
+}
+
+optional<SwapFile::Extent> SwapFile::store(uint8_t const* _data, size_t _size)
+{
+    auto compressed = crispy::lz::compress(_data, _size);
+    auto const extent = Extent{nextOffset_++, compressed.size(), _size};
+    blobs_.emplace(extent.offset, std::move(compressed));
+    size_ += extent.size;
+    rawSize_ += extent.rawSize;
+    return extent;
+}
+
+optional<vector<uint8_t>> SwapFile::load(Extent const& _extent) const
+{
+    if (auto const i = blobs_.find(_extent.offset); i != blobs_.end())
+        return crispy::lz::decompress(i->second, _extent.rawSize);
+    return nullopt;
+}
+
+void SwapFile::release(Extent const& _extent)
+{
+    blobs_.erase(_extent.offset);
+    size_ -= _extent.size;
+    rawSize_ -= _extent.rawSize;
+}
+#endif
+
+} // end namespace
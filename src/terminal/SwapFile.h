@@ -0,0 +1,85 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace terminal {
+
+/// Backing store for blobs of data that are not to be kept in memory, such as cold scrollback pages.
+///
+/// Blobs are compressed and written to an anonymous temporary file, that is unlinked right after
+/// it has been created, so it goes away with the process. Loading a blob maps its region of the
+/// file into memory for decompression. The file is only created once the first blob is stored.
+///
+/// On platforms without mmap(), the compressed blobs are kept in memory instead.
+class SwapFile {
+  public:
+    /// Location of a stored blob.
+    struct Extent {
+        uint64_t offset;
+        size_t size;        //!< compressed size
+        size_t rawSize;     //!< size before compression
+    };
+
+    SwapFile() = default;
+    SwapFile(SwapFile&& _other) noexcept;
+    SwapFile& operator=(SwapFile&& _other) noexcept;
+    SwapFile(SwapFile const&) = delete;
+    SwapFile& operator=(SwapFile const&) = delete;
+    ~SwapFile();
+
+    /// Compresses and stores @p _size bytes at @p _data.
+    ///
+    /// @returns the blob's location, or std::nullopt if it could not be written.
+    std::optional<Extent> store(uint8_t const* _data, size_t _size);
+
+    /// @returns the decompressed blob at @p _extent, or std::nullopt if it could not be read back.
+    std::optional<std::vector<uint8_t>> load(Extent const& _extent) const;
+
+    /// Frees the space of the blob at @p _extent, to be reused by subsequently stored blobs.
+    void release(Extent const& _extent);
+
+    /// @returns the number of compressed bytes currently stored.
+    size_t size() const noexcept { return size_; }
+
+    /// @returns the number of bytes the blobs were occupying before compression.
+    size_t rawSize() const noexcept { return rawSize_; }
+
+  private:
+    void close() noexcept;
+
+    size_t size_ = 0;
+    size_t rawSize_ = 0;
+
+#if defined(__unix__) || defined(__APPLE__)
+    bool open();
+    std::optional<uint64_t> allocate(uint64_t _length);
+
+    int fd_ = -1;
+    uint64_t fileSize_ = 0;
+
+    /// Unused regions of the file, offset mapped to length, both multiples of the system page size.
+    std::map<uint64_t, uint64_t> freeRegions_;
+#else
+    uint64_t nextOffset_ = 0;
+    std::map<uint64_t, std::vector<uint8_t>> blobs_;
+#endif
+};
+
+} // end namespace
@@ -34,7 +34,8 @@ Terminal::Terminal(Size _winSize,
                    chrono::milliseconds _cursorBlinkInterval,
                    chrono::steady_clock::time_point _now,
                    Logger _logger,
-                   string const& _wordDelimiters
+                   string const& _wordDelimiters,
+                   IoReactor* _ioReactor
 ) :
     changes_{ 0 },
     eventListener_{ _eventListener },
@@ -48,6 +49,7 @@ Terminal::Terminal(Size _winSize,
     startTime_{ _now },
     wordDelimiters_{ unicode::from_utf8(_wordDelimiters) },
     inputGenerator_{},
+    inputWriter_{ pty_ },
     screen_{
         _winSize,
         *this,
@@ -56,35 +58,114 @@ Terminal::Terminal(Size _winSize,
         true, // logs trace output by default?
         _maxHistoryLineCount
     },
-    screenUpdateThread_{ [this]() { screenUpdateThread(); } }
+    outputReader_{ pty_ },
+    outputParser_{ logger_ },
+    ioReactor_{ _ioReactor }
 {
+    if (ioReactor_)
+        ioSource_ = ioReactor_->add(pty_, [this](size_t _byteBudget) { return handleOutput(_byteBudget); });
+    else
+    {
+        screenUpdateThread_ = thread{ [this]() { screenUpdateThread(); } };
+        outputThread_ = thread{ [this]() { outputThread(); } };
+    }
 }
 
 Terminal::~Terminal()
 {
-    screenUpdateThread_.join();
+    if (ioReactor_)
+        ioReactor_->remove(ioSource_);
+    else
+    {
+        outputThread_.join();
+        screenUpdateThread_.join();
+    }
 }
 
-void Terminal::screenUpdateThread()
+void Terminal::parseOutput(string_view _chunk, CommandList& _commands)
 {
-    constexpr size_t BufSize = 32 * 1024;
-    vector<char> buf;
-    buf.resize(BufSize);
+#if defined(LIBTERMINAL_LOG_RAW)
+    if (screen_.logRaw() && logger_)
+        logger_(RawOutputEvent{ crispy::escape(_chunk.begin(), _chunk.end()) });
+#endif
 
-    for (;;)
+    outputParser_.setMaxPayloadSize(maxPayloadSize_.load());
+    outputParser_.parse(_chunk.data(), _chunk.size(), _commands);
+}
+
+void Terminal::outputThread()
+{
+    while (auto const chunk = outputReader_.read())
+    {
+        // Parsing is done without locking, concurrently to the previous batch being applied.
+        parseOutput(*chunk, outputQueue_.wait_back());
+        outputQueue_.push();
+    }
+
+    outputQueue_.close();
+}
+
+void Terminal::screenUpdateThread()
+{
+    while (outputQueue_.wait_front())
     {
-        if (auto const n = pty_.read(buf.data(), buf.size()); n != -1)
         {
-            //log("outputThread.data: {}", crispy::escape(buf, buf + n));
             lock_guard<decltype(screenLock_)> _l{ screenLock_ };
-            screen_.write(buf.data(), n);
+
+            // Applies what has been queued up so far before publishing it in one go,
+            // but not what keeps coming in meanwhile, which would hold the lock for too long.
+            for (auto n = outputQueue_.size(); n != 0; --n)
+            {
+                screen_.write(*outputQueue_.try_front());
+                outputQueue_.pop();
+            }
+
+            publishSnapshot();
         }
-        else
+
+        // Only now a frame being requested is guaranteed to render what has just been written.
+        eventListener_.screenUpdated();
+    }
+
+    eventListener_.onClosed();
+}
+
+bool Terminal::handleOutput(size_t _byteBudget)
+{
+    // Locks for applying chunk by chunk only, and publishes the snapshot once at the end of the turn.
+    size_t consumed = 0;
+    bool open = true;
+    while (consumed < _byteBudget)
+    {
+        auto const chunk = outputReader_.readAvailable(_byteBudget - consumed);
+        if (!chunk)
         {
-            eventListener_.onClosed();
+            open = false;
             break;
         }
+        if (chunk->empty())
+            break;
+
+        parseOutput(*chunk, outputCommands_);
+        consumed += chunk->size();
+
+        lock_guard<decltype(screenLock_)> _l{ screenLock_ };
+        screen_.write(outputCommands_);
+    }
+
+    if (consumed != 0)
+    {
+        {
+            lock_guard<decltype(screenLock_)> _l{ screenLock_ };
+            publishSnapshot();
+        }
+        eventListener_.screenUpdated();
     }
+
+    if (!open)
+        eventListener_.onClosed();
+
+    return open;
 }
 
 bool Terminal::send(KeyInputEvent const& _keyEvent, chrono::steady_clock::time_point _now)
@@ -158,6 +239,8 @@ bool Terminal::send(MousePressEvent const& _mousePress, chrono::steady_clock::ti
                     return Selector::Mode::Linear;
             }(speedClicks_, _mousePress.modifier);
 
+            // Selecting reads (and may swap in) scrollback lines.
+            lock_guard<decltype(screenLock_)> _l{ screenLock_ };
             changes_++;
             if (!screen_.selectionAvailable()
                 || screen_.selector()->state() == Selector::State::Waiting
@@ -194,6 +277,11 @@ bool Terminal::send(MouseMoveEvent const& _mouseMove, chrono::steady_clock::time
 
     currentMousePosition_ = newPosition;
 
+    {
+        lock_guard<decltype(screenLock_)> _l{ screenLock_ };
+        updateHoveredHyperlink();
+    }
+
     if (inputGenerator_.generate(_mouseMove))
     {
         flushInput();
@@ -202,6 +290,7 @@ bool Terminal::send(MouseMoveEvent const& _mouseMove, chrono::steady_clock::time
 
     speedClicks_ = 0;
 
+    lock_guard<decltype(screenLock_)> _l{ screenLock_ };
     if (leftMouseButtonPressed_ && !screen_.selectionAvailable())
     {
         screen_.setSelector(make_unique<Selector>(
@@ -299,22 +388,49 @@ bool Terminal::send(InputEvent const& _inputEvent, chrono::steady_clock::time_po
 
 void Terminal::sendPaste(string_view const& _text)
 {
-    inputGenerator_.generatePaste(_text);
-    flushInput();
+    auto text = _text;
+    while (!text.empty())
+    {
+        // Chunks end at a character boundary, so that the application can decode each one on its own.
+        auto const continuesCharacter = [&](size_t i) { return (static_cast<uint8_t>(text[i]) & 0xC0) == 0x80; };
+        auto length = min(text.size(), inputWriter_.pasteChunkSize());
+        while (length > 0 && length < text.size() && continuesCharacter(length))
+            --length;
+
+        // A chunk smaller than the first character is extended to the end of it instead.
+        if (length == 0)
+        {
+            length = 1;
+            while (length < text.size() && continuesCharacter(length))
+                ++length;
+        }
+
+        inputGenerator_.generatePaste(text.substr(0, length));
+        inputGenerator_.swap(pendingInput_);
+        inputWriter_.paste(string_view(pendingInput_.data(), pendingInput_.size()));
+        logger_(RawInputEvent{crispy::escape(begin(pendingInput_), end(pendingInput_))});
+        pendingInput_.clear();
+
+        text.remove_prefix(length);
+    }
 }
 
 void Terminal::flushInput()
 {
     inputGenerator_.swap(pendingInput_);
-    pty_.write(pendingInput_.data(), pendingInput_.size());
+    inputWriter_.write(string_view(pendingInput_.data(), pendingInput_.size()));
     logger_(RawInputEvent{crispy::escape(begin(pendingInput_), end(pendingInput_))});
     pendingInput_.clear();
 }
 
 void Terminal::writeToScreen(char const* data, size_t size)
 {
-    lock_guard<decltype(screenLock_)> _l{ screenLock_ };
-    screen_.write(data, size);
+    {
+        lock_guard<decltype(screenLock_)> _l{ screenLock_ };
+        screen_.write(data, size);
+        publishSnapshot();
+    }
+    eventListener_.screenUpdated();
 }
 
 Cursor Terminal::cursor() const
@@ -336,6 +452,57 @@ bool Terminal::shouldRender(chrono::steady_clock::time_point const& _now) const
         chrono::duration_cast<chrono::milliseconds>(_now - lastCursorBlink_) >= cursorBlinkInterval());
 }
 
+void Terminal::updateHoveredHyperlink()
+{
+    auto const hyperlink = screen_.contains(currentMousePosition_)
+                         ? screen_.at(currentMousePosition_).cell().hyperlinkId()
+                         : Cell::HyperlinkId{0};
+    if (hyperlink == hoveredHyperlink_)
+        return;
+
+    // Both the previously and the newly hovered hyperlink change their looks.
+    screen_.markHyperlinkDamaged(hoveredHyperlink_);
+    screen_.markHyperlinkDamaged(hyperlink);
+    hoveredHyperlink_ = hyperlink;
+    changes_++;
+}
+
+void Terminal::publishSnapshot()
+{
+    snapshots_[updateSnapshot_].update(screen_, hoveredHyperlink_);
+    snapshots_[updateSnapshot_].setCursorStyle(cursorDisplay_, cursorShape_);
+    updateSnapshot_ = publishedSnapshot_.exchange(updateSnapshot_ | FreshSnapshot) & ~FreshSnapshot;
+}
+
+ScreenSnapshot const& Terminal::snapshot(chrono::steady_clock::time_point _now)
+{
+    if (auto _l = unique_lock{screenLock_, try_to_lock}; _l.owns_lock())
+    {
+        // Snapshots are only published when having locked, so a fresh one is newer than ours,
+        // leaving less to be updated.
+        if (publishedSnapshot_.load() & FreshSnapshot)
+            renderSnapshot_ = publishedSnapshot_.exchange(renderSnapshot_) & ~FreshSnapshot;
+        snapshots_[renderSnapshot_].update(screen_, hoveredHyperlink_);
+        snapshots_[renderSnapshot_].setCursorStyle(cursorDisplay_, cursorShape_);
+    }
+    else if (publishedSnapshot_.load() & FreshSnapshot)
+        renderSnapshot_ = publishedSnapshot_.exchange(renderSnapshot_) & ~FreshSnapshot;
+
+    // The blink phase is kept by the render thread itself.
+    updateCursorVisibilityState(_now);
+    snapshots_[renderSnapshot_].setCursorBlinkPhase(cursorBlinkState_ != 0);
+
+    return snapshots_[renderSnapshot_];
+}
+
+std::vector<cursor_pos_t> Terminal::damagedLines(uint64_t& _generation)
+{
+    lock_guard<decltype(screenLock_)> _l{ screenLock_ };
+    auto rows = screen_.damagedLines(_generation);
+    _generation = screen_.advanceDamageGeneration();
+    return rows;
+}
+
 void Terminal::updateCursorVisibilityState(std::chrono::steady_clock::time_point _now) const
 {
     auto const diff = chrono::duration_cast<chrono::milliseconds>(_now - lastCursorBlink_);
@@ -355,13 +522,13 @@ std::chrono::milliseconds Terminal::nextRender(chrono::steady_clock::time_point
         return chrono::milliseconds::min();
 }
 
-Cell const* Terminal::at(Coordinate const& _coord) const
+std::optional<CellView> Terminal::at(Coordinate const& _coord) const
 {
     lock_guard<decltype(screenLock_)> _l{ screenLock_ };
     if (-screen_.historyLineCount() < _coord.row && _coord.row <= screen_.size().height)
-        return &screen_.at(_coord);
+        return screen_.at(_coord);
     else
-        return nullptr;
+        return std::nullopt;
 }
 
 void Terminal::resizeScreen(Size _cells, optional<Size> _pixels)
@@ -430,7 +597,7 @@ void Terminal::notify(std::string_view const& _title, std::string_view const& _b
 
 void Terminal::reply(string_view const& reply)
 {
-    pty_.write(reply.data(), reply.size());
+    inputWriter_.write(reply);
 }
 
 void Terminal::resetDynamicColor(DynamicColorName _name)
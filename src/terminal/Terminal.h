@@ -13,20 +13,29 @@
  */
 #pragma once
 
+#include <terminal/CommandBuilder.h>
 #include <terminal/Commands.h>
 #include <terminal/Logger.h>
 #include <terminal/InputGenerator.h>
+#include <terminal/IoReactor.h>
 #include <terminal/PseudoTerminal.h>
+#include <terminal/PtyReader.h>
+#include <terminal/PtyWriter.h>
 #include <terminal/ScreenEvents.h>
 #include <terminal/Screen.h>
+#include <terminal/ScreenSnapshot.h>
+
+#include <crispy/spsc_queue.h>
 
 #include <fmt/format.h>
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string_view>
 #include <thread>
 #include <vector>
@@ -56,6 +65,8 @@ class Terminal : public ScreenEvents {
         virtual void onSelectionComplete() {}
         virtual void resetDynamicColor(DynamicColorName /*_name*/) {}
         virtual void resizeWindow(int /*_width*/, int /*_height*/, bool /*_unitInPixels*/) {}
+        /// Invoked once updates to the screen have been published for rendering, see snapshot().
+        virtual void screenUpdated() {}
         virtual void setDynamicColor(DynamicColorName, RGBColor const&) {}
         virtual void setWindowTitle(std::string_view const& /*_title*/) {}
     };
@@ -66,7 +77,8 @@ class Terminal : public ScreenEvents {
              std::chrono::milliseconds _cursorBlinkInterval = std::chrono::milliseconds{500},
              std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now(),
              Logger _logger = {},
-             std::string const& _wordDelimiters = "");
+             std::string const& _wordDelimiters = "",
+             IoReactor* _ioReactor = nullptr);
     ~Terminal();
 
     /// Retrieves the time point this terminal instance has been spawned.
@@ -92,14 +104,40 @@ class Terminal : public ScreenEvents {
     bool send(InputEvent const& _inputEvent, std::chrono::steady_clock::time_point _now);
 
     /// Sends verbatim text in bracketed mode to application.
+    ///
+    /// The text is sent in chunks, each one bracketed on its own, with other input taking priority.
     void sendPaste(std::string_view const& _text);
+    void setPasteChunkSize(size_t _value) { inputWriter_.setPasteChunkSize(_value); }
+    void setPasteChunkInterval(std::chrono::milliseconds _value) { inputWriter_.setPasteChunkInterval(_value); }
     // }}}
 
     // {{{ screen proxy
     void setLogTraceOutput(bool _enabled) { screen_.setLogTrace(_enabled); }
     void setLogRawOutput(bool _enabled) { screen_.setLogRaw(_enabled); }
+    void setCommandRecording(bool _enabled) { screen_.setCommandRecording(_enabled); }
     void setTabWidth(int _tabWidth) { screen_.setTabWidth(_tabWidth); }
+    void setMaxPayloadSize(size_t _value)
+    {
+        // The output parser is in use by the output thread, which picks the new limit up by itself.
+        maxPayloadSize_ = _value;
+        auto _l = std::lock_guard{*this};
+        screen_.setMaxPayloadSize(_value);
+    }
+    void setMaxReadBufferSize(size_t _value) { outputReader_.setMaxBufferSize(_value); }
+    void setReadLatency(std::chrono::milliseconds _value) { outputReader_.setLatency(_value); }
+    /// Thread-safe query of the rate the application's output is read at.
+    PtyReader::Statistics outputStatistics() const noexcept { return outputReader_.statistics(); }
     void setMaxHistoryLineCount(std::optional<size_t> _maxHistoryLineCount) { screen_.setMaxHistoryLineCount(_maxHistoryLineCount); }
+    void setMaxResidentHistoryLineCount(std::optional<size_t> _count)
+    {
+        auto _l = std::lock_guard{*this};
+        screen_.setMaxResidentHistoryLineCount(_count);
+    }
+    void setMaxHistoryBytes(std::optional<size_t> _bytes)
+    {
+        auto _l = std::lock_guard{*this};
+        screen_.setMaxHistoryBytes(_bytes);
+    }
     int historyLineCount() const noexcept { return screen_.historyLineCount(); }
     std::string const& windowTitle() const noexcept { return screen_.windowTitle(); }
     ScreenBuffer::Type screenBufferType() const noexcept { return screen_.bufferType(); }
@@ -110,8 +148,8 @@ class Terminal : public ScreenEvents {
     /// @returns the current Cursor state.
     Cursor cursor() const;
 
-    /// @returns a reference to the cell at the given coordinate.
-    Cell const* at(Coordinate const& _coord) const;
+    /// @returns a view of the cell at the given coordinate, if inside screen or scrollback.
+    std::optional<CellView> at(Coordinate const& _coord) const;
 
     /// @returns absolute coordinate of @p _pos with scroll offset and applied.
     Coordinate absoluteCoordinate(Coordinate const& _pos) const noexcept
@@ -130,12 +168,13 @@ class Terminal : public ScreenEvents {
     // viewport management
     bool isLineVisible(cursor_pos_t _row) const noexcept { return screen_.isLineVisible(_row); }
     int scrollOffset() const noexcept { return screen_.scrollOffset(); }
-    bool scrollUp(int _numLines) { return screen_.scrollUp(_numLines); }
-    bool scrollDown(int  _numLines) { return screen_.scrollDown(_numLines); }
-    bool scrollToTop() { return screen_.scrollToTop(); }
-    bool scrollToBottom() { return screen_.scrollToBottom(); }
-    bool scrollMarkUp() { return screen_.scrollMarkUp(); }
-    bool scrollMarkDown() { return screen_.scrollMarkDown(); }
+    // Scrolling may swap scrollback pages in and out, so it must be done when having locked.
+    bool scrollUp(int _numLines) { auto _l = std::lock_guard{*this}; return screen_.scrollUp(_numLines); }
+    bool scrollDown(int  _numLines) { auto _l = std::lock_guard{*this}; return screen_.scrollDown(_numLines); }
+    bool scrollToTop() { auto _l = std::lock_guard{*this}; return screen_.scrollToTop(); }
+    bool scrollToBottom() { auto _l = std::lock_guard{*this}; return screen_.scrollToBottom(); }
+    bool scrollMarkUp() { auto _l = std::lock_guard{*this}; return screen_.scrollMarkUp(); }
+    bool scrollMarkDown() { auto _l = std::lock_guard{*this}; return screen_.scrollMarkDown(); }
     // }}}
 
     // {{{ Screen Render Proxy
@@ -145,22 +184,37 @@ class Terminal : public ScreenEvents {
 
     std::chrono::milliseconds nextRender(std::chrono::steady_clock::time_point _now) const;
 
-    /// Thread-safe access to screen data for rendering.
+    /// Thread-safe access to screen data for rendering, see snapshot().
     template <typename... RenderPasses>
-    uint64_t render(std::chrono::steady_clock::time_point _now, Screen::Renderer const& pass, RenderPasses... passes) const
+    uint64_t render(std::chrono::steady_clock::time_point _now, Screen::Renderer const& pass, RenderPasses... passes)
     {
-        auto _l = std::lock_guard{*this};
         auto const changes = preRender(_now);
-        renderPass(pass, std::forward<RenderPasses>(passes)...);
+        renderPass(snapshot(_now), pass, std::forward<RenderPasses>(passes)...);
         return changes;
     }
 
+    /// @returns the most recent snapshot of the screen, to be rendered without locking.
+    ///
+    /// If the screen is not being written to, the snapshot is brought up to date right away,
+    /// otherwise the one published by the screen update thread after its last write is returned.
+    /// Either way, this never waits for the screen update thread, nor does that thread wait for rendering.
+    /// The cursor's blink phase is advanced to @p _now.
+    ///
+    /// Must only be called by the render thread. The snapshot remains unchanged until the next call.
+    ScreenSnapshot const& snapshot(std::chrono::steady_clock::time_point _now);
+
     uint64_t preRender(std::chrono::steady_clock::time_point _now) const
     {
         auto const changes = changes_.exchange(0);
         updateCursorVisibilityState(_now);
         return changes;
     }
+
+    /// Thread-safe query of the screen lines changed since damage generation @p _generation,
+    /// which is advanced to the generation to be passed in next time.
+    ///
+    /// Pass in 0 at first, to get all lines.
+    std::vector<cursor_pos_t> damagedLines(uint64_t& _generation);
     // }}}
 
     void lock() const { screenLock_.lock(); }
@@ -181,7 +235,13 @@ class Terminal : public ScreenEvents {
 
     bool shouldDisplayCursor() const noexcept
     {
-        return cursor().visible && (cursorDisplay_ != CursorDisplay::Blink || cursorBlinkState_);
+        return cursor().visible && isCursorBlinkVisible();
+    }
+
+    /// Tests whether a visible cursor is to be displayed in the current blink phase.
+    bool isCursorBlinkVisible() const noexcept
+    {
+        return cursorDisplay_ != CursorDisplay::Blink || cursorBlinkState_;
     }
 
     std::chrono::steady_clock::time_point lastCursorBlink() const noexcept
@@ -205,20 +265,26 @@ class Terminal : public ScreenEvents {
 
   private:
     void flushInput();
+    void parseOutput(std::string_view _chunk, CommandList& _commands);
+    void outputThread();
     void screenUpdateThread();
+    bool handleOutput(size_t _byteBudget);
     void onScreenReply(std::string_view const& reply);
     void onScreenCommands(std::vector<Command> const& commands);
     void updateCursorVisibilityState(std::chrono::steady_clock::time_point _now) const;
+    void updateHoveredHyperlink();
 
     template <typename... RemainingPasses>
-    void renderPass(Screen::Renderer const& pass, RemainingPasses... remainingPasses) const
+    void renderPass(ScreenSnapshot const& _snapshot, Screen::Renderer const& pass, RemainingPasses... remainingPasses) const
     {
-        screen_.render(pass, screen_.scrollOffset());
+        _snapshot.render(pass);
 
         if constexpr (sizeof...(RemainingPasses) != 0)
-            renderPass(std::forward<RemainingPasses>(remainingPasses)...);
+            renderPass(_snapshot, std::forward<RemainingPasses>(remainingPasses)...);
     }
 
+    void publishSnapshot();
+
   private:
     std::optional<RGBColor> requestDynamicColor(DynamicColorName _name) override;
     void bell() override;
@@ -250,8 +316,9 @@ class Terminal : public ScreenEvents {
     Logger logger_;
     PseudoTerminal pty_;
 
-    CursorDisplay cursorDisplay_;
-    CursorShape cursorShape_;
+    // Set by the application as well as by the user, and captured into the snapshots.
+    std::atomic<CursorDisplay> cursorDisplay_;
+    std::atomic<CursorShape> cursorShape_;
     std::chrono::milliseconds cursorBlinkInterval_;
 	mutable unsigned cursorBlinkState_;
 	mutable std::chrono::steady_clock::time_point lastCursorBlink_;
@@ -266,13 +333,38 @@ class Terminal : public ScreenEvents {
     unsigned int speedClicks_ = 0;
 
     terminal::Coordinate currentMousePosition_{0, 0}; // current mouse position
+    Cell::HyperlinkId hoveredHyperlink_ = 0; // hyperlink at the current mouse position, rendered as hovered
     bool leftMouseButtonPressed_ = false; // tracks left-mouse button pressed state (used for cell selection).
 
     InputGenerator inputGenerator_;
     InputGenerator::Sequence pendingInput_;
+    PtyWriter inputWriter_;
     Screen screen_;
     std::recursive_mutex mutable screenLock_;
+
+    // The application's output is read and parsed by the output thread, without locking,
+    // and handed over to the screen update thread in batches of commands to be applied to the screen.
+    // When using a shared I/O reactor instead, both is done by turns of the reactor's threads.
+    static constexpr size_t OutputQueueCapacity = 4;
+    PtyReader outputReader_;
+    CommandParser outputParser_;
+    std::atomic<size_t> maxPayloadSize_{Sequence::DefaultMaxPayloadSize};
+    crispy::spsc_queue<CommandList> outputQueue_{OutputQueueCapacity};
+    IoReactor* ioReactor_;
+    IoReactor::SourceId ioSource_ = 0;
+    CommandList outputCommands_; // batch of commands parsed during a turn of the I/O reactor
+
+    // Triple buffered snapshots of the screen, one being updated by whoever writes to the screen
+    // (when having locked), one being rendered, and the one published last in between,
+    // handed over by atomic exchange.
+    static constexpr unsigned FreshSnapshot = 0x100; // flags the published snapshot as not taken yet
+    std::array<ScreenSnapshot, 3> snapshots_;
+    unsigned updateSnapshot_ = 0;
+    unsigned renderSnapshot_ = 1;
+    std::atomic<unsigned> publishedSnapshot_{2};
+
     std::thread screenUpdateThread_;
+    std::thread outputThread_;
 };
 
 }  // namespace terminal
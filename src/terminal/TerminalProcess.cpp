@@ -25,7 +25,8 @@ TerminalProcess::TerminalProcess(Process::ExecInfo const& _shell,
                                  string const& _wordDelimiters,
                                  CursorDisplay _cursorDisplay,
                                  CursorShape _cursorShape,
-                                 Logger _logger) :
+                                 Logger _logger,
+                                 IoReactor* _ioReactor) :
     Terminal(
         _winSize,
         _eventListener,
@@ -33,7 +34,8 @@ TerminalProcess::TerminalProcess(Process::ExecInfo const& _shell,
         _cursorBlinkInterval,
         _now,
         move(_logger),
-        _wordDelimiters
+        _wordDelimiters,
+        _ioReactor
     ),
     Process{_shell, terminal().device()}
 {
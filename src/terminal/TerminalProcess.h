@@ -31,7 +31,8 @@ class TerminalProcess : public Terminal, public Process {
         std::string const& _wordDelimiters,
         CursorDisplay _cursorDisplay,
         CursorShape _cursorShape,
-        Logger _logger
+        Logger _logger,
+        IoReactor* _ioReactor = nullptr
     );
 
     ~TerminalProcess();
@@ -0,0 +1,370 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/UTF8Decoder.h>
+
+#include <array>
+#include <variant>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define LIBTERMINAL_UTF8_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
+
+// GCC and Clang only allow intrinsics of instruction sets enabled for the function using them,
+// whereas MSVC always does.
+#if defined(LIBTERMINAL_UTF8_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define LIBTERMINAL_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define LIBTERMINAL_TARGET(isa)
+#endif
+
+using namespace std;
+
+namespace terminal {
+
+namespace {
+    /// Sequence length by the 5 most significant bits of the lead byte, or 0 if not a lead byte.
+    ///
+    /// Just like unicode::from_utf8(), this does not reject overlong leads (0xC0, 0xC1)
+    /// nor leads beyond U+10FFFF (0xF5..0xF7).
+    constexpr auto SequenceLength = array<uint8_t, 32>{
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0xxxxxxx
+        0, 0, 0, 0, 0, 0, 0, 0,                         // 10xxxxxx
+        2, 2, 2, 2,                                     // 110xxxxx
+        3, 3,                                           // 1110xxxx
+        4,                                              // 11110xxx
+        0,                                              // 11111xxx
+    };
+
+    /// Decodes the sequence of @p _length bytes at @p _input.
+    ///
+    /// Continuation bytes are not validated, as unicode::from_utf8() does not either.
+    inline char32_t decodeSequence(uint8_t const* _input, size_t _length) noexcept
+    {
+        switch (_length)
+        {
+            case 1:
+                return _input[0];
+            case 2:
+                return (char32_t(_input[0] & 0x1F) << 6)
+                     | (_input[1] & 0x3F);
+            case 3:
+                return (char32_t(_input[0] & 0x0F) << 12)
+                     | (char32_t(_input[1] & 0x3F) << 6)
+                     | (_input[2] & 0x3F);
+            default:
+                return (char32_t(_input[0] & 0x07) << 18)
+                     | (char32_t(_input[1] & 0x3F) << 12)
+                     | (char32_t(_input[2] & 0x3F) << 6)
+                     | (_input[3] & 0x3F);
+        }
+    }
+
+    /// Decodes a single sequence, or replaces an invalid lead byte.
+    ///
+    /// @returns false if the sequence is incomplete, leaving @p _input and @p _output untouched.
+    inline bool decodeOne(uint8_t const*& _input, uint8_t const* _end, char32_t*& _output, size_t& _invalidCount) noexcept
+    {
+        auto const length = SequenceLength[*_input >> 3];
+        if (length == 0)
+        {
+            *_output++ = UTF8Decoder::ReplacementCharacter;
+            ++_input;
+            ++_invalidCount;
+            return true;
+        }
+
+        if (static_cast<size_t>(_end - _input) < length)
+            return false;
+
+        *_output++ = decodeSequence(_input, length);
+        _input += length;
+        return true;
+    }
+
+    size_t decodeScalar(uint8_t const*& _input, uint8_t const* _end, char32_t*& _output) noexcept
+    {
+        size_t invalidCount = 0;
+        while (_input != _end && decodeOne(_input, _end, _output, invalidCount))
+            ;
+        return invalidCount;
+    }
+
+#if defined(LIBTERMINAL_UTF8_X86)
+    inline unsigned countTrailingZeros(uint32_t _value) noexcept
+    {
+    #if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, _value);
+        return static_cast<unsigned>(index);
+    #else
+        return static_cast<unsigned>(__builtin_ctz(_value));
+    #endif
+    }
+
+    // The shuffles below move the bytes of one sequence into each 32-bit lane, last byte first,
+    // so that the lead byte ends up as the most significant one (0x80 selects zero).
+    size_t LIBTERMINAL_TARGET("sse4.1") decodeSSE41(uint8_t const*& _input, uint8_t const* _end, char32_t*& _output) noexcept
+    {
+        auto const shuffle2 = _mm_setr_epi8(1, 0, char(0x80), char(0x80), 3, 2, char(0x80), char(0x80),
+                                            5, 4, char(0x80), char(0x80), 7, 6, char(0x80), char(0x80));
+        auto const shuffle3 = _mm_setr_epi8(2, 1, 0, char(0x80), 5, 4, 3, char(0x80),
+                                            8, 7, 6, char(0x80), 11, 10, 9, char(0x80));
+
+        size_t invalidCount = 0;
+        while (_end - _input >= 16)
+        {
+            auto const batch = _mm_loadu_si128(reinterpret_cast<__m128i const*>(_input));
+            auto const nonASCII = static_cast<uint32_t>(_mm_movemask_epi8(batch));
+
+            // Widen all 16 bytes, but only keep the leading US-ASCII ones.
+            // This may write beyond the decoded codepoints, but not beyond what _output must provide.
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(_output + 0), _mm_cvtepu8_epi32(batch));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(_output + 4), _mm_cvtepu8_epi32(_mm_srli_si128(batch, 4)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(_output + 8), _mm_cvtepu8_epi32(_mm_srli_si128(batch, 8)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(_output + 12), _mm_cvtepu8_epi32(_mm_srli_si128(batch, 12)));
+            if (nonASCII == 0)
+            {
+                _input += 16;
+                _output += 16;
+                continue;
+            }
+            if (auto const ascii = countTrailingZeros(nonASCII); ascii != 0)
+            {
+                _input += ascii;
+                _output += ascii;
+                continue;
+            }
+
+            // Four 3-byte sequences in a row (CJK and most symbols).
+            auto const leads3 = static_cast<uint32_t>(_mm_movemask_epi8(
+                _mm_cmpeq_epi8(_mm_and_si128(batch, _mm_set1_epi8(char(0xF0))), _mm_set1_epi8(char(0xE0)))));
+            if ((leads3 & 0x249) == 0x249)
+            {
+                auto const lanes = _mm_and_si128(_mm_shuffle_epi8(batch, shuffle3), _mm_set1_epi32(0x000F3F3F));
+                auto const codepoints = _mm_or_si128(
+                    _mm_or_si128(_mm_and_si128(lanes, _mm_set1_epi32(0x3F)),
+                                 _mm_and_si128(_mm_srli_epi32(lanes, 2), _mm_set1_epi32(0xFC0))),
+                    _mm_and_si128(_mm_srli_epi32(lanes, 4), _mm_set1_epi32(0xF000)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(_output), codepoints);
+                _input += 12;
+                _output += 4;
+                continue;
+            }
+
+            // Four 2-byte sequences in a row (Latin-1 supplement, Greek, Cyrillic, ...).
+            auto const leads2 = static_cast<uint32_t>(_mm_movemask_epi8(
+                _mm_cmpeq_epi8(_mm_and_si128(batch, _mm_set1_epi8(char(0xE0))), _mm_set1_epi8(char(0xC0)))));
+            if ((leads2 & 0x55) == 0x55)
+            {
+                auto const lanes = _mm_and_si128(_mm_shuffle_epi8(batch, shuffle2), _mm_set1_epi32(0x1F3F));
+                auto const codepoints = _mm_or_si128(_mm_and_si128(lanes, _mm_set1_epi32(0x3F)),
+                                                     _mm_and_si128(_mm_srli_epi32(lanes, 2), _mm_set1_epi32(0x7C0)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(_output), codepoints);
+                _input += 8;
+                _output += 4;
+                continue;
+            }
+
+            // Any other sequence is always complete here, as at least 16 bytes are available.
+            decodeOne(_input, _end, _output, invalidCount);
+        }
+
+        return invalidCount + decodeScalar(_input, _end, _output);
+    }
+
+    /// Loads 16 bytes from @p _input into the lower, and from @p _input + @p _offset into the upper lane.
+    inline __m256i LIBTERMINAL_TARGET("avx2") loadLanes(uint8_t const* _input, size_t _offset) noexcept
+    {
+        return _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const*>(_input))),
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(_input + _offset)),
+            1);
+    }
+
+    size_t LIBTERMINAL_TARGET("avx2") decodeAVX2(uint8_t const*& _input, uint8_t const* _end, char32_t*& _output) noexcept
+    {
+        // The same shuffle in both 128-bit lanes, as _mm256_shuffle_epi8() does not cross lanes.
+        auto const shuffle2 = _mm256_setr_epi8(1, 0, char(0x80), char(0x80), 3, 2, char(0x80), char(0x80),
+                                               5, 4, char(0x80), char(0x80), 7, 6, char(0x80), char(0x80),
+                                               1, 0, char(0x80), char(0x80), 3, 2, char(0x80), char(0x80),
+                                               5, 4, char(0x80), char(0x80), 7, 6, char(0x80), char(0x80));
+        auto const shuffle3 = _mm256_setr_epi8(2, 1, 0, char(0x80), 5, 4, 3, char(0x80),
+                                               8, 7, 6, char(0x80), 11, 10, 9, char(0x80),
+                                               2, 1, 0, char(0x80), 5, 4, 3, char(0x80),
+                                               8, 7, 6, char(0x80), 11, 10, 9, char(0x80));
+
+        size_t invalidCount = 0;
+        while (_end - _input >= 32)
+        {
+            auto const batch = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(_input));
+            auto const nonASCII = static_cast<uint32_t>(_mm256_movemask_epi8(batch));
+
+            for (int i = 0; i < 4; ++i)
+            {
+                auto const bytes = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(_input + 8 * i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(_output + 8 * i), _mm256_cvtepu8_epi32(bytes));
+            }
+            if (nonASCII == 0)
+            {
+                _input += 32;
+                _output += 32;
+                continue;
+            }
+            if (auto const ascii = countTrailingZeros(nonASCII); ascii != 0)
+            {
+                _input += ascii;
+                _output += ascii;
+                continue;
+            }
+
+            auto const leads3 = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_and_si256(batch, _mm256_set1_epi8(char(0xF0))), _mm256_set1_epi8(char(0xE0)))));
+            if ((leads3 & 0x249249) == 0x249249)
+            {
+                auto const lanes = _mm256_and_si256(_mm256_shuffle_epi8(loadLanes(_input, 12), shuffle3),
+                                                    _mm256_set1_epi32(0x000F3F3F));
+                auto const codepoints = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_and_si256(lanes, _mm256_set1_epi32(0x3F)),
+                                    _mm256_and_si256(_mm256_srli_epi32(lanes, 2), _mm256_set1_epi32(0xFC0))),
+                    _mm256_and_si256(_mm256_srli_epi32(lanes, 4), _mm256_set1_epi32(0xF000)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(_output), codepoints);
+                _input += 24;
+                _output += 8;
+                continue;
+            }
+
+            auto const leads2 = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_and_si256(batch, _mm256_set1_epi8(char(0xE0))), _mm256_set1_epi8(char(0xC0)))));
+            if ((leads2 & 0x5555) == 0x5555)
+            {
+                auto const lanes = _mm256_and_si256(_mm256_shuffle_epi8(loadLanes(_input, 8), shuffle2),
+                                                    _mm256_set1_epi32(0x1F3F));
+                auto const codepoints = _mm256_or_si256(
+                    _mm256_and_si256(lanes, _mm256_set1_epi32(0x3F)),
+                    _mm256_and_si256(_mm256_srli_epi32(lanes, 2), _mm256_set1_epi32(0x7C0)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(_output), codepoints);
+                _input += 16;
+                _output += 8;
+                continue;
+            }
+
+            decodeOne(_input, _end, _output, invalidCount);
+        }
+
+        return invalidCount + decodeSSE41(_input, _end, _output);
+    }
+#endif
+
+    UTF8Decoder::Implementation detectImplementation() noexcept
+    {
+#if defined(LIBTERMINAL_UTF8_X86) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return UTF8Decoder::Implementation::AVX2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return UTF8Decoder::Implementation::SSE41;
+#elif defined(LIBTERMINAL_UTF8_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        auto const maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        bool const sse41 = info[2] & (1 << 19);
+        bool const osAVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+
+        if (osAVX && maxLeaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5))
+                return UTF8Decoder::Implementation::AVX2;
+        }
+        if (sse41)
+            return UTF8Decoder::Implementation::SSE41;
+#endif
+        return UTF8Decoder::Implementation::Scalar;
+    }
+
+    UTF8Decoder::DecodeFunction decodeFunction(UTF8Decoder::Implementation _implementation) noexcept
+    {
+        switch (_implementation)
+        {
+#if defined(LIBTERMINAL_UTF8_X86)
+            case UTF8Decoder::Implementation::AVX2:
+                return &decodeAVX2;
+            case UTF8Decoder::Implementation::SSE41:
+                return &decodeSSE41;
+#endif
+            default:
+                return &decodeScalar;
+        }
+    }
+}
+
+UTF8Decoder::UTF8Decoder() noexcept :
+    UTF8Decoder(detect())
+{
+}
+
+UTF8Decoder::UTF8Decoder(Implementation _implementation) noexcept :
+    implementation_{ _implementation },
+    decode_{ decodeFunction(_implementation) }
+{
+}
+
+UTF8Decoder::Implementation UTF8Decoder::detect() noexcept
+{
+    static Implementation const best = detectImplementation();
+    return best;
+}
+
+bool UTF8Decoder::supported(Implementation _implementation) noexcept
+{
+    return static_cast<int>(_implementation) <= static_cast<int>(detect());
+}
+
+UTF8Decoder::Result UTF8Decoder::decode(uint8_t const* _begin, uint8_t const* _end, char32_t* _output) noexcept
+{
+    auto input = _begin;
+    auto output = _output;
+    size_t invalidCount = 0;
+
+    // Bytes around buffer boundaries go through the reference decoder, byte by byte.
+    auto const feed = [&](uint8_t _byte) {
+        auto const result = unicode::from_utf8(state_, _byte);
+        if (auto const success = get_if<unicode::Success>(&result); success != nullptr)
+            *output++ = success->value;
+        else if (holds_alternative<unicode::Invalid>(result))
+        {
+            *output++ = ReplacementCharacter;
+            ++invalidCount;
+        }
+    };
+
+    while (pending() && input != _end)
+        feed(*input++);
+
+    invalidCount += decode_(input, _end, output);
+
+    // Whatever is left is the beginning of an incomplete sequence.
+    while (input != _end)
+        feed(*input++);
+
+    return Result{static_cast<size_t>(output - _output), invalidCount};
+}
+
+}  // namespace terminal
@@ -0,0 +1,84 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <unicode/utf8.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace terminal {
+
+/// Decodes a stream of UTF-8 bytes into codepoints, one buffer at a time.
+///
+/// The result is exactly what feeding each byte to unicode::from_utf8() yields, with every
+/// Invalid result replaced by U+FFFD. A sequence that is incomplete at the end of a buffer
+/// is kept and completed by the next call to decode().
+///
+/// Runs of US-ASCII as well as runs of 2-byte and 3-byte sequences are decoded using SIMD,
+/// whereas the instruction set to use is detected at runtime.
+class UTF8Decoder {
+  public:
+    static constexpr char32_t ReplacementCharacter = 0xFFFD;
+
+    enum class Implementation {
+        Scalar,
+        SSE41,
+        AVX2,
+    };
+
+    /// Decodes all complete sequences from @p _input on, given that none is pending,
+    /// and advances @p _input and @p _output accordingly.
+    ///
+    /// @returns the number of invalid bytes replaced.
+    using DecodeFunction = size_t (*)(uint8_t const*& _input, uint8_t const* _end, char32_t*& _output) noexcept;
+
+    struct Result {
+        size_t count;        //!< number of codepoints written
+        size_t invalidCount; //!< number of those being U+FFFD due to invalid input
+    };
+
+    /// Constructs a decoder, using the best implementation supported by this CPU.
+    UTF8Decoder() noexcept;
+
+    /// Constructs a decoder using the given implementation, which must be supported.
+    explicit UTF8Decoder(Implementation _implementation) noexcept;
+
+    /// @returns whether or not the given implementation can be used on this CPU.
+    static bool supported(Implementation _implementation) noexcept;
+
+    /// @returns the best implementation supported by this CPU.
+    static Implementation detect() noexcept;
+
+    Implementation implementation() const noexcept { return implementation_; }
+
+    /// Decodes [_begin, _end) into @p _output.
+    ///
+    /// @p _output must provide room for at least (_end - _begin) codepoints,
+    /// as no byte produces more than one codepoint.
+    Result decode(uint8_t const* _begin, uint8_t const* _end, char32_t* _output) noexcept;
+
+    /// @returns whether or not an incomplete sequence is pending from the previous call.
+    bool pending() const noexcept { return state_.expectedLength != 0; }
+
+    /// Drops any pending incomplete sequence.
+    void reset() noexcept { state_ = {}; }
+
+  private:
+    Implementation implementation_;
+    DecodeFunction decode_;
+    unicode::utf8_decoder_state state_{};
+};
+
+}  // namespace terminal
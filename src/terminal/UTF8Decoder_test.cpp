@@ -0,0 +1,211 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/UTF8Decoder.h>
+
+#include <crispy/escape.h>
+
+#include <unicode/utf8.h>
+
+#include <catch2/catch.hpp>
+#include <fmt/format.h>
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace terminal;
+
+namespace
+{
+    auto constexpr Implementations = array{
+        UTF8Decoder::Implementation::Scalar,
+        UTF8Decoder::Implementation::SSE41,
+        UTF8Decoder::Implementation::AVX2,
+    };
+
+    /// Decodes @p _input byte by byte using the reference decoder.
+    u32string referenceDecode(string const& _input, size_t& _invalidCount, bool& _pending)
+    {
+        auto state = unicode::utf8_decoder_state{};
+        auto output = u32string{};
+        _invalidCount = 0;
+        for (char const ch : _input)
+        {
+            auto const result = unicode::from_utf8(state, static_cast<uint8_t>(ch));
+            if (auto const success = get_if<unicode::Success>(&result); success != nullptr)
+                output.push_back(success->value);
+            else if (holds_alternative<unicode::Invalid>(result))
+            {
+                output.push_back(UTF8Decoder::ReplacementCharacter);
+                ++_invalidCount;
+            }
+        }
+        _pending = state.expectedLength != 0;
+        return output;
+    }
+
+    /// Decodes @p _input in the given fragments, which must add up to the input's size.
+    u32string decode(UTF8Decoder& _decoder, string const& _input, vector<size_t> const& _fragments, size_t& _invalidCount)
+    {
+        auto output = u32string(_input.size(), U'\0');
+        auto const bytes = reinterpret_cast<uint8_t const*>(_input.data());
+        size_t offset = 0;
+        size_t count = 0;
+        _invalidCount = 0;
+        for (size_t const length : _fragments)
+        {
+            auto const result = _decoder.decode(bytes + offset, bytes + offset + length, output.data() + count);
+            count += result.count;
+            _invalidCount += result.invalidCount;
+            offset += length;
+        }
+        output.resize(count);
+        return output;
+    }
+
+    void appendUTF8(string& _output, char32_t _codepoint)
+    {
+        uint8_t bytes[4];
+        auto const length = unicode::to_utf8(_codepoint, bytes);
+        _output.append(reinterpret_cast<char const*>(bytes), length);
+    }
+
+    /// Generates text, mostly valid UTF-8 of all sequence lengths, in runs as well as mixed,
+    /// interspersed with control codes, stray continuation bytes, truncated sequences and garbage.
+    string generateInput(mt19937& _rng, size_t _tokenCount)
+    {
+        auto const pick = [&](unsigned a, unsigned b) { return uniform_int_distribution<unsigned>{a, b}(_rng); };
+
+        string output;
+        for (size_t i = 0; i < _tokenCount; ++i)
+        {
+            auto const runLength = pick(0, 3) == 0 ? pick(1, 40) : 1;
+            auto const kind = pick(0, 9);
+            for (unsigned k = 0; k < runLength; ++k)
+            {
+                switch (kind)
+                {
+                    case 0: case 1: case 2:
+                        output.push_back(static_cast<char>(pick(0x20, 0x7E)));
+                        break;
+                    case 3:
+                        appendUTF8(output, pick(0x80, 0x7FF));
+                        break;
+                    case 4:
+                        appendUTF8(output, pick(0x800, 0xFFFF));
+                        break;
+                    case 5:
+                        appendUTF8(output, pick(0x10000, 0x10FFFF));
+                        break;
+                    case 6:
+                        output.push_back(static_cast<char>(pick(0x00, 0x1F)));
+                        break;
+                    case 7:
+                        output.push_back(static_cast<char>(pick(0x80, 0xBF)));
+                        break;
+                    case 8:
+                    {
+                        string sequence;
+                        appendUTF8(sequence, pick(0x80, 0x10FFFF));
+                        output.append(sequence, 0, pick(1, static_cast<unsigned>(sequence.size())));
+                        break;
+                    }
+                    default:
+                        output.push_back(static_cast<char>(pick(0x00, 0xFF)));
+                        break;
+                }
+            }
+        }
+        return output;
+    }
+
+    vector<size_t> generateFragments(mt19937& _rng, size_t _size)
+    {
+        vector<size_t> fragments;
+        while (_size != 0)
+        {
+            size_t const maxLength = uniform_int_distribution<unsigned>{0, 3}(_rng) == 0 ? 7 : 300;
+            auto const length = min<size_t>(_size, uniform_int_distribution<size_t>{1, maxLength}(_rng));
+            fragments.push_back(length);
+            _size -= length;
+        }
+        return fragments;
+    }
+}
+
+TEST_CASE("UTF8Decoder.simple", "[UTF8Decoder]")
+{
+    for (auto const implementation : Implementations)
+    {
+        if (!UTF8Decoder::supported(implementation))
+            continue;
+
+        INFO(fmt::format("implementation: {}", static_cast<int>(implementation)));
+        auto decoder = UTF8Decoder{implementation};
+        size_t invalidCount = 0;
+
+        auto const text = string("Hello, \xC3\xB6\xE2\x82\xAC\xF0\x9F\x98\x80 World!"); // ö€😀
+        CHECK(decode(decoder, text, {text.size()}, invalidCount) == U"Hello, ö€\U0001F600 World!");
+        CHECK(invalidCount == 0);
+
+        // sequences split across calls
+        CHECK(decode(decoder, text, {8, 1, 1, 2, 3, text.size() - 15}, invalidCount) == U"Hello, ö€\U0001F600 World!");
+        CHECK(invalidCount == 0);
+        CHECK_FALSE(decoder.pending());
+
+        auto const incomplete = string("ab\xE2\x82");
+        CHECK(decode(decoder, incomplete, {incomplete.size()}, invalidCount) == U"ab");
+        CHECK(decoder.pending());
+        decoder.reset();
+        CHECK_FALSE(decoder.pending());
+
+        auto const invalid = string("a\x80\xFF" "b");
+        CHECK(decode(decoder, invalid, {invalid.size()}, invalidCount) == U"a\uFFFD\uFFFDb");
+        CHECK(invalidCount == 2);
+    }
+}
+
+TEST_CASE("UTF8Decoder.fuzz", "[UTF8Decoder]")
+{
+    auto rng = mt19937{4711};
+
+    for (int iteration = 0; iteration < 500; ++iteration)
+    {
+        auto const input = generateInput(rng, uniform_int_distribution<size_t>{1, 200}(rng));
+        auto const fragments = generateFragments(rng, input.size());
+
+        size_t expectedInvalidCount = 0;
+        bool expectedPending = false;
+        auto const expected = referenceDecode(input, expectedInvalidCount, expectedPending);
+
+        for (auto const implementation : Implementations)
+        {
+            if (!UTF8Decoder::supported(implementation))
+                continue;
+
+            INFO(fmt::format("iteration: {}, implementation: {}, input: {}",
+                             iteration, static_cast<int>(implementation), crispy::escape(input)));
+
+            auto decoder = UTF8Decoder{implementation};
+            size_t invalidCount = 0;
+            auto const actual = decode(decoder, input, fragments, invalidCount);
+
+            REQUIRE(actual == expected);
+            CHECK(invalidCount == expectedInvalidCount);
+            CHECK(decoder.pending() == expectedPending);
+        }
+    }
+}
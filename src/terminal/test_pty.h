@@ -0,0 +1,44 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+// Helpers shared by the unit tests driving a PseudoTerminal.
+
+#include <terminal/PseudoTerminal.h>
+
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace terminal::test {
+
+#if defined(__unix__) || defined(__APPLE__)
+/// Writes @p _text to the slave side of @p _pty, as the application would.
+inline bool writeToSlave(PseudoTerminal& _pty, std::string const& _text)
+{
+    size_t offset = 0;
+    while (offset < _text.size())
+    {
+        auto const rv = ::write(_pty.slave(), _text.data() + offset, _text.size() - offset);
+        if (rv <= 0)
+            return false;
+        offset += static_cast<size_t>(rv);
+    }
+    return true;
+}
+#endif
+
+} // end namespace
@@ -27,14 +27,20 @@ BackgroundRenderer::BackgroundRenderer(ScreenCoordinates const& _screenCoordinat
                                        OpenGLRenderer& _renderTarget) :
     screenCoordinates_{ _screenCoordinates },
     colorProfile_{ _colorProfile },
+    colorCache_{ colorProfile_ },
     renderTarget_{ _renderTarget }
 {
 }
 
-void BackgroundRenderer::renderCell(Coordinate const& _pos, Cell const& _cell)
+void BackgroundRenderer::setColorProfile(ColorProfile const& _colorProfile)
 {
-    RGBColor const color = _cell.attributes().makeColors(colorProfile_, false).second;
-    renderCell(_pos, color);
+    colorProfile_ = _colorProfile;
+    colorCache_.clear();
+}
+
+void BackgroundRenderer::renderCell(Coordinate const& _pos, CellView const& _cell)
+{
+    renderCell(_pos, colorCache_.colors(_cell).second);
 }
 
 void BackgroundRenderer::renderCell(Coordinate const& _pos, RGBColor const& _color)
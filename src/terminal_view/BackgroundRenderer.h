@@ -13,6 +13,7 @@
  */
 #pragma once
 
+#include <terminal_view/ColorCache.h>
 #include <terminal_view/ShaderConfig.h>
 
 #include <terminal/Screen.h>
@@ -41,7 +42,7 @@ class BackgroundRenderer {
     // because there is no need to detect bg/fg color more than once per grid cell!
 
     /// Queues up a render with given background
-    void renderCell(Coordinate const& _pos, Cell const& _cell);
+    void renderCell(Coordinate const& _pos, CellView const& _cell);
     void renderCell(Coordinate const& _pos, RGBColor const& _color);
 
     void renderOnce(Coordinate const& _pos, RGBColor const& _color, unsigned _count);
@@ -57,6 +58,7 @@ class BackgroundRenderer {
   private:
     ScreenCoordinates const& screenCoordinates_;
     ColorProfile colorProfile_; // TODO: make const&, maybe reference_wrapper<>?
+    ColorCache colorCache_;
     float opacity_ = 1.0f; // normalized opacity value between 0.0 .. 1.0
 
     // input state
@@ -0,0 +1,109 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Color.h>
+#include <terminal/ScreenBuffer.h>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace terminal::view {
+
+/// Caches the RGB colors resolved from a cell's graphics attributes, indexed by attributes ID.
+///
+/// Resolving colors means visiting up to three color variants and applying the color profile,
+/// which would otherwise be repeated for every cell of every frame, although a screen usually
+/// only uses a handful of distinct attributes.
+///
+/// The cache is dropped whenever the cells come from another pool (e.g. after switching to the
+/// alternate screen), the pool recycled IDs, or the color profile or reverse video mode changed.
+class ColorCache {
+  public:
+    using Colors = std::pair<RGBColor, RGBColor>;
+
+    /// @param _colorProfile color profile to resolve colors with. Must outlive this cache,
+    ///                      and clear() must be invoked whenever it changes.
+    explicit ColorCache(ColorProfile const& _colorProfile) : colorProfile_{_colorProfile} {}
+
+    void clear()
+    {
+        entries_.clear();
+    }
+
+    void setReverseVideo(bool _reverseVideo)
+    {
+        if (reverseVideo_ != _reverseVideo)
+        {
+            reverseVideo_ = _reverseVideo;
+            clear();
+        }
+    }
+
+    /// @returns foreground and background color of the given cell.
+    Colors const& colors(CellView const& _cell)
+    {
+        Entry& entry = lookup(_cell);
+        if (!entry.hasColors)
+        {
+            entry.colors = _cell.attributes().makeColors(colorProfile_.get(), reverseVideo_);
+            entry.hasColors = true;
+        }
+        return entry.colors;
+    }
+
+    RGBColor const& underlineColor(CellView const& _cell)
+    {
+        Entry& entry = lookup(_cell);
+        if (!entry.hasUnderlineColor)
+        {
+            entry.underlineColor = _cell.attributes().getUnderlineColor(colorProfile_.get());
+            entry.hasUnderlineColor = true;
+        }
+        return entry.underlineColor;
+    }
+
+  private:
+    struct Entry {
+        bool hasColors = false;
+        bool hasUnderlineColor = false;
+        Colors colors{};
+        RGBColor underlineColor{};
+    };
+
+    Entry& lookup(CellView const& _cell)
+    {
+        if (&_cell.pool() != pool_ || _cell.pool().generation() != generation_)
+        {
+            entries_.clear();
+            pool_ = &_cell.pool();
+            generation_ = _cell.pool().generation();
+        }
+
+        auto const id = _cell.attributesId();
+        if (id >= entries_.size())
+            entries_.resize(id + 1);
+
+        return entries_[id];
+    }
+
+    std::reference_wrapper<ColorProfile const> colorProfile_;
+    bool reverseVideo_ = false;
+    CellPool const* pool_ = nullptr;
+    uint64_t generation_ = 0;
+    std::vector<Entry> entries_;
+};
+
+} // end namespace
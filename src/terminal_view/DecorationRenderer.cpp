@@ -71,6 +71,7 @@ DecorationRenderer::DecorationRenderer(atlas::CommandListener& _commandListener,
     curlyAmplitude_{ _curlyAmplitude },
     curlyFrequency_{ _curlyFrequency },
     colorProfile_{ _colorProfile },
+    colorCache_{ colorProfile_ },
     commandListener_{ _commandListener },
     atlas_{ _monochromeTextureAtlas }
 {
@@ -84,6 +85,7 @@ void DecorationRenderer::clearCache()
 void DecorationRenderer::setColorProfile(ColorProfile const& _colorProfile)
 {
     colorProfile_ = _colorProfile;
+    colorCache_.clear();
 }
 
 void DecorationRenderer::rebuild()
@@ -261,7 +263,7 @@ void DecorationRenderer::rebuild()
 }
 
 void DecorationRenderer::renderCell(Coordinate const& _pos,
-                                    Cell const& _cell)
+                                    CellView const& _cell)
 {
     if (_cell.hyperlink())
     {
@@ -285,7 +287,7 @@ void DecorationRenderer::renderCell(Coordinate const& _pos,
 
         for (auto const& mapping : underlineMappings)
             if (_cell.attributes().styles & mapping.first)
-                renderDecoration(mapping.second, _pos, 1, _cell.attributes().getUnderlineColor(colorProfile_));
+                renderDecoration(mapping.second, _pos, 1, colorCache_.underlineColor(_cell));
     }
 
     auto constexpr supplementalMappings = array{
@@ -297,7 +299,7 @@ void DecorationRenderer::renderCell(Coordinate const& _pos,
 
     for (auto const& mapping : supplementalMappings)
         if (_cell.attributes().styles & mapping.first)
-            renderDecoration(mapping.second, _pos, 1, _cell.attributes().getUnderlineColor(colorProfile_));
+            renderDecoration(mapping.second, _pos, 1, colorCache_.underlineColor(_cell));
 }
 
 optional<DecorationRenderer::DataRef> DecorationRenderer::getDataRef(Decorator _decoration)
@@ -13,6 +13,7 @@
  */
 #pragma once
 
+#include <terminal_view/ColorCache.h>
 #include <terminal_view/ShaderConfig.h>
 
 #include <crispy/Atlas.h>
@@ -84,7 +85,7 @@ class DecorationRenderer {
         hyperlinkHover_ = _hover;
     }
 
-    void renderCell(Coordinate const& _pos, Cell const& _cell);
+    void renderCell(Coordinate const& _pos, CellView const& _cell);
 
     void renderDecoration(Decorator _decoration,
                           Coordinate const& _pos,
@@ -112,6 +113,7 @@ class DecorationRenderer {
     float curlyFrequency_ = 1.0f;
 
     ColorProfile colorProfile_; // TODO: make const&, maybe reference_wrapper<>?
+    ColorCache colorCache_;
 
     crispy::atlas::CommandListener& commandListener_;
     Atlas atlas_;
@@ -16,7 +16,6 @@
 
 #include <functional>
 
-using std::scoped_lock;
 using std::chrono::steady_clock;
 
 namespace terminal::view {
@@ -134,57 +133,36 @@ void Renderer::setBackgroundOpacity(terminal::Opacity _opacity)
 void Renderer::setColorProfile(terminal::ColorProfile const& _colors)
 {
     colorProfile_ = _colors;
+    backgroundRenderer_.setColorProfile(_colors);
     textRenderer_.setColorProfile(_colors);
     decorationRenderer_.setColorProfile(_colors);
     cursorRenderer_.setColor(canonicalColor(colorProfile_.cursor));
 }
 
 uint64_t Renderer::render(Terminal& _terminal,
+                          ScreenSnapshot const& _snapshot,
                           steady_clock::time_point _now,
-                          terminal::Coordinate const& _currentMousePosition,
                           bool _pressure)
 {
-    auto const pressure = _pressure && _terminal.screenBufferType() == ScreenBuffer::Type::Main;
+    // The snapshot is rendered without locking, so the terminal may keep processing output meanwhile.
+    auto const pressure = _pressure && _snapshot.bufferType() == ScreenBuffer::Type::Main;
     metrics_.clear();
     textRenderer_.setPressure(pressure);
 
-    screenCoordinates_.screenSize = _terminal.screenSize();
+    screenCoordinates_.screenSize = _snapshot.size();
 
-    if (!pressure)
-        renderCursor(_terminal);
-
-    uint64_t changes = 0;
-    {
-        auto _l = scoped_lock{_terminal};
-        textRenderer_.setReverseVideo(_terminal.screen().isModeEnabled(terminal::Mode::ReverseVideo));
-        if (!pressure && _terminal.screen().contains(_currentMousePosition))
-        {
-            auto& cellAtMouse = _terminal.screen().at(_currentMousePosition);
-            if (cellAtMouse.hyperlink())
-            {
-                cellAtMouse.hyperlink()->state = HyperlinkState::Hover; // TODO: Left-Ctrl pressed?
-            }
+    auto const changes = _terminal.preRender(_now);
 
-            changes = _terminal.preRender(_now);
-
-            _terminal.screen().render([this](Coordinate const& _pos, Cell const& _cell) { renderCell(_pos, _cell); },
-                                      _terminal.screen().scrollOffset());
+    if (!pressure)
+        renderCursor(_snapshot);
 
-            if (cellAtMouse.hyperlink())
-                cellAtMouse.hyperlink()->state = HyperlinkState::Inactive;
-        }
-        else
-        {
-            changes = _terminal.preRender(_now);
-            _terminal.screen().render([this](Coordinate const& pos, Cell const& _cell) { renderCell(pos, _cell); },
-                                      _terminal.screen().scrollOffset());
-        }
-    }
+    textRenderer_.setReverseVideo(_snapshot.reverseVideo());
+    _snapshot.render([this](Coordinate const& _pos, CellView const& _cell) { renderCell(_pos, _cell); });
 
     backgroundRenderer_.renderPendingCells();
     backgroundRenderer_.finish();
 
-    renderSelection(_terminal);
+    renderSelection(_snapshot);
 
     textRenderer_.flushPendingSegments();
     textRenderer_.finish();
@@ -194,40 +172,40 @@ uint64_t Renderer::render(Terminal& _terminal,
     return changes;
 }
 
-void Renderer::renderCursor(Terminal const& _terminal)
+void Renderer::renderCursor(ScreenSnapshot const& _snapshot)
 {
     // TODO: check if CursorStyle has changed, and update render context accordingly.
-    if (_terminal.shouldDisplayCursor() && _terminal.isLineVisible(_terminal.cursor().position.row))
+    auto const& cursor = _snapshot.cursor();
+    if (_snapshot.cursorVisible() && _snapshot.isLineVisible(cursor.position.row))
     {
-        Cell const& cursorCell = *_terminal.at(_terminal.cursor().position);
+        auto const position = Coordinate{cursor.position.row + _snapshot.scrollOffset(), cursor.position.column};
+        auto const cursorCell = _snapshot.at(position);
 
-        auto const cursorShape = _terminal.screen().focused() ? _terminal.cursorShape()
-                                                              : CursorShape::Rectangle;
+        auto const cursorShape = _snapshot.focused() ? _snapshot.cursorShape()
+                                                     : CursorShape::Rectangle;
 
         cursorRenderer_.setShape(cursorShape);
 
         cursorRenderer_.render(
-            screenCoordinates_.map(_terminal.cursor().position.column, _terminal.cursor().position.row + _terminal.scrollOffset()),
+            screenCoordinates_.map(position.column, position.row),
             cursorCell.width()
         );
     }
 }
 
-void Renderer::renderSelection(Terminal const& _terminal)
+void Renderer::renderSelection(ScreenSnapshot const& _snapshot)
 {
-    if (_terminal.screen().isSelectionAvailable())
+    if (!_snapshot.selection().empty())
     {
         // TODO: don't abouse BackgroundRenderer here, maybe invent RectRenderer?
         backgroundRenderer_.setOpacity(colorProfile_.selectionOpacity);
-        Screen const& screen = _terminal.screen();
-        auto const selection = screen.selection();
-        for (Selector::Range const& range : selection) // _terminal.screen().selection())
+        for (Selector::Range const& range : _snapshot.selection())
         {
             // TODO: see if we can extract and then unit-test this display rendering of selection
-            auto const relativeLineNr = range.line - _terminal.historyLineCount();// - _terminal.scrollOffset();
-            if (_terminal.isLineVisible(relativeLineNr))
+            auto const relativeLineNr = range.line - _snapshot.historyLineCount();
+            if (_snapshot.isLineVisible(relativeLineNr))
             {
-                auto const pos = Coordinate{relativeLineNr + _terminal.scrollOffset(), range.fromColumn};
+                auto const pos = Coordinate{relativeLineNr + _snapshot.scrollOffset(), range.fromColumn};
                 auto const count = 1 + range.toColumn - range.fromColumn;
                 backgroundRenderer_.renderOnce(pos, colorProfile_.selection, count);
                 ++metrics_.cellBackgroundRenderCount;
@@ -238,7 +216,7 @@ void Renderer::renderSelection(Terminal const& _terminal)
     }
 }
 
-void Renderer::renderCell(Coordinate const& _pos, Cell const& _cell)
+void Renderer::renderCell(Coordinate const& _pos, CellView const& _cell)
 {
     backgroundRenderer_.renderCell(_pos, _cell);
     decorationRenderer_.renderCell(_pos, _cell);
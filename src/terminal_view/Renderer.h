@@ -93,11 +93,12 @@ class Renderer {
     /**
      * Renders the given @p _terminal to the current OpenGL context.
      *
+     * @p _snapshot The terminal's snapshot to be rendered, as taken by Terminal::snapshot().
      * @p _now The time hint to use when rendering the eventually blinking cursor.
      */
     uint64_t render(Terminal& _terminal,
+                    ScreenSnapshot const& _snapshot,
                     std::chrono::steady_clock::time_point _now,
-                    terminal::Coordinate const& _currentMousePosition,
                     bool _pressure);
 
     RenderMetrics const& metrics() const noexcept { return metrics_; }
@@ -118,9 +119,9 @@ class Renderer {
     void dumpState(std::ostream& _textOutput) const;
 
   private:
-    void renderCell(Coordinate const& _pos, Cell const& _cell);
-    void renderCursor(Terminal const& _terminal);
-    void renderSelection(Terminal const& _terminal);
+    void renderCell(Coordinate const& _pos, CellView const& _cell);
+    void renderCursor(ScreenSnapshot const& _snapshot);
+    void renderSelection(ScreenSnapshot const& _snapshot);
 
   private:
     RenderMetrics metrics_;
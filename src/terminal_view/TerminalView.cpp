@@ -58,7 +58,8 @@ TerminalView::TerminalView(steady_clock::time_point _now,
                            QMatrix4x4 const& _projectionMatrix,
                            ShaderConfig const& _backgroundShaderConfig,
                            ShaderConfig const& _textShaderConfig,
-                           Logger _logger) :
+                           Logger _logger,
+                           terminal::IoReactor* _ioReactor) :
     events_{ _events },
     logger_{ move(_logger) },
     fonts_{ _fonts },
@@ -88,7 +89,8 @@ TerminalView::TerminalView(steady_clock::time_point _now,
         _wordDelimiters,
         _cursorDisplay,
         _cursorShape,
-        [this](terminal::LogEvent const& _event) { logger_(_event); }
+        [this](terminal::LogEvent const& _event) { logger_(_event); },
+        _ioReactor
     },
     colorProfile_{_colorProfile},
     defaultColorProfile_{_colorProfile}
@@ -235,9 +237,9 @@ bool TerminalView::setTerminalSize(Size _cells)
     return true;
 }
 
-uint64_t TerminalView::render(steady_clock::time_point const& _now, bool _pressure)
+uint64_t TerminalView::render(ScreenSnapshot const& _snapshot, steady_clock::time_point const& _now, bool _pressure)
 {
-    return renderer_.render(process_.terminal(), _now, terminal().currentMousePosition(), _pressure);
+    return renderer_.render(process_.terminal(), _snapshot, _now, _pressure);
 }
 
 void TerminalView::wait()
@@ -323,6 +325,11 @@ void TerminalView::resizeWindow(int _width, int _height, bool _unitInPixels)
     events_.resizeWindow(_width, _height, _unitInPixels);
 }
 
+void TerminalView::screenUpdated()
+{
+    events_.screenUpdated();
+}
+
 void TerminalView::setDynamicColor(DynamicColorName _name, RGBColor const& _value)
 {
     switch (_name)
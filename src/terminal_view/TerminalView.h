@@ -51,6 +51,7 @@ class TerminalView : private Terminal::Events {
         virtual void onClosed() {}
         virtual void onSelectionComplete() {}
         virtual void resizeWindow(int /*_width*/, int /*_height*/, bool /*_unitInPixels*/) {}
+        virtual void screenUpdated() {}
         virtual void setWindowTitle(std::string_view const& /*_title*/) {}
     };
 
@@ -71,7 +72,8 @@ class TerminalView : private Terminal::Events {
                  QMatrix4x4 const& _projectionMatrix,
                  ShaderConfig const& _backgroundShaderConfig,
                  ShaderConfig const& _textShaderConfig,
-                 Logger _logger);
+                 Logger _logger,
+                 terminal::IoReactor* _ioReactor = nullptr);
 
     TerminalView(TerminalView const&) = delete;
     TerminalView(TerminalView&&) = delete;
@@ -98,8 +100,8 @@ class TerminalView : private Terminal::Events {
     void setHyperlinkDecoration(Decorator _normal, Decorator _hover) { renderer_.setHyperlinkDecoration(_normal, _hover); }
     void setProjection(QMatrix4x4 const& _projectionMatrix) { return renderer_.setProjection(_projectionMatrix); }
 
-    /// Renders the screen buffer to the current OpenGL screen.
-    uint64_t render(std::chrono::steady_clock::time_point const& _now, bool _pressure);
+    /// Renders the terminal's snapshot @p _snapshot to the current OpenGL screen.
+    uint64_t render(ScreenSnapshot const& _snapshot, std::chrono::steady_clock::time_point const& _now, bool _pressure);
 
     /// Checks if there is still a slave connected to the PTY.
     bool alive() const;
@@ -139,6 +141,7 @@ class TerminalView : private Terminal::Events {
     void onSelectionComplete() override;
     void resetDynamicColor(DynamicColorName /*_name*/) override;
     void resizeWindow(int /*_width*/, int /*_height*/, bool /*_unitInPixels*/) override;
+    void screenUpdated() override;
     void setDynamicColor(DynamicColorName, RGBColor const&) override;
     void setWindowTitle(std::string_view const& /*_title*/) override;
 
@@ -57,6 +57,7 @@ TextRenderer::TextRenderer(RenderMetrics& _renderMetrics,
     renderMetrics_{ _renderMetrics },
     screenCoordinates_{ _screenCoordinates },
     colorProfile_{ _colorProfile },
+    colorCache_{ colorProfile_ },
     fonts_{ _fonts },
     cellSize_{ _cellSize },
     textShaper_{},
@@ -88,6 +89,7 @@ void TextRenderer::setCellSize(Size const& _cellSize)
 void TextRenderer::setColorProfile(ColorProfile const& _colorProfile)
 {
     colorProfile_ = _colorProfile;
+    colorCache_.clear();
 }
 
 void TextRenderer::setFont(FontConfig const& _fonts)
@@ -96,18 +98,20 @@ void TextRenderer::setFont(FontConfig const& _fonts)
     clearCache();
 }
 
-void TextRenderer::reset(Coordinate const& _pos, GraphicsAttributes const& _attr)
+void TextRenderer::reset(Coordinate const& _pos, CellView const& _cell)
 {
-    //std::cout << fmt::format("TextRenderer.reset(): attr:{}\n", _attr.styles);
+    //std::cout << fmt::format("TextRenderer.reset(): attr:{}\n", _cell.attributes().styles);
     row_ = _pos.row;
     startColumn_ = _pos.column;
-    attributes_ = _attr;
+    attributesId_ = _cell.attributesId();
+    attributes_ = _cell.attributes();
+    color_ = colorCache_.colors(_cell).first;
     codepoints_.clear();
     clusters_.clear();
     clusterOffset_ = 0;
 }
 
-void TextRenderer::extend(Cell const& _cell, [[maybe_unused]] cursor_pos_t _column)
+void TextRenderer::extend(CellView const& _cell, [[maybe_unused]] cursor_pos_t _column)
 {
     for (size_t const i: times(_cell.codepointCount()))
     {
@@ -117,7 +121,7 @@ void TextRenderer::extend(Cell const& _cell, [[maybe_unused]] cursor_pos_t _colu
     ++clusterOffset_;
 }
 
-void TextRenderer::schedule(Coordinate const& _pos, Cell const& _cell)
+void TextRenderer::schedule(Coordinate const& _pos, CellView const& _cell)
 {
     constexpr char32_t SP = 0x20;
 
@@ -127,7 +131,7 @@ void TextRenderer::schedule(Coordinate const& _pos, Cell const& _cell)
             if (!_cell.empty() && _cell.codepoint(0) != SP)
             {
                 state_ = State::Filling;
-                reset(_pos, _cell.attributes());
+                reset(_pos, _cell);
                 extend(_cell, _pos.column);
             }
             break;
@@ -135,7 +139,7 @@ void TextRenderer::schedule(Coordinate const& _pos, Cell const& _cell)
         {
             //if (!_cell.empty() && row_ == _pos.row && attributes_ == _cell.attributes() && _cell.codepoint(0) != SP)
             bool const sameLine = _pos.row == row_;
-            bool const sameSGR = _cell.attributes() == attributes_;
+            bool const sameSGR = _cell.attributesId() == attributesId_;
             bool const nonspace = !_cell.empty() && _cell.codepoint(0) != SP;
 
             // Do not perform multi-column text shaping when under rendering pressure.
@@ -154,7 +158,7 @@ void TextRenderer::schedule(Coordinate const& _pos, Cell const& _cell)
                     state_ = State::Empty;
                 else // i.o.w.: cell attributes OR row number changed
                 {
-                    reset(_pos, _cell.attributes());
+                    reset(_pos, _cell);
                     extend(_cell, _pos.column);
                 }
             }
@@ -168,8 +172,6 @@ void TextRenderer::flushPendingSegments()
     if (codepoints_.empty())
         return;
 
-    auto const [fgColor, bgColor] = attributes_.makeColors(colorProfile_, reverseVideo_);
-
     render(
         #if 1
         screenCoordinates_.map(startColumn_, row_),
@@ -178,9 +180,9 @@ void TextRenderer::flushPendingSegments()
         #endif
         cachedGlyphPositions(),
         QVector4D(
-            static_cast<float>(fgColor.red) / 255.0f,
-            static_cast<float>(fgColor.green) / 255.0f,
-            static_cast<float>(fgColor.blue) / 255.0f,
+            static_cast<float>(color_.red) / 255.0f,
+            static_cast<float>(color_.green) / 255.0f,
+            static_cast<float>(color_.blue) / 255.0f,
             1.0f
         )
     );
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <terminal/Screen.h>
+#include <terminal_view/ColorCache.h>
 #include <terminal_view/ScreenCoordinates.h>
 #include <terminal_view/ShaderConfig.h>
 #include <terminal_view/FontConfig.h>
@@ -126,9 +127,9 @@ class TextRenderer {
 
     void setPressure(bool _pressure) noexcept { pressure_ = _pressure; }
 
-    void setReverseVideo(bool _reverse) noexcept { reverseVideo_ = _reverse; }
+    void setReverseVideo(bool _reverse) { colorCache_.setReverseVideo(_reverse); }
 
-    void schedule(Coordinate const& _pos, Cell const& _cell);
+    void schedule(Coordinate const& _pos, CellView const& _cell);
     void flushPendingSegments();
     void finish();
 
@@ -136,8 +137,8 @@ class TextRenderer {
     void clearCache();
 
   private:
-    void reset(Coordinate const& _pos, GraphicsAttributes const& _attr);
-    void extend(Cell const& _cell, cursor_pos_t _column);
+    void reset(Coordinate const& _pos, CellView const& _cell);
+    void extend(CellView const& _cell, cursor_pos_t _column);
     crispy::text::GlyphPositionList prepareRun(unicode::run_segmenter::range const& _range);
 
     crispy::text::GlyphPositionList const& cachedGlyphPositions();
@@ -181,7 +182,7 @@ class TextRenderer {
     RenderMetrics& renderMetrics_;
     ScreenCoordinates const& screenCoordinates_;
     ColorProfile colorProfile_; // TODO: make const&, maybe reference_wrapper<>?
-    bool reverseVideo_ = false;
+    ColorCache colorCache_;
     FontConfig fonts_;
 
     // text run segmentation
@@ -190,7 +191,9 @@ class TextRenderer {
     State state_ = State::Empty;
     cursor_pos_t row_ = 1;
     cursor_pos_t startColumn_ = 1;
+    Cell::AttributesId attributesId_ = 0;
     GraphicsAttributes attributes_ = {};
+    RGBColor color_ = {};
     std::vector<char32_t> codepoints_{};
     std::vector<int> clusters_{};
     unsigned clusterOffset_ = 0;